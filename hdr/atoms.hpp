@@ -25,6 +25,7 @@
 #ifndef ATOMS_H_
 #define ATOMS_H_
 
+#include <stdint.h>
 #include <string>
 #include <vector>
 
@@ -100,6 +101,7 @@ namespace atoms
 	extern std::vector <int> category_array;
 	extern std::vector <int> grain_array;
 	extern std::vector <int> cell_array;
+	extern std::vector <uint64_t> global_id_array; /// Unique lattice site id, independent of decomposition
 
 	extern std::vector <double> x_spin_array;
 	extern std::vector <double> y_spin_array;
@@ -119,6 +121,47 @@ namespace atoms
 	extern std::vector <zval_t> i_exchange_list;
 	extern std::vector <zvec_t> v_exchange_list;
 	extern std::vector <zten_t> t_exchange_list;
+
+	//--------------------------------------------------------------------------
+	// Packed exchange layout. Neighbours are stored in padded ELL format with
+	// [slot*ell_stride+atom] ordering so that consecutive atoms are contiguous
+	// in memory, and neighbour spins are gathered from a single aligned array
+	// of [x,y,z,0] blocks. Compile with -DSINGLE_PRECISION_SPINS to store
+	// packed spins and exchange constants in single precision (fields are
+	// always accumulated in double precision).
+	//--------------------------------------------------------------------------
+	#ifdef SINGLE_PRECISION_SPINS
+		typedef float packed_real_t;
+	#else
+		typedef double packed_real_t;
+	#endif
+
+	extern bool packed_exchange; /// Enables packed layout for isotropic exchange
+	extern int ell_width; /// Maximum number of neighbours of any atom
+	extern int ell_stride; /// Number of atoms padded to a multiple of the vector length
+	extern std::vector <int> ell_neighbour_array; /// Padded neighbour list
+	extern std::vector <packed_real_t> ell_exchange_array; /// Padded exchange constants (zero for padding)
+	extern packed_real_t* packed_spin_array; /// 64-byte aligned packed spin array
+	extern bool packed_spins_current; /// Packed spins of local atoms have been written by integrator
+
+	//--------------------------------------------------------------------------
+	// Stencil exchange layout. Atoms are mapped onto a padded grid of unit
+	// cells for each unit cell atom (sublattice), with sites stored as
+	// [sublattice*stencil_grid_size+cell] and x varying fastest. Exchange
+	// fields are calculated by applying the unit cell interaction template to
+	// whole rows of the grid, with vacancies treated as sites with zero spin.
+	//--------------------------------------------------------------------------
+	extern bool stencil_exchange; /// Enables stencil evaluation of isotropic exchange
+	extern int stencil_num_sublattices; /// Number of atoms in unit cell
+	extern int stencil_dimensions[3]; /// Dimensions of padded grid in unit cells
+	extern int stencil_padding; /// Number of padding cells on each side of grid
+	extern int stencil_grid_size; /// Number of cells in padded grid
+	extern std::vector <int> stencil_atom_array; /// Atom at each site, or -1 for vacancies
+	extern std::vector <int> stencil_site_array; /// Site of each atom
+	extern std::vector <int> stencil_interaction_start_index; /// First interaction of each sublattice
+	extern std::vector <int> stencil_interaction_sublattice_array; /// Sublattice of neighbour for each interaction
+	extern std::vector <int> stencil_interaction_offset_array; /// Offset of neighbour cell for each interaction
+	extern std::vector <double> stencil_interaction_Jij_array; /// Exchange constant for each interaction
 	
 	// surface anisotropy
 	extern std::vector<bool> surface_array;
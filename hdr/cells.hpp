@@ -38,6 +38,9 @@ namespace cells{
 
 	extern int num_cells;
 	extern int num_local_cells;
+	extern int num_cells_x; /// Number of macrocells along each axis of regular grid
+	extern int num_cells_y;
+	extern int num_cells_z;
    extern int num_atoms_in_unit_cell;
 
 	extern double size;
@@ -144,15 +144,28 @@ namespace cs{
 
 	};
 	
-	class neighbour_t {
+	//-----------------------------------------------------------------------------
+	// Neighbour list in compressed sparse row form, where the neighbours of
+	// atom are stored in the range start[atom] to start[atom+1]-1
+	//-----------------------------------------------------------------------------
+	class neighbour_list_t {
 	public:
-		
-		int nn; // atom id of neighbour
-		int i; // interaction type of neighbour
 
-      double vx; // vector between atoms i->j
-      double vy;
-      double vz;
+		std::vector<int> start; // index of first neighbour of each atom (num_atoms+1 entries)
+		std::vector<int> nn; // atom id of neighbour
+		std::vector<int> i; // interaction type of neighbour
+
+		bool vectors; // flag to indicate vectors between atoms are stored
+		std::vector<double> vx; // vector between atoms i->j
+		std::vector<double> vy;
+		std::vector<double> vz;
+
+		neighbour_list_t():
+			vectors(false)
+		{};
+
+		// number of neighbours of atom
+		int size(const int atom) const { return start[atom+1]-start[atom]; }
 
 	};
 	
@@ -294,7 +307,7 @@ int create_system_type(std::vector<cs::catom_t> &);
 ///	Revision:	  ---
 ///=====================================================================================
 ///
-int create_neighbourlist(std::vector<cs::catom_t> &, std::vector<std::vector <neighbour_t> > &);
+int create_neighbourlist(std::vector<cs::catom_t> &, cs::neighbour_list_t &);
 
 /// @brief This is the brief (one line only) description of the function.
 ///
@@ -317,10 +330,14 @@ int create_neighbourlist(std::vector<cs::catom_t> &, std::vector<std::vector <ne
 ///	Revision:	  ---
 ///=====================================================================================
 ///
-int set_atom_vars(std::vector<cs::catom_t> &, std::vector<std::vector <neighbour_t> > &);
+int set_atom_vars(std::vector<cs::catom_t> &, cs::neighbour_list_t &);
 
 int voronoi_film(std::vector<cs::catom_t> &);
 
+// Function to map atoms onto grid for stencil exchange calculation
+void create_stencil_exchange(const std::vector<cs::catom_t> &, const cs::neighbour_list_t &);
+void release_neighbour_list();
+
 /// @brief This is the brief (one line only) description of the function.
 ///
 /// @section License
@@ -447,7 +464,28 @@ void generate_multilayers(std::vector<cs::catom_t> & catom_array);
 
   // unit cell initialisation function
   void unit_cell_set(cs::unit_cell_t &);
-  
+
+  // Space filling curve ordering of atoms for memory locality
+  namespace sfc{
+
+    extern int ordering; /// space filling curve used to order atoms (0 = generation order, 1 = Morton, 2 = Hilbert)
+    extern std::vector<int> output_order; /// atom ids in generation order (empty if not reordered)
+
+    extern void reorder_atoms(std::vector<cs::catom_t>&, cs::neighbour_list_t&);
+
+  }
+
+  // Cached system image to skip system generation
+  namespace image{
+
+    extern bool enabled; /// flag to load and save system image
+
+    extern void add_to_key(const std::string& line);
+    extern bool load();
+    extern void save();
+
+  }
+
 }
 
 #endif /*CREATE_H_*/
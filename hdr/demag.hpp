@@ -36,10 +36,44 @@
 namespace demag{
 
 	extern bool fast;
+	extern bool fft;
+	extern bool compressed;
+	extern bool tree;
+	extern double tree_opening_angle;
+	extern bool adaptive;
+	extern double update_tolerance;
+	extern bool hybrid;
+	extern int near_field_range;
 	extern int update_rate;
+
+	extern const double prefactor;
+
+	// Precalculated dipole tensor for fast update [local cell][cell]
+	extern std::vector <std::vector < double > > rij_xx;
+	extern std::vector <std::vector < double > > rij_xy;
+	extern std::vector <std::vector < double > > rij_xz;
+	extern std::vector <std::vector < double > > rij_yy;
+	extern std::vector <std::vector < double > > rij_yz;
+	extern std::vector <std::vector < double > > rij_zz;
 	
 	extern void init();
 	extern void update();
+	extern void dipole_tensor(const double rx, const double ry, const double rz, double rij_matrix[6]);
+	extern void fast_tensor(const int lc, const int j, double rij_matrix[6]);
+
+	// Tree code demag functions
+	extern void tree_init();
+	extern void tree_update();
+
+	// Hybrid near field atomistic demag functions
+	extern void hybrid_init();
+	extern void hybrid_update();
+
+	// Adaptive demag update functions
+	extern void adaptive_init();
+	extern bool adaptive_update_required(const int last_update_time);
+	extern bool adaptive_update();
+	extern void adaptive_schedule();
 
 
 }
@@ -176,6 +176,32 @@ using std::string;
 
 	extern std::vector <materials_t> material;
 
+	//--------------------------------------------------------------------
+	// Compact read-only table of the per-material constants needed by the
+	// integrator, field and Monte Carlo hot loops. Each entry is exactly
+	// 64 bytes and the table is 64-byte aligned, so that a lookup touches a
+	// single cache line. Entries are rebuilt by set_derived_parameters() and
+	// the temperature dependent values by
+	// update_material_hot_params_temperature().
+	//--------------------------------------------------------------------
+	class material_hot_params_t {
+		public:
+		double one_oneplusalpha_sq;
+		double alpha_oneplusalpha_sq;
+		double alpha;
+		double mu_s_SI;
+		double H_th_sigma; /// thermal field width at T = 1K
+		double thermal_sigma; /// thermal field width at (rescaled) material temperature
+		double mc_kBTBohr; /// mu_B/kB T at rescaled system temperature
+		double mc_sigma; /// width of tuned Monte Carlo trial move
+	};
+
+	// compile time check that each entry fills exactly one cache line
+	typedef char material_hot_params_size_check[sizeof(material_hot_params_t)==64 ? 1 : -1];
+
+	extern material_hot_params_t* material_hot_params; /// 64-byte aligned table [material]
+	extern int num_material_hot_params;
+
 	extern double dt_SI;
 	extern double dt;
 	extern double half_dt;
@@ -197,6 +223,8 @@ using std::string;
 	extern int default_system();	
 	extern int single_spin_system();
 	extern int set_derived_parameters();
+	extern void update_material_hot_params();
+	extern void update_material_hot_params_temperature();
 	
 
 }
@@ -46,6 +46,7 @@ namespace program
    extern void lagrange_multiplier();
    extern void localised_temperature_pulse();
    extern void effective_damping();
+   extern void replica_exchange();
 
 	// Sundry programs and diagnostics not under general release
 	extern int LLB_Boltzmann();
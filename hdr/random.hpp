@@ -24,6 +24,8 @@
 //
 #ifndef RANDOM_H_
 #define RANDOM_H_
+#include <stdint.h>
+#include <vector>
 #include "mtrand.hpp"
 namespace mtrandom
 //==========================================================
@@ -36,6 +38,18 @@ namespace mtrandom
 	
 	extern int voronoi_seed;
 	extern int integration_seed;
+
+	//-----------------------------------------------------------------------------
+	// Counter-based (Philox4x32-10) random numbers for the thermal field. Each
+	// number is a pure function of (seed, global atom id, thermal step) so the
+	// noise is independent of the number of threads or MPI processes.
+	//-----------------------------------------------------------------------------
+	extern uint64_t thermal_step; /// counter advanced once per integration step
+
+	extern void philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t result[4]);
+	extern void counter_gaussian_batch(const std::vector<uint64_t>& global_id, const int start_index, const int end_index,
+	                                   const uint32_t seed, const uint64_t step,
+	                                   std::vector<double>& gx, std::vector<double>& gy, std::vector<double>& gz);
 }
 
 
@@ -37,6 +37,7 @@ enum pump_functions_t {square=0, two_temperature, double_pump_two_temperature, d
 namespace sim{
 	extern std::ofstream mag_file;
 	extern uint64_t time;
+	extern double physical_time; /// Simulated physical time [s]
 	extern uint64_t total_time;
 	extern uint64_t loop_time;
 	extern int partial_time;
@@ -88,6 +89,15 @@ namespace sim{
 	extern double mc_delta_angle; /// Tuned angle for Monte Carlo trial move
 	enum mc_algorithms { spin_flip, uniform, angle, hinzke_nowak};
    extern mc_algorithms mc_algorithm; /// Selected algorith for Monte Carlo simulations
+   extern bool parallel_cmc; /// Use graph coloured pair moves for constrained Monte Carlo
+   extern bool incremental_mc; /// Use cached local exchange fields for Monte Carlo
+
+	// Adaptive integrator variables
+	extern double adaptive_tolerance; /// Maximum error in spin direction per adaptive step
+	extern double adaptive_dt_SI; /// Physical time of last adaptive step [s]
+
+	// Energy minimisation variables
+	extern double minimiser_tolerance; /// Maximum torque on any spin at convergence [T]
 
 	extern double head_position[2];
 	extern double head_speed;
@@ -112,7 +122,11 @@ namespace sim{
 	extern int system_simulation_flags;
 	extern int hamiltonian_simulation_flags[10];
 	
-	extern int integrator;
+	/// Enumerated list of integrators selected by sim::integrator
+	enum integrators_t { llg_heun=0, monte_carlo, llg_midpoint, constrained_monte_carlo, hybrid_constrained_monte_carlo,
+	                     parallel_monte_carlo, llg_rk23, llg_rotation, energy_minimisation };
+
+	extern int integrator; /// Selected integrator from integrators_t
 	extern int program;
 	extern int AnisotropyType;
 	
@@ -161,18 +175,41 @@ namespace sim{
 	extern int LLG_Midpoint();
 	extern int LLG_Midpoint_mpi();
 	extern int LLG_Midpoint_cuda();
+	extern int LLG_RK23();
+	extern int LLG_Rotation();
+	extern int Minimise();
 	extern int MonteCarlo();
 	extern int ConstrainedMonteCarlo();
 	extern int ConstrainedMonteCarloMonteCarlo();
+	extern int ParallelMonteCarlo();
+	extern int ParallelConstrainedMonteCarlo();
+	extern int IncrementalMonteCarlo();
 	extern void mc_move(const std::valarray<double>&, std::valarray<double>&);
 
 	// Integrator initialisers
 	extern void CMCinit();
 	extern int LLGinit();
 	extern void CMCMCinit();
+	extern void initialise_parallel_monte_carlo();
+	extern void initialise_parallel_constrained_monte_carlo();
+	extern void initialise_incremental_monte_carlo();
+
+	// Packed exchange functions
+	extern void initialise_packed_exchange();
+	extern void finalise_packed_exchange();
+	extern void pack_spins(const int, const int);
+	extern void update_packed_spins(const int, const int);
+	extern void calculate_packed_exchange_fields(const int, const int);
+
+	// Stencil exchange functions
+	extern void initialise_stencil_exchange();
+	extern void update_stencil_exchange_fields();
+	extern void calculate_stencil_exchange_fields(const int, const int);
+	extern double stencil_exchange_energy(const int, const double, const double, const double);
 
 	// Field and energy functions
 	extern double calculate_spin_energy(const int, const int);
+	extern double calculate_spin_onsite_energy(const int, const double, const double, const double);
    extern double spin_exchange_energy_isotropic(const int, const double, const double , const double );
    extern double spin_exchange_energy_vector(const int, const double, const double, const double);
    extern double spin_exchange_energy_tensor(const int, const double, const double, const double);
@@ -245,6 +282,11 @@ namespace cmc{
 	};
 	
 	extern std::vector<cmc_material_t> cmc_mat;
+
+	// Rotational matrices for constrained Monte Carlo
+	extern std::vector<std::vector<double> > polar_vector;
+	extern std::vector<std::vector<double> > polar_matrix_tp;
+	extern std::vector<std::vector<double> > polar_matrix;
 	
 	extern bool is_initialised;
 	
@@ -28,6 +28,7 @@
 #include <fstream>
 #include <string>
 #include <iostream>
+#include <vector>
 #include <time.h>
 #include <sys/types.h>
 #ifdef WIN_COMPILE
@@ -102,6 +103,7 @@ namespace vout{
 	
 	extern bool output_atoms_config;
 	extern int output_atoms_config_rate;
+	extern int atoms_output_format;
 	
 	extern double atoms_output_min[3];
 	extern double atoms_output_max[3];
@@ -124,6 +126,9 @@ namespace vout{
 	
 	extern void data();
 	extern void config();
+	extern void store_replica_line(const std::string& line);
+	extern void data_block_separator();
+	extern void write_replica_data();
 	extern void zLogTsInit(std::string);
 	
 	//extern int pov_file();
@@ -131,6 +136,37 @@ namespace vout{
 	void redirect(std::ostream& strm, std::string filename);
 	void nullify(std::ostream& strm);  
 
+	// Asynchronous output
+	extern bool asynchronous_output;
+	extern int asynchronous_queue_depth;
+
+	namespace async{
+
+		// Output job, formatted and written to disk by background writer thread
+		class job_t{
+		public:
+			std::vector<char> buffer; /// data copied from simulation
+			std::string message; /// logged once job has been written to disk
+			virtual ~job_t(){}
+			virtual void write()=0;
+		};
+
+		// Output job to write buffer unchanged to a file opened before submission
+		class binary_job_t : public job_t{
+		public:
+			std::ofstream ofile;
+			void write(){
+				if(buffer.size()>0) ofile.write(&buffer[0], buffer.size());
+				ofile.close();
+			}
+		};
+
+		extern void acquire_buffer(std::vector<char>& buffer, const size_t size);
+		extern void submit(job_t* job);
+		extern void finalise();
+
+	}
+
 }
 
 // Checkpoint load/save functions
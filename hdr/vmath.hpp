@@ -42,6 +42,7 @@
 
 #include<vector>
 #include <cmath>
+#include <complex>
 
 /// @namespace ns
 /// @brief vmath namespace containing sundry math functions for vampire.
@@ -95,6 +96,11 @@ namespace vmath{
 	
    extern double interpolate_m(double,double,double,double);
    extern double interpolate_c(double,double,double,double);
+
+   // Fast Fourier transforms (radix-2, dimensions must be powers of two)
+   extern unsigned int next_power_of_two(unsigned int);
+   extern void fft(std::complex<double>*, const int, const int, const bool);
+   extern void fft3d(std::vector<std::complex<double> >&, const int, const int, const int, const bool);
 	
 }
 
@@ -48,6 +48,11 @@ namespace vmpi{
 	extern int num_core_atoms;			///< Number of atoms on local CPU with no external communication
 	extern int num_bdry_atoms;			///< Number of atoms on local CPU with external communication
 	extern int num_halo_atoms;			///< Number of atoms on remote CPUs needed for boundary atom integration
+
+	extern int world_rank;				///< CPU ID in all CPUs
+	extern int num_replicas;			///< Number of independent replicas of system (0 = one per CPU)
+	extern int replica_id;				///< Replica of system simulated on local CPU
+	extern int replica_point;			///< Index of current point of parameter sweep for statistical parallelism
 	
 	extern bool replicated_data_staged; ///< Flag for staged system generation
 	
@@ -80,20 +85,66 @@ namespace vmpi{
 	extern std::vector<int> recv_num_array;
 	extern std::vector<double> recv_spin_data_array;
 	
+	//-------------------------------------------------------------------------
+	// Class for summing partial values of items (such as macrocell or grain
+	// moments) over processors, where each processor contributes values for
+	// its local items only and receives totals for the items it needs
+	//-------------------------------------------------------------------------
+	class sparse_sum_t {
+
+		public:
+
+			sparse_sum_t();
+
+			// set up communication pattern for local and needed item ids
+			void initialise(const std::vector<int>& local_items, const std::vector<int>& needed_items, const int num_items, const int num_components);
+
+			// sum values [local item][component] into totals [needed item][component]
+			void sum(const std::vector<double>& local_data, std::vector<double>& needed_data);
+
+		private:
+
+			int num_components;  /// number of values per item
+			int num_needed;      /// number of needed items
+			bool gather_all;     /// flag to indicate all processors need all items
+
+			std::vector<int> send_order;          /// local item position for each value sent to owners
+			std::vector<int> send_counts;         /// number of items sent to each owner
+			std::vector<int> send_displacements;
+			std::vector<int> recv_counts;         /// number of items received from each contributor
+			std::vector<int> recv_displacements;
+			std::vector<int> recv_owned_index;    /// owned item position for each value received
+
+			std::vector<int> reply_counts;        /// number of owned items sent to each processor in need
+			std::vector<int> reply_displacements;
+			std::vector<int> reply_owned_index;   /// owned item position for each value sent in reply
+			std::vector<int> request_counts;      /// number of needed items received from each owner
+			std::vector<int> request_displacements;
+			std::vector<int> request_needed_index; /// needed item position for each value received in reply
+
+			std::vector<double> send_buffer;
+			std::vector<double> recv_buffer;
+			std::vector<double> owned_data;
+
+	};
+
 	#ifdef MPICF
 		extern std::vector<MPI::Request> requests;
 		extern std::vector<MPI::Status> stati;
+		extern MPI::Intracomm comm;	///< Communicator for CPUs simulating local replica of system
 	#endif
 
 	//functions declarations
 	extern int initialise();
+	extern int initialise_replicas();
+	extern bool is_replica_point();
 	extern int hosts();
 	extern int finalise();
 	extern int geometric_decomposition(int, double []);
 	extern int crystal_xyz(std::vector<cs::catom_t> &);
 	extern int copy_halo_atoms(std::vector<cs::catom_t> &);
 	extern int set_replicated_data(std::vector<cs::catom_t> &);
-	extern int identify_boundary_atoms(std::vector<cs::catom_t> &, std::vector<std::vector <cs::neighbour_t> > &);
+	extern int identify_boundary_atoms(std::vector<cs::catom_t> &, cs::neighbour_list_t &);
 	extern int init_mpi_comms(std::vector<cs::catom_t> & catom_array);
 	extern double SwapTimer(double, double&);
 
@@ -0,0 +1,79 @@
+#ifndef VOMP_H_
+#define VOMP_H_
+//-----------------------------------------------------------------------------
+//
+// This header file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+
+// OpenMP headers are only included when compiled with OpenMP support
+#ifdef _OPENMP
+   #include <omp.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Thin wrappers around OpenMP runtime functions so that threaded kernels
+// compile and run unchanged (on a single thread) without OpenMP support
+//-----------------------------------------------------------------------------
+namespace vomp{
+
+   //-----------------------------------------------------------------------------
+   // Minimum number of atoms before a loop is worth threading
+   //-----------------------------------------------------------------------------
+   const int min_atoms_per_team = 4096;
+
+   //-----------------------------------------------------------------------------
+   // Maximum number of threads available to a parallel region
+   //-----------------------------------------------------------------------------
+   inline int max_threads(){
+      #ifdef _OPENMP
+         return omp_get_max_threads();
+      #else
+         return 1;
+      #endif
+   }
+
+   //-----------------------------------------------------------------------------
+   // Number of threads in the current team
+   //-----------------------------------------------------------------------------
+   inline int num_threads(){
+      #ifdef _OPENMP
+         return omp_get_num_threads();
+      #else
+         return 1;
+      #endif
+   }
+
+   //-----------------------------------------------------------------------------
+   // Id of calling thread within the current team
+   //-----------------------------------------------------------------------------
+   inline int thread_id(){
+      #ifdef _OPENMP
+         return omp_get_thread_num();
+      #else
+         return 0;
+      #endif
+   }
+
+   //-----------------------------------------------------------------------------
+   // Splits the range [start_index,end_index) into contiguous equal blocks,
+   // one per thread of the current team, and returns the block for the caller
+   //-----------------------------------------------------------------------------
+   inline void thread_range(const int start_index, const int end_index, int& thread_start, int& thread_end){
+      const int nt = num_threads();
+      const int tid = thread_id();
+      const int range = end_index - start_index;
+      const int block = range / nt;
+      const int remainder = range % nt;
+      // first remainder threads get one extra element
+      thread_start = start_index + tid*block + (tid < remainder ? tid : remainder);
+      thread_end = thread_start + block + (tid < remainder ? 1 : 0);
+      return;
+   }
+
+} // end of vomp namespace
+
+#endif //VOMP_H_
@@ -137,7 +137,7 @@ int create(){
 	
 	// Atom creation array
 	std::vector<cs::catom_t> catom_array;
-	std::vector<std::vector<neighbour_t> > cneighbourlist;
+	cs::neighbour_list_t cneighbourlist;
 
 	// initialise unit cell for system
 	unit_cell_set(cs::unit_cell);
@@ -159,7 +159,7 @@ int create(){
 
 	// Set up Parallel Decomposition if required 
 	#ifdef MPICF
-		if(vmpi::mpi_mode==0) vmpi::geometric_decomposition(vmpi::num_processors,cs::system_dimensions);
+		if(vmpi::mpi_mode==0 || vmpi::mpi_mode==2) vmpi::geometric_decomposition(vmpi::num_processors,cs::system_dimensions);
 	#endif
 
 	//      Initialise variables for system creation	
@@ -167,128 +167,146 @@ int create(){
 		// read_coord_file();
 	}
 	
+	// Load prebuilt system from image if available, skipping system generation
+	const bool image_loaded = cs::image::load();
+	if(!image_loaded){
+
 	#ifdef MPICF
-	// check for staged replicated data generation
-	if(vmpi::replicated_data_staged==true && vmpi::mpi_mode==1){
+		// check for staged replicated data generation
+		if(vmpi::replicated_data_staged==true && vmpi::mpi_mode==1){
 	
-		// copy ppn to constant temporary
-		const int ppn=vmpi::ppn;
+			// copy ppn to constant temporary
+			const int ppn=vmpi::ppn;
 		
-		for(int n=0;n<ppn;n++){
-			bool i_am_it=false;
-			if(vmpi::my_rank%ppn==n) i_am_it=true;
+			for(int n=0;n<ppn;n++){
+				bool i_am_it=false;
+				if(vmpi::my_rank%ppn==n) i_am_it=true;
 			
-			// Only generate system if I am it
-			if(i_am_it){
+				// Only generate system if I am it
+				if(i_am_it){
 				
-				zlog << zTs() << "Generating staged system on rank " << vmpi::my_rank << "..." << std::endl;
-				//std::cerr << zTs() << "Generating staged system on rank " << vmpi::my_rank << "..." << std::endl;
+					zlog << zTs() << "Generating staged system on rank " << vmpi::my_rank << "..." << std::endl;
+					//std::cerr << zTs() << "Generating staged system on rank " << vmpi::my_rank << "..." << std::endl;
 				
-				// Create block of crystal of desired size
-				cs::create_crystal_structure(catom_array);
+					// Create block of crystal of desired size
+					cs::create_crystal_structure(catom_array);
 				
-				// Cut system to the correct type, species etc
-				cs::create_system_type(catom_array);
+					// Cut system to the correct type, species etc
+					cs::create_system_type(catom_array);
 				
-				vmpi::set_replicated_data(catom_array);
+					vmpi::set_replicated_data(catom_array);
 
-				// Create Neighbour list for system
-				cs::create_neighbourlist(catom_array,cneighbourlist);
+					// Create Neighbour list for system
+					cs::create_neighbourlist(catom_array,cneighbourlist);
 				
-				// Identify needed atoms and destroy the rest
-				vmpi::identify_boundary_atoms(catom_array,cneighbourlist);
+					// Identify needed atoms and destroy the rest
+					vmpi::identify_boundary_atoms(catom_array,cneighbourlist);
 
-				zlog << zTs() << "Staged system generation on rank " << vmpi::my_rank << " completed." << std::endl;
-				//std::cerr << zTs() << "Staged system generation on rank " << vmpi::my_rank << " completed." << std::endl;
-			}
+					zlog << zTs() << "Staged system generation on rank " << vmpi::my_rank << " completed." << std::endl;
+					//std::cerr << zTs() << "Staged system generation on rank " << vmpi::my_rank << " completed." << std::endl;
+				}
 			
-			// Wait for process who is it
-			MPI::COMM_WORLD.Barrier();
+				// Wait for process who is it
+				vmpi::comm.Barrier();
 			
-		} // end of loop over processes
-	}
-	else{
+			} // end of loop over processes
+		}
+		else{
 	#endif
 	
-	// Create block of crystal of desired size
-	cs::create_crystal_structure(catom_array);
+		// Create block of crystal of desired size
+		cs::create_crystal_structure(catom_array);
 	
-	// Cut system to the correct type, species etc
-	cs::create_system_type(catom_array);
+		// Cut system to the correct type, species etc
+		cs::create_system_type(catom_array);
 	
-	// Copy atoms for interprocessor communications
+		// Copy atoms for interprocessor communications
 	#ifdef MPICF
-	if(vmpi::mpi_mode==0){
-		MPI::COMM_WORLD.Barrier(); // wait for everyone
-		vmpi::copy_halo_atoms(catom_array);
-		MPI::COMM_WORLD.Barrier(); // sync after halo atoms copied
-	}
-	else if(vmpi::mpi_mode==1){
-		vmpi::set_replicated_data(catom_array);
-	}
+		if(vmpi::mpi_mode==0 || vmpi::mpi_mode==2){
+			vmpi::comm.Barrier(); // wait for everyone
+			vmpi::copy_halo_atoms(catom_array);
+			vmpi::comm.Barrier(); // sync after halo atoms copied
+		}
+		else if(vmpi::mpi_mode==1){
+			vmpi::set_replicated_data(catom_array);
+		}
 	#else
-		//cs::copy_periodic_boundaries(catom_array);
+			//cs::copy_periodic_boundaries(catom_array);
 	#endif
 	
-	// Create Neighbour list for system
-	cs::create_neighbourlist(catom_array,cneighbourlist);
+		// Create Neighbour list for system
+		cs::create_neighbourlist(catom_array,cneighbourlist);
 	
 	#ifdef MPICF
-		vmpi::identify_boundary_atoms(catom_array,cneighbourlist);
+			vmpi::identify_boundary_atoms(catom_array,cneighbourlist);
 	#endif
 
+		// Optionally reorder atoms along space filling curve for memory locality
+		if(cs::sfc::ordering!=0) cs::sfc::reorder_atoms(catom_array,cneighbourlist);
+
 
 	#ifdef MPICF	
-	} // stop if for staged generation here
-	// ** Must be done in parallel **
-		vmpi::init_mpi_comms(catom_array);
-		MPI::COMM_WORLD.Barrier();
+		} // stop if for staged generation here
+		// ** Must be done in parallel **
+			vmpi::init_mpi_comms(catom_array);
+			vmpi::comm.Barrier();
 	#endif
 
-	// Set atom variables for simulation
+		// Set atom variables for simulation
 	#ifdef MPICF
-	// check for staged replicated data generation
-	if(vmpi::replicated_data_staged==true && vmpi::mpi_mode==1){
+		// check for staged replicated data generation
+		if(vmpi::replicated_data_staged==true && vmpi::mpi_mode==1){
 	
-		// copy ppn to constant temporary
-		const int ppn=vmpi::ppn;
+			// copy ppn to constant temporary
+			const int ppn=vmpi::ppn;
 		
-		for(int n=0;n<ppn;n++){
-			bool i_am_it=false;
-			if(vmpi::my_rank%ppn==n) i_am_it=true;
+			for(int n=0;n<ppn;n++){
+				bool i_am_it=false;
+				if(vmpi::my_rank%ppn==n) i_am_it=true;
 			
-			// Only generate system if I am it
-			if(i_am_it){
+				// Only generate system if I am it
+				if(i_am_it){
 				
-				zlog << zTs() << "Copying system data to optimised data structures on rank " << vmpi::my_rank << "..." << std::endl;
-				//std::cerr << zTs() << "Copying system data to optimised data structures on rank " << vmpi::my_rank << "..." << std::endl;
-				cs::set_atom_vars(catom_array,cneighbourlist);
-				zlog << zTs() << "Copying on rank " << vmpi::my_rank << " completed." << std::endl;
-				//std::cerr << zTs() << "Copying on rank " << vmpi::my_rank << " completed." << std::endl;
-			}
+					zlog << zTs() << "Copying system data to optimised data structures on rank " << vmpi::my_rank << "..." << std::endl;
+					//std::cerr << zTs() << "Copying system data to optimised data structures on rank " << vmpi::my_rank << "..." << std::endl;
+					cs::set_atom_vars(catom_array,cneighbourlist);
+					zlog << zTs() << "Copying on rank " << vmpi::my_rank << " completed." << std::endl;
+					//std::cerr << zTs() << "Copying on rank " << vmpi::my_rank << " completed." << std::endl;
+				}
 			
-			// Wait for process who is it
-			MPI::COMM_WORLD.Barrier();
+				// Wait for process who is it
+				vmpi::comm.Barrier();
 			
-		} // end of loop over processes
-	}
-	else{
+			} // end of loop over processes
+		}
+		else{
 	#endif
 
-	// Print informative message
-	std::cout << "Copying system data to optimised data structures." << std::endl;
-	zlog << zTs() << "Copying system data to optimised data structures." << std::endl;
+		// Print informative message
+		std::cout << "Copying system data to optimised data structures." << std::endl;
+		zlog << zTs() << "Copying system data to optimised data structures." << std::endl;
 
-	cs::set_atom_vars(catom_array,cneighbourlist);
+		cs::set_atom_vars(catom_array,cneighbourlist);
 	
 	#ifdef MPICF	
-	} // stop if for staged generation here
+		} // stop if for staged generation here
 	#endif
 
+	} // end of system generation
+
+	// Set up packed exchange layout
+	if(atoms::packed_exchange) sim::initialise_packed_exchange();
+
 	// Set grain and cell variables for simulation
 	grains::set_properties();
 	cells::initialise();
 	if(sim::hamiltonian_simulation_flags[4]==1) demag::init();
+
+	// Save generated system for reuse by later simulations
+	if(!image_loaded) cs::image::save();
+
+	// Release explicit neighbour list superseded by stencil exchange
+	if(atoms::stencil_exchange) cs::release_neighbour_list();
 	
    // Determine number of local atoms
    #ifdef MPICF
@@ -321,7 +339,7 @@ int create(){
 		//vmpi::crystal_xyz(catom_array);
 	int my_num_atoms=vmpi::num_core_atoms+vmpi::num_bdry_atoms;
 	int total_num_atoms=0;
-	MPI::COMM_WORLD.Reduce(&my_num_atoms,&total_num_atoms, 1,MPI_INT, MPI_SUM, 0 );
+	vmpi::comm.Reduce(&my_num_atoms,&total_num_atoms, 1,MPI_INT, MPI_SUM, 0 );
 	std::cout << "Total number of atoms (all CPUs): " << total_num_atoms << std::endl;
    zlog << zTs() << "Total number of atoms (all CPUs): " << total_num_atoms << std::endl;
 	#else
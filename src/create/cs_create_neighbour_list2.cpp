@@ -46,9 +46,11 @@
 // Vampire Header files
 #include "create.hpp"
 #include "errors.hpp"
+#include "sim.hpp"
 #include "vio.hpp"
 #include "vmath.hpp"
 #include "vmpi.hpp"
+#include "vomp.hpp"
 
 // Standard Libraries
 #include <cmath>
@@ -57,6 +59,50 @@
 
 namespace cs{
 
+namespace internal{
+
+///
+/// @brief Determine neighbouring supercell for an interaction
+///
+/// Wraps neighbouring supercell coordinates for periodic boundaries (in serial only,
+/// parallel periodic boundaries are handled explicitly elsewhere) and returns the
+/// flat index of the neighbouring supercell, or -1 if it lies outside the system.
+/// The offset of the periodic image from the neighbouring supercell is returned in v.
+///
+inline int neighbour_cell(const int scc[3], const cs::unit_cell_interaction_t& interaction, const int d[3], double v[3]){
+
+	int n[3]={interaction.dx+scc[0], interaction.dy+scc[1], interaction.dz+scc[2]};
+
+	v[0]=0.0;
+	v[1]=0.0;
+	v[2]=0.0;
+
+	#ifndef MPICF
+	// Wrap around for periodic boundaries
+	// Consider virtual atom position for position vector
+	for(int i=0;i<3;i++){
+		if(cs::pbc[i]==true){
+			if(n[i]>=d[i]){
+				n[i]=n[i]-d[i];
+				v[i]=v[i]+d[i]*cs::unit_cell.dimensions[i];
+			}
+			else if(n[i]<0){
+				n[i]=n[i]+d[i];
+				v[i]=v[i]-d[i]*cs::unit_cell.dimensions[i];
+			}
+		}
+	}
+	#endif
+
+	// check for out-of-bounds access
+	if(n[0]<0 || n[0]>=d[0] || n[1]<0 || n[1]>=d[1] || n[2]<0 || n[2]>=d[2]) return -1;
+
+	return (n[0]*d[1]+n[1])*d[2]+n[2];
+
+}
+
+} // end of namespace internal
+
 ///
 /// @brief Generate atomic neighbourlist
 ///
@@ -69,8 +115,13 @@ namespace cs{
 ///
 ///  In this example offset=4, and max_cell = 8. Therefore 4 cells are needed.
 ///
+/// The neighbour list is generated in two passes over all supercells, first
+/// counting the neighbours of each atom and then filling the compressed list
+/// in place. Each atom belongs to a single supercell and so both passes are
+/// threaded over supercells. Vectors between atoms are only calculated when
+/// needed for surface anisotropy.
 ///
-int create_neighbourlist(std::vector<cs::catom_t> & catom_array, std::vector<std::vector <neighbour_t> > & cneighbourlist){
+int create_neighbourlist(std::vector<cs::catom_t> & catom_array, cs::neighbour_list_t & cneighbourlist){
 	
 	// check calling of routine if error checking is activated
 	if(err::check==true){std::cout << "cs::create_neighbourlist has been called" << std::endl;}	
@@ -78,17 +129,9 @@ int create_neighbourlist(std::vector<cs::catom_t> & catom_array, std::vector<std
 	// put number of atoms into temporary variable
 	const int num_atoms = catom_array.size();
 
-	// Reserve space for num_atoms
-	cneighbourlist.reserve(num_atoms);
-
-	// estimate number of interactions per atom
-	const int max_nn=int(1.1*(double(unit_cell.interaction.size())/double(unit_cell.atom.size())));
-	
-	// Reserve space for each atom in neighbour list according to material type
-	for(int atom=0;atom<num_atoms;atom++){
-		cneighbourlist.push_back(std::vector<neighbour_t>());
-		cneighbourlist[atom].reserve(max_nn);
-	}
+	// number of atoms and interactions in unit cell
+	const int num_uc_atoms = cs::unit_cell.atom.size();
+	const int num_interactions = cs::unit_cell.interaction.size();
 
    // Calculate system dimensions and number of supercells
    int max_val=std::numeric_limits<int>::max();
@@ -112,60 +155,25 @@ int create_neighbourlist(std::vector<cs::catom_t> & catom_array, std::vector<std
 	const int max_cell[3] = {max[0],max[1],max[2]};
 	
 	// calculate number of cells needed = max-min+1 ( if max_cell = 25, then 0-25 = 26
-	const unsigned int d[3]={max_cell[0]-offset[0]+1,max_cell[1]-offset[1]+1,max_cell[2]-offset[2]+1};
-
-	// Declare array for create space for 3D supercell array
-	std::vector<std::vector<std::vector<std::vector<int> > > > supercell_array;
+	const int d[3]={max_cell[0]-offset[0]+1,max_cell[1]-offset[1]+1,max_cell[2]-offset[2]+1};
+	const int num_cells=d[0]*d[1]*d[2];
 
-	zlog << zTs() << "Memory required for neighbourlist calculation:" << 8.0*double(d[0])*double(d[1])*double(d[2])*double(unit_cell.atom.size())/1.0e6 << " MB" << std::endl;
+	// Flat supercell array storing atom id of each unit cell atom in each cell, or -1 if missing
+	zlog << zTs() << "Memory required for neighbourlist calculation:" << double(sizeof(int))*double(num_cells)*double(num_uc_atoms)/1.0e6 << " MB" << std::endl;
    zlog << zTs() << "Allocating memory for supercell array in neighbourlist calculation..."<< std::endl;
-	supercell_array.resize(d[0]);
-	for(unsigned int i=0; i<d[0] ; i++){
-		supercell_array[i].resize(d[1]);
-		for(unsigned int j=0; j<d[1] ; j++){
-			supercell_array[i][j].resize(d[2]);
-			for(unsigned int k=0; k<d[2] ; k++){
-				supercell_array[i][j][k].resize(unit_cell.atom.size(),-1);
-			}
-		}
-	}
+	std::vector<int> supercell_array(num_cells*num_uc_atoms,-1);
    zlog << zTs() << "\tDone"<< std::endl;
 
-	// declare cell array to loop over
-	const unsigned int num_cells=d[0]*d[1]*d[2];
-	std::vector< std::vector <int> > cell_coord_array;
-	cell_coord_array.reserve(num_cells);
-	for(unsigned int i=0;i<num_cells;i++){
-		cell_coord_array.push_back(std::vector<int>());
-		cell_coord_array[i].resize(3);
-	}
-
-	// Initialise cell_array
-	unsigned int cell=0;
-	for(unsigned int x=0;x<d[0];x++){
-		for(unsigned int y=0;y<d[1];y++){
-			for(unsigned int z=0;z<d[2];z++){
-				//save cell coordinates
-				cell_coord_array[cell][0]=x;
-				cell_coord_array[cell][1]=y;
-				cell_coord_array[cell][2]=z;
-				cell++;
-			}
-		}
-	}
    zlog << zTs() << "Populating supercell array for neighbourlist calculation..."<< std::endl;
 	// Populate supercell array with atom numbers
 	for(int atom=0;atom<num_atoms;atom++){
 		unsigned int scc[3]={catom_array[atom].scx-offset[0],catom_array[atom].scy-offset[1],catom_array[atom].scz-offset[2]};
 		
 		double c[3]={catom_array[atom].x,catom_array[atom].y,catom_array[atom].z};
-		//std::cout << atom << "\t" << c[0] << "\t" << c[1] <<"\t" << c[2] << std::endl;
 		for(int i=0;i<3;i++){
-			//scc[i]=int(c[i]/cs::unit_cell_size[i])-offset[i]; // Always round down for supercell coordinates
 			// Always check cell in range
-         if(scc[i]>= d[i]){
+         if(scc[i]>= (unsigned int)d[i]){
 			//if(scc[i]<0 || scc[i]>= d[i]){ // Chexk for scc < 0 not required since d and scc are unsigned
-				//std::cerr << "Error - atom out of supercell range in neighbourlist calculation!" << std::endl;
 				#ifdef MPICF
 				terminaltextcolor(RED);
 				std::cerr << "\tCPU Rank: " << vmpi::my_rank << std::endl;
@@ -184,10 +192,11 @@ int create_neighbourlist(std::vector<cs::catom_t> & catom_array, std::vector<std
 				err::vexit();
 			}
 		}
+		const int cell=(scc[0]*d[1]+scc[1])*d[2]+scc[2];
 		// Check for atoms greater than max_atoms_per_supercell
-		if(catom_array[atom].uc_id<unit_cell.atom.size()){
+		if(catom_array[atom].uc_id<(unsigned int)num_uc_atoms){
 			// Add atom to supercell
-			supercell_array[scc[0]][scc[1]][scc[2]][catom_array[atom].uc_id]=atom;
+			supercell_array[cell*num_uc_atoms+catom_array[atom].uc_id]=atom;
 		}
 		else{
 			terminaltextcolor(RED);
@@ -198,8 +207,9 @@ int create_neighbourlist(std::vector<cs::catom_t> & catom_array, std::vector<std
 			std::cerr << "\tCell maxima:      " << d[0] << "\t" << d[1] << "\t" << d[2] << std::endl;
 			std::cerr << "\tCell offset:      " << offset[0] << "\t" << offset[1] << "\t" << offset[2] << std::endl;
 			std::cerr << "\tAtoms in Current Cell:" << std::endl;
-			for(unsigned int ix=0;ix<supercell_array[scc[0]][scc[1]][scc[2]].size();ix++){
-				const int ixatom=supercell_array[scc[0]][scc[1]][scc[2]][ix];
+			for(int ix=0;ix<num_uc_atoms;ix++){
+				const int ixatom=supercell_array[cell*num_uc_atoms+ix];
+				if(ixatom<0) continue;
 				std::cerr << "\t\t [id x y z] "<< ix << "\t" << ixatom << "\t" << catom_array[ixatom].x << "\t" << catom_array[ixatom].y << "\t" << catom_array[ixatom].z << std::endl;
 			}
 			terminaltextcolor(WHITE);
@@ -209,158 +219,89 @@ int create_neighbourlist(std::vector<cs::catom_t> & catom_array, std::vector<std
 
    zlog << zTs() << "\tDone"<< std::endl;
 
-   // Get unit cell size
-   const double ucdx=cs::unit_cell.dimensions[0];
-   const double ucdy=cs::unit_cell.dimensions[1];
-   const double ucdz=cs::unit_cell.dimensions[2];
+	// Vectors between atoms are only needed for surface anisotropy
+	cneighbourlist.vectors=sim::surface_anisotropy;
 
 	// Generate neighbour list
 	std::cout <<"Generating neighbour list"<< std::flush;
-   zlog << zTs() << "Memory required for neighbour list:" << 8.0*double(num_cells)*double(cs::unit_cell.interaction.size())/1.0e6 << " MB" << std::endl;
    zlog << zTs() << "Generating neighbour list..."<< std::endl;
-	neighbour_t tmp_nt;
-	// Loop over all cells
-	for(unsigned int cell=0;cell<num_cells;cell++){
-		if(cell%(num_cells/10+1)==0){
-			std::cout << "." << std::flush;
+
+	//----------------------------------------------------------
+	// First pass: count neighbours of each atom
+	//----------------------------------------------------------
+	std::vector<int>& start=cneighbourlist.start;
+	start.assign(num_atoms+1,0);
+
+	#pragma omp parallel for schedule(static) if(num_cells*num_uc_atoms > vomp::min_atoms_per_team)
+	for(int cell=0;cell<num_cells;cell++){
+		const int scc[3]={cell/(d[1]*d[2]), (cell/d[2])%d[1], cell%d[2]};
+		double v[3];
+		// Loop over all interactions
+		for(int i=0;i<num_interactions;i++){
+			const int atomi=supercell_array[cell*num_uc_atoms+cs::unit_cell.interaction[i].i];
+			if(atomi==-1) continue;
+			const int ncell=internal::neighbour_cell(scc, cs::unit_cell.interaction[i], d, v);
+			// check for missing atoms
+			if(ncell!=-1 && supercell_array[ncell*num_uc_atoms+cs::unit_cell.interaction[i].j]!=-1) start[atomi+1]++;
 		}
-		//std::cout << "cell: " << cell << ":>" << std::flush; // << std::endl;
-		int scc[3]={cell_coord_array[cell][0],cell_coord_array[cell][1],cell_coord_array[cell][2]};
+	}
+
+	// convert counts to start indices
+	for(int atom=0;atom<num_atoms;atom++) start[atom+1]+=start[atom];
+	const int total_num_neighbours=start[num_atoms];
+
+	std::cout << "." << std::flush;
+	zlog << zTs() << "Memory required for neighbour list:" << (cneighbourlist.vectors ? 32.0 : 8.0)*double(total_num_neighbours)/1.0e6 << " MB" << std::endl;
+
+	cneighbourlist.nn.resize(total_num_neighbours);
+	cneighbourlist.i.resize(total_num_neighbours);
+	if(cneighbourlist.vectors){
+		cneighbourlist.vx.resize(total_num_neighbours);
+		cneighbourlist.vy.resize(total_num_neighbours);
+		cneighbourlist.vz.resize(total_num_neighbours);
+	}
+
+	//----------------------------------------------------------
+	// Second pass: fill neighbour list in interaction order
+	//----------------------------------------------------------
+	#pragma omp parallel for schedule(static) if(num_cells*num_uc_atoms > vomp::min_atoms_per_team)
+	for(int cell=0;cell<num_cells;cell++){
+		const int scc[3]={cell/(d[1]*d[2]), (cell/d[2])%d[1], cell%d[2]};
+		double v[3];
 		// Loop over all interactions
-		for(unsigned int i=0;i<cs::unit_cell.interaction.size();i++){
-
-			const int atom=cs::unit_cell.interaction[i].i;
-			const int natom=cs::unit_cell.interaction[i].j;
-
-			int nx=cs::unit_cell.interaction[i].dx+scc[0];
-			int ny=cs::unit_cell.interaction[i].dy+scc[1];
-			int nz=cs::unit_cell.interaction[i].dz+scc[2];
-
-         // vector from i->j
-         double vx=0.0;
-         double vy=0.0;
-         double vz=0.0;
-
-         #ifdef MPICF
-           // Parallel periodic boundaries are handled explicitly elsewhere
-         #else
-         // Wrap around for periodic boundaries
-         // Consider virtual atom position for position vector
-         if(cs::pbc[0]==true){
-            if(nx>=int(d[0])){
-               nx=nx-d[0];
-               vx=vx+d[0]*ucdx;
-            }
-            else if(nx<0){
-               nx=nx+d[0];
-               vx=vx-d[0]*ucdx;
-            }
-         }
-         if(cs::pbc[1]==true){
-            if(ny>=int(d[1])){
-               ny=ny-d[1];
-               vy=vy+d[1]*ucdy;
-            }
-            else if(ny<0){
-               ny=ny+d[1];
-               vy=vy-d[1]*ucdy;
-            }
-         }
-         if(cs::pbc[2]==true){
-            if(nz>=int(d[2])){
-               nz=nz-d[2];
-               vz=vz+d[2]*ucdz;
-            }
-            else if(nz<0){
-               nz=nz+d[2];
-               vz=vz-d[2]*ucdz;
-            }
-         }
-         #endif
-         // check for out-of-bounds access
-         if((nx>=0 && nx<d[0]) && (ny>=0 && ny<d[1]) && (nz>=0 && nz<d[2])){
-            // check for missing atoms
-            if((supercell_array[scc[0]][scc[1]][scc[2]][atom]!=-1) && (supercell_array[nx][ny][nz][natom]!=-1)){
-
-               // need actual atom numbers...
-               int atomi = supercell_array[scc[0]][scc[1]][scc[2]][atom];
-               int atomj = supercell_array[nx][ny][nz][natom];
-
-               //std::cout << "int_id: " << i << "\tatom i: " << atomi << "\tatom j: " << atomj << "\tuc_i: " << atom << "\tuc_j: " << natom << std::endl;  
-
-               double ix=catom_array[atomi].x; // Already in A
-               double iy=catom_array[atomi].y;
-               double iz=catom_array[atomi].z;
-               double jx=catom_array[atomj].x;
-               double jy=catom_array[atomj].y;
-               double jz=catom_array[atomj].z;
-
-               //std::cout << "\tpi:    " << ix << "\t" << iy << "\t" << iz << std::endl;
-               //std::cout << "\tpj:    " << jx << "\t" << jy << "\t" << jz << std::endl;
-               //std::cout << "\tv_uc:  " << vx << "\t" << vy << "\t" << vz << std::endl;
-
-               vx+=jx-ix;
-               vy+=jy-iy;
-               vz+=jz-iz;
-
-               //std::cout << "\tv:     " << jx-ix << "\t" << jy-iy << "\t" << jz-iz << std::endl;
-               //std::cout << "\tv_eff: " << vx << "\t" << vy << "\t" << vz << std::endl;
-
-               // get current index
-               int index=cneighbourlist[supercell_array[scc[0]][scc[1]][scc[2]][atom]].size();
-
-               // push back array of class
-               cneighbourlist[supercell_array[scc[0]][scc[1]][scc[2]][atom]].push_back(tmp_nt);
-
-               // now save atom id and interaction type
-               cneighbourlist[supercell_array[scc[0]][scc[1]][scc[2]][atom]][index].nn=supercell_array[nx][ny][nz][natom];
-               cneighbourlist[supercell_array[scc[0]][scc[1]][scc[2]][atom]][index].i=i;
-
-               // Add position vector from i-> j
-               cneighbourlist[supercell_array[scc[0]][scc[1]][scc[2]][atom]][index].vx=vx;
-               cneighbourlist[supercell_array[scc[0]][scc[1]][scc[2]][atom]][index].vy=vy;
-               cneighbourlist[supercell_array[scc[0]][scc[1]][scc[2]][atom]][index].vz=vz;
-
-            }
+		for(int i=0;i<num_interactions;i++){
+			const int atomi=supercell_array[cell*num_uc_atoms+cs::unit_cell.interaction[i].i];
+			if(atomi==-1) continue;
+			const int ncell=internal::neighbour_cell(scc, cs::unit_cell.interaction[i], d, v);
+			if(ncell==-1) continue;
+			const int atomj=supercell_array[ncell*num_uc_atoms+cs::unit_cell.interaction[i].j];
+			if(atomj==-1) continue;
+
+			// start index of atomi is used as insertion point, restored afterwards
+			const int index=start[atomi]++;
+
+			// now save atom id and interaction type
+			cneighbourlist.nn[index]=atomj;
+			cneighbourlist.i[index]=i;
+
+			// Add position vector from i-> j
+			if(cneighbourlist.vectors){
+				cneighbourlist.vx[index]=v[0]+catom_array[atomj].x-catom_array[atomi].x;
+				cneighbourlist.vy[index]=v[1]+catom_array[atomj].y-catom_array[atomi].y;
+				cneighbourlist.vz[index]=v[2]+catom_array[atomj].z-catom_array[atomi].z;
 			}
 		}
 	}
+
+	// restore start indices, which now point to the start of the next atom
+	for(int atom=num_atoms;atom>0;atom--) start[atom]=start[atom-1];
+	start[0]=0;
+
 	terminaltextcolor(GREEN);
 	std::cout << "done!" << std::endl;
 	terminaltextcolor(WHITE);
    zlog << zTs() << "\tDone"<< std::endl;
 
-	// Deallocate supercell array
-   zlog << zTs() << "Deallocating supercell array for neighbour list calculation" << std::endl;
-	for(unsigned int i=0; i<d[0] ; i++){
-		for(unsigned int j=0; j<d[1] ;j++){
-			for(unsigned int k=0; k<d[2] ;k++){
-				supercell_array[i][j][k].resize(0);
-				}
-				supercell_array[i][j].resize(0);
-			}
-			supercell_array[i].resize(0);
-		}
-	supercell_array.resize(0);
-
-   zlog << zTs() << "\tDone" << std::endl;
-
-	// Print neighbour list
-	//for(int atom=0;atom<catom_array.size();atom++){
-	//	std::cout << atom << "\t";
-	//	for(int nn=0;nn<cneighbourlist[atom].size();nn++){
-	//		std::cout << cneighbourlist[atom][nn].nn << "\t";
-	//	}
-	//	std::cout << std::endl;
-	//}
-		
-	// Mark surface atoms
-	//for(int atom=0;atom<num_atoms;atom++){
-	//	if(int(cneighbourlist[atom].size())!=mp::material[catom_array[atom].material].hamiltonian_num_neighbours){
-	//		catom_array[atom].material=2;
-	//	}
-	//}
-
 	return EXIT_SUCCESS;
 }
 
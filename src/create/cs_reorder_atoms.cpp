@@ -0,0 +1,211 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+//
+//    Space filling curve atom ordering. With create:atom-ordering=morton or
+//    hilbert, atoms are renumbered after neighbour list generation in order
+//    along a space filling curve through the unit cells of the system, so
+//    that neighbouring atoms are close in memory and neighbour gathers in
+//    the exchange field and energy calculations hit fewer cache lines.
+//
+//    In parallel, core and boundary atoms are reordered separately so that
+//    the core | boundary | halo layout is preserved. The generation order of
+//    the atoms is kept in output_order, which is used to write output and
+//    checkpoint files in the same order as without reordering.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <stdint.h>
+#include <vector>
+
+// Vampire headers
+#include "create.hpp"
+#include "errors.hpp"
+#include "vio.hpp"
+#include "vmpi.hpp"
+
+namespace cs{
+
+namespace sfc{
+
+   int ordering=0; /// space filling curve used to order atoms (0 = generation order, 1 = Morton, 2 = Hilbert)
+   std::vector<int> output_order(0); /// atom ids in generation order (empty if not reordered)
+
+   namespace internal{
+
+      // number of bits per dimension in curve keys
+      const int bits=21;
+
+      //-----------------------------------------------------------------------
+      // Function to calculate Morton (z-order) key by bit interleaving
+      //-----------------------------------------------------------------------
+      uint64_t morton_key(const uint32_t x, const uint32_t y, const uint32_t z){
+         uint64_t key=0;
+         for(int b=bits-1; b>=0; b--){
+            key = (key<<3) | (uint64_t((x>>b)&1)<<2) | (uint64_t((y>>b)&1)<<1) | uint64_t((z>>b)&1);
+         }
+         return key;
+      }
+
+      //-----------------------------------------------------------------------
+      // Function to calculate Hilbert key, transforming coordinates to the
+      // transposed Hilbert index (J. Skilling, AIP Conf. Proc. 707, 381 (2004))
+      // and then interleaving the bits
+      //-----------------------------------------------------------------------
+      uint64_t hilbert_key(const uint32_t x, const uint32_t y, const uint32_t z){
+
+         uint32_t X[3]={x,y,z};
+         const uint32_t M = 1u << (bits-1);
+
+         // inverse undo
+         for(uint32_t Q=M; Q>1; Q>>=1){
+            const uint32_t P=Q-1;
+            for(int i=0; i<3; i++){
+               if(X[i] & Q) X[0] ^= P;
+               else{
+                  const uint32_t t=(X[0]^X[i]) & P;
+                  X[0]^=t;
+                  X[i]^=t;
+               }
+            }
+         }
+
+         // Gray encode
+         for(int i=1; i<3; i++) X[i] ^= X[i-1];
+         uint32_t t=0;
+         for(uint32_t Q=M; Q>1; Q>>=1) if(X[2] & Q) t ^= Q-1;
+         for(int i=0; i<3; i++) X[i] ^= t;
+
+         return morton_key(X[0], X[1], X[2]);
+
+      }
+
+      // Define data type storing curve key and atom number
+      struct key_t{
+         uint64_t key;
+         int atom;
+         bool operator<(const key_t& other) const {
+            if(key!=other.key) return key<other.key;
+            return atom<other.atom;
+         }
+      };
+
+      //-----------------------------------------------------------------------
+      // Function to sort atoms in range [start,end) along curve, storing the
+      // old atom number of each new atom in order
+      //-----------------------------------------------------------------------
+      void sort_range(const std::vector<cs::catom_t>& catom_array, const int start, const int end, std::vector<int>& order){
+
+         if(end<=start) return;
+
+         // determine lowest supercell coordinates in range
+         int min[3]={std::numeric_limits<int>::max(),std::numeric_limits<int>::max(),std::numeric_limits<int>::max()};
+         for(int atom=start; atom<end; atom++){
+            min[0]=std::min(min[0],catom_array[atom].scx);
+            min[1]=std::min(min[1],catom_array[atom].scy);
+            min[2]=std::min(min[2],catom_array[atom].scz);
+         }
+
+         std::vector<key_t> keys(end-start);
+         for(int atom=start; atom<end; atom++){
+            const uint32_t x=catom_array[atom].scx-min[0];
+            const uint32_t y=catom_array[atom].scy-min[1];
+            const uint32_t z=catom_array[atom].scz-min[2];
+            key_t& k=keys[atom-start];
+            k.key = (ordering==2) ? hilbert_key(x,y,z) : morton_key(x,y,z);
+            k.atom = atom;
+         }
+
+         // atoms in the same unit cell have the same key and keep their generation order
+         std::sort(keys.begin(), keys.end());
+
+         for(int i=0; i<end-start; i++) order[start+i]=keys[i].atom;
+
+         return;
+
+      }
+
+   } // end of namespace internal
+
+   //--------------------------------------------------------------------------
+   // Function to reorder atoms and neighbour list along space filling curve
+   //--------------------------------------------------------------------------
+   void reorder_atoms(std::vector<cs::catom_t>& catom_array, cs::neighbour_list_t& cneighbourlist){
+
+      // check calling of routine if error checking is activated
+      if(err::check==true){std::cout << "cs::sfc::reorder_atoms has been called" << std::endl;}
+
+      const int num_atoms=catom_array.size();
+
+      // old atom number of each new atom, initially unchanged
+      std::vector<int> order(num_atoms);
+      for(int atom=0; atom<num_atoms; atom++) order[atom]=atom;
+
+      #ifdef MPICF
+         // reorder core and boundary atoms separately, leaving halo atoms in place
+         internal::sort_range(catom_array, 0, vmpi::num_core_atoms, order);
+         internal::sort_range(catom_array, vmpi::num_core_atoms, vmpi::num_core_atoms+vmpi::num_bdry_atoms, order);
+      #else
+         internal::sort_range(catom_array, 0, num_atoms, order);
+      #endif
+
+      // calculate new atom number of each old atom, which is generation order
+      output_order.resize(num_atoms);
+      for(int atom=0; atom<num_atoms; atom++) output_order[order[atom]]=atom;
+
+      // reorder atoms
+      std::vector<cs::catom_t> tmp_catom_array(num_atoms);
+      for(int atom=0; atom<num_atoms; atom++) tmp_catom_array[atom]=catom_array[order[atom]];
+      catom_array.swap(tmp_catom_array);
+      std::vector<cs::catom_t>().swap(tmp_catom_array);
+
+      // reorder neighbour list using new atom numbers
+      cs::neighbour_list_t tmp_cneighbourlist;
+      tmp_cneighbourlist.vectors=cneighbourlist.vectors;
+      tmp_cneighbourlist.start.resize(num_atoms+1,0);
+      for(int atom=0; atom<num_atoms; atom++){
+         tmp_cneighbourlist.start[atom+1]=tmp_cneighbourlist.start[atom]+cneighbourlist.size(order[atom]);
+      }
+      const int total_num_neighbours=tmp_cneighbourlist.start[num_atoms];
+      tmp_cneighbourlist.nn.resize(total_num_neighbours);
+      tmp_cneighbourlist.i.resize(total_num_neighbours);
+      if(tmp_cneighbourlist.vectors){
+         tmp_cneighbourlist.vx.resize(total_num_neighbours);
+         tmp_cneighbourlist.vy.resize(total_num_neighbours);
+         tmp_cneighbourlist.vz.resize(total_num_neighbours);
+      }
+
+      for(int atom=0; atom<num_atoms; atom++){
+         const int old_start=cneighbourlist.start[order[atom]];
+         for(int nn=0; nn<tmp_cneighbourlist.size(atom); nn++){
+            const int index=tmp_cneighbourlist.start[atom]+nn;
+            tmp_cneighbourlist.nn[index]=output_order[cneighbourlist.nn[old_start+nn]];
+            tmp_cneighbourlist.i[index]=cneighbourlist.i[old_start+nn];
+            if(tmp_cneighbourlist.vectors){
+               tmp_cneighbourlist.vx[index]=cneighbourlist.vx[old_start+nn];
+               tmp_cneighbourlist.vy[index]=cneighbourlist.vy[old_start+nn];
+               tmp_cneighbourlist.vz[index]=cneighbourlist.vz[old_start+nn];
+            }
+         }
+      }
+
+      std::swap(cneighbourlist,tmp_cneighbourlist);
+
+      zlog << zTs() << "Reordered " << num_atoms << " atoms along " << (ordering==2 ? "Hilbert" : "Morton") << " curve" << std::endl;
+
+      return;
+
+   }
+
+} // end of namespace sfc
+
+} // end of namespace cs
@@ -29,6 +29,7 @@
 //
 //==================================================================== 
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -48,7 +49,7 @@
 //using namespace material_parameters;
 	
 namespace cs{
-int set_atom_vars(std::vector<cs::catom_t> & catom_array, std::vector<std::vector <neighbour_t> > & cneighbourlist){
+int set_atom_vars(std::vector<cs::catom_t> & catom_array, cs::neighbour_list_t & cneighbourlist){
 
 	// check calling of routine if error checking is activated
 	if(err::check==true){
@@ -76,6 +77,7 @@ int set_atom_vars(std::vector<cs::catom_t> & catom_array, std::vector<std::vecto
 	atoms::category_array.resize(atoms::num_atoms,0);
 	atoms::grain_array.resize(atoms::num_atoms,0);
 	atoms::cell_array.resize(atoms::num_atoms,0);
+	atoms::global_id_array.resize(atoms::num_atoms,0);
 	
 	atoms::x_total_spin_field_array.resize(atoms::num_atoms,0.0);
 	atoms::y_total_spin_field_array.resize(atoms::num_atoms,0.0);
@@ -102,6 +104,18 @@ int set_atom_vars(std::vector<cs::catom_t> & catom_array, std::vector<std::vecto
 		//std::cout << atom << " grain: " << catom_array[atom].grain << std::endl;
 		atoms::grain_array[atom] = catom_array[atom].grain;
 
+		// global id from supercell coordinates and unit cell atom, identical for any decomposition.
+		// Periodic halo atoms have offset supercell coordinates and are wrapped back into the system.
+		const uint64_t num_uc_atoms = cs::unit_cell.atom.size();
+		const int ncx = cs::total_num_unit_cells[0];
+		const int ncy = cs::total_num_unit_cells[1];
+		const int ncz = cs::total_num_unit_cells[2];
+		const int scx = ((catom_array[atom].scx%ncx)+ncx)%ncx;
+		const int scy = ((catom_array[atom].scy%ncy)+ncy)%ncy;
+		const int scz = ((catom_array[atom].scz%ncz)+ncz)%ncz;
+		const uint64_t sc_id = (uint64_t(scz)*uint64_t(ncy) + uint64_t(scy))*uint64_t(ncx) + uint64_t(scx);
+		atoms::global_id_array[atom] = sc_id*num_uc_atoms + uint64_t(catom_array[atom].uc_id);
+
 		// initialise atomic spin positions
       // Use a normalised gaussian for uniform distribution on a unit sphere
 		int mat=atoms::type_array[atom];
@@ -132,45 +146,31 @@ int set_atom_vars(std::vector<cs::catom_t> & catom_array, std::vector<std::vecto
 	zlog << (2.0*double(atoms::num_atoms)+2.0*double(atoms::total_num_neighbours))*8.0/1.0e6 << " MB RAM"<< std::endl; 
 
 	//-------------------------------------------------
-	//	Calculate total number of neighbours
+	//	Move compressed neighbour list to atom arrays
 	//-------------------------------------------------
-	int counter = 0;
-	
-	for(int atom=0;atom<atoms::num_atoms;atom++){
-		counter+=cneighbourlist[atom].size();
-	}
-	
-	atoms::total_num_neighbours = counter;
-	
-	atoms::neighbour_list_array.resize(atoms::total_num_neighbours,0);
-	atoms::neighbour_interaction_type_array.resize(atoms::total_num_neighbours,0);
+	atoms::total_num_neighbours = cneighbourlist.start[atoms::num_atoms];
+
+	// neighbour ids are moved, interaction types are copied as needed later for surface atoms
+	atoms::neighbour_list_array.swap(cneighbourlist.nn);
+	atoms::neighbour_interaction_type_array=cneighbourlist.i;
 	atoms::neighbour_list_start_index.resize(atoms::num_atoms,0);
 	atoms::neighbour_list_end_index.resize(atoms::num_atoms,0);
 
-	//	Populate 1D neighbourlist and index arrays
-	counter = 0;
+	//	Populate index arrays
 	for(int atom=0;atom<atoms::num_atoms;atom++){
-		//std::cout << atom << ": ";
-		// Set start index
-		atoms::neighbour_list_start_index[atom]=counter;
-		for(unsigned int nn=0;nn<cneighbourlist[atom].size();nn++){
-			atoms::neighbour_list_array[counter] = cneighbourlist[atom][nn].nn;
-			if(cneighbourlist[atom][nn].nn > atoms::num_atoms){
+		// Set start and end index
+		atoms::neighbour_list_start_index[atom]=cneighbourlist.start[atom];
+		atoms::neighbour_list_end_index[atom]=cneighbourlist.start[atom+1]-1;
+		for(int nn=cneighbourlist.start[atom];nn<cneighbourlist.start[atom+1];nn++){
+			if(atoms::neighbour_list_array[nn] > atoms::num_atoms){
 				terminaltextcolor(RED);
-				std::cerr << "Fatal Error - neighbour " << cneighbourlist[atom][nn].nn <<" is out of valid range 0-" 
+				std::cerr << "Fatal Error - neighbour " << atoms::neighbour_list_array[nn] <<" is out of valid range 0-" 
 				<< atoms::num_atoms << " on rank " << vmpi::my_rank << std::endl;
 				std::cerr << "Atom " << atom << " of MPI type " << catom_array[atom].mpi_type << std::endl;
 				terminaltextcolor(WHITE);
 				err::vexit();
 			}
-			
-			atoms::neighbour_interaction_type_array[counter] = cneighbourlist[atom][nn].i;
-			//std::cout << cneighbourlist[atom][nn] << " ";
-			counter++;
 		}
-		//std::cout << std::endl;
-		// Set end index
-		atoms::neighbour_list_end_index[atom]=counter-1;
 	}
 	
 	// condense interaction list
@@ -183,20 +183,23 @@ int set_atom_vars(std::vector<cs::catom_t> & catom_array, std::vector<std::vecto
 	
 	switch(atoms::exchange_type){
 		case -1:
-			// unroll material calculations
+			// unroll material calculations into table of material pairs
 			std::cout << "Using generic form of exchange interaction with " << unit_cell.interaction.size() << " total interactions." << std::endl;
-			zlog << zTs() << "Unrolled exchange template requires " << 1.0*double(atoms::neighbour_list_array.size())*double(sizeof(double))*1.0e-6 << "MB RAM" << std::endl;
-			atoms::i_exchange_list.reserve(atoms::neighbour_list_array.size());
-			// loop over all interactions
+			zlog << zTs() << "Unrolled exchange template requires " << double(mp::num_materials)*double(mp::num_materials)*double(sizeof(double))*1.0e-6 << "MB RAM" << std::endl;
+			atoms::i_exchange_list.reserve(mp::num_materials*mp::num_materials);
+			for(int imaterial=0;imaterial<mp::num_materials;imaterial++){
+				for(int jmaterial=0;jmaterial<mp::num_materials;jmaterial++){
+					atoms::i_exchange_list.push_back(tmp_zval);
+					atoms::i_exchange_list[imaterial*mp::num_materials+jmaterial].Jij=mp::material[imaterial].Jij_matrix[jmaterial];
+				}
+			}
+			// set interaction id to material pair of atoms i and j
 			for(int atom=0;atom<atoms::num_atoms;atom++){
 				const int imaterial=atoms::type_array[atom];
 				for(int nn=atoms::neighbour_list_start_index[atom];nn<=atoms::neighbour_list_end_index[atom];nn++){
 					const int natom = atoms::neighbour_list_array[nn];
 					const int jmaterial=atoms::type_array[natom];
-					atoms::i_exchange_list.push_back(tmp_zval);
-					atoms::i_exchange_list[nn].Jij=mp::material[imaterial].Jij_matrix[jmaterial];
-					// reset interation id to neighbour number - causes segfault if nn out of range
-					atoms::neighbour_interaction_type_array[nn]=nn;
+					atoms::neighbour_interaction_type_array[nn]=imaterial*mp::num_materials+jmaterial;
 				}
 			}
 			// now set exchange type to normal isotropic case
@@ -333,16 +336,16 @@ int set_atom_vars(std::vector<cs::catom_t> & catom_array, std::vector<std::vecto
    for(int atom=0;atom<atoms::num_atoms;atom++){
 
       // set all interactions for atom as non-nearest neighbour by default
-      nearest_neighbour_interactions_list[atom].resize(cneighbourlist[atom].size(),false);
+      nearest_neighbour_interactions_list[atom].resize(cneighbourlist.size(atom),false);
 
       // counter for number of nearest neighbour interactions
       int num_nn=0;
 
       // loop over all interactions for atom
-      for(unsigned int nn=0;nn<cneighbourlist[atom].size();nn++){
+      for(int nn=0;nn<cneighbourlist.size(atom);nn++){
 
          // get interaction type (same as unit cell interaction id)
-         int id = cneighbourlist[atom][nn].i;
+         int id = cneighbourlist.i[cneighbourlist.start[atom]+nn];
 
          // Ensure valid interaction id
          if(id>nn_interaction.size()){
@@ -377,7 +380,7 @@ int set_atom_vars(std::vector<cs::catom_t> & catom_array, std::vector<std::vecto
          int nnn_int=0;
 
          // Loop over all interactions to determine number of nearest neighbour interactions
-         for(unsigned int nn=0;nn<cneighbourlist[atom].size();nn++){
+         for(int nn=0;nn<cneighbourlist.size(atom);nn++){
 
             // If interaction is nn, increment counter
             if(nearest_neighbour_interactions_list[atom][nn]) nnn_int++;
@@ -428,16 +431,19 @@ int set_atom_vars(std::vector<cs::catom_t> & catom_array, std::vector<std::vecto
             atoms::nearest_neighbour_list_si[atom]=counter;
 
             // loop over all neighbours
-            for(unsigned int nn=0;nn<cneighbourlist[atom].size();nn++){
+            for(int nn=0;nn<cneighbourlist.size(atom);nn++){
 
                // only add nearest neighbours to list
                if(nearest_neighbour_interactions_list[atom][nn]==true){
 
+                  // index in compressed neighbour list
+                  const int index=cneighbourlist.start[atom]+nn;
+
                   // add interaction to 1D list
-                  atoms::nearest_neighbour_list.push_back(cneighbourlist[atom][nn].nn);
+                  atoms::nearest_neighbour_list.push_back(atoms::neighbour_list_array[index]);
 
                   // get atomic position vector i->j
-                  double eij[3]={cneighbourlist[atom][nn].vx,cneighbourlist[atom][nn].vy,cneighbourlist[atom][nn].vz};
+                  double eij[3]={cneighbourlist.vx[index],cneighbourlist.vy[index],cneighbourlist.vz[index]};
 
                   // normalise to unit vector
                   double invrij=1.0/sqrt(eij[0]*eij[0]+eij[1]*eij[1]+eij[2]*eij[2]);
@@ -466,6 +472,9 @@ int set_atom_vars(std::vector<cs::catom_t> & catom_array, std::vector<std::vecto
    } // end of surface anisotropy initialisation
    //-------------------------------------------------------------------------------------------------------------
 
+   // Optionally map atoms onto grid for stencil exchange calculation
+   if(atoms::stencil_exchange) cs::create_stencil_exchange(catom_array, cneighbourlist);
+
    // now remove unit cell interactions data
    unit_cell.interaction.resize(0);
 
@@ -476,9 +485,9 @@ int set_atom_vars(std::vector<cs::catom_t> & catom_array, std::vector<std::vecto
 
    // Now nuke generation vectors to free memory NOW
    std::vector<cs::catom_t> zerov;
-   std::vector<std::vector <neighbour_t> > zerovv;
+   cs::neighbour_list_t zeronl;
    catom_array.swap(zerov);
-   cneighbourlist.swap(zerovv);
+   std::swap(cneighbourlist,zeronl);
 
    return EXIT_SUCCESS;
 
@@ -0,0 +1,217 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+//
+//    Stencil exchange setup. With sim:enable-stencil-exchange, atoms are
+//    mapped onto a padded grid of unit cells for each unit cell atom, and
+//    the unit cell interaction template is stored as constant offsets on
+//    the grid, so that exchange fields and energies are calculated without
+//    an explicit neighbour list. The padding is wide enough for the longest
+//    interaction range. In serial, padding cells in periodic directions map
+//    to the atoms on the opposite side of the system. In parallel, halo atoms
+//    lie on the grid at their own (offset) unit cell coordinates. Exchange
+//    defined by material is supported where each interaction of the template
+//    has the same exchange constant for all atoms.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+// Vampire headers
+#include "atoms.hpp"
+#include "create.hpp"
+#include "errors.hpp"
+#include "sim.hpp"
+#include "vio.hpp"
+#include "vmpi.hpp"
+
+namespace cs{
+
+void create_stencil_exchange(const std::vector<cs::catom_t> & catom_array, const cs::neighbour_list_t & cneighbourlist){
+
+	// check calling of routine if error checking is activated
+	if(err::check==true){std::cout << "cs::create_stencil_exchange has been called" << std::endl;}
+
+	// Stencil exchange is only implemented for isotropic exchange
+	if(cs::unit_cell.exchange_type!=0 && cs::unit_cell.exchange_type!=-1){
+		zlog << zTs() << "Warning: Stencil exchange is only available for isotropic exchange and has been disabled." << std::endl;
+		atoms::stencil_exchange=false;
+		return;
+	}
+
+	const int num_atoms = catom_array.size();
+	const int num_sublattices = cs::unit_cell.atom.size();
+	const int num_interactions = cs::unit_cell.interaction.size();
+
+	// Determine exchange constant of each template interaction
+	std::vector<double> Jij(num_interactions,0.0);
+	if(cs::unit_cell.exchange_type==0){
+		for(int i=0;i<num_interactions;i++) Jij[i]=atoms::i_exchange_list[i].Jij;
+	}
+	else{
+		// material pair exchange must be the same for all neighbours of an interaction
+		std::vector<bool> set(num_interactions,false);
+		for(int nn=0;nn<cneighbourlist.start[num_atoms];nn++){
+			const int i=cneighbourlist.i[nn];
+			const double J=atoms::i_exchange_list[atoms::neighbour_interaction_type_array[nn]].Jij;
+			if(set[i]==false){
+				Jij[i]=J;
+				set[i]=true;
+			}
+			else if(Jij[i]!=J){
+				zlog << zTs() << "Warning: Stencil exchange requires the same exchange constant for all equivalent neighbours and has been disabled." << std::endl;
+				atoms::stencil_exchange=false;
+				return;
+			}
+		}
+	}
+
+	// Determine range of unit cells occupied by atoms
+	int min[3]={std::numeric_limits<int>::max(),std::numeric_limits<int>::max(),std::numeric_limits<int>::max()};
+	int max[3]={std::numeric_limits<int>::min(),std::numeric_limits<int>::min(),std::numeric_limits<int>::min()};
+	for(int atom=0;atom<num_atoms;atom++){
+		const int c[3]={catom_array[atom].scx,catom_array[atom].scy,catom_array[atom].scz};
+		for(int i=0;i<3;i++){
+			if(c[i]<min[i]) min[i]=c[i];
+			if(c[i]>max[i]) max[i]=c[i];
+		}
+	}
+	if(num_atoms==0){
+		for(int i=0;i<3;i++){ min[i]=0; max[i]=-1; }
+	}
+
+	// Determine padding from longest interaction range
+	int pad=0;
+	for(int i=0;i<num_interactions;i++){
+		pad=std::max(pad,std::abs(cs::unit_cell.interaction[i].dx));
+		pad=std::max(pad,std::abs(cs::unit_cell.interaction[i].dy));
+		pad=std::max(pad,std::abs(cs::unit_cell.interaction[i].dz));
+	}
+
+	// Calculate grid dimensions
+	const int n[3]={max[0]-min[0]+1, max[1]-min[1]+1, max[2]-min[2]+1};
+	const int g[3]={n[0]+2*pad, n[1]+2*pad, n[2]+2*pad};
+	const double num_sites = double(g[0])*double(g[1])*double(g[2])*double(num_sublattices);
+	if(num_sites > double(std::numeric_limits<int>::max())){
+		zlog << zTs() << "Warning: Stencil exchange grid of " << num_sites << " sites is too large and stencil exchange has been disabled." << std::endl;
+		atoms::stencil_exchange=false;
+		return;
+	}
+	const int grid_size=g[0]*g[1]*g[2];
+
+	atoms::stencil_num_sublattices=num_sublattices;
+	atoms::stencil_padding=pad;
+	atoms::stencil_grid_size=grid_size;
+	for(int i=0;i<3;i++) atoms::stencil_dimensions[i]=g[i];
+
+	// Map atoms onto grid
+	atoms::stencil_atom_array.assign(size_t(num_sublattices)*size_t(grid_size),-1);
+	atoms::stencil_site_array.resize(num_atoms);
+	for(int atom=0;atom<num_atoms;atom++){
+		const int x=catom_array[atom].scx-min[0]+pad;
+		const int y=catom_array[atom].scy-min[1]+pad;
+		const int z=catom_array[atom].scz-min[2]+pad;
+		const int site=catom_array[atom].uc_id*grid_size+(z*g[1]+y)*g[0]+x;
+		atoms::stencil_atom_array[site]=atom;
+		atoms::stencil_site_array[atom]=site;
+	}
+
+	#ifndef MPICF
+	// Map padding cells onto periodic images of the system
+	if(cs::pbc[0] || cs::pbc[1] || cs::pbc[2]){
+		for(int z=0;z<g[2];z++){
+			for(int y=0;y<g[1];y++){
+				for(int x=0;x<g[0];x++){
+					int c[3]={x-pad,y-pad,z-pad};
+					// skip cells inside system
+					if(c[0]>=0 && c[0]<n[0] && c[1]>=0 && c[1]<n[1] && c[2]>=0 && c[2]<n[2]) continue;
+					for(int i=0;i<3;i++){
+						if(cs::pbc[i]==true){
+							if(c[i]>=n[i]) c[i]-=n[i];
+							else if(c[i]<0) c[i]+=n[i];
+						}
+					}
+					// skip cells outside system after wrapping
+					if(c[0]<0 || c[0]>=n[0] || c[1]<0 || c[1]>=n[1] || c[2]<0 || c[2]>=n[2]) continue;
+					const int cell=(z*g[1]+y)*g[0]+x;
+					const int image=((c[2]+pad)*g[1]+(c[1]+pad))*g[0]+(c[0]+pad);
+					for(int s=0;s<num_sublattices;s++){
+						atoms::stencil_atom_array[s*grid_size+cell]=atoms::stencil_atom_array[s*grid_size+image];
+					}
+				}
+			}
+		}
+	}
+	#endif
+
+	// Group interactions by sublattice of atom i, keeping order of unit cell template
+	atoms::stencil_interaction_start_index.assign(num_sublattices+1,0);
+	for(int i=0;i<num_interactions;i++) atoms::stencil_interaction_start_index[cs::unit_cell.interaction[i].i+1]++;
+	for(int s=0;s<num_sublattices;s++) atoms::stencil_interaction_start_index[s+1]+=atoms::stencil_interaction_start_index[s];
+
+	atoms::stencil_interaction_sublattice_array.resize(num_interactions);
+	atoms::stencil_interaction_offset_array.resize(num_interactions);
+	atoms::stencil_interaction_Jij_array.resize(num_interactions);
+	std::vector<int> counter(atoms::stencil_interaction_start_index.begin(),atoms::stencil_interaction_start_index.end()-1);
+	for(int i=0;i<num_interactions;i++){
+		const cs::unit_cell_interaction_t& interaction=cs::unit_cell.interaction[i];
+		const int index=counter[interaction.i]++;
+		atoms::stencil_interaction_sublattice_array[index]=interaction.j;
+		atoms::stencil_interaction_offset_array[index]=(interaction.dz*g[1]+interaction.dy)*g[0]+interaction.dx;
+		atoms::stencil_interaction_Jij_array[index]=Jij[i];
+	}
+
+	zlog << zTs() << "Stencil exchange grid on rank " << vmpi::my_rank << " of " << g[0] << " x " << g[1] << " x " << g[2] << " unit cells with "
+	     << num_sublattices << " sublattices requires " << num_sites*(double(sizeof(int))+6.0*double(sizeof(double)))/1.0e6 << " MB RAM" << std::endl;
+
+	// Packed exchange layout is superseded by stencil exchange
+	if(atoms::packed_exchange){
+		zlog << zTs() << "Warning: Packed exchange layout is superseded by stencil exchange and has been disabled." << std::endl;
+		atoms::packed_exchange=false;
+	}
+
+	// allocate work arrays for stencil exchange
+	sim::initialise_stencil_exchange();
+
+	return;
+
+}
+
+//-----------------------------------------------------------------------------
+// Function to release explicit neighbour list for stencil exchange, unless
+// needed by Monte Carlo integrators. This is called after the system image
+// is saved, so that images are independent of the integrator.
+//-----------------------------------------------------------------------------
+void release_neighbour_list(){
+
+	// coloured Monte Carlo integrators build their colouring from the explicit list
+	bool list_required = sim::incremental_mc || sim::parallel_cmc || sim::integrator==sim::parallel_monte_carlo;
+	#ifdef MPICF
+		// in parallel the Monte Carlo and constrained Monte Carlo integrators are always coloured
+		if(sim::integrator==sim::monte_carlo || sim::integrator==sim::constrained_monte_carlo ||
+		   sim::integrator==sim::hybrid_constrained_monte_carlo) list_required=true;
+	#endif
+
+	if(!list_required){
+		zlog << zTs() << "Releasing " << double(atoms::neighbour_list_array.size())*2.0*double(sizeof(int))/1.0e6 << " MB of explicit neighbour list for stencil exchange" << std::endl;
+		std::vector<int>().swap(atoms::neighbour_list_array);
+		std::vector<int>().swap(atoms::neighbour_interaction_type_array);
+		atoms::neighbour_list_start_index.assign(atoms::num_atoms,0);
+		atoms::neighbour_list_end_index.assign(atoms::num_atoms,-1);
+	}
+
+	return;
+
+}
+
+} // end of namespace cs
@@ -0,0 +1,451 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+//
+//    Cached system image. With create:system-image the generated system
+//    (atomic data, neighbour and exchange lists, surface data, parallel
+//    communication data and the fast demag dipole tensor) is saved after
+//    creation to a binary image file, which later runs read directly into
+//    the system arrays to skip system generation entirely.
+//
+//    Images are keyed by a hash of all input file lines which may affect
+//    creation, all material file lines, and the simulation variables used
+//    during creation. Lines of the sim, output, screen, config and grain
+//    sections of the input file are excluded, so that parameter studies
+//    varying temperature, field or integrator reuse the same image. The
+//    image always holds the full neighbour list, which is released after
+//    loading if it is not needed by the integrator. Each processor
+//    writes its own image, which is only valid for the same number of
+//    processors.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Vampire headers
+#include "atoms.hpp"
+#include "cells.hpp"
+#include "create.hpp"
+#include "demag.hpp"
+#include "errors.hpp"
+#include "grains.hpp"
+#include "sim.hpp"
+#include "vio.hpp"
+#include "vmpi.hpp"
+
+namespace cs{
+
+namespace image{
+
+   bool enabled=false;
+
+   namespace internal{
+
+      const uint32_t version=5;
+
+      uint64_t input_hash=14695981039346656037ULL; /// hash of input and material file lines
+      uint64_t key=0; /// hash of all data affecting system generation
+
+      //-----------------------------------------------------------------------
+      // Function to add data to 64-bit FNV-1a hash
+      //-----------------------------------------------------------------------
+      void hash(uint64_t& h, const void* data, const size_t size){
+         const unsigned char* bytes = static_cast<const unsigned char*>(data);
+         for(size_t i=0; i<size; i++){
+            h ^= uint64_t(bytes[i]);
+            h *= 1099511628211ULL;
+         }
+      }
+
+      template <typename T> void hash_value(uint64_t& h, const T value){
+         hash(h, &value, sizeof(T));
+      }
+
+      //-----------------------------------------------------------------------
+      // Function to determine image file name of local processor
+      //-----------------------------------------------------------------------
+      std::string filename(){
+         std::stringstream ss;
+         ss << "vampire-system-" << std::hex << std::setfill('0') << std::setw(16) << key << std::dec;
+         #ifdef MPICF
+            ss << "-" << std::setfill('0') << std::setw(5) << vmpi::my_rank;
+         #endif
+         ss << ".img";
+         return ss.str();
+      }
+
+      //-----------------------------------------------------------------------
+      // Functions to write vector as element count, element size and data,
+      // padded to 8 bytes
+      //-----------------------------------------------------------------------
+      template <typename T> void write(std::ofstream& ofile, const std::vector<T>& data){
+         const uint64_t header[2] = {data.size(), sizeof(T)};
+         ofile.write(reinterpret_cast<const char*>(header), sizeof(header));
+         const size_t size = data.size()*sizeof(T);
+         if(size>0) ofile.write(reinterpret_cast<const char*>(&data[0]), size);
+         const char padding[8] = {0,0,0,0,0,0,0,0};
+         ofile.write(padding, (8-size%8)%8);
+      }
+
+      void write(std::ofstream& ofile, const std::vector<bool>& data){
+         std::vector<char> chars(data.begin(), data.end());
+         write(ofile, chars);
+      }
+
+      //-----------------------------------------------------------------------
+      // Class to read vectors sequentially from image file directly into
+      // their final storage
+      //-----------------------------------------------------------------------
+      class reader_t{
+      public:
+         std::ifstream& ifile;
+         uint64_t size;
+         uint64_t position;
+         bool ok;
+
+         reader_t(std::ifstream& in_ifile, const uint64_t in_size):
+            ifile(in_ifile), size(in_size), position(0), ok(true){}
+
+         template <typename T> void read(std::vector<T>& values){
+            uint64_t header[2] = {0,0};
+            if(!ok || position+sizeof(header)>size){ ok=false; return; }
+            ifile.read(reinterpret_cast<char*>(header), sizeof(header));
+            position+=sizeof(header);
+            const uint64_t bytes = header[0]*header[1];
+            if(header[1]!=sizeof(T) || position+bytes>size){ ok=false; return; }
+            values.resize(header[0]);
+            if(bytes>0) ifile.read(reinterpret_cast<char*>(&values[0]), bytes);
+            const uint64_t padding = (8-bytes%8)%8;
+            ifile.seekg(padding, std::ios::cur);
+            position+=bytes+padding;
+            if(!ifile.good()) ok=false;
+         }
+
+         void read(std::vector<bool>& values){
+            std::vector<char> chars;
+            read(chars);
+            values.assign(chars.begin(), chars.end());
+         }
+      };
+
+      //-----------------------------------------------------------------------
+      // Function to set variables of generated system from image
+      //-----------------------------------------------------------------------
+      bool unpack(reader_t& image){
+
+         std::vector<char> magic;
+         std::vector<uint64_t> header;
+         image.read(magic);
+         image.read(header);
+         if(!image.ok || magic.size()!=8 || std::string(&magic[0],8)!="VAMPSYS1") return false;
+         if(header.size()!=2 || header[0]!=version || header[1]!=key) return false;
+
+         std::vector<int64_t> scalars;
+         image.read(scalars);
+         if(!image.ok || scalars.size()!=20) return false;
+
+         atoms::num_atoms = scalars[0];
+         atoms::num_neighbours = scalars[1];
+         atoms::total_num_neighbours = scalars[2];
+         atoms::exchange_type = scalars[3];
+         cells::num_atoms_in_unit_cell = scalars[4];
+         sim::surface_anisotropy_threshold = scalars[5];
+         grains::num_grains = scalars[6];
+         cs::local_num_unit_cells[0] = scalars[7];
+         cs::local_num_unit_cells[1] = scalars[8];
+         cs::local_num_unit_cells[2] = scalars[9];
+         vmpi::num_core_atoms = scalars[10];
+         vmpi::num_bdry_atoms = scalars[11];
+         vmpi::num_halo_atoms = scalars[12];
+         atoms::stencil_exchange = scalars[13];
+         atoms::stencil_num_sublattices = scalars[14];
+         atoms::stencil_dimensions[0] = scalars[15];
+         atoms::stencil_dimensions[1] = scalars[16];
+         atoms::stencil_dimensions[2] = scalars[17];
+         atoms::stencil_padding = scalars[18];
+         atoms::stencil_grid_size = scalars[19];
+
+         image.read(atoms::x_coord_array);
+         image.read(atoms::y_coord_array);
+         image.read(atoms::z_coord_array);
+         image.read(atoms::type_array);
+         image.read(atoms::category_array);
+         image.read(atoms::grain_array);
+         image.read(atoms::global_id_array);
+         image.read(atoms::x_spin_array);
+         image.read(atoms::y_spin_array);
+         image.read(atoms::z_spin_array);
+         image.read(atoms::m_spin_array);
+         image.read(cs::sfc::output_order);
+
+         image.read(atoms::neighbour_list_array);
+         image.read(atoms::neighbour_interaction_type_array);
+         image.read(atoms::neighbour_list_start_index);
+         image.read(atoms::neighbour_list_end_index);
+         image.read(atoms::i_exchange_list);
+         image.read(atoms::v_exchange_list);
+         image.read(atoms::t_exchange_list);
+
+         image.read(atoms::surface_array);
+         image.read(atoms::nearest_neighbour_list);
+         image.read(atoms::nearest_neighbour_list_si);
+         image.read(atoms::nearest_neighbour_list_ei);
+         image.read(atoms::eijx);
+         image.read(atoms::eijy);
+         image.read(atoms::eijz);
+
+         image.read(atoms::stencil_atom_array);
+         image.read(atoms::stencil_site_array);
+         image.read(atoms::stencil_interaction_start_index);
+         image.read(atoms::stencil_interaction_sublattice_array);
+         image.read(atoms::stencil_interaction_offset_array);
+         image.read(atoms::stencil_interaction_Jij_array);
+
+         image.read(vmpi::send_atom_translation_array);
+         image.read(vmpi::send_start_index_array);
+         image.read(vmpi::send_num_array);
+         image.read(vmpi::recv_atom_translation_array);
+         image.read(vmpi::recv_start_index_array);
+         image.read(vmpi::recv_num_array);
+
+         // dipole tensor for fast demag [local cell][cell]
+         std::vector<uint64_t> demag_size;
+         image.read(demag_size);
+         if(!image.ok || demag_size.size()!=2) return false;
+         std::vector<std::vector<double> >* rij[6] = {&demag::rij_xx, &demag::rij_xy, &demag::rij_xz, &demag::rij_yy, &demag::rij_yz, &demag::rij_zz};
+         for(int c=0; c<6; c++){
+            rij[c]->resize(demag_size[0]);
+            for(uint64_t lc=0; lc<demag_size[0]; lc++) image.read((*rij[c])[lc]);
+         }
+
+         return image.ok && image.position==image.size;
+
+      }
+
+   } // end of namespace internal
+
+   //--------------------------------------------------------------------------
+   // Function to add line of input or material file to image key
+   //--------------------------------------------------------------------------
+   void add_to_key(const std::string& line){
+      internal::hash(internal::input_hash, line.c_str(), line.size());
+      internal::hash_value<char>(internal::input_hash, '\n');
+   }
+
+   //--------------------------------------------------------------------------
+   // Function to load generated system from image, returning true if
+   // system generation can be skipped
+   //--------------------------------------------------------------------------
+   bool load(){
+
+      if(!enabled) return false;
+
+      // complete key with simulation variables used during system generation
+      using internal::hash_value;
+      uint64_t key = internal::input_hash;
+      hash_value<uint32_t>(key, internal::version);
+      hash_value<uint64_t>(key, sizeof(zval_t));
+      hash_value<uint64_t>(key, sizeof(zvec_t));
+      hash_value<uint64_t>(key, sizeof(zten_t));
+      hash_value<bool>(key, sim::surface_anisotropy);
+      hash_value<bool>(key, atoms::stencil_exchange);
+      hash_value<unsigned int>(key, sim::surface_anisotropy_threshold);
+      hash_value<bool>(key, sim::NativeSurfaceAnisotropyThreshold);
+      hash_value<double>(key, sim::nearest_neighbour_distance);
+      hash_value<int>(key, sim::hamiltonian_simulation_flags[4]);
+      hash_value<bool>(key, demag::fast);
+      hash_value<bool>(key, demag::fft);
+      hash_value<bool>(key, demag::compressed);
+      hash_value<int>(key, vmpi::num_processors);
+      hash_value<int>(key, vmpi::mpi_mode);
+      internal::key = key;
+
+      const std::string filename = internal::filename();
+
+      bool loaded=false;
+
+      // read image file
+      std::ifstream ifile(filename.c_str(), std::ios::binary);
+      if(ifile.is_open()){
+         ifile.seekg(0, std::ios::end);
+         const std::streamoff size = ifile.tellg();
+         ifile.seekg(0, std::ios::beg);
+         if(size>0){
+            internal::reader_t image(ifile, uint64_t(size));
+            loaded = internal::unpack(image);
+         }
+         ifile.close();
+      }
+
+      // all processors must load their image
+      #ifdef MPICF
+         int all_loaded = loaded;
+         MPI_Allreduce(MPI_IN_PLACE, &all_loaded, 1, MPI_INT, MPI_MIN, vmpi::comm);
+         loaded = all_loaded;
+      #endif
+
+      if(!loaded){
+         zlog << zTs() << "No valid system image " << filename << " found, generating system." << std::endl;
+         // discard any partially loaded dipole tensor
+         demag::rij_xx.resize(0); demag::rij_xy.resize(0); demag::rij_xz.resize(0);
+         demag::rij_yy.resize(0); demag::rij_yz.resize(0); demag::rij_zz.resize(0);
+         return false;
+      }
+
+      // allocate remaining atomic arrays
+      atoms::cell_array.resize(atoms::num_atoms,0);
+      atoms::x_total_spin_field_array.resize(atoms::num_atoms,0.0);
+      atoms::y_total_spin_field_array.resize(atoms::num_atoms,0.0);
+      atoms::z_total_spin_field_array.resize(atoms::num_atoms,0.0);
+      atoms::x_total_external_field_array.resize(atoms::num_atoms,0.0);
+      atoms::y_total_external_field_array.resize(atoms::num_atoms,0.0);
+      atoms::z_total_external_field_array.resize(atoms::num_atoms,0.0);
+      atoms::x_dipolar_field_array.resize(atoms::num_atoms,0.0);
+      atoms::y_dipolar_field_array.resize(atoms::num_atoms,0.0);
+      atoms::z_dipolar_field_array.resize(atoms::num_atoms,0.0);
+      vmpi::send_spin_data_array.resize(3*vmpi::send_atom_translation_array.size());
+      vmpi::recv_spin_data_array.resize(3*vmpi::recv_atom_translation_array.size());
+
+      // allocate work arrays for stencil exchange
+      if(atoms::stencil_exchange) sim::initialise_stencil_exchange();
+
+      // unit cell data is no longer needed, as after system generation
+      cs::unit_cell.interaction.resize(0);
+      cs::unit_cell.atom.resize(0);
+
+      std::cout << "Loaded system from image " << filename << std::endl;
+      zlog << zTs() << "Loaded system from image " << filename << " with " << atoms::num_atoms << " atoms." << std::endl;
+
+      return true;
+
+   }
+
+   //--------------------------------------------------------------------------
+   // Function to save generated system to image
+   //--------------------------------------------------------------------------
+   void save(){
+
+      if(!enabled) return;
+
+      // replicas of a statistically parallel simulation share images
+      if(vmpi::replica_id!=0) return;
+
+      const std::string filename = internal::filename();
+
+      std::ofstream ofile(filename.c_str(), std::ios::binary | std::ios::trunc);
+      if(!ofile.is_open()){
+         terminaltextcolor(RED);
+         std::cerr << "Warning: Unable to open system image file " << filename << " for writing." << std::endl;
+         terminaltextcolor(WHITE);
+         zlog << zTs() << "Warning: Unable to open system image file " << filename << " for writing." << std::endl;
+         return;
+      }
+
+      using internal::write;
+
+      const char magic[8] = {'V','A','M','P','S','Y','S','1'};
+      write(ofile, std::vector<char>(magic, magic+8));
+      std::vector<uint64_t> header(2);
+      header[0] = internal::version;
+      header[1] = internal::key;
+      write(ofile, header);
+
+      std::vector<int64_t> scalars(20);
+      scalars[0] = atoms::num_atoms;
+      scalars[1] = atoms::num_neighbours;
+      scalars[2] = atoms::total_num_neighbours;
+      scalars[3] = atoms::exchange_type;
+      scalars[4] = cells::num_atoms_in_unit_cell;
+      scalars[5] = sim::surface_anisotropy_threshold;
+      scalars[6] = grains::num_grains;
+      scalars[7] = cs::local_num_unit_cells[0];
+      scalars[8] = cs::local_num_unit_cells[1];
+      scalars[9] = cs::local_num_unit_cells[2];
+      scalars[10] = vmpi::num_core_atoms;
+      scalars[11] = vmpi::num_bdry_atoms;
+      scalars[12] = vmpi::num_halo_atoms;
+      scalars[13] = atoms::stencil_exchange;
+      scalars[14] = atoms::stencil_num_sublattices;
+      scalars[15] = atoms::stencil_dimensions[0];
+      scalars[16] = atoms::stencil_dimensions[1];
+      scalars[17] = atoms::stencil_dimensions[2];
+      scalars[18] = atoms::stencil_padding;
+      scalars[19] = atoms::stencil_grid_size;
+      write(ofile, scalars);
+
+      write(ofile, atoms::x_coord_array);
+      write(ofile, atoms::y_coord_array);
+      write(ofile, atoms::z_coord_array);
+      write(ofile, atoms::type_array);
+      write(ofile, atoms::category_array);
+      write(ofile, atoms::grain_array);
+      write(ofile, atoms::global_id_array);
+      write(ofile, atoms::x_spin_array);
+      write(ofile, atoms::y_spin_array);
+      write(ofile, atoms::z_spin_array);
+      write(ofile, atoms::m_spin_array);
+      write(ofile, cs::sfc::output_order);
+
+      write(ofile, atoms::neighbour_list_array);
+      write(ofile, atoms::neighbour_interaction_type_array);
+      write(ofile, atoms::neighbour_list_start_index);
+      write(ofile, atoms::neighbour_list_end_index);
+      write(ofile, atoms::i_exchange_list);
+      write(ofile, atoms::v_exchange_list);
+      write(ofile, atoms::t_exchange_list);
+
+      write(ofile, atoms::surface_array);
+      write(ofile, atoms::nearest_neighbour_list);
+      write(ofile, atoms::nearest_neighbour_list_si);
+      write(ofile, atoms::nearest_neighbour_list_ei);
+      write(ofile, atoms::eijx);
+      write(ofile, atoms::eijy);
+      write(ofile, atoms::eijz);
+
+      write(ofile, atoms::stencil_atom_array);
+      write(ofile, atoms::stencil_site_array);
+      write(ofile, atoms::stencil_interaction_start_index);
+      write(ofile, atoms::stencil_interaction_sublattice_array);
+      write(ofile, atoms::stencil_interaction_offset_array);
+      write(ofile, atoms::stencil_interaction_Jij_array);
+
+      write(ofile, vmpi::send_atom_translation_array);
+      write(ofile, vmpi::send_start_index_array);
+      write(ofile, vmpi::send_num_array);
+      write(ofile, vmpi::recv_atom_translation_array);
+      write(ofile, vmpi::recv_start_index_array);
+      write(ofile, vmpi::recv_num_array);
+
+      // dipole tensor for fast demag [local cell][cell]
+      std::vector<uint64_t> demag_size(2,0);
+      demag_size[0] = demag::rij_xx.size();
+      demag_size[1] = cells::num_cells;
+      write(ofile, demag_size);
+      const std::vector<std::vector<double> >* rij[6] = {&demag::rij_xx, &demag::rij_xy, &demag::rij_xz, &demag::rij_yy, &demag::rij_yz, &demag::rij_zz};
+      for(int c=0; c<6; c++){
+         for(uint64_t lc=0; lc<demag_size[0]; lc++) write(ofile, (*rij[c])[lc]);
+      }
+
+      ofile.close();
+
+      zlog << zTs() << "Saved system image " << filename << std::endl;
+
+      return;
+
+   }
+
+} // end of namespace image
+
+} // end of namespace cs
@@ -24,6 +24,7 @@
 //
 #include "atoms.hpp"
 
+#include <cstddef>
 #include <vector>
 
 //==========================================================
@@ -52,6 +53,7 @@ namespace atoms{
 	std::vector <int> category_array(0);
 	std::vector <int> grain_array(0);
 	std::vector <int> cell_array(0);
+	std::vector <uint64_t> global_id_array(0);
 
 	std::vector <double> x_spin_array(0);
 	std::vector <double> y_spin_array(0);
@@ -71,6 +73,28 @@ namespace atoms{
 	std::vector <zval_t> i_exchange_list(0);
 	std::vector <zvec_t> v_exchange_list(0);
 	std::vector <zten_t> t_exchange_list(0);
+
+	// packed exchange layout
+	bool packed_exchange=false;
+	int ell_width=0;
+	int ell_stride=0;
+	std::vector <int> ell_neighbour_array(0);
+	std::vector <packed_real_t> ell_exchange_array(0);
+	packed_real_t* packed_spin_array=NULL;
+	bool packed_spins_current=false;
+
+	// stencil exchange layout
+	bool stencil_exchange=false;
+	int stencil_num_sublattices=0;
+	int stencil_dimensions[3]={0,0,0};
+	int stencil_padding=0;
+	int stencil_grid_size=0;
+	std::vector <int> stencil_atom_array(0);
+	std::vector <int> stencil_site_array(0);
+	std::vector <int> stencil_interaction_start_index(0);
+	std::vector <int> stencil_interaction_sublattice_array(0);
+	std::vector <int> stencil_interaction_offset_array(0);
+	std::vector <double> stencil_interaction_Jij_array(0);
 	
 	// surface anisotropy
 	std::vector<bool> surface_array(0);
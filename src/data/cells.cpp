@@ -52,6 +52,7 @@
 #include "vio.hpp"
 
 // System header files
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
@@ -60,6 +61,9 @@ namespace cells{
 	
 	int num_cells=0;
 	int num_local_cells=0;
+	int num_cells_x=0;
+	int num_cells_y=0;
+	int num_cells_z=0;
    int num_atoms_in_unit_cell=0;
 	double size=7.0; // Angstroms
 
@@ -81,6 +85,14 @@ namespace cells{
 	std::vector <double> z_field_array;
 
    std::vector <double> volume_array;
+
+	namespace internal{
+		std::vector <int> local_cell_index;    /// local cell of each local atom
+		std::vector <int> occupied_cells;      /// cells containing atoms on any processor
+		std::vector <double> local_mag_array;  /// partial moments of local cells [local cell][3]
+		std::vector <double> occupied_mag_array; /// total moments of occupied cells [cell][3]
+		vmpi::sparse_sum_t mag_sum;            /// summation of cell moments over processors
+	}
 	
 /// @brief Cell initialiser function
 ///
@@ -119,6 +131,9 @@ namespace cells{
 		
 		//update total number of cells
 		cells::num_cells=ncellx*ncelly*ncellz;
+		cells::num_cells_x=ncellx;
+		cells::num_cells_y=ncelly;
+		cells::num_cells_z=ncellz;
 		
 		zlog << zTs() << "Macrocells in x,y,z: " << ncellx << "\t" << ncelly << "\t" << ncellz << std::endl;
 		zlog << zTs() << "Total number of macrocells: " << cells::num_cells << std::endl;
@@ -231,7 +246,7 @@ namespace cells{
 		for(int atom=0;atom<num_local_atoms;atom++){
 			int local_cell=atoms::cell_array[atom];
          int type = atoms::type_array[atom];
-         const double mus = mp::material[type].mu_s_SI;
+         const double mus = mp::material_hot_params[type].mu_s_SI;
 			cells::x_coord_array[local_cell]+=atoms::x_coord_array[atom]*mus;
 			cells::y_coord_array[local_cell]+=atoms::y_coord_array[atom]*mus;
 			cells::z_coord_array[local_cell]+=atoms::z_coord_array[atom]*mus;
@@ -241,11 +256,11 @@ namespace cells{
 
 		// For MPI sum coordinates from all CPUs
 		#ifdef MPICF
-			MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&cells::num_atoms_in_cell[0],cells::num_cells,MPI_INT,MPI_SUM);
-			MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&cells::x_coord_array[0],cells::num_cells,MPI_DOUBLE,MPI_SUM);
-			MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&cells::y_coord_array[0],cells::num_cells,MPI_DOUBLE,MPI_SUM);
-			MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&cells::z_coord_array[0],cells::num_cells,MPI_DOUBLE,MPI_SUM);
-         MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&total_moment_array[0],cells::num_cells,MPI_DOUBLE,MPI_SUM);
+			vmpi::comm.Allreduce(MPI_IN_PLACE,&cells::num_atoms_in_cell[0],cells::num_cells,MPI_INT,MPI_SUM);
+			vmpi::comm.Allreduce(MPI_IN_PLACE,&cells::x_coord_array[0],cells::num_cells,MPI_DOUBLE,MPI_SUM);
+			vmpi::comm.Allreduce(MPI_IN_PLACE,&cells::y_coord_array[0],cells::num_cells,MPI_DOUBLE,MPI_SUM);
+			vmpi::comm.Allreduce(MPI_IN_PLACE,&cells::z_coord_array[0],cells::num_cells,MPI_DOUBLE,MPI_SUM);
+         vmpi::comm.Allreduce(MPI_IN_PLACE,&total_moment_array[0],cells::num_cells,MPI_DOUBLE,MPI_SUM);
       #endif
 		
 		//if(vmpi::my_rank==0){
@@ -292,6 +307,22 @@ namespace cells{
 		}
 		
 		zlog << zTs() << "Number of local macrocells on rank " << vmpi::my_rank << ": " << cells::num_local_cells << std::endl;
+
+		// Set up summation of moments of local cells over processors
+		#ifdef MPICF
+			std::vector<int> local_cell(cells::num_cells,-1);
+			for(int lc=0;lc<cells::num_local_cells;lc++) local_cell[cells::local_cell_array[lc]]=lc;
+			internal::local_cell_index.resize(num_local_atoms);
+			for(int atom=0;atom<num_local_atoms;atom++) internal::local_cell_index[atom]=local_cell[atoms::cell_array[atom]];
+
+			internal::occupied_cells.resize(0);
+			for(int cell=0;cell<cells::num_cells;cell++){
+				if(cells::volume_array[cell]>0.0) internal::occupied_cells.push_back(cell);
+			}
+
+			internal::local_mag_array.resize(3*cells::num_local_cells);
+			internal::mag_sum.initialise(cells::local_cell_array, internal::occupied_cells, cells::num_cells, 3);
+		#endif
 		
 		cells::initialised=true;
 
@@ -329,34 +360,54 @@ int mag() {
   // Check for initialised arrays
   //if(cells::initialised!=true) cells::initialise();
 
+#ifdef MPICF
+
+  // calculate partial moment in each local cell
+  std::fill(internal::local_mag_array.begin(),internal::local_mag_array.end(),0.0);
+
+  const int num_local_atoms = vmpi::num_core_atoms+vmpi::num_bdry_atoms;
+
+  for(int i=0;i<num_local_atoms;++i) {
+    const int lc = internal::local_cell_index[i];
+    int type = atoms::type_array[i];
+    const double mus = mp::material_hot_params[type].mu_s_SI;
+
+    internal::local_mag_array[3*lc+0] += atoms::x_spin_array[i]*mus;
+    internal::local_mag_array[3*lc+1] += atoms::y_spin_array[i]*mus;
+    internal::local_mag_array[3*lc+2] += atoms::z_spin_array[i]*mus;
+  }
+
+  // Sum moments of local cells over processors for all occupied cells
+  internal::mag_sum.sum(internal::local_mag_array, internal::occupied_mag_array);
+
+  for(unsigned int i=0;i<internal::occupied_cells.size();++i) {
+    const int cell = internal::occupied_cells[i];
+    cells::x_mag_array[cell] = internal::occupied_mag_array[3*i+0];
+    cells::y_mag_array[cell] = internal::occupied_mag_array[3*i+1];
+    cells::z_mag_array[cell] = internal::occupied_mag_array[3*i+2];
+  }
+
+#else
+
   for(int i=0; i<cells::num_cells; ++i) {
     cells::x_mag_array[i] = 0.0;
     cells::y_mag_array[i] = 0.0;
     cells::z_mag_array[i] = 0.0;
   }
 
-#ifdef MPICF
-    int num_local_atoms = vmpi::num_core_atoms+vmpi::num_bdry_atoms;
-#else
-    int num_local_atoms = atoms::num_atoms;
-#endif
+  int num_local_atoms = atoms::num_atoms;
 
   // calulate total moment in each cell
   for(int i=0;i<num_local_atoms;++i) {
     int cell = atoms::cell_array[i];
     int type = atoms::type_array[i];
-    const double mus = mp::material[type].mu_s_SI;
+    const double mus = mp::material_hot_params[type].mu_s_SI;
 
     cells::x_mag_array[cell] += atoms::x_spin_array[i]*mus;
     cells::y_mag_array[cell] += atoms::y_spin_array[i]*mus;
     cells::z_mag_array[cell] += atoms::z_spin_array[i]*mus;
   }
 
-#ifdef MPICF
-  // Reduce magnetisation on all nodes
-  MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&cells::x_mag_array[0],cells::num_cells,MPI_DOUBLE,MPI_SUM);
-  MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&cells::y_mag_array[0],cells::num_cells,MPI_DOUBLE,MPI_SUM);
-  MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&cells::z_mag_array[0],cells::num_cells,MPI_DOUBLE,MPI_SUM);
 #endif
 
   return EXIT_SUCCESS;
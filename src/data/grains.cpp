@@ -29,6 +29,7 @@
 #include "vmpi.hpp"
 #include "vio.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -54,6 +55,14 @@ namespace grains{
 	std::vector <double> mat_mag_m_array(0);
 	std::vector <double> mat_sat_mag_array(0);
 
+	namespace internal{
+		std::vector <int> local_grain_index;    /// local grain of each local atom
+		std::vector <int> occupied_grains;      /// grains containing atoms on any processor
+		std::vector <double> local_mag_array;   /// partial moments of local grains [local grain][component]
+		std::vector <double> occupied_mag_array; /// total moments of occupied grains [grain][component]
+		vmpi::sparse_sum_t mag_sum;             /// summation of grain moments over processors
+	}
+
 
 int set_properties(){
 	//========================================================================================================
@@ -131,12 +140,35 @@ int set_properties(){
 		//MPI::COMM_WORLD.Allreduce(&grains::y_coord_array[0], &grains::y_coord_array[0],grains::num_grains, MPI_INT,MPI_SUM);
 		//MPI::COMM_WORLD.Allreduce(&grains::z_coord_array[0], &grains::z_coord_array[0],grains::num_grains, MPI_INT,MPI_SUM);
 		//MPI::COMM_WORLD.Allreduce(&grains::sat_mag_array[0], &grains::sat_mag_array[0],grains::num_grains, MPI_INT,MPI_SUM);
-		MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE, &grains::grain_size_array[0],grains::num_grains, MPI_INT,MPI_SUM);
-		MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE, &grains::x_coord_array[0],grains::num_grains, MPI_DOUBLE,MPI_SUM);
-		MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE, &grains::y_coord_array[0],grains::num_grains, MPI_DOUBLE,MPI_SUM);
-		MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE, &grains::z_coord_array[0],grains::num_grains, MPI_DOUBLE,MPI_SUM);
-		MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE, &grains::sat_mag_array[0],grains::num_grains, MPI_DOUBLE,MPI_SUM);
-		if(mp::num_materials>1) MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE, &grains::mat_sat_mag_array[0],grains::num_grains*mp::num_materials, MPI_DOUBLE,MPI_SUM);
+		vmpi::comm.Allreduce(MPI_IN_PLACE, &grains::grain_size_array[0],grains::num_grains, MPI_INT,MPI_SUM);
+		vmpi::comm.Allreduce(MPI_IN_PLACE, &grains::x_coord_array[0],grains::num_grains, MPI_DOUBLE,MPI_SUM);
+		vmpi::comm.Allreduce(MPI_IN_PLACE, &grains::y_coord_array[0],grains::num_grains, MPI_DOUBLE,MPI_SUM);
+		vmpi::comm.Allreduce(MPI_IN_PLACE, &grains::z_coord_array[0],grains::num_grains, MPI_DOUBLE,MPI_SUM);
+		vmpi::comm.Allreduce(MPI_IN_PLACE, &grains::sat_mag_array[0],grains::num_grains, MPI_DOUBLE,MPI_SUM);
+		if(mp::num_materials>1) vmpi::comm.Allreduce(MPI_IN_PLACE, &grains::mat_sat_mag_array[0],grains::num_grains*mp::num_materials, MPI_DOUBLE,MPI_SUM);
+
+		// Set up summation of moments of local grains over processors
+		std::vector<int> local_grain(grains::num_grains,-1);
+		std::vector<int> local_grains;
+		internal::local_grain_index.resize(num_local_atoms);
+		for(unsigned int atom=0;atom< num_local_atoms;atom++){
+			const int grain = atoms::grain_array[atom];
+			if(local_grain[grain]<0){
+				local_grain[grain]=local_grains.size();
+				local_grains.push_back(grain);
+			}
+			internal::local_grain_index[atom]=local_grain[grain];
+		}
+
+		internal::occupied_grains.resize(0);
+		for(int grain=0;grain<grains::num_grains;grain++){
+			if(grains::grain_size_array[grain]>0) internal::occupied_grains.push_back(grain);
+		}
+
+		// moment and moment of each material in grain
+		const int num_components = mp::num_materials>1 ? 3+3*mp::num_materials : 3;
+		internal::local_mag_array.resize(local_grains.size()*num_components);
+		internal::mag_sum.initialise(local_grains, internal::occupied_grains, grains::num_grains, num_components);
 	#endif
 
 	//vinfo << "-------------------------------------------------------------------------------------------------------------------" << std::endl;
@@ -172,6 +204,48 @@ int mag(){
 		const unsigned int num_local_atoms = atoms::num_atoms;
 	#endif
 
+	#ifdef MPICF
+
+	// calculate partial moments of local grains
+	const int num_components = mp::num_materials>1 ? 3+3*mp::num_materials : 3;
+	std::fill(internal::local_mag_array.begin(),internal::local_mag_array.end(),0.0);
+
+	for(unsigned int atom=0;atom< num_local_atoms;atom++){
+
+		const int lg = internal::local_grain_index[atom];
+		const int mat = atoms::type_array[atom];
+		double* m = &internal::local_mag_array[lg*num_components];
+
+		m[0]+=(atoms::x_spin_array[atom]*mp::material[mat].mu_s_SI);
+		m[1]+=(atoms::y_spin_array[atom]*mp::material[mat].mu_s_SI);
+		m[2]+=(atoms::z_spin_array[atom]*mp::material[mat].mu_s_SI);
+		if(mp::num_materials>1){
+			m[3+3*mat+0]+=(atoms::x_spin_array[atom]*mp::material[mat].mu_s_SI);
+			m[3+3*mat+1]+=(atoms::y_spin_array[atom]*mp::material[mat].mu_s_SI);
+			m[3+3*mat+2]+=(atoms::z_spin_array[atom]*mp::material[mat].mu_s_SI);
+		}
+	}
+
+	// Sum moments of local grains over processors for all occupied grains
+	internal::mag_sum.sum(internal::local_mag_array, internal::occupied_mag_array);
+
+	for(unsigned int i=0;i<internal::occupied_grains.size();i++){
+		const int grain = internal::occupied_grains[i];
+		const double* m = &internal::occupied_mag_array[i*num_components];
+		grains::x_mag_array[grain]=m[0];
+		grains::y_mag_array[grain]=m[1];
+		grains::z_mag_array[grain]=m[2];
+		if(mp::num_materials>1){
+			for(int mat=0;mat<mp::num_materials;mat++){
+				grains::x_mat_mag_array[grain*mp::num_materials+mat]=m[3+3*mat+0];
+				grains::y_mat_mag_array[grain*mp::num_materials+mat]=m[3+3*mat+1];
+				grains::z_mat_mag_array[grain*mp::num_materials+mat]=m[3+3*mat+2];
+			}
+		}
+	}
+
+	#else
+
 	//initialise magnetisations
 	for(int grain=0;grain<grains::num_grains;grain++){
 		grains::x_mag_array[grain]=0.0;
@@ -216,14 +290,6 @@ int mag(){
 		}
 	}
 
-	// Reduce grain properties on all CPUs
-	#ifdef MPICF
-		MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE, &grains::x_mag_array[0],grains::num_grains, MPI_DOUBLE,MPI_SUM);
-		MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE, &grains::y_mag_array[0],grains::num_grains, MPI_DOUBLE,MPI_SUM);
-		MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE, &grains::z_mag_array[0],grains::num_grains, MPI_DOUBLE,MPI_SUM);
-		if(mp::num_materials>1) MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE, &grains::x_mat_mag_array[0],grains::num_grains*mp::num_materials, MPI_DOUBLE,MPI_SUM);
-		if(mp::num_materials>1) MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE, &grains::y_mat_mag_array[0],grains::num_grains*mp::num_materials, MPI_DOUBLE,MPI_SUM);
-		if(mp::num_materials>1) MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE, &grains::z_mat_mag_array[0],grains::num_grains*mp::num_materials, MPI_DOUBLE,MPI_SUM);
 	#endif
 
 	// calculate mag_m of each grain and normalised direction
@@ -35,6 +35,7 @@
 #include "vmpi.hpp"
 
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <sstream>
 //==========================================================
@@ -75,6 +76,11 @@ namespace mp{
    std::vector <double> material_spherical_harmonic_constants_array(0);
 	std::vector <double> MaterialCubicAnisotropyArray(0);
 
+	// Compact table of hot loop material constants
+	material_hot_params_t* material_hot_params=NULL;
+	int num_material_hot_params=0;
+	double material_hot_params_temperature=-1.0; /// system temperature for last update of table
+
 ///
 /// @brief Function to initialise program variables prior to system creation.
 ///
@@ -583,6 +589,9 @@ int set_derived_parameters(){
 			for(int mat=0;mat<mp::num_materials; mat++) MaterialCubicAnisotropyArray.at(mat)=mp::material[mat].Kc;
 		}
 
+		// Build compact table of hot loop material constants
+		mp::update_material_hot_params();
+
 		// Loop over materials to check for invalid input and warn appropriately
 		for(int mat=0;mat<mp::num_materials;mat++){
 			const double lmin=material[mat].min;
@@ -610,4 +619,71 @@ int set_derived_parameters(){
 	return EXIT_SUCCESS;
 }
 
+//--------------------------------------------------------------------
+// Function to copy per-material constants into compact table
+//--------------------------------------------------------------------
+void update_material_hot_params(){
+
+	// allocate aligned table
+	if(mp::material_hot_params!=NULL) free(mp::material_hot_params);
+	void* ptr=NULL;
+	if(posix_memalign(&ptr, 64, mp::material.size()*sizeof(material_hot_params_t))!=0){
+		terminaltextcolor(RED);
+		std::cerr << "Error allocating material parameter table" << std::endl;
+		terminaltextcolor(WHITE);
+		zlog << zTs() << "Error allocating material parameter table" << std::endl;
+		err::vexit();
+	}
+	mp::material_hot_params = static_cast<material_hot_params_t*>(ptr);
+	mp::num_material_hot_params = mp::material.size();
+
+	for(unsigned int mat=0;mat<mp::material.size();mat++){
+		mp::material_hot_params[mat].one_oneplusalpha_sq   = mp::material[mat].one_oneplusalpha_sq;
+		mp::material_hot_params[mat].alpha_oneplusalpha_sq = mp::material[mat].alpha_oneplusalpha_sq;
+		mp::material_hot_params[mat].alpha                 = mp::material[mat].alpha;
+		mp::material_hot_params[mat].mu_s_SI               = mp::material[mat].mu_s_SI;
+		mp::material_hot_params[mat].H_th_sigma            = mp::material[mat].H_th_sigma;
+	}
+
+	// force recalculation of temperature dependent constants
+	mp::material_hot_params_temperature=-1.0;
+	mp::update_material_hot_params_temperature();
+
+	return;
+
+}
+
+//--------------------------------------------------------------------
+// Function to update temperature dependent constants in compact table.
+// Material temperatures can change independently when local
+// temperatures are enabled, so these are always recalculated.
+//--------------------------------------------------------------------
+void update_material_hot_params_temperature(){
+
+	if(!sim::local_temperature && sim::temperature==mp::material_hot_params_temperature) return;
+
+	for(int mat=0;mat<mp::num_material_hot_params;mat++){
+
+		// temperature rescaling, if T<Tc T/Tc = (T/Tc)^alpha else T = T
+		const double alpha = mp::material[mat].temperature_rescaling_alpha;
+		const double Tc = mp::material[mat].temperature_rescaling_Tc;
+
+		// thermal field uses material temperature if local temperatures are enabled
+		const double temperature = sim::local_temperature ? mp::material[mat].temperature : sim::temperature;
+		const double rescaled_temperature = temperature < Tc ? Tc*pow(temperature/Tc,alpha) : temperature;
+		mp::material_hot_params[mat].thermal_sigma = sqrt(rescaled_temperature)*mp::material[mat].H_th_sigma;
+
+		// Monte Carlo always uses system temperature
+		const double rescaled_system_temperature = sim::temperature < Tc ? Tc*pow(sim::temperature/Tc,alpha) : sim::temperature;
+		mp::material_hot_params[mat].mc_kBTBohr = 9.27400915e-24/(rescaled_system_temperature*1.3806503e-23);
+		mp::material_hot_params[mat].mc_sigma = rescaled_system_temperature < 1.0 ? 0.02 : pow(1.0/mp::material_hot_params[mat].mc_kBTBohr,0.2)*0.08;
+
+	}
+
+	mp::material_hot_params_temperature=sim::temperature;
+
+	return;
+
+}
+
 } // end of namespace mp
@@ -134,20 +134,28 @@ int main(int argc, char* argv[]){
    // Initialise system
    mp::initialise(infile);
 
+   // Split processors into independent replicas for statistical parallelism
+   #ifdef MPICF
+      if(vmpi::mpi_mode==2) vmpi::initialise_replicas();
+   #endif
+
    // Create system
    cs::create();
 
    // Simulate system
    sim::run();
 
+   // Complete any outstanding asynchronous output
+   vout::async::finalise();
+
    // Finalise MPI
    #ifdef MPICF
       vmpi::finalise();
       // concatenate log, sort, and append departure message.
       #ifdef WIN_COMPILE
-         if(vmpi::num_processors!=1 && vmpi::my_rank==0) system("type log.* 2>NUL | sort > log");
+         if((vmpi::num_processors!=1 || vmpi::num_replicas>1) && vmpi::world_rank==0) system("type log.* 2>NUL | sort > log");
       #else
-         if(vmpi::num_processors!=1 && vmpi::my_rank==0) system("ls log.* | xargs cat | sort -n > log");
+         if((vmpi::num_processors!=1 || vmpi::num_replicas>1) && vmpi::world_rank==0) system("ls log.* | xargs cat | sort -n > log");
       #endif
    #endif
 
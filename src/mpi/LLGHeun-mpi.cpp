@@ -98,8 +98,8 @@ int LLG_Heun_mpi(){
 		for(int atom=pre_comm_si;atom<pre_comm_ei;atom++){
 
 			const int imaterial=atoms::type_array[atom];
-			const double one_oneplusalpha_sq = material_parameters::material[imaterial].one_oneplusalpha_sq;
-			const double alpha_oneplusalpha_sq = material_parameters::material[imaterial].alpha_oneplusalpha_sq;
+			const double one_oneplusalpha_sq = mp::material_hot_params[imaterial].one_oneplusalpha_sq;
+			const double alpha_oneplusalpha_sq = mp::material_hot_params[imaterial].alpha_oneplusalpha_sq;
 
 			// Store local spin in Sand local field in H
 			const double S[3] = {atoms::x_spin_array[atom],atoms::y_spin_array[atom],atoms::z_spin_array[atom]};
@@ -154,8 +154,8 @@ int LLG_Heun_mpi(){
 		for(int atom=post_comm_si;atom<post_comm_ei;atom++){
 
 			const int imaterial=atoms::type_array[atom];
-			const double one_oneplusalpha_sq = material_parameters::material[imaterial].one_oneplusalpha_sq;
-			const double alpha_oneplusalpha_sq = material_parameters::material[imaterial].alpha_oneplusalpha_sq;
+			const double one_oneplusalpha_sq = mp::material_hot_params[imaterial].one_oneplusalpha_sq;
+			const double alpha_oneplusalpha_sq = mp::material_hot_params[imaterial].alpha_oneplusalpha_sq;
 
 			// Store local spin in Sand local field in H
 			const double S[3] = {atoms::x_spin_array[atom],atoms::y_spin_array[atom],atoms::z_spin_array[atom]};
@@ -192,13 +192,21 @@ int LLG_Heun_mpi(){
 		}
 
 		//----------------------------------------
-		// Copy new spins to spin array (all)
+		// Copy new spins to spin array (all), and
+		// to packed array for exchange calculation
 		//----------------------------------------
+		const bool packed_spins=(atoms::packed_spin_array!=NULL);
 		for(int atom=pre_comm_si;atom<post_comm_ei;atom++){
 			atoms::x_spin_array[atom]=x_spin_storage_array[atom];
 			atoms::y_spin_array[atom]=y_spin_storage_array[atom];
 			atoms::z_spin_array[atom]=z_spin_storage_array[atom];
+			if(packed_spins){
+				atoms::packed_spin_array[4*atom+0]=atoms::packed_real_t(x_spin_storage_array[atom]);
+				atoms::packed_spin_array[4*atom+1]=atoms::packed_real_t(y_spin_storage_array[atom]);
+				atoms::packed_spin_array[4*atom+2]=atoms::packed_real_t(z_spin_storage_array[atom]);
+			}
 		}
+		atoms::packed_spins_current=packed_spins;
 
 		//------------------------------------------
 		// Initiate second halo swap
@@ -218,8 +226,8 @@ int LLG_Heun_mpi(){
 		for(int atom=pre_comm_si;atom<pre_comm_ei;atom++){
 
 			const int imaterial=atoms::type_array[atom];;
-			const double one_oneplusalpha_sq = material_parameters::material[imaterial].one_oneplusalpha_sq;
-			const double alpha_oneplusalpha_sq = material_parameters::material[imaterial].alpha_oneplusalpha_sq;
+			const double one_oneplusalpha_sq = mp::material_hot_params[imaterial].one_oneplusalpha_sq;
+			const double alpha_oneplusalpha_sq = mp::material_hot_params[imaterial].alpha_oneplusalpha_sq;
 
 			// Store local spin in Sand local field in H
 			const double S[3] = {atoms::x_spin_array[atom],atoms::y_spin_array[atom],atoms::z_spin_array[atom]};
@@ -256,8 +264,8 @@ int LLG_Heun_mpi(){
 		for(int atom=post_comm_si;atom<post_comm_ei;atom++){
 
 			const int imaterial=atoms::type_array[atom];;
-			const double one_oneplusalpha_sq = material_parameters::material[imaterial].one_oneplusalpha_sq;
-			const double alpha_oneplusalpha_sq = material_parameters::material[imaterial].alpha_oneplusalpha_sq;
+			const double one_oneplusalpha_sq = mp::material_hot_params[imaterial].one_oneplusalpha_sq;
+			const double alpha_oneplusalpha_sq = mp::material_hot_params[imaterial].alpha_oneplusalpha_sq;
 
 			// Store local spin in Sand local field in H
 			const double S[3] = {atoms::x_spin_array[atom],atoms::y_spin_array[atom],atoms::z_spin_array[atom]};
@@ -304,7 +312,7 @@ int LLG_Heun_mpi(){
 	vmpi::TotalComputeTime+=vmpi::SwapTimer(vmpi::ComputeTime, vmpi::WaitTime);
 
 	// Wait for other processors
-	MPI::COMM_WORLD.Barrier();
+	vmpi::comm.Barrier();
 
 	// Swap timers wait -> compute
 	vmpi::TotalWaitTime+=vmpi::SwapTimer(vmpi::WaitTime, vmpi::ComputeTime);
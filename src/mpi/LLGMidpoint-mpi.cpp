@@ -76,8 +76,8 @@ int LLG_Midpoint_mpi(){
 	for(int atom=pre_comm_si;atom<pre_comm_ei;atom++){
 
 		const int imaterial=atoms::type_array[atom];
-		const double alpha = mp::material[imaterial].alpha;
-		const double beta  = -1.0*mp::dt*mp::material[imaterial].one_oneplusalpha_sq*0.5;
+		const double alpha = mp::material_hot_params[imaterial].alpha;
+		const double beta  = -1.0*mp::dt*mp::material_hot_params[imaterial].one_oneplusalpha_sq*0.5;
 		const double beta2 = beta*beta;
 		
 		// Store local spin in S and local field in H
@@ -115,8 +115,8 @@ int LLG_Midpoint_mpi(){
 	for(int atom=post_comm_si;atom<post_comm_ei;atom++){
 
 		const int imaterial=atoms::type_array[atom];
-		const double alpha = mp::material[imaterial].alpha;
-		const double beta  = -1.0*mp::dt*mp::material[imaterial].one_oneplusalpha_sq*0.5;
+		const double alpha = mp::material_hot_params[imaterial].alpha;
+		const double beta  = -1.0*mp::dt*mp::material_hot_params[imaterial].one_oneplusalpha_sq*0.5;
 		const double beta2 = beta*beta;
 		
 		// Store local spin in S and local field in H
@@ -159,8 +159,8 @@ int LLG_Midpoint_mpi(){
 	for(int atom=pre_comm_si;atom<pre_comm_ei;atom++){
 
 		const int imaterial=atoms::type_array[atom];
-		const double alpha = mp::material[imaterial].alpha;
-		const double beta  = -1.0*mp::dt*mp::material[imaterial].one_oneplusalpha_sq*0.5;
+		const double alpha = mp::material_hot_params[imaterial].alpha;
+		const double beta  = -1.0*mp::dt*mp::material_hot_params[imaterial].one_oneplusalpha_sq*0.5;
 		const double beta2 = beta*beta;
 		
 		// Store local spin in S and local field in H
@@ -196,8 +196,8 @@ int LLG_Midpoint_mpi(){
 	for(int atom=post_comm_si;atom<post_comm_ei;atom++){
 
 		const int imaterial=atoms::type_array[atom];
-		const double alpha = mp::material[imaterial].alpha;
-		const double beta  = -1.0*mp::dt*mp::material[imaterial].one_oneplusalpha_sq*0.5;
+		const double alpha = mp::material_hot_params[imaterial].alpha;
+		const double beta  = -1.0*mp::dt*mp::material_hot_params[imaterial].one_oneplusalpha_sq*0.5;
 		const double beta2 = beta*beta;
 		
 		// Store local spin in S and local field in H
@@ -231,7 +231,7 @@ int LLG_Midpoint_mpi(){
 	}
 
 	// Wait for other processors
-	MPI::COMM_WORLD.Barrier();
+	vmpi::comm.Barrier();
 
 	return EXIT_SUCCESS;
 }
@@ -95,12 +95,12 @@ int mpi_init_halo_swap(){
 		if(vmpi::send_num_array[p]!=0){
 			int num_pts = 3*vmpi::send_num_array[p];
 			int si = 3*vmpi::send_start_index_array[p];
-			vmpi::requests.push_back(MPI::COMM_WORLD.Isend(&vmpi::send_spin_data_array[si],num_pts,MPI_DOUBLE,p,48));
+			vmpi::requests.push_back(vmpi::comm.Isend(&vmpi::send_spin_data_array[si],num_pts,MPI_DOUBLE,p,48));
 		}
 		if(vmpi::recv_num_array[p]!=0){
 			int num_pts = 3*vmpi::recv_num_array[p];
 			int si = 3*vmpi::recv_start_index_array[p];
-			vmpi::requests.push_back(MPI::COMM_WORLD.Irecv(&vmpi::recv_spin_data_array[si],num_pts,MPI_DOUBLE,p,48));
+			vmpi::requests.push_back(vmpi::comm.Irecv(&vmpi::recv_spin_data_array[si],num_pts,MPI_DOUBLE,p,48));
 		}
 	}
 
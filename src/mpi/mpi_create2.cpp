@@ -30,6 +30,7 @@
 #include "errors.hpp"
 #include "vio.hpp"
 #include "vmpi.hpp"
+#include <algorithm>
 #include <iostream>
 #include <list>
 #include <vector>
@@ -44,6 +45,11 @@ namespace vmpi{
 	int num_bdry_atoms;
 	int num_halo_atoms;
 
+	int world_rank=0;
+	int num_replicas=0;
+	int replica_id=0;
+	int replica_point=0;
+
 	bool replicated_data_staged=false;
 	
 	char hostname[20];
@@ -78,7 +84,20 @@ namespace vmpi{
 	#ifdef MPICF
 	std::vector<MPI::Request> requests(0);
 	std::vector<MPI::Status> stati(0);
+	MPI::Intracomm comm;
 	#endif
+
+	//-----------------------------------------------------------------------------
+	// Function to determine if the current point of a parameter sweep
+	// (vmpi::replica_point) is simulated by the local replica. Points are
+	// assigned to replicas cyclically for statistical parallelism, otherwise
+	// all points are simulated.
+	//-----------------------------------------------------------------------------
+	bool is_replica_point(){
+		if(vmpi::mpi_mode!=2 || vmpi::num_replicas<=1) return true;
+		return vmpi::replica_point%vmpi::num_replicas==vmpi::replica_id;
+	}
+
 }
 	
 #ifdef MPICF
@@ -246,19 +265,19 @@ namespace vmpi{
 	//--------------------------------------------------------------------------
 	// Wait for root process
 	//--------------------------------------------------------------------------
-	MPI::COMM_WORLD.Barrier();
+	vmpi::comm.Barrier();
 
 	//--------------------------------------------------------------------------
 	// Find number of atoms on each node
 	//--------------------------------------------------------------------------
 	if(my_rank==0){
 		for(int p=1;p<num_processors;p++){
-			MPI::COMM_WORLD.Recv(&num_atoms_array[p],1,MPI_INT,p,34);
+			vmpi::comm.Recv(&num_atoms_array[p],1,MPI_INT,p,34);
 			//std::cout << p << "\t" << num_atoms_array[p] << std::endl;
 		}
 	}
 	else{
-		MPI::COMM_WORLD.Send(&num_atoms,1,MPI_INT,0,34);
+		vmpi::comm.Send(&num_atoms,1,MPI_INT,0,34);
 	}
 
 	//--------------------------------------------------------------------------
@@ -319,9 +338,9 @@ namespace vmpi{
 			// Get data from processors
 			//std::cout << "Receiving data from rank " << p << std::endl;
 			//std::cout << "\t" << "Number of data points expected: " << 3*num_atoms_array[p] << std::endl;
-			MPI::COMM_WORLD.Recv(&mpi_data_array[0],3*num_atoms_array[p],MPI_DOUBLE,p,35);
-			MPI::COMM_WORLD.Recv(&mpi_char_array[0],num_atoms_array[p],MPI_INT,p,36);
-			MPI::COMM_WORLD.Recv(&mpi_type_array[0],num_atoms_array[p],MPI_INT,p,37);
+			vmpi::comm.Recv(&mpi_data_array[0],3*num_atoms_array[p],MPI_DOUBLE,p,35);
+			vmpi::comm.Recv(&mpi_char_array[0],num_atoms_array[p],MPI_INT,p,36);
+			vmpi::comm.Recv(&mpi_type_array[0],num_atoms_array[p],MPI_INT,p,37);
 			//MPI::COMM_WORLD.Recv(&mpi_comms_array[0],num_atoms_array[p],MPI_INT,p,37);
 
 			//void MPI::Comm::Recv(void* buf, int count, const MPI::Datatype& datatype,
@@ -379,9 +398,9 @@ namespace vmpi{
 			mpi_type_array[i]=catom_array[i].mpi_type;
 			//mpi_comms_array[i]=mpi_create_variables::mpi_atom_comm_class_array[i];
 		}
-		MPI::COMM_WORLD.Send(&mpi_data_array[0],3*num_atoms,MPI_DOUBLE,0,35);
-		MPI::COMM_WORLD.Send(&mpi_char_array[0],num_atoms,MPI_INT,0,36);
-		MPI::COMM_WORLD.Send(&mpi_type_array[0],num_atoms,MPI_INT,0,37);
+		vmpi::comm.Send(&mpi_data_array[0],3*num_atoms,MPI_DOUBLE,0,35);
+		vmpi::comm.Send(&mpi_char_array[0],num_atoms,MPI_INT,0,36);
+		vmpi::comm.Send(&mpi_type_array[0],num_atoms,MPI_INT,0,37);
 		//MPI::COMM_WORLD.Send(&mpi_comms_array[0],num_atoms,MPI_INT,0,37);
 	}
 
@@ -488,7 +507,7 @@ int copy_halo_atoms(std::vector<cs::catom_t> & catom_array){
 	cpu_range_array[6*vmpi::my_rank+5]=vmpi::max_dimensions[2] + max_interaction_range*cs::unit_cell.dimensions[2]+0.01;
 	
 	// Reduce data on all CPUs
-	MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE, &cpu_range_array[0],6*vmpi::num_processors, MPI_DOUBLE,MPI_SUM);
+	vmpi::comm.Allreduce(MPI_IN_PLACE, &cpu_range_array[0],6*vmpi::num_processors, MPI_DOUBLE,MPI_SUM);
 	
    // Copy ranges to 2D array
    std::vector<std::vector<double> > cpu_range_array2D(vmpi::num_processors);
@@ -596,8 +615,8 @@ int copy_halo_atoms(std::vector<cs::catom_t> & catom_array){
 
    // Send/receive number of boundary/halo atoms
    for(int cpu=0;cpu<vmpi::num_processors;cpu++){
-      requests.push_back(MPI::COMM_WORLD.Isend(&num_send_atoms[cpu],1,MPI_INT,cpu,35));
-      requests.push_back(MPI::COMM_WORLD.Irecv(&num_recv_atoms[cpu],1,MPI_INT,cpu,35));
+      requests.push_back(vmpi::comm.Isend(&num_send_atoms[cpu],1,MPI_INT,cpu,35));
+      requests.push_back(vmpi::comm.Irecv(&num_recv_atoms[cpu],1,MPI_INT,cpu,35));
    }
 
    stati.resize(requests.size());
@@ -675,22 +694,22 @@ int copy_halo_atoms(std::vector<cs::catom_t> & catom_array){
    // Exchange boundary/halo data
    for(int cpu=0;cpu<vmpi::num_processors;cpu++){
       if(num_send_atoms[cpu]>0){
-         requests.push_back(MPI::COMM_WORLD.Isend(&send_coord_array[3*send_index],3*num_send_atoms[cpu],MPI_DOUBLE,cpu,50));
-         requests.push_back(MPI::COMM_WORLD.Isend(&send_mpi_atom_supercell_array[3*send_index],3*num_send_atoms[cpu],MPI_INT,cpu,54));
-         requests.push_back(MPI::COMM_WORLD.Isend(&send_material_array[send_index],num_send_atoms[cpu],MPI_INT,cpu,51));
-         requests.push_back(MPI::COMM_WORLD.Isend(&send_cpuid_array[send_index],num_send_atoms[cpu],MPI_INT,cpu,52));
-         requests.push_back(MPI::COMM_WORLD.Isend(&send_mpi_atom_num_array[send_index],num_send_atoms[cpu],MPI_INT,cpu,53));
-         requests.push_back(MPI::COMM_WORLD.Isend(&send_mpi_uc_id_array[send_index],num_send_atoms[cpu],MPI_INT,cpu,55));
+         requests.push_back(vmpi::comm.Isend(&send_coord_array[3*send_index],3*num_send_atoms[cpu],MPI_DOUBLE,cpu,50));
+         requests.push_back(vmpi::comm.Isend(&send_mpi_atom_supercell_array[3*send_index],3*num_send_atoms[cpu],MPI_INT,cpu,54));
+         requests.push_back(vmpi::comm.Isend(&send_material_array[send_index],num_send_atoms[cpu],MPI_INT,cpu,51));
+         requests.push_back(vmpi::comm.Isend(&send_cpuid_array[send_index],num_send_atoms[cpu],MPI_INT,cpu,52));
+         requests.push_back(vmpi::comm.Isend(&send_mpi_atom_num_array[send_index],num_send_atoms[cpu],MPI_INT,cpu,53));
+         requests.push_back(vmpi::comm.Isend(&send_mpi_uc_id_array[send_index],num_send_atoms[cpu],MPI_INT,cpu,55));
          //std::cout << "Send complete on CPU " << vmpi::my_rank << " to CPU " << cpu << " at index " << send_index  << std::endl;
          send_index+=num_send_atoms[cpu];
       }
       if(num_recv_atoms[cpu]>0){
-         requests.push_back(MPI::COMM_WORLD.Irecv(&recv_coord_array[3*recv_index],3*num_recv_atoms[cpu],MPI_DOUBLE,cpu,50));
-         requests.push_back(MPI::COMM_WORLD.Irecv(&recv_mpi_atom_supercell_array[3*recv_index],3*num_recv_atoms[cpu],MPI_INT,cpu,54));
-         requests.push_back(MPI::COMM_WORLD.Irecv(&recv_material_array[recv_index],num_recv_atoms[cpu],MPI_INT,cpu,51));
-         requests.push_back(MPI::COMM_WORLD.Irecv(&recv_cpuid_array[recv_index],num_recv_atoms[cpu],MPI_INT,cpu,52));
-         requests.push_back(MPI::COMM_WORLD.Irecv(&recv_mpi_atom_num_array[recv_index],num_recv_atoms[cpu],MPI_INT,cpu,53));
-         requests.push_back(MPI::COMM_WORLD.Irecv(&recv_mpi_uc_id_array[recv_index],num_recv_atoms[cpu],MPI_INT,cpu,55));
+         requests.push_back(vmpi::comm.Irecv(&recv_coord_array[3*recv_index],3*num_recv_atoms[cpu],MPI_DOUBLE,cpu,50));
+         requests.push_back(vmpi::comm.Irecv(&recv_mpi_atom_supercell_array[3*recv_index],3*num_recv_atoms[cpu],MPI_INT,cpu,54));
+         requests.push_back(vmpi::comm.Irecv(&recv_material_array[recv_index],num_recv_atoms[cpu],MPI_INT,cpu,51));
+         requests.push_back(vmpi::comm.Irecv(&recv_cpuid_array[recv_index],num_recv_atoms[cpu],MPI_INT,cpu,52));
+         requests.push_back(vmpi::comm.Irecv(&recv_mpi_atom_num_array[recv_index],num_recv_atoms[cpu],MPI_INT,cpu,53));
+         requests.push_back(vmpi::comm.Irecv(&recv_mpi_uc_id_array[recv_index],num_recv_atoms[cpu],MPI_INT,cpu,55));
          //std::cout << "Receive complete on CPU " << vmpi::my_rank << " from CPU " << cpu << " at index " << recv_index << " at address " << &recv_mpi_atom_num_array[recv_index] << std::endl;
          recv_index+=num_recv_atoms[cpu];
       }
@@ -791,7 +810,7 @@ int set_replicated_data(std::vector<cs::catom_t> & catom_array){
 	return EXIT_SUCCESS;
 }
 
-int sort_atoms_by_mpi_type(std::vector<cs::catom_t> &,std::vector<std::vector <cs::neighbour_t> > &);
+int sort_atoms_by_mpi_type(std::vector<cs::catom_t> &,cs::neighbour_list_t &);
 
 /// @brief Identify Boundary Atoms
 ///
@@ -816,7 +835,7 @@ int sort_atoms_by_mpi_type(std::vector<cs::catom_t> &,std::vector<std::vector <c
 ///	Revision:	  ---
 ///=====================================================================================
 ///
-int identify_boundary_atoms(std::vector<cs::catom_t> & catom_array,std::vector<std::vector <cs::neighbour_t> > & cneighbourlist){
+int identify_boundary_atoms(std::vector<cs::catom_t> & catom_array,cs::neighbour_list_t & cneighbourlist){
 	
 	// check calling of routine if error checking is activated
 	if(err::check==true){std::cout << "vmpi::identify_boundary_atoms has been called" << std::endl;}
@@ -826,8 +845,8 @@ int identify_boundary_atoms(std::vector<cs::catom_t> & catom_array,std::vector<s
 		const int my_mpi_type=catom_array[atom].mpi_type;
 		bool boundary=false;
 		bool non_interacting_halo=true;
-		for(unsigned int nn=0;nn<cneighbourlist[atom].size();nn++){
-			int nn_mpi_type = catom_array[cneighbourlist[atom][nn].nn].mpi_type;
+		for(int nn=cneighbourlist.start[atom];nn<cneighbourlist.start[atom+1];nn++){
+			int nn_mpi_type = catom_array[cneighbourlist.nn[nn]].mpi_type;
 			// Test for interaction with halo
 			if((my_mpi_type==0) && (nn_mpi_type == 2)){
 				boundary=true;
@@ -868,7 +887,7 @@ bool compare(data_t first,data_t second){
 	else return false;
 }
 	
-int sort_atoms_by_mpi_type(std::vector<cs::catom_t> & catom_array,std::vector<std::vector <cs::neighbour_t> > & cneighbourlist){
+int sort_atoms_by_mpi_type(std::vector<cs::catom_t> & catom_array,cs::neighbour_list_t & cneighbourlist){
 	
 	// check calling of routine if error checking is activated
 	if(err::check==true){std::cout << "cs::sort_atoms_by_mpi_type has been called" << std::endl;}	
@@ -941,48 +960,50 @@ int sort_atoms_by_mpi_type(std::vector<cs::catom_t> & catom_array,std::vector<st
 		
 		// create temporary catom and cneighbourlist arrays for copying data
 	std::vector <cs::catom_t> tmp_catom_array(new_num_atoms);
-	std::vector <std::vector <cs::neighbour_t> > tmp_cneighbourlist(new_num_atoms);
-	//tmp_cneighbourlist.reserve(new_num_atoms);
-	
+	cs::neighbour_list_t tmp_cneighbourlist;
+	tmp_cneighbourlist.vectors=cneighbourlist.vectors;
+
+	// Count interactions of each atom, ignoring all halo-x interactions but not x-halo
+	tmp_cneighbourlist.start.resize(new_num_atoms+1,0);
+	for (unsigned int atom=0;atom<new_num_atoms;atom++){
+		unsigned int old_atom_num = mpi_type_vec[atom].atom_number;
+		int num_nn=0;
+		if(!(mpi_type_vec[atom].mpi_type==2)) num_nn=cneighbourlist.size(old_atom_num);
+		tmp_cneighbourlist.start[atom+1]=tmp_cneighbourlist.start[atom]+num_nn;
+	}
+	const int total_num_neighbours=tmp_cneighbourlist.start[new_num_atoms];
+	tmp_cneighbourlist.nn.resize(total_num_neighbours);
+	tmp_cneighbourlist.i.resize(total_num_neighbours);
+	if(tmp_cneighbourlist.vectors){
+		tmp_cneighbourlist.vx.resize(total_num_neighbours);
+		tmp_cneighbourlist.vy.resize(total_num_neighbours);
+		tmp_cneighbourlist.vz.resize(total_num_neighbours);
+	}
+
 	// Populate tmp arrays (assuming all mpi_type=3 atoms are at the end of the array?)
 	for (unsigned int atom=0;atom<new_num_atoms;atom++){ // new atom number
 		unsigned int old_atom_num = mpi_type_vec[atom].atom_number;
 		tmp_catom_array[atom]=catom_array[old_atom_num];
 		tmp_catom_array[atom].mpi_old_atom_number=old_atom_num; // Store old atom numbers for translation after sorting
-		tmp_cneighbourlist[atom].reserve(cneighbourlist[old_atom_num].size());
 		//Copy neighbourlist using new atom numbers
-		//if(vmpi::my_rank==0) std::cout << vmpi::my_rank << " old " << old_atom_num << " nn: ";
-		for(unsigned int nn=0;nn<cneighbourlist[old_atom_num].size();nn++){
-			unsigned int old_nn_number = cneighbourlist[old_atom_num][nn].nn;
-			unsigned int interaction_id= cneighbourlist[old_atom_num][nn].i;
-			unsigned int new_nn_number = inv_mpi_type_vec[old_nn_number];
-			cs::neighbour_t temp_nt;
-			temp_nt.nn=new_nn_number;
-			temp_nt.i=interaction_id;
+		int index=tmp_cneighbourlist.start[atom];
+		for(int nn=0;nn<tmp_cneighbourlist.size(atom);nn++){
+			const int old_index=cneighbourlist.start[old_atom_num]+nn;
+			tmp_cneighbourlist.nn[index]=inv_mpi_type_vec[cneighbourlist.nn[old_index]];
+			tmp_cneighbourlist.i[index]=cneighbourlist.i[old_index];
          // Actual neighbours stay the same so simply copy separation vectors
-         temp_nt.vx=cneighbourlist[old_atom_num][nn].vx;
-         temp_nt.vy=cneighbourlist[old_atom_num][nn].vy;
-         temp_nt.vz=cneighbourlist[old_atom_num][nn].vz;
-			// ignore all halo-x interactions but not x-halo
-			//if(!((mpi_type_vec[atom].mpi_type==2) && (mpi_type_vec[new_nn_number].mpi_type==2)))
-			if(!(mpi_type_vec[atom].mpi_type==2))
-			tmp_cneighbourlist[atom].push_back(temp_nt);
-			//else std::cerr << "ignoring interaction " << atom << "\t" << new_nn_number << " on " << vmpi::my_rank << std::endl;
-			//if(vmpi::my_rank==0) std::cout << cneighbourlist[old_atom_num][nn].nn << "\t";
+         if(tmp_cneighbourlist.vectors){
+            tmp_cneighbourlist.vx[index]=cneighbourlist.vx[old_index];
+            tmp_cneighbourlist.vy[index]=cneighbourlist.vy[old_index];
+            tmp_cneighbourlist.vz[index]=cneighbourlist.vz[old_index];
+         }
+			index++;
 		}
-		//if(vmpi::my_rank==0) std::cout <<std::endl;
-		//if(vmpi::my_rank==0) std::cout << vmpi::my_rank << " new " << atom << " nn: ";
-		//for(unsigned int nn=0;nn<tmp_cneighbourlist[atom].size();nn++){
-		//	if(vmpi::my_rank==0) std::cout << tmp_cneighbourlist[atom][nn].nn << "\t";
-		//}
-		//if(vmpi::my_rank==0) std::cout <<std::endl;
 	}
 	
-
-		
 	// Swap tmp data over old data more efficient and saves memory
 	catom_array.swap(tmp_catom_array);
-	cneighbourlist.swap(tmp_cneighbourlist); // This actually works(!) - COPIES both pointers and elements of pointers
+	std::swap(cneighbourlist,tmp_cneighbourlist);
 
 	// Print out final neighbourlist
 	//for (unsigned int atom=0;atom<new_num_atoms;atom++){
@@ -1044,8 +1065,8 @@ int init_mpi_comms(std::vector<cs::catom_t> & catom_array){
 	std::vector<MPI::Status> stati(0);
 	
 	for(int cpu=0;cpu<vmpi::num_processors;cpu++){
-			requests.push_back(MPI::COMM_WORLD.Isend(&vmpi::recv_num_array[cpu],1,MPI_INT,cpu,60));
-			requests.push_back(MPI::COMM_WORLD.Irecv(&vmpi::send_num_array[cpu],1,MPI_INT,cpu,60));
+			requests.push_back(vmpi::comm.Isend(&vmpi::recv_num_array[cpu],1,MPI_INT,cpu,60));
+			requests.push_back(vmpi::comm.Irecv(&vmpi::send_num_array[cpu],1,MPI_INT,cpu,60));
 	}
 
 	stati.resize(requests.size());
@@ -1077,8 +1098,8 @@ int init_mpi_comms(std::vector<cs::catom_t> & catom_array){
 			recv_data[si+index]=remote_atom_number;
 		}
 		int rsi=vmpi::send_start_index_array[cpu];
-		requests.push_back(MPI::COMM_WORLD.Isend(&recv_data[si],vmpi::recv_num_array[cpu],MPI_INT,cpu,61));
-		requests.push_back(MPI::COMM_WORLD.Irecv(&vmpi::send_atom_translation_array[rsi],vmpi::send_num_array[cpu],MPI_INT,cpu,61));
+		requests.push_back(vmpi::comm.Isend(&recv_data[si],vmpi::recv_num_array[cpu],MPI_INT,cpu,61));
+		requests.push_back(vmpi::comm.Irecv(&vmpi::send_atom_translation_array[rsi],vmpi::send_num_array[cpu],MPI_INT,cpu,61));
 	}
 
 	stati.resize(requests.size());
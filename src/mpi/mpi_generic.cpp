@@ -33,6 +33,8 @@
 //====================================================================================
 
 #include "errors.hpp"
+#include "random.hpp"
+#include "vio.hpp"
 #include "vmpi.hpp"
 #include <iostream>
 #include <fstream>
@@ -71,6 +73,10 @@ int initialise(){
 	// Get number of processors and rank
 	vmpi::my_rank = MPI::COMM_WORLD.Get_rank();
 	vmpi::num_processors = MPI::COMM_WORLD.Get_size();
+	vmpi::world_rank = vmpi::my_rank;
+
+	// All processors simulate a single system unless split into replicas
+	vmpi::comm = MPI::COMM_WORLD;
 	MPI::Get_processor_name(vmpi::hostname, resultlen);
 
 	// Start MPI Timer
@@ -79,6 +85,58 @@ int initialise(){
 	return EXIT_SUCCESS;	
 }
 
+//-----------------------------------------------------------------------------
+// Function to split processors into groups for statistical parallelism.
+// Each group simulates an independent replica of the system by geometric
+// decomposition, with communicator vmpi::comm and rank and number of
+// processors within the group. Replicas use different random seeds.
+//-----------------------------------------------------------------------------
+int initialise_replicas(){
+
+	// check calling of routine if error checking is activated
+	if(err::check==true){std::cout << "vmpi::initialise_replicas has been called" << std::endl;}
+
+	const int num_world_processors = MPI::COMM_WORLD.Get_size();
+
+	// Default to one replica per processor
+	if(vmpi::num_replicas==0) vmpi::num_replicas=num_world_processors;
+
+	if(vmpi::num_replicas>num_world_processors || num_world_processors%vmpi::num_replicas!=0){
+		terminaltextcolor(RED);
+		std::cerr << "Error: Number of replicas for statistical parallelism (" << vmpi::num_replicas << ") must be a factor of the number of processors (" << num_world_processors << "). Exiting." << std::endl;
+		terminaltextcolor(WHITE);
+		zlog << zTs() << "Error: Number of replicas for statistical parallelism (" << vmpi::num_replicas << ") must be a factor of the number of processors (" << num_world_processors << "). Exiting." << std::endl;
+		err::vexit();
+	}
+
+	// Configuration files are named by processor and snapshot only, and so
+	// would be overwritten by other replicas
+	if(vmpi::num_replicas>1 && (vout::output_atoms_config || vout::output_cells_config)){
+		terminaltextcolor(RED);
+		std::cerr << "Error: Configuration output is not available for statistical parallelism with more than one replica. Exiting." << std::endl;
+		terminaltextcolor(WHITE);
+		zlog << zTs() << "Error: Configuration output is not available for statistical parallelism with more than one replica. Exiting." << std::endl;
+		err::vexit();
+	}
+
+	// Assign contiguous ranks to each replica
+	const int processors_per_replica = num_world_processors/vmpi::num_replicas;
+	vmpi::replica_id = vmpi::world_rank/processors_per_replica;
+
+	vmpi::comm = MPI::COMM_WORLD.Split(vmpi::replica_id, vmpi::world_rank);
+	vmpi::my_rank = vmpi::comm.Get_rank();
+	vmpi::num_processors = vmpi::comm.Get_size();
+
+	// Offset random seed for each replica
+	mtrandom::integration_seed = int(uint32_t(mtrandom::integration_seed) + uint32_t(vmpi::replica_id)*2654435761u);
+
+	zlog << zTs() << "Statistical parallelism: processor " << vmpi::world_rank << " is rank " << vmpi::my_rank << " of " << vmpi::num_processors;
+	zlog << " in replica " << vmpi::replica_id << " of " << vmpi::num_replicas << std::endl;
+
+	return EXIT_SUCCESS;
+
+}
+
 int hosts(){
 	//====================================================================================
 	//
@@ -141,12 +199,12 @@ int finalise(){
 	//	std::cout << "node01:" << p << " " << sizes.at(p) << std::endl;
 	//}
 	
-	// Gather timings
-	if(DetailedMPITiming){
+	// Gather timings of first replica
+	if(DetailedMPITiming && replica_id==0){
 		std::vector<double> AllTimes(0);
 		if(my_rank==0) AllTimes.resize(num_processors*WaitTimeArray.size());
 		
-		MPI_Gather(&WaitTimeArray[0],WaitTimeArray.size(),MPI_DOUBLE,&AllTimes[0],WaitTimeArray.size(),MPI_DOUBLE,0,MPI_COMM_WORLD); 
+		MPI_Gather(&WaitTimeArray[0],WaitTimeArray.size(),MPI_DOUBLE,&AllTimes[0],WaitTimeArray.size(),MPI_DOUBLE,0,vmpi::comm); 
 
 		if(my_rank==0){
 			std::ofstream WaitTimesOFS;
@@ -163,7 +221,7 @@ int finalise(){
 			WaitTimesOFS.close();
 		}
 		
-		MPI_Gather(&ComputeTimeArray[0],ComputeTimeArray.size(),MPI_DOUBLE,&AllTimes[0],ComputeTimeArray.size(),MPI_DOUBLE,0,MPI_COMM_WORLD); 
+		MPI_Gather(&ComputeTimeArray[0],ComputeTimeArray.size(),MPI_DOUBLE,&AllTimes[0],ComputeTimeArray.size(),MPI_DOUBLE,0,vmpi::comm); 
 
 		if(my_rank==0){
 			std::ofstream ComputeTimesOFS;
@@ -0,0 +1,273 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+//
+//    Sparse summation of item values over processors. Each item (such as a
+//    macrocell or grain) is owned by one processor, with items divided into
+//    contiguous blocks. Processors send partial values for their local items
+//    to the owners, which sum them, and the totals are then sent back to the
+//    processors which need them. Only items with local atoms are sent and
+//    only needed items are received, in place of reductions over all items
+//    on all processors. Where all processors need all items with
+//    contributions (as for demag calculations) the totals are distributed
+//    with a single gather. The communication pattern is set up once, and
+//    only values are communicated in each summation.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <algorithm>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+// Vampire headers
+#include "vio.hpp"
+#include "vmpi.hpp"
+
+namespace vmpi{
+
+   namespace internal{
+
+      //-----------------------------------------------------------------------
+      // Function to return pointer to vector data, or NULL if empty
+      //-----------------------------------------------------------------------
+      template <typename T>
+      T* data(std::vector<T>& v){
+         return v.empty() ? NULL : &v[0];
+      }
+
+      //-----------------------------------------------------------------------
+      // Function to calculate first item owned by processor
+      //-----------------------------------------------------------------------
+      int first_owned_item(const int rank, const int num_items, const int num_processors){
+         return int((int64_t(rank)*int64_t(num_items)+num_processors-1)/int64_t(num_processors));
+      }
+
+   } // end of namespace internal
+
+   sparse_sum_t::sparse_sum_t():
+      num_components(0),
+      num_needed(0),
+      gather_all(false)
+   {}
+
+   //--------------------------------------------------------------------------
+   // Function to set up communication pattern for sparse summation
+   //--------------------------------------------------------------------------
+   void sparse_sum_t::initialise(const std::vector<int>& local_items, const std::vector<int>& needed_items, const int num_items, const int num_comps){
+
+      num_components=num_comps;
+      num_needed=needed_items.size();
+      gather_all=false;
+
+      #ifdef MPICF
+
+         const int P=vmpi::num_processors;
+         const int owned_start=internal::first_owned_item(vmpi::my_rank, num_items, P);
+         const int num_owned=internal::first_owned_item(vmpi::my_rank+1, num_items, P)-owned_start;
+
+         // sort local and needed items by owner, which is the same as sorting by item
+         std::vector<std::pair<int,int> > sorted;
+         std::vector<int> counts(P,0);
+         std::vector<int> displacements(P,0);
+         std::vector<int> ids;
+         std::vector<int> remote_counts(P,0);
+         std::vector<int> remote_displacements(P,0);
+         std::vector<int> remote_ids;
+
+         //---------------------------------------------------------------------
+         // Send ids of local items to their owners
+         //---------------------------------------------------------------------
+         sorted.resize(local_items.size());
+         for(unsigned int i=0;i<local_items.size();i++) sorted[i]=std::make_pair(local_items[i],int(i));
+         std::sort(sorted.begin(),sorted.end());
+
+         send_order.resize(sorted.size());
+         ids.resize(sorted.size());
+         std::fill(counts.begin(),counts.end(),0);
+         for(unsigned int i=0;i<sorted.size();i++){
+            ids[i]=sorted[i].first;
+            send_order[i]=sorted[i].second;
+            counts[int(int64_t(ids[i])*int64_t(P)/int64_t(num_items))]++;
+         }
+         for(int p=1;p<P;p++) displacements[p]=displacements[p-1]+counts[p-1];
+
+         MPI_Alltoall(&counts[0], 1, MPI_INT, &remote_counts[0], 1, MPI_INT, vmpi::comm);
+         for(int p=1;p<P;p++) remote_displacements[p]=remote_displacements[p-1]+remote_counts[p-1];
+         remote_ids.resize(remote_displacements[P-1]+remote_counts[P-1]);
+         MPI_Alltoallv(internal::data(ids), &counts[0], &displacements[0], MPI_INT,
+                       internal::data(remote_ids), &remote_counts[0], &remote_displacements[0], MPI_INT, vmpi::comm);
+
+         recv_owned_index.resize(remote_ids.size());
+         for(unsigned int i=0;i<remote_ids.size();i++) recv_owned_index[i]=remote_ids[i]-owned_start;
+
+         send_counts.resize(P);
+         send_displacements.resize(P);
+         recv_counts.resize(P);
+         recv_displacements.resize(P);
+         for(int p=0;p<P;p++){
+            send_counts[p]=counts[p]*num_components;
+            send_displacements[p]=displacements[p]*num_components;
+            recv_counts[p]=remote_counts[p]*num_components;
+            recv_displacements[p]=remote_displacements[p]*num_components;
+         }
+
+         // determine owned items with contributions
+         std::vector<bool> contributed(num_owned,false);
+         for(unsigned int i=0;i<recv_owned_index.size();i++) contributed[recv_owned_index[i]]=true;
+         std::vector<int> contributed_items;
+         for(int i=0;i<num_owned;i++) if(contributed[i]) contributed_items.push_back(i);
+
+         //---------------------------------------------------------------------
+         // Send ids of needed items to their owners
+         //---------------------------------------------------------------------
+         sorted.resize(needed_items.size());
+         for(unsigned int i=0;i<needed_items.size();i++) sorted[i]=std::make_pair(needed_items[i],int(i));
+         std::sort(sorted.begin(),sorted.end());
+
+         request_needed_index.resize(sorted.size());
+         ids.resize(sorted.size());
+         std::fill(counts.begin(),counts.end(),0);
+         for(unsigned int i=0;i<sorted.size();i++){
+            ids[i]=sorted[i].first;
+            request_needed_index[i]=sorted[i].second;
+            counts[int(int64_t(ids[i])*int64_t(P)/int64_t(num_items))]++;
+         }
+         displacements[0]=0;
+         for(int p=1;p<P;p++) displacements[p]=displacements[p-1]+counts[p-1];
+
+         MPI_Alltoall(&counts[0], 1, MPI_INT, &remote_counts[0], 1, MPI_INT, vmpi::comm);
+         remote_displacements[0]=0;
+         for(int p=1;p<P;p++) remote_displacements[p]=remote_displacements[p-1]+remote_counts[p-1];
+         remote_ids.resize(remote_displacements[P-1]+remote_counts[P-1]);
+         MPI_Alltoallv(internal::data(ids), &counts[0], &displacements[0], MPI_INT,
+                       internal::data(remote_ids), &remote_counts[0], &remote_displacements[0], MPI_INT, vmpi::comm);
+
+         reply_owned_index.resize(remote_ids.size());
+         for(unsigned int i=0;i<remote_ids.size();i++) reply_owned_index[i]=remote_ids[i]-owned_start;
+
+         // check if all processors need exactly the owned items with contributions
+         int all=1;
+         for(int p=0;p<P;p++){
+            if(remote_counts[p]!=int(contributed_items.size())){
+               all=0;
+               break;
+            }
+            for(int i=0;i<remote_counts[p];i++){
+               if(reply_owned_index[remote_displacements[p]+i]!=contributed_items[i]){
+                  all=0;
+                  break;
+               }
+            }
+         }
+         MPI_Allreduce(MPI_IN_PLACE, &all, 1, MPI_INT, MPI_MIN, vmpi::comm);
+         gather_all=(all==1);
+
+         if(gather_all){
+            // reply with contributed items to all processors in a single gather
+            reply_owned_index.swap(contributed_items);
+            std::fill(remote_counts.begin(),remote_counts.end(),int(reply_owned_index.size()));
+            remote_displacements[0]=0;
+            for(int p=1;p<P;p++) remote_displacements[p]=remote_displacements[p-1]+remote_counts[p-1];
+         }
+
+         reply_counts.resize(P);
+         reply_displacements.resize(P);
+         request_counts.resize(P);
+         request_displacements.resize(P);
+         for(int p=0;p<P;p++){
+            reply_counts[p]=remote_counts[p]*num_components;
+            reply_displacements[p]=remote_displacements[p]*num_components;
+            request_counts[p]=counts[p]*num_components;
+            request_displacements[p]=displacements[p]*num_components;
+         }
+
+         owned_data.resize(num_owned*num_components);
+
+         zlog << zTs() << "Sparse summation of " << num_items << " items set up on rank " << vmpi::my_rank << " with " << local_items.size()
+              << " local items and " << needed_items.size() << " needed items" << (gather_all ? " using gather of all items" : "") << std::endl;
+
+      #else
+
+         // all items are local, and so needed items are copied from local items
+         std::vector<int> local_position(num_items,-1);
+         for(unsigned int i=0;i<local_items.size();i++) local_position[local_items[i]]=i;
+         request_needed_index.resize(num_needed);
+         for(int i=0;i<num_needed;i++) request_needed_index[i]=local_position[needed_items[i]];
+
+      #endif
+
+      return;
+
+   }
+
+   //--------------------------------------------------------------------------
+   // Function to sum values of local items over processors
+   //--------------------------------------------------------------------------
+   void sparse_sum_t::sum(const std::vector<double>& local_data, std::vector<double>& needed_data){
+
+      const int nc=num_components;
+
+      needed_data.resize(num_needed*nc);
+
+      #ifdef MPICF
+
+         // send partial values of local items to owners
+         send_buffer.resize(send_order.size()*nc);
+         for(unsigned int i=0;i<send_order.size();i++){
+            for(int c=0;c<nc;c++) send_buffer[i*nc+c]=local_data[send_order[i]*nc+c];
+         }
+         recv_buffer.resize(recv_owned_index.size()*nc);
+         MPI_Alltoallv(internal::data(send_buffer), &send_counts[0], &send_displacements[0], MPI_DOUBLE,
+                       internal::data(recv_buffer), &recv_counts[0], &recv_displacements[0], MPI_DOUBLE, vmpi::comm);
+
+         // sum contributions in order of processor rank
+         std::fill(owned_data.begin(),owned_data.end(),0.0);
+         for(unsigned int i=0;i<recv_owned_index.size();i++){
+            for(int c=0;c<nc;c++) owned_data[recv_owned_index[i]*nc+c]+=recv_buffer[i*nc+c];
+         }
+
+         // send totals to processors which need them
+         if(gather_all){
+            send_buffer.resize(reply_owned_index.size()*nc);
+            for(unsigned int i=0;i<reply_owned_index.size();i++){
+               for(int c=0;c<nc;c++) send_buffer[i*nc+c]=owned_data[reply_owned_index[i]*nc+c];
+            }
+            recv_buffer.resize(request_needed_index.size()*nc);
+            MPI_Allgatherv(internal::data(send_buffer), int(send_buffer.size()), MPI_DOUBLE,
+                           internal::data(recv_buffer), &request_counts[0], &request_displacements[0], MPI_DOUBLE, vmpi::comm);
+         }
+         else{
+            send_buffer.resize(reply_owned_index.size()*nc);
+            for(unsigned int i=0;i<reply_owned_index.size();i++){
+               for(int c=0;c<nc;c++) send_buffer[i*nc+c]=owned_data[reply_owned_index[i]*nc+c];
+            }
+            recv_buffer.resize(request_needed_index.size()*nc);
+            MPI_Alltoallv(internal::data(send_buffer), &reply_counts[0], &reply_displacements[0], MPI_DOUBLE,
+                          internal::data(recv_buffer), &request_counts[0], &request_displacements[0], MPI_DOUBLE, vmpi::comm);
+         }
+
+         for(unsigned int i=0;i<request_needed_index.size();i++){
+            for(int c=0;c<nc;c++) needed_data[request_needed_index[i]*nc+c]=recv_buffer[i*nc+c];
+         }
+
+      #else
+
+         for(int i=0;i<num_needed;i++){
+            const int l=request_needed_index[i];
+            for(int c=0;c<nc;c++) needed_data[i*nc+c] = l>=0 ? local_data[l*nc+c] : 0.0;
+         }
+
+      #endif
+
+      return;
+
+   }
+
+} // end of namespace vmpi
@@ -116,7 +116,7 @@ int LLB_Boltzmann(){
 			P1D[para]=0.0;
 		}
 		// Simulate system
-		for(sim::time=0;sim::time<10000000;sim::time+=1){
+		for(sim::time=0,sim::physical_time=0.0;sim::time<10000000;sim::time+=1,sim::physical_time+=mp::dt_SI){
 			// Calculate LLG
 			sim::LLB(1);
 			  if(sim::time%100000==0){
@@ -89,12 +89,13 @@ void cmc_anisotropy(){
 	if(err::check==true){std::cout << "program::cmc_anisotropy has been called" << std::endl;}
 
 	// Check integrator is CMC, if not then exit disgracefully
-	if(sim::integrator!=3){
+	if(sim::integrator!=sim::constrained_monte_carlo){
 		err::zexit("Program CMC-anisotropy requires Constrained Monte Carlo as the integrator. Check input file.");
 	}
 	
 	// set minimum rotational angle
 	sim::constraint_theta=sim::constraint_theta_min;
+	vmpi::replica_point=0;
 
 	// perform rotational angle sweep
 	while(sim::constraint_theta<=sim::constraint_theta_max){
@@ -104,55 +105,65 @@ void cmc_anisotropy(){
 
 		// perform azimuthal angle sweep
 		while(sim::constraint_phi<=sim::constraint_phi_max){
-			
-			// Re-initialise spin moments for CMC
-			sim::CMCinit();
-			
-			// Set starting temperature
-			sim::temperature=sim::Tmin;
-			
-			// Perform Temperature Loop
-			while(sim::temperature<=sim::Tmax){
-
-				// Equilibrate system
-				sim::integrate(sim::equilibration_time);
-				
-				// Reset mean magnetisation counters
-				stats::mag_m_reset();
-				
-				// Reset start time
-				int start_time=sim::time;
-
-				// Simulate system
-				while(sim::time<sim::loop_time+start_time){
-					
-					// Integrate system
-					sim::integrate(sim::partial_time);
-				
-					// Calculate magnetisation statistics
-					stats::mag_m();
-
-				}
-				
-				// Output data
-				vout::data();
-				
-				// Increment temperature
-				sim::temperature+=sim::delta_temperature;
-				
-			} // End of temperature loop
-			
+
+			// Simulate only angles assigned to this replica for statistical parallelism
+			if(vmpi::is_replica_point()){
+
+				// Re-initialise spin moments for CMC
+				sim::CMCinit();
+
+				// Set starting temperature
+				sim::temperature=sim::Tmin;
+
+				// Perform Temperature Loop
+				while(sim::temperature<=sim::Tmax){
+
+					// Equilibrate system
+					sim::integrate(sim::equilibration_time);
+
+					// Reset mean magnetisation counters
+					stats::mag_m_reset();
+
+					// Reset start time
+					int start_time=sim::time;
+
+					// Simulate system
+					while(sim::time<sim::loop_time+start_time){
+
+						// Integrate system
+						sim::integrate(sim::partial_time);
+
+						// Calculate magnetisation statistics
+						stats::mag_m();
+
+					}
+
+					// Output data
+					vout::data();
+
+					// Increment temperature
+					sim::temperature+=sim::delta_temperature;
+
+				} // End of temperature loop
+
+			}
+
 			// Increment azimuthal angle
 			sim::constraint_phi+=sim::constraint_phi_delta;
 			sim::constraint_phi_changed=true;
-			
+			vmpi::replica_point++;
+
 		} // End of azimuthal angle sweep
-      if(vout::gnuplot_array_format) zmag << std::endl;
+
+		// separate rows of angles, from the replica simulating the last angle of the row
+		vmpi::replica_point--;
+		if(vout::gnuplot_array_format) vout::data_block_separator();
+		vmpi::replica_point++;
 
 		// Increment rotational angle
 		sim::constraint_theta+=sim::constraint_theta_delta;
 		sim::constraint_theta_changed=true;
-		
+
 	} // End of rotational angle sweep
 
 	return;
@@ -95,36 +95,43 @@ int curie_temperature(){
 
 	// Set starting temperature
 	sim::temperature=sim::Tmin;
+	vmpi::replica_point=0;
 
 	// Perform Temperature Loop
 	while(sim::temperature<=sim::Tmax){
 
-		// Equilibrate system
-		sim::integrate(sim::equilibration_time);
-		
-		// Reset mean magnetisation counters
-		stats::mag_m_reset();
-		
-		// Reset start time
-		int start_time=sim::time;
-
-		// Simulate system
-		while(sim::time<sim::loop_time+start_time){
-			
-			// Integrate system
-			sim::integrate(sim::partial_time);
-		
-			// Calculate magnetisation statistics
-			stats::mag_m();
+		// Simulate only temperatures assigned to this replica for statistical parallelism
+		if(vmpi::is_replica_point()){
+
+			// Equilibrate system
+			sim::integrate(sim::equilibration_time);
+
+			// Reset mean magnetisation counters
+			stats::mag_m_reset();
+
+			// Reset start time
+			int start_time=sim::time;
+
+			// Simulate system
+			while(sim::time<sim::loop_time+start_time){
+
+				// Integrate system
+				sim::integrate(sim::partial_time);
+
+				// Calculate magnetisation statistics
+				stats::mag_m();
+
+			}
+
+			// Output data
+			vout::data();
 
 		}
-		
-		// Output data
-		vout::data();
-		
+
 		// Increment temperature
 		sim::temperature+=sim::delta_temperature;
-		
+		vmpi::replica_point++;
+
 	} // End of temperature loop
 		
 	return EXIT_SUCCESS;
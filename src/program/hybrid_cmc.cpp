@@ -90,7 +90,7 @@ void hybrid_cmc(){
 	if(err::check==true){std::cout << "program::hybrid_cmc has been called" << std::endl;}
 
 	// Check integrator is CMC, if not then exit disgracefully
-	if(sim::integrator!=4){
+	if(sim::integrator!=sim::hybrid_constrained_monte_carlo){
 		terminaltextcolor(RED);
 		std::cerr << "Error! cmc-anisotropy program requires Hybrid Constrained Monte Carlo as the integrator. Exiting." << std::endl; 
 		terminaltextcolor(WHITE);
@@ -207,7 +207,7 @@ void reverse_hybrid_cmc(){
    if(err::check==true){std::cout << "program::reversed_hybrid_cmc has been called" << std::endl;}
 
    // Check integrator is CMC, if not then exit disgracefully
-   if(sim::integrator!=4){
+   if(sim::integrator!=sim::hybrid_constrained_monte_carlo){
 	  terminaltextcolor(RED);
       std::cerr << "Error! cmc-anisotropy program requires Hybrid Constrained Monte Carlo as the integrator. Exiting." << std::endl; 
 	  terminaltextcolor(WHITE);
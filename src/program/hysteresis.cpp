@@ -161,6 +161,13 @@ int hysteresis(){
 				// Calculate mag_m, mag
 				stats::mag_m();
 
+				// Energy minimisation has no dynamics, so use converged state only
+				if(sim::integrator==sim::energy_minimisation && stats::max_torque()<sim::minimiser_tolerance){
+					stats::mag_m_reset();
+					stats::mag_m();
+					break;
+				}
+
 			}
 
 			// Increment of iH
@@ -0,0 +1,300 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+//
+//    Replica exchange (parallel tempering) program. A ladder of temperatures
+//    from sim:minimum-temperature to sim:maximum-temperature is simulated at
+//    once, with one configuration of the system at each temperature. After
+//    every sim:time-steps-increment steps, configurations at neighbouring
+//    temperatures are exchanged with probability
+//
+//       P = min[1, exp((1/kTi - 1/kTj)(Ei - Ej))]
+//
+//    so that configurations trapped in metastable states at low temperature
+//    decorrelate by passing through high temperatures.
+//
+//    Configurations are stored in memory and simulated in turn. For
+//    statistical parallelism the configurations are distributed over the
+//    replicas, and an exchange swaps the temperatures of two configurations
+//    so that no spins are communicated. Exchange decisions use counter based
+//    random numbers and are identical on all processors.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// Vampire Header files
+#include "atoms.hpp"
+#include "errors.hpp"
+#include "material.hpp"
+#include "program.hpp"
+#include "random.hpp"
+#include "sim.hpp"
+#include "vio.hpp"
+#include "vmpi.hpp"
+
+// Function prototypes
+#ifdef MPICF
+int mpi_init_halo_swap();
+int mpi_complete_halo_swap();
+#endif
+
+//-----------------------------------------------------------------------------
+// Function to calculate total energy of the local replica in Joules,
+// counting each exchange interaction once
+//-----------------------------------------------------------------------------
+double replica_exchange_energy(const int num_local_atoms){
+
+   // update halo spins for exchange energy
+   #ifdef MPICF
+      mpi_init_halo_swap();
+      mpi_complete_halo_swap();
+   #endif
+
+   const int AtomExchangeType = atoms::exchange_type;
+
+   double energy=0.0;
+   for(int atom=0;atom<num_local_atoms;atom++){
+      const int imaterial=atoms::type_array[atom];
+      const double onsite = sim::calculate_spin_onsite_energy(atom, atoms::x_spin_array[atom], atoms::y_spin_array[atom], atoms::z_spin_array[atom]);
+      energy += 0.5*mp::material_hot_params[imaterial].mu_s_SI*(sim::calculate_spin_energy(atom, AtomExchangeType) + onsite);
+   }
+
+   #ifdef MPICF
+      MPI_Allreduce(MPI_IN_PLACE, &energy, 1, MPI_DOUBLE, MPI_SUM, vmpi::comm);
+   #endif
+
+   return energy;
+
+}
+
+//-----------------------------------------------------------------------------
+// Function to calculate reduced magnetisation length of the local replica
+//-----------------------------------------------------------------------------
+double replica_exchange_magnetisation(const int num_local_atoms){
+
+   double m[4]={0.0,0.0,0.0,0.0};
+   for(int atom=0;atom<num_local_atoms;atom++){
+      const double mu_s = atoms::m_spin_array[atom];
+      m[0]+=mu_s*atoms::x_spin_array[atom];
+      m[1]+=mu_s*atoms::y_spin_array[atom];
+      m[2]+=mu_s*atoms::z_spin_array[atom];
+      m[3]+=mu_s;
+   }
+
+   #ifdef MPICF
+      MPI_Allreduce(MPI_IN_PLACE, m, 4, MPI_DOUBLE, MPI_SUM, vmpi::comm);
+   #endif
+
+   return sqrt(m[0]*m[0]+m[1]*m[1]+m[2]*m[2])/m[3];
+
+}
+
+namespace program{
+
+//-----------------------------------------------------------------------------
+// Program to calculate the temperature dependent magnetisation and
+// susceptibility using replica exchange Monte Carlo
+//-----------------------------------------------------------------------------
+void replica_exchange(){
+
+   // check calling of routine if error checking is activated
+   if(err::check==true) std::cout << "program::replica_exchange has been called" << std::endl;
+
+   #ifdef MPICF
+      const int num_local_atoms = vmpi::num_core_atoms+vmpi::num_bdry_atoms;
+   #else
+      const int num_local_atoms = atoms::num_atoms;
+   #endif
+
+   // Determine temperature ladder
+   std::vector<double> temperatures;
+   double temperature=sim::Tmin;
+   while(temperature<=sim::Tmax){
+      temperatures.push_back(temperature);
+      temperature+=sim::delta_temperature;
+   }
+   const int num_temperatures = temperatures.size();
+
+   if(num_temperatures<2 || sim::Tmin<=0.0){
+      terminaltextcolor(RED);
+      std::cerr << "Error: Replica exchange program requires a minimum temperature greater than zero and at least two temperatures. Exiting." << std::endl;
+      terminaltextcolor(WHITE);
+      zlog << zTs() << "Error: Replica exchange program requires a minimum temperature greater than zero and at least two temperatures. Exiting." << std::endl;
+      err::vexit();
+   }
+
+   // inverse temperatures 1/kT in 1/J
+   std::vector<double> beta(num_temperatures);
+   for(int t=0;t<num_temperatures;t++) beta[t]=1.0/(1.3806503e-23*temperatures[t]);
+
+   // Store initial state for all configurations simulated by local replica
+   std::vector<std::vector<double> > spins(num_temperatures);
+   for(int c=0;c<num_temperatures;c++){
+      vmpi::replica_point=c;
+      if(vmpi::is_replica_point()){
+         spins[c].resize(3*atoms::num_atoms);
+         for(int atom=0;atom<atoms::num_atoms;atom++){
+            spins[c][3*atom+0]=atoms::x_spin_array[atom];
+            spins[c][3*atom+1]=atoms::y_spin_array[atom];
+            spins[c][3*atom+2]=atoms::z_spin_array[atom];
+         }
+      }
+   }
+
+   // Temperature of each configuration and configuration at each temperature
+   std::vector<int> config_temperature(num_temperatures);
+   std::vector<int> temperature_config(num_temperatures);
+   for(int c=0;c<num_temperatures;c++){
+      config_temperature[c]=c;
+      temperature_config[c]=c;
+   }
+
+   // Seed for exchanges, identical for all replicas
+   uint32_t exchange_seed = mtrandom::integration_seed;
+   #ifdef MPICF
+      MPI::COMM_WORLD.Bcast(&exchange_seed,1,MPI_UNSIGNED,0);
+   #endif
+
+   // Statistics for each temperature and neighbouring pair of temperatures
+   std::vector<double> mean_m(num_temperatures,0.0);
+   std::vector<double> mean_m_sq(num_temperatures,0.0);
+   std::vector<double> exchange_attempts(num_temperatures-1,0.0);
+   std::vector<double> exchange_accepts(num_temperatures-1,0.0);
+   double mean_counter=0.0;
+
+   // Total moment of system in mu_B for susceptibility
+   double saturation=0.0;
+   for(int atom=0;atom<num_local_atoms;atom++) saturation+=atoms::m_spin_array[atom];
+   #ifdef MPICF
+      MPI_Allreduce(MPI_IN_PLACE, &saturation, 1, MPI_DOUBLE, MPI_SUM, vmpi::comm);
+   #endif
+
+   std::vector<double> energy(num_temperatures);
+   std::vector<double> magnetisation(num_temperatures);
+
+   const uint64_t num_equilibration_exchanges = sim::equilibration_time/sim::partial_time;
+   const uint64_t num_exchanges = num_equilibration_exchanges + sim::loop_time/sim::partial_time;
+
+   for(uint64_t exchange=0;exchange<num_exchanges;exchange++){
+
+      const bool measure = (exchange>=num_equilibration_exchanges);
+
+      std::fill(energy.begin(),energy.end(),0.0);
+      std::fill(magnetisation.begin(),magnetisation.end(),0.0);
+
+      // Simulate each configuration at its current temperature
+      for(int c=0;c<num_temperatures;c++){
+         vmpi::replica_point=c;
+         if(!vmpi::is_replica_point()) continue;
+
+         for(int atom=0;atom<atoms::num_atoms;atom++){
+            atoms::x_spin_array[atom]=spins[c][3*atom+0];
+            atoms::y_spin_array[atom]=spins[c][3*atom+1];
+            atoms::z_spin_array[atom]=spins[c][3*atom+2];
+         }
+
+         sim::temperature=temperatures[config_temperature[c]];
+         sim::integrate(sim::partial_time);
+
+         const double E = replica_exchange_energy(num_local_atoms);
+         const double m = replica_exchange_magnetisation(num_local_atoms);
+
+         // store values once for each replica for reduction over all processors
+         if(vmpi::my_rank==0){
+            energy[c]=E;
+            magnetisation[c]=m;
+         }
+
+         for(int atom=0;atom<atoms::num_atoms;atom++){
+            spins[c][3*atom+0]=atoms::x_spin_array[atom];
+            spins[c][3*atom+1]=atoms::y_spin_array[atom];
+            spins[c][3*atom+2]=atoms::z_spin_array[atom];
+         }
+      }
+
+      #ifdef MPICF
+         if(vmpi::mpi_mode==2){
+            MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&energy[0],num_temperatures,MPI_DOUBLE,MPI_SUM);
+            MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&magnetisation[0],num_temperatures,MPI_DOUBLE,MPI_SUM);
+         }
+         else{
+            MPI::COMM_WORLD.Bcast(&energy[0],num_temperatures,MPI_DOUBLE,0);
+            MPI::COMM_WORLD.Bcast(&magnetisation[0],num_temperatures,MPI_DOUBLE,0);
+         }
+      #endif
+
+      // Accumulate magnetisation statistics at each temperature
+      if(measure){
+         for(int t=0;t<num_temperatures;t++){
+            const double m = magnetisation[temperature_config[t]];
+            mean_m[t]+=m;
+            mean_m_sq[t]+=m*m;
+         }
+         mean_counter+=1.0;
+      }
+
+      // Attempt exchanges of alternate neighbouring pairs of temperatures
+      for(int t=exchange%2;t<num_temperatures-1;t+=2){
+
+         const int ci=temperature_config[t];
+         const int cj=temperature_config[t+1];
+         const double delta = (beta[t]-beta[t+1])*(energy[ci]-energy[cj]);
+
+         const uint32_t counter[4] = {uint32_t(exchange), uint32_t(exchange>>32), uint32_t(t), 0x52455843u};
+         const uint32_t key[2] = {exchange_seed, 0x54454d50u};
+         uint32_t random[4];
+         mtrandom::philox4x32(counter, key, random);
+         const double r = double(random[0])*(1.0/4294967296.0);
+
+         const bool accept = (delta>=0.0 || exp(delta)>r);
+         if(accept){
+            temperature_config[t]=cj;
+            temperature_config[t+1]=ci;
+            config_temperature[ci]=t+1;
+            config_temperature[cj]=t;
+         }
+
+         if(measure){
+            exchange_attempts[t]+=1.0;
+            if(accept) exchange_accepts[t]+=1.0;
+         }
+
+      }
+
+   }
+
+   // Output temperature dependent magnetisation, susceptibility and exchange rates
+   if(vmpi::world_rank==0){
+
+      std::ofstream ofile("replica_exchange.dat");
+      ofile << "# temperature\tmean-magnetisation-length\tmean-susceptibility\texchange-acceptance-rate" << std::endl;
+
+      for(int t=0;t<num_temperatures;t++){
+         const double m = mean_m[t]/mean_counter;
+         const double m_sq = mean_m_sq[t]/mean_counter;
+         const double chi = 9.274e-24*saturation*(m_sq-m*m)/(1.3806503e-23*temperatures[t]);
+         const double rate = (t<num_temperatures-1 && exchange_attempts[t]>0.0) ? exchange_accepts[t]/exchange_attempts[t] : 0.0;
+         ofile << temperatures[t] << "\t" << m << "\t" << chi << "\t" << rate << std::endl;
+         zlog << zTs() << "Replica exchange: T = " << temperatures[t] << " K, m = " << m << ", chi = " << chi << ", exchange acceptance rate = " << rate << std::endl;
+      }
+
+      ofile.close();
+
+   }
+
+   return;
+
+}
+
+} // end of namespace program
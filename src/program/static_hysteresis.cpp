@@ -107,7 +107,11 @@ int static_hysteresis(){
 				sim::integrate(sim::partial_time);
 				
 				double torque=stats::max_torque(); // needs correcting for new integrators
-				if((torque<1.0e-6) && (sim::time-start_time>100)){
+				// Energy minimisation is converged as soon as torque is small
+				if(sim::integrator==sim::energy_minimisation){
+					if(torque<sim::minimiser_tolerance) break;
+				}
+				else if((torque<1.0e-6) && (sim::time-start_time>100)){
 					break;
 				}
 
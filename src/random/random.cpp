@@ -23,6 +23,7 @@
 // ----------------------------------------------------------------------------
 //
 #include "random.hpp"
+#include "vomp.hpp"
 #include <cmath>
 
 using std::log;
@@ -42,6 +43,7 @@ namespace mtrandom
 	double number2;
 	bool logic=false;
 	MTRand grnd; // single sequence of random numbers
+	uint64_t thermal_step=0; // counter for thermal field random numbers
 
   
 double gaussian_old(){
@@ -271,5 +273,161 @@ double gaussianc(MTRand& grnd){
   return  sign ? x : -x;
 }
 
+//-----------------------------------------------------------------------------
+// Philox4x32-10 counter-based generator
+//
+// J. K. Salmon, M. A. Moraes, R. O. Dror and D. E. Shaw, "Parallel random
+// numbers: as easy as 1, 2, 3", Proceedings of SC11 (2011)
+//-----------------------------------------------------------------------------
+const uint32_t philox_m0 = 0xD2511F53;
+const uint32_t philox_m1 = 0xCD9E8D57;
+const uint32_t philox_w0 = 0x9E3779B9;
+const uint32_t philox_w1 = 0xBB67AE85;
+
+inline void philox_round(uint32_t ctr[4], const uint32_t key[2]){
+	const uint64_t p0 = uint64_t(philox_m0)*uint64_t(ctr[0]);
+	const uint64_t p1 = uint64_t(philox_m1)*uint64_t(ctr[2]);
+	const uint32_t c0 = uint32_t(p1 >> 32) ^ ctr[1] ^ key[0];
+	const uint32_t c1 = uint32_t(p1);
+	const uint32_t c2 = uint32_t(p0 >> 32) ^ ctr[3] ^ key[1];
+	const uint32_t c3 = uint32_t(p0);
+	ctr[0]=c0; ctr[1]=c1; ctr[2]=c2; ctr[3]=c3;
+}
+
+inline void philox4x32_10(const uint32_t counter[4], const uint32_t key[2], uint32_t result[4]){
+	uint32_t k[2] = {key[0], key[1]};
+	result[0]=counter[0]; result[1]=counter[1]; result[2]=counter[2]; result[3]=counter[3];
+	for(int r=0; r<10; r++){
+		philox_round(result, k);
+		k[0]+=philox_w0;
+		k[1]+=philox_w1;
+	}
+}
+
+void philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t result[4]){
+	philox4x32_10(counter, key, result);
+}
+
+/// Converts a 32-bit integer to a uniform double in the open interval (0,1)
+inline double uniform_open(const uint32_t i){
+	return (double(i)+0.5)*2.3283064365386963e-10; // 2^-32
+}
+
+//-----------------------------------------------------------------------------
+// Stream of further Philox words for one atom, used only when the ziggurat
+// rejects. The stream starts with the spare fourth word of the atom block and
+// continues with blocks under successive keys, so rejected draws remain a
+// pure function of (seed, global atom id, thermal step).
+//-----------------------------------------------------------------------------
+class counter_stream_t{
+public:
+	counter_stream_t(const uint32_t counter[4], const uint32_t seed, const uint32_t spare){
+		for(int i=0;i<4;i++) ctr[i]=counter[i];
+		key[0]=seed;
+		key[1]=0x1BD11BDA;
+		words[3]=spare;
+		pos=3;
+	}
+
+	uint32_t next(){
+		if(pos==4){
+			key[1]++;
+			philox4x32_10(ctr, key, words);
+			pos=0;
+		}
+		return words[pos++];
+	}
+
+private:
+	uint32_t ctr[4];
+	uint32_t key[2];
+	uint32_t words[4];
+	int pos;
+};
+
+/// Ziggurat rejection and tail sampling for a word failing the fast test
+double counter_ziggurat_reject(uint32_t U, counter_stream_t& stream){
+	unsigned long sign, i, j;
+	double x, y;
+
+	while(1){
+		i = U & 0x0000007F;
+		sign = U & 0x00000080;
+		j = U>>8;
+
+		x = j*wtab[i];
+		if (j < ktab[i]) break;
+
+		if (i<127) {
+			const double y0 = ytab[i];
+			const double y1 = ytab[i+1];
+			y = y1+(y0-y1)*uniform_open(stream.next());
+		} else {
+			x = PARAM_R - log(uniform_open(stream.next()))/PARAM_R;
+			y = exp(-PARAM_R*(x-0.5*PARAM_R))*uniform_open(stream.next());
+		}
+		if (y < exp(-0.5*x*x)) break;
+
+		U = stream.next();
+	}
+	return sign ? x : -x;
+}
+
+/// Ziggurat gaussian from one 32-bit word, accepting ~99% of words without floating point tests
+inline double counter_ziggurat(const uint32_t U, counter_stream_t& stream){
+	const uint32_t i = U & 0x0000007F;
+	const uint32_t j = U>>8;
+	if(j < ktab[i]){
+		const double x = j*wtab[i];
+		return (U & 0x00000080) ? x : -x;
+	}
+	return counter_ziggurat_reject(U, stream);
+}
+
+/// Number of atoms per batch of Philox words, small enough to stay in L1 cache
+const int counter_batch_size = 256;
+
+//-----------------------------------------------------------------------------
+// Generates three gaussian random numbers per atom in [start_index,end_index).
+// Each batch of atoms is processed in two passes: one Philox block per atom
+// is first written to a contiguous array of words, which are then transformed
+// with the ziggurat method of gaussian() above. Three words give the three
+// field components and the fourth is kept for ziggurat rejections.
+//-----------------------------------------------------------------------------
+void counter_gaussian_batch(const std::vector<uint64_t>& global_id, const int start_index, const int end_index,
+                            const uint32_t seed, const uint64_t step,
+                            std::vector<double>& gx, std::vector<double>& gy, std::vector<double>& gz){
+
+	const uint32_t key[2] = {seed, 0x1BD11BDA};
+	const uint32_t step_lo = uint32_t(step);
+	const uint32_t step_hi = uint32_t(step >> 32);
+
+	#pragma omp parallel for schedule(static) if(end_index-start_index > vomp::min_atoms_per_team)
+	for(int batch=start_index; batch<end_index; batch+=counter_batch_size){
+		const int batch_end = batch+counter_batch_size < end_index ? batch+counter_batch_size : end_index;
+		uint32_t words[4*counter_batch_size];
+
+		// generate Philox words for all atoms in batch
+		for(int atom=batch; atom<batch_end; atom++){
+			const uint64_t id = global_id[atom];
+			const uint32_t ctr[4] = {uint32_t(id), uint32_t(id >> 32), step_lo, step_hi};
+			philox4x32_10(ctr, key, &words[4*(atom-batch)]);
+		}
+
+		// transform words to gaussian numbers
+		for(int atom=batch; atom<batch_end; atom++){
+			const uint32_t* w = &words[4*(atom-batch)];
+			const uint64_t id = global_id[atom];
+			const uint32_t ctr[4] = {uint32_t(id), uint32_t(id >> 32), step_lo, step_hi};
+			counter_stream_t stream(ctr, seed, w[3]);
+			gx[atom] = counter_ziggurat(w[0], stream);
+			gy[atom] = counter_ziggurat(w[1], stream);
+			gz[atom] = counter_ziggurat(w[2], stream);
+		}
+	}
+
+	return;
+}
+
 } // end of namespace random
 
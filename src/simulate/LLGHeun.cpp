@@ -56,6 +56,7 @@
 #include "errors.hpp"
 #include "LLG.hpp"
 #include "material.hpp"
+#include "vomp.hpp"
 
 //Function prototypes
 int calculate_spin_fields(const int,const int);
@@ -169,113 +170,102 @@ int LLG_Heun(){
 	
 	// Local variables for system integration
 	const int num_atoms=atoms::num_atoms;
-	double xyz[3];		// Local Delta Spin Components
-	double S_new[3];	// New Local Spin Moment
-	double mod_S;		// magnitude of spin moment 
-
-	// Store initial spin positions		
-	for(int atom=0;atom<num_atoms;atom++){
-		x_initial_spin_array[atom] = atoms::x_spin_array[atom];
-		y_initial_spin_array[atom] = atoms::y_spin_array[atom];
-		z_initial_spin_array[atom] = atoms::z_spin_array[atom];
-	}
+	const double dt=mp::dt;
+	const double half_dt=mp::half_dt;
+	const bool packed_spins=(atoms::packed_spin_array!=NULL);
 
 	// Calculate fields
 	calculate_spin_fields(0,num_atoms);
 	calculate_external_fields(0,num_atoms);
-	
-	// Calculate Euler Step
+
+	// Calculate Euler Step, storing the initial spin and predicted spin in a single pass
+	#pragma omp parallel for schedule(static) if(num_atoms > vomp::min_atoms_per_team)
 	for(int atom=0;atom<num_atoms;atom++){
 
 		const int imaterial=atoms::type_array[atom];
-		const double one_oneplusalpha_sq = mp::material[imaterial].one_oneplusalpha_sq; // material specific alpha and gamma
-		const double alpha_oneplusalpha_sq = mp::material[imaterial].alpha_oneplusalpha_sq;
+		const double one_oneplusalpha_sq = mp::material_hot_params[imaterial].one_oneplusalpha_sq; // material specific alpha and gamma
+		const double alpha_oneplusalpha_sq = mp::material_hot_params[imaterial].alpha_oneplusalpha_sq;
 
-		// Store local spin in Sand local field in H
+		// Store local spin in S and local field in H
 		const double S[3] = {atoms::x_spin_array[atom],atoms::y_spin_array[atom],atoms::z_spin_array[atom]};
 		const double H[3] = {atoms::x_total_spin_field_array[atom]+atoms::x_total_external_field_array[atom],
 									atoms::y_total_spin_field_array[atom]+atoms::y_total_external_field_array[atom],
 									atoms::z_total_spin_field_array[atom]+atoms::z_total_external_field_array[atom]};
 
 		// Calculate Delta S
+		double xyz[3];
 		xyz[0]=(one_oneplusalpha_sq)*(S[1]*H[2]-S[2]*H[1]) + (alpha_oneplusalpha_sq)*(S[1]*(S[0]*H[1]-S[1]*H[0])-S[2]*(S[2]*H[0]-S[0]*H[2]));
 		xyz[1]=(one_oneplusalpha_sq)*(S[2]*H[0]-S[0]*H[2]) + (alpha_oneplusalpha_sq)*(S[2]*(S[1]*H[2]-S[2]*H[1])-S[0]*(S[0]*H[1]-S[1]*H[0]));
 		xyz[2]=(one_oneplusalpha_sq)*(S[0]*H[1]-S[1]*H[0]) + (alpha_oneplusalpha_sq)*(S[0]*(S[2]*H[0]-S[0]*H[2])-S[1]*(S[1]*H[2]-S[2]*H[1]));
 
-		// Store dS in euler array
+		// Store initial spin and dS for Heun step
+		x_initial_spin_array[atom]=S[0];
+		y_initial_spin_array[atom]=S[1];
+		z_initial_spin_array[atom]=S[2];
+
 		x_euler_array[atom]=xyz[0];
 		y_euler_array[atom]=xyz[1];
 		z_euler_array[atom]=xyz[2];
 
 		// Calculate Euler Step
-		S_new[0]=S[0]+xyz[0]*mp::dt;
-		S_new[1]=S[1]+xyz[1]*mp::dt;
-		S_new[2]=S[2]+xyz[2]*mp::dt;
-			
+		double S_new[3];
+		S_new[0]=S[0]+xyz[0]*dt;
+		S_new[1]=S[1]+xyz[1]*dt;
+		S_new[2]=S[2]+xyz[2]*dt;
+
 		// Normalise Spin Length
-		mod_S = 1.0/sqrt(S_new[0]*S_new[0] + S_new[1]*S_new[1] + S_new[2]*S_new[2]);
-			
-		S_new[0]=S_new[0]*mod_S;
-		S_new[1]=S_new[1]*mod_S;
-		S_new[2]=S_new[2]*mod_S;
-
-		//Writing of Spin Values to Storage Array
-		x_spin_storage_array[atom]=S_new[0];
-		y_spin_storage_array[atom]=S_new[1];
-		z_spin_storage_array[atom]=S_new[2];		
- 	}
-		
-	// Copy new spins to spin array
-	for(int atom=0;atom<num_atoms;atom++){
-		atoms::x_spin_array[atom]=x_spin_storage_array[atom];
-		atoms::y_spin_array[atom]=y_spin_storage_array[atom];
-		atoms::z_spin_array[atom]=z_spin_storage_array[atom];
+		const double mod_S = 1.0/sqrt(S_new[0]*S_new[0] + S_new[1]*S_new[1] + S_new[2]*S_new[2]);
+
+		// Write predicted spin directly to spin array (fields for this step are already known)
+		atoms::x_spin_array[atom]=S_new[0]*mod_S;
+		atoms::y_spin_array[atom]=S_new[1]*mod_S;
+		atoms::z_spin_array[atom]=S_new[2]*mod_S;
+
+		// Write predicted spin to packed array for exchange calculation
+		if(packed_spins){
+			atoms::packed_spin_array[4*atom+0]=atoms::packed_real_t(atoms::x_spin_array[atom]);
+			atoms::packed_spin_array[4*atom+1]=atoms::packed_real_t(atoms::y_spin_array[atom]);
+			atoms::packed_spin_array[4*atom+2]=atoms::packed_real_t(atoms::z_spin_array[atom]);
+		}
 	}
-		
+	atoms::packed_spins_current=packed_spins;
+
 	// Recalculate spin dependent fields
 	calculate_spin_fields(0,num_atoms);
-		
-	// Calculate Heun Gradients
+
+	// Calculate Heun Gradients and final Heun step in a single pass
+	#pragma omp parallel for schedule(static) if(num_atoms > vomp::min_atoms_per_team)
 	for(int atom=0;atom<num_atoms;atom++){
 
-		const int imaterial=atoms::type_array[atom];;
-		const double one_oneplusalpha_sq = mp::material[imaterial].one_oneplusalpha_sq;
-		const double alpha_oneplusalpha_sq = mp::material[imaterial].alpha_oneplusalpha_sq;
+		const int imaterial=atoms::type_array[atom];
+		const double one_oneplusalpha_sq = mp::material_hot_params[imaterial].one_oneplusalpha_sq;
+		const double alpha_oneplusalpha_sq = mp::material_hot_params[imaterial].alpha_oneplusalpha_sq;
 
-		// Store local spin in Sand local field in H
+		// Store local spin in S and local field in H
 		const double S[3] = {atoms::x_spin_array[atom],atoms::y_spin_array[atom],atoms::z_spin_array[atom]};
 		const double H[3] = {atoms::x_total_spin_field_array[atom]+atoms::x_total_external_field_array[atom],
 									atoms::y_total_spin_field_array[atom]+atoms::y_total_external_field_array[atom],
 									atoms::z_total_spin_field_array[atom]+atoms::z_total_external_field_array[atom]};
 
 		// Calculate Delta S
+		double xyz[3];
 		xyz[0]=(one_oneplusalpha_sq)*(S[1]*H[2]-S[2]*H[1]) + (alpha_oneplusalpha_sq)*(S[1]*(S[0]*H[1]-S[1]*H[0])-S[2]*(S[2]*H[0]-S[0]*H[2]));
 		xyz[1]=(one_oneplusalpha_sq)*(S[2]*H[0]-S[0]*H[2]) + (alpha_oneplusalpha_sq)*(S[2]*(S[1]*H[2]-S[2]*H[1])-S[0]*(S[0]*H[1]-S[1]*H[0]));
 		xyz[2]=(one_oneplusalpha_sq)*(S[0]*H[1]-S[1]*H[0]) + (alpha_oneplusalpha_sq)*(S[0]*(S[2]*H[0]-S[0]*H[2])-S[1]*(S[1]*H[2]-S[2]*H[1]));
 
-		// Store dS in heun array
-		x_heun_array[atom]=xyz[0];
-		y_heun_array[atom]=xyz[1];
-		z_heun_array[atom]=xyz[2];
-	}
+		// Calculate Heun Step
+		double S_new[3];
+		S_new[0]=x_initial_spin_array[atom]+half_dt*(x_euler_array[atom]+xyz[0]);
+		S_new[1]=y_initial_spin_array[atom]+half_dt*(y_euler_array[atom]+xyz[1]);
+		S_new[2]=z_initial_spin_array[atom]+half_dt*(z_euler_array[atom]+xyz[2]);
 
-	// Calculate Heun Step
-	for(int atom=0;atom<num_atoms;atom++){
-		S_new[0]=x_initial_spin_array[atom]+mp::half_dt*(x_euler_array[atom]+x_heun_array[atom]);
-		S_new[1]=y_initial_spin_array[atom]+mp::half_dt*(y_euler_array[atom]+y_heun_array[atom]);
-		S_new[2]=z_initial_spin_array[atom]+mp::half_dt*(z_euler_array[atom]+z_heun_array[atom]);
-		
 		// Normalise Spin Length
-		mod_S = 1.0/sqrt(S_new[0]*S_new[0] + S_new[1]*S_new[1] + S_new[2]*S_new[2]);
-		
-		S_new[0]=S_new[0]*mod_S;
-		S_new[1]=S_new[1]*mod_S;
-		S_new[2]=S_new[2]*mod_S;
+		const double mod_S = 1.0/sqrt(S_new[0]*S_new[0] + S_new[1]*S_new[1] + S_new[2]*S_new[2]);
 
 		// Copy new spins to spin array
-		atoms::x_spin_array[atom]=S_new[0];
-		atoms::y_spin_array[atom]=S_new[1];
-		atoms::z_spin_array[atom]=S_new[2];
+		atoms::x_spin_array[atom]=S_new[0]*mod_S;
+		atoms::y_spin_array[atom]=S_new[1]*mod_S;
+		atoms::z_spin_array[atom]=S_new[2]*mod_S;
 	}
 
 	return EXIT_SUCCESS;
@@ -115,8 +115,8 @@ int LLG_Midpoint(){
 	for(int atom=0;atom<num_atoms;atom++){
 
 		const int imaterial=atoms::type_array[atom];
-		const double alpha = mp::material[imaterial].alpha;
-		const double beta  = -1.0*mp::dt*mp::material[imaterial].one_oneplusalpha_sq*0.5;
+		const double alpha = mp::material_hot_params[imaterial].alpha;
+		const double beta  = -1.0*mp::dt*mp::material_hot_params[imaterial].one_oneplusalpha_sq*0.5;
 		const double beta2 = beta*beta;
 		
 		// Store local spin in S and local field in H
@@ -156,8 +156,8 @@ int LLG_Midpoint(){
 	for(int atom=0;atom<num_atoms;atom++){
 
 		const int imaterial=atoms::type_array[atom];
-		const double alpha = mp::material[imaterial].alpha;
-		const double beta  = -1.0*mp::dt*mp::material[imaterial].one_oneplusalpha_sq*0.5;
+		const double alpha = mp::material_hot_params[imaterial].alpha;
+		const double beta  = -1.0*mp::dt*mp::material_hot_params[imaterial].one_oneplusalpha_sq*0.5;
 		const double beta2 = beta*beta;
 		
 		// Store local spin in S and local field in H
@@ -0,0 +1,152 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+//
+//    Geometric LLG integrator. The LLG equation is written as dS/dt = w x S,
+//    with w = [H + alpha S x H]/(1+alpha^2), and each spin is rotated
+//    about w using the Rodrigues formula. Rotations preserve the length of
+//    the spin exactly, so no renormalisation is needed. The rotation vector
+//    is evaluated at the midpoint of the step, which is second order
+//    accurate and consistent with the Stratonovich interpretation of the
+//    thermal field.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Vampire headers
+#include "atoms.hpp"
+#include "errors.hpp"
+#include "material.hpp"
+#include "sim.hpp"
+#include "vmpi.hpp"
+#include "vomp.hpp"
+
+// Function prototypes
+int calculate_spin_fields(const int,const int);
+int calculate_external_fields(const int,const int);
+#ifdef MPICF
+int mpi_init_halo_swap();
+int mpi_complete_halo_swap();
+#endif
+
+namespace sim{
+
+   namespace internal{
+
+      bool rotation_set=false;            /// flag to indicate initialised rotation arrays
+      std::vector<double> rotation_S0;    /// spins at start of step (3N)
+
+   } // end of namespace internal
+
+   //-----------------------------------------------------------------------------
+   // Function to rotate spins of local atoms from initial positions about the
+   // precession vector of the current spin configuration by the time dt
+   //-----------------------------------------------------------------------------
+   void rotate_spins(const int num_local_atoms, const double dt){
+
+      // update halo spins and calculate fields
+      #ifdef MPICF
+         mpi_init_halo_swap();
+         mpi_complete_halo_swap();
+      #endif
+      calculate_spin_fields(0,num_local_atoms);
+      calculate_external_fields(0,num_local_atoms);
+
+      const std::vector<double>& S0 = internal::rotation_S0;
+
+      #pragma omp parallel for schedule(static) if(num_local_atoms > vomp::min_atoms_per_team)
+      for(int atom=0;atom<num_local_atoms;atom++){
+
+         const int imaterial=atoms::type_array[atom];
+         const double one_oneplusalpha_sq = mp::material_hot_params[imaterial].one_oneplusalpha_sq;
+         const double alpha = mp::material_hot_params[imaterial].alpha;
+
+         const double S[3] = {atoms::x_spin_array[atom],atoms::y_spin_array[atom],atoms::z_spin_array[atom]};
+         const double Ht[3] = {atoms::x_total_spin_field_array[atom]+atoms::x_total_external_field_array[atom],
+                               atoms::y_total_spin_field_array[atom]+atoms::y_total_external_field_array[atom],
+                               atoms::z_total_spin_field_array[atom]+atoms::z_total_external_field_array[atom]};
+
+         // Remove field parallel to spin, which exerts no torque but would rotate
+         // the spin about a fixed axis by a large angle for strong exchange fields
+         const double HdotS = Ht[0]*S[0] + Ht[1]*S[1] + Ht[2]*S[2];
+         const double H[3] = {Ht[0]-HdotS*S[0], Ht[1]-HdotS*S[1], Ht[2]-HdotS*S[2]};
+
+         // Calculate rotation vector w = [H + alpha* (S x H)]/(1+alpha^2)
+         const double w[3] = {-one_oneplusalpha_sq*(H[0] + alpha*(S[1]*H[2]-S[2]*H[1])),
+                              -one_oneplusalpha_sq*(H[1] + alpha*(S[2]*H[0]-S[0]*H[2])),
+                              -one_oneplusalpha_sq*(H[2] + alpha*(S[0]*H[1]-S[1]*H[0]))};
+
+         const double mod_w = sqrt(w[0]*w[0] + w[1]*w[1] + w[2]*w[2]);
+         if(mod_w==0.0){
+            atoms::x_spin_array[atom] = S0[3*atom+0];
+            atoms::y_spin_array[atom] = S0[3*atom+1];
+            atoms::z_spin_array[atom] = S0[3*atom+2];
+            continue;
+         }
+
+         // Rotate initial spin about unit vector k by angle theta
+         const double k[3] = {w[0]/mod_w, w[1]/mod_w, w[2]/mod_w};
+         const double theta = mod_w*dt;
+         const double cos_theta = cos(theta);
+         const double sin_theta = sin(theta);
+
+         const double R[3] = {S0[3*atom+0], S0[3*atom+1], S0[3*atom+2]};
+         const double kxR[3] = {k[1]*R[2]-k[2]*R[1], k[2]*R[0]-k[0]*R[2], k[0]*R[1]-k[1]*R[0]};
+         const double kdotR = (k[0]*R[0] + k[1]*R[1] + k[2]*R[2])*(1.0-cos_theta);
+
+         atoms::x_spin_array[atom] = R[0]*cos_theta + kxR[0]*sin_theta + k[0]*kdotR;
+         atoms::y_spin_array[atom] = R[1]*cos_theta + kxR[1]*sin_theta + k[1]*kdotR;
+         atoms::z_spin_array[atom] = R[2]*cos_theta + kxR[2]*sin_theta + k[2]*kdotR;
+
+      }
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Geometric midpoint integrator using Rodrigues rotations
+   //-----------------------------------------------------------------------------
+   int LLG_Rotation(){
+
+      // check calling of routine if error checking is activated
+      if(err::check==true) std::cout << "sim::LLG_Rotation has been called" << std::endl;
+
+      #ifdef MPICF
+         const int num_local_atoms = vmpi::num_core_atoms+vmpi::num_bdry_atoms;
+      #else
+         const int num_local_atoms = atoms::num_atoms;
+      #endif
+
+      // Check for initialisation of rotation arrays
+      if(internal::rotation_set==false){
+         internal::rotation_S0.resize(3*num_local_atoms);
+         internal::rotation_set=true;
+      }
+
+      // Store initial spin positions
+      for(int atom=0;atom<num_local_atoms;atom++){
+         internal::rotation_S0[3*atom+0] = atoms::x_spin_array[atom];
+         internal::rotation_S0[3*atom+1] = atoms::y_spin_array[atom];
+         internal::rotation_S0[3*atom+2] = atoms::z_spin_array[atom];
+      }
+
+      // Rotate to midpoint with initial fields, then full step with midpoint fields
+      rotate_spins(num_local_atoms, mp::half_dt);
+      rotate_spins(num_local_atoms, mp::dt);
+
+      return EXIT_SUCCESS;
+
+   }
+
+} // end of namespace sim
@@ -0,0 +1,248 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+//
+//    Adaptive Bogacki-Shampine 3(2) Runge-Kutta integrator for the
+//    deterministic LLG equation. The difference between the embedded
+//    third and second order solutions controls the time step, so that
+//    slow relaxations are integrated with steps many times larger than
+//    the fixed time step. Thermal fields are not included, as the time
+//    step of a stochastic integration must be fixed.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Vampire headers
+#include "atoms.hpp"
+#include "errors.hpp"
+#include "material.hpp"
+#include "sim.hpp"
+#include "vio.hpp"
+#include "vmpi.hpp"
+#include "vomp.hpp"
+
+// Function prototypes
+int calculate_spin_fields(const int,const int);
+int calculate_external_fields(const int,const int);
+#ifdef MPICF
+int mpi_init_halo_swap();
+int mpi_complete_halo_swap();
+#endif
+
+namespace sim{
+
+   namespace internal{
+
+      bool rk_set=false;             /// flag to indicate initialised Runge-Kutta arrays
+      double rk_dt=0.0;              /// current reduced time step
+      std::vector<double> rk_S0;     /// spins at start of step (3N)
+      std::vector<double> rk_k1;     /// stage derivatives (3N)
+      std::vector<double> rk_k2;
+      std::vector<double> rk_k3;
+      std::vector<double> rk_k4;
+
+      // Limits of change in time step between steps and relative to fixed time step
+      const double rk_max_growth = 5.0;
+      const double rk_min_growth = 0.2;
+      const double rk_max_dt_ratio = 1.0e4;
+
+      // Maximum product of time step and precession frequency. Steps near the
+      // stability limit of the explicit method would otherwise be accepted with
+      // persistent oscillations, preventing relaxation to equilibrium.
+      const double rk_stability_limit = 1.0;
+
+   } // end of namespace internal
+
+   //-----------------------------------------------------------------------------
+   // Function to calculate LLG derivative dS/dt = -S x [H + alpha S x H]/(1+alpha^2)
+   // for local atoms from current spin configuration
+   //-----------------------------------------------------------------------------
+   void calculate_llg_derivative(const int num_local_atoms, std::vector<double>& k){
+
+      // update halo spins and calculate fields
+      #ifdef MPICF
+         mpi_init_halo_swap();
+         mpi_complete_halo_swap();
+      #endif
+      calculate_spin_fields(0,num_local_atoms);
+      calculate_external_fields(0,num_local_atoms);
+
+      #pragma omp parallel for schedule(static) if(num_local_atoms > vomp::min_atoms_per_team)
+      for(int atom=0;atom<num_local_atoms;atom++){
+
+         const int imaterial=atoms::type_array[atom];
+         const double one_oneplusalpha_sq = mp::material_hot_params[imaterial].one_oneplusalpha_sq;
+         const double alpha = mp::material_hot_params[imaterial].alpha;
+
+         const double S[3] = {atoms::x_spin_array[atom],atoms::y_spin_array[atom],atoms::z_spin_array[atom]};
+         const double H[3] = {atoms::x_total_spin_field_array[atom]+atoms::x_total_external_field_array[atom],
+                              atoms::y_total_spin_field_array[atom]+atoms::y_total_external_field_array[atom],
+                              atoms::z_total_spin_field_array[atom]+atoms::z_total_external_field_array[atom]};
+
+         // Calculate F = [H + alpha* (S x H)]
+         const double F[3] = {H[0] + alpha*(S[1]*H[2]-S[2]*H[1]),
+                              H[1] + alpha*(S[2]*H[0]-S[0]*H[2]),
+                              H[2] + alpha*(S[0]*H[1]-S[1]*H[0])};
+
+         k[3*atom+0] = one_oneplusalpha_sq*(S[1]*F[2]-S[2]*F[1]);
+         k[3*atom+1] = one_oneplusalpha_sq*(S[2]*F[0]-S[0]*F[2]);
+         k[3*atom+2] = one_oneplusalpha_sq*(S[0]*F[1]-S[1]*F[0]);
+
+      }
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to set spins to S0 + dt*sum_i(b_i k_i) for local atoms
+   //-----------------------------------------------------------------------------
+   void set_stage_spins(const int num_local_atoms, const double dt, const double b1, const double b2, const double b3, const double b4){
+
+      using namespace internal;
+
+      #pragma omp parallel for schedule(static) if(num_local_atoms > vomp::min_atoms_per_team)
+      for(int atom=0;atom<num_local_atoms;atom++){
+         const int i=3*atom;
+         atoms::x_spin_array[atom] = rk_S0[i+0] + dt*(b1*rk_k1[i+0] + b2*rk_k2[i+0] + b3*rk_k3[i+0] + b4*rk_k4[i+0]);
+         atoms::y_spin_array[atom] = rk_S0[i+1] + dt*(b1*rk_k1[i+1] + b2*rk_k2[i+1] + b3*rk_k3[i+1] + b4*rk_k4[i+1]);
+         atoms::z_spin_array[atom] = rk_S0[i+2] + dt*(b1*rk_k1[i+2] + b2*rk_k2[i+2] + b3*rk_k3[i+2] + b4*rk_k4[i+2]);
+      }
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Adaptive Runge-Kutta integrator. Each call makes a single accepted step,
+   // repeating the step with a smaller time step if the error is too large.
+   // The physical time of the step is stored in sim::adaptive_dt_SI.
+   //-----------------------------------------------------------------------------
+   int LLG_RK23(){
+
+      // check calling of routine if error checking is activated
+      if(err::check==true) std::cout << "sim::LLG_RK23 has been called" << std::endl;
+
+      using namespace internal;
+
+      #ifdef MPICF
+         const int num_local_atoms = vmpi::num_core_atoms+vmpi::num_bdry_atoms;
+      #else
+         const int num_local_atoms = atoms::num_atoms;
+      #endif
+
+      // Check for initialisation of Runge-Kutta arrays
+      if(rk_set==false){
+         rk_S0.resize(3*num_local_atoms);
+         rk_k1.resize(3*num_local_atoms);
+         rk_k2.resize(3*num_local_atoms);
+         rk_k3.resize(3*num_local_atoms);
+         rk_k4.resize(3*num_local_atoms);
+         rk_dt=mp::dt;
+         if(sim::hamiltonian_simulation_flags[3]==1 && sim::temperature>0.0){
+            zlog << zTs() << "Warning: Adaptive Runge-Kutta integrator integrates deterministic dynamics, thermal fields will be ignored." << std::endl;
+         }
+         rk_set=true;
+      }
+
+      // Disable thermal fields during integration
+      const int thermal_flag = sim::hamiltonian_simulation_flags[3];
+      sim::hamiltonian_simulation_flags[3] = 0;
+
+      // Store initial spin positions
+      for(int atom=0;atom<num_local_atoms;atom++){
+         rk_S0[3*atom+0] = atoms::x_spin_array[atom];
+         rk_S0[3*atom+1] = atoms::y_spin_array[atom];
+         rk_S0[3*atom+2] = atoms::z_spin_array[atom];
+      }
+
+      calculate_llg_derivative(num_local_atoms, rk_k1);
+
+      // Determine maximum precession frequency from fields of initial spins
+      double max_rate=0.0;
+      #pragma omp parallel for schedule(static) reduction(max:max_rate) if(num_local_atoms > vomp::min_atoms_per_team)
+      for(int atom=0;atom<num_local_atoms;atom++){
+         const int imaterial=atoms::type_array[atom];
+         const double alpha = mp::material_hot_params[imaterial].alpha;
+         const double H[3] = {atoms::x_total_spin_field_array[atom]+atoms::x_total_external_field_array[atom],
+                              atoms::y_total_spin_field_array[atom]+atoms::y_total_external_field_array[atom],
+                              atoms::z_total_spin_field_array[atom]+atoms::z_total_external_field_array[atom]};
+         const double rate = std::fabs(mp::material_hot_params[imaterial].one_oneplusalpha_sq)*sqrt((1.0+alpha*alpha)*(H[0]*H[0]+H[1]*H[1]+H[2]*H[2]));
+         if(rate>max_rate) max_rate=rate;
+      }
+      #ifdef MPICF
+         MPI_Allreduce(MPI_IN_PLACE, &max_rate, 1, MPI_DOUBLE, MPI_MAX, vmpi::comm);
+      #endif
+      const double max_dt = max_rate > 0.0 ? std::min(rk_stability_limit/max_rate, rk_max_dt_ratio*mp::dt) : rk_max_dt_ratio*mp::dt;
+      if(rk_dt>max_dt) rk_dt=max_dt;
+
+      const double tolerance = sim::adaptive_tolerance;
+
+      while(true){
+
+         const double dt = rk_dt;
+
+         // Bogacki-Shampine stages
+         set_stage_spins(num_local_atoms, dt, 0.5, 0.0, 0.0, 0.0);
+         calculate_llg_derivative(num_local_atoms, rk_k2);
+         set_stage_spins(num_local_atoms, dt, 0.0, 0.75, 0.0, 0.0);
+         calculate_llg_derivative(num_local_atoms, rk_k3);
+         set_stage_spins(num_local_atoms, dt, 2.0/9.0, 1.0/3.0, 4.0/9.0, 0.0);
+         calculate_llg_derivative(num_local_atoms, rk_k4);
+
+         // Calculate maximum difference of second order solution
+         double error=0.0;
+         #pragma omp parallel for schedule(static) reduction(max:error) if(num_local_atoms > vomp::min_atoms_per_team)
+         for(int atom=0;atom<num_local_atoms;atom++){
+            double e2=0.0;
+            for(int i=3*atom;i<3*atom+3;i++){
+               const double e = dt*((2.0/9.0-7.0/24.0)*rk_k1[i] + (1.0/3.0-0.25)*rk_k2[i] + (4.0/9.0-1.0/3.0)*rk_k3[i] - 0.125*rk_k4[i]);
+               e2+=e*e;
+            }
+            if(e2>error) error=e2;
+         }
+         #ifdef MPICF
+            MPI_Allreduce(MPI_IN_PLACE, &error, 1, MPI_DOUBLE, MPI_MAX, vmpi::comm);
+         #endif
+         error=sqrt(error);
+
+         // Calculate next time step
+         double growth = error > 0.0 ? 0.9*pow(tolerance/error,1.0/3.0) : rk_max_growth;
+         growth = std::max(rk_min_growth, std::min(rk_max_growth, growth));
+         rk_dt = std::min(dt*growth, max_dt);
+
+         if(error<=tolerance){
+            sim::adaptive_dt_SI = dt/mp::gamma_SI;
+            break;
+         }
+
+      }
+
+      // Normalise spins of third order solution, which are in spin arrays
+      for(int atom=0;atom<num_local_atoms;atom++){
+         const double S[3] = {atoms::x_spin_array[atom],atoms::y_spin_array[atom],atoms::z_spin_array[atom]};
+         const double mod_S = 1.0/sqrt(S[0]*S[0] + S[1]*S[1] + S[2]*S[2]);
+         atoms::x_spin_array[atom]=S[0]*mod_S;
+         atoms::y_spin_array[atom]=S[1]*mod_S;
+         atoms::z_spin_array[atom]=S[2]*mod_S;
+      }
+
+      // restore thermal fields
+      sim::hamiltonian_simulation_flags[3] = thermal_flag;
+
+      return EXIT_SUCCESS;
+
+   }
+
+} // end of namespace sim
@@ -0,0 +1,697 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+//
+//    Parallel constrained Monte Carlo integrator. Pair moves are made
+//    between atoms of the same colour, which do not interact, so that
+//    all pairs of a colour can be moved concurrently. A pair move keeps
+//    the transverse magnetisation fixed exactly; the change in the
+//    magnetisation along the constraint direction is reconciled over
+//    all threads and processors after each colour.
+//
+//    Pairs within one colour on one processor conserve the transverse
+//    magnetisation of that subset of atoms. Each step therefore ends
+//    with a small number of sequential mixing pairs between colours,
+//    and in parallel runs with pairs of one colour between matched
+//    processors, so that only the total transverse magnetisation is
+//    constrained, as in the serial algorithm.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Vampire headers
+#include "atoms.hpp"
+#include "errors.hpp"
+#include "material.hpp"
+#include "random.hpp"
+#include "sim.hpp"
+#include "vio.hpp"
+#include "vmath.hpp"
+#include "vmpi.hpp"
+#include "vomp.hpp"
+
+// Internal sim header
+#include "internal.hpp"
+
+#ifdef MPICF
+int mpi_init_halo_swap();
+int mpi_complete_halo_swap();
+#endif
+
+namespace sim{
+
+   namespace internal{
+
+      bool cmc_groups_set=false;           /// flag to indicate initialised pair lists
+      int cmc_num_groups=0;                /// number of constraint groups (1 or number of materials)
+      std::vector<int> cmc_group_start;    /// start index of each (colour, group) in cmc_group_atoms
+      std::vector<int> cmc_group_atoms;    /// list of local atoms sorted by colour and group
+      std::vector<int> cmc_mix_start;      /// start index of each group in cmc_mix_atoms
+      std::vector<int> cmc_mix_atoms;      /// list of core atoms sorted by group for mixing pairs
+
+      // Key words for random selection of pairs and for the moves of mixing pairs
+      const uint32_t cmc_pair_stream = 0x9E3779B1;
+      const uint32_t cmc_mix_stream  = 0x7F4A7C15;
+      const uint32_t cmc_rank_stream = 0x94D049BB;
+
+      // Labels for random selection of mixing pairs (above any colour index)
+      const uint32_t cmc_mix_label   = 0xFFFFFFFF;
+      const uint32_t cmc_match_label = 0xFFFFFFFE;
+      const uint32_t cmc_rank_label  = 0xFFFFFFFD;
+
+      // Number of atoms per mixing pair in each step
+      const int cmc_mix_ratio = 128;
+
+   } // end of namespace internal
+
+   //-----------------------------------------------------------------------------
+   // Function to calculate greatest common divisor
+   //-----------------------------------------------------------------------------
+   inline int gcd(int a, int b){
+      while(b!=0){
+         const int t=a%b;
+         a=b;
+         b=t;
+      }
+      return a;
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to choose a random pairing of a list of n atoms. Atoms 2k and
+   // 2k+1 of the sequence (offset + i*stride)%n form pair k, and as the stride
+   // is coprime with n every atom appears at most once.
+   //-----------------------------------------------------------------------------
+   void random_pairing(const int n, const uint32_t label, const uint32_t index, uint64_t& offset, int& stride){
+
+      const uint32_t key[2] = {uint32_t(mtrandom::integration_seed), internal::cmc_pair_stream};
+      const uint32_t ctr[4] = {label, index, uint32_t(mtrandom::thermal_step), uint32_t(mtrandom::thermal_step >> 32)};
+      uint32_t r[4];
+      mtrandom::philox4x32(ctr, key, r);
+
+      offset = r[0]%uint32_t(n);
+      stride = n > 2 ? 1+int(r[1]%uint32_t(n-1)) : 1;
+      while(gcd(stride,n)!=1) stride = stride%(n-1)+1;
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to calculate the change in energy of a spin in units of kT
+   //-----------------------------------------------------------------------------
+   inline double spin_move_energy(const int atom, const double new_spin[3], const int AtomExchangeType){
+
+      const int imat = atoms::type_array[atom];
+      const double Eold = sim::calculate_spin_energy(atom, AtomExchangeType);
+      atoms::x_spin_array[atom] = new_spin[0];
+      atoms::y_spin_array[atom] = new_spin[1];
+      atoms::z_spin_array[atom] = new_spin[2];
+      const double Enew = sim::calculate_spin_energy(atom, AtomExchangeType);
+
+      // Calculate difference in Joules/mu_B and multiply by 1/kT
+      return (Enew-Eold)*mp::material_hot_params[imat].mu_s_SI*1.07828231e23*mp::material_hot_params[imat].mc_kBTBohr;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to set spin of atom
+   //-----------------------------------------------------------------------------
+   inline void set_spin(const int atom, const double spin[3]){
+      atoms::x_spin_array[atom] = spin[0];
+      atoms::y_spin_array[atom] = spin[1];
+      atoms::z_spin_array[atom] = spin[2];
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to complete a constrained pair move given the move of spin 1,
+   // which is described by the change in its transverse components in the
+   // constraint frame (delta), its change in energy (beta_dE1) and its change
+   // in magnetisation (dm1). Spin 2 is moved to compensate the transverse
+   // change. Returns 0 for an accepted move, 1 for an energy rejection and 2
+   // for a rejection as spin 2 cannot be placed on the unit sphere. On
+   // acceptance the change in magnetisation of the pair is added to dM.
+   //-----------------------------------------------------------------------------
+   inline int complete_pair_move(const int atom_number2, const double delta[2], const double beta_dE1, const double dm1[3],
+                                 const double u, const double pm[3][3], const double pmt[3][3], const double pv[3],
+                                 const double M[3], double dM[3], const int AtomExchangeType){
+
+      const double spin2_initial[3] = {atoms::x_spin_array[atom_number2], atoms::y_spin_array[atom_number2], atoms::z_spin_array[atom_number2]};
+      double spin2_init_mvd[3];
+      double spin2_fin_mvd[3];
+      double spin2_final[3];
+
+      for(int i=0;i<3;i++) spin2_init_mvd[i]=pm[i][0]*spin2_initial[0]+pm[i][1]*spin2_initial[1]+pm[i][2]*spin2_initial[2];
+
+      // Calculate new spin based on constraint Mx=My=0
+      spin2_fin_mvd[0] = spin2_init_mvd[0]+delta[0];
+      spin2_fin_mvd[1] = spin2_init_mvd[1]+delta[1];
+      if((spin2_fin_mvd[0]*spin2_fin_mvd[0]+spin2_fin_mvd[1]*spin2_fin_mvd[1])>=1.0) return 2;
+      spin2_fin_mvd[2] = vmath::sign(spin2_init_mvd[2])*sqrt(1.0-spin2_fin_mvd[0]*spin2_fin_mvd[0] - spin2_fin_mvd[1]*spin2_fin_mvd[1]);
+
+      for(int i=0;i<3;i++) spin2_final[i]=pmt[i][0]*spin2_fin_mvd[0]+pmt[i][1]*spin2_fin_mvd[1]+pmt[i][2]*spin2_fin_mvd[2];
+
+      // Calculate Delta E for both spins, which do not interact
+      const double delta_energy21 = beta_dE1 + spin_move_energy(atom_number2, spin2_final, AtomExchangeType);
+
+      // Compute Mz, Mz'
+      const double dm[3] = {dm1[0]+spin2_final[0]-spin2_initial[0], dm1[1]+spin2_final[1]-spin2_initial[1], dm1[2]+spin2_final[2]-spin2_initial[2]};
+      const double Mz_old = M[0]*pv[0] + M[1]*pv[1] + M[2]*pv[2];
+      const double Mz_new = (M[0] + dm[0])*pv[0] + (M[1] + dm[1])*pv[1] + (M[2] + dm[2])*pv[2];
+
+      const double probability = exp(-delta_energy21)*((Mz_new/Mz_old)*(Mz_new/Mz_old))*std::fabs(spin2_init_mvd[2]/spin2_fin_mvd[2]);
+      if((probability>=u) && (Mz_new>0.0)){
+         dM[0]+=dm[0];
+         dM[1]+=dm[1];
+         dM[2]+=dm[2];
+         return 0;
+      }
+
+      // reset spin 2
+      set_spin(atom_number2, spin2_initial);
+      return 1;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to make a trial move of spin 1 of a pair, returning the change in
+   // transverse components in the constraint frame, energy and magnetisation.
+   // The spin is provisionally moved and the random number for acceptance of
+   // the pair is returned in u.
+   //-----------------------------------------------------------------------------
+   inline void propose_pair_move(const int atom_number1, const uint32_t stream, const double pm[3][3],
+                                 double spin1_initial[3], double delta[2], double& beta_dE1, double dm1[3], double& u,
+                                 const int AtomExchangeType){
+
+      const int imat1 = atoms::type_array[atom_number1];
+
+      // generate random numbers for move
+      double g[3];
+      double ru[2];
+      internal::mc_counter_randoms(atoms::global_id_array[atom_number1], stream, g, ru);
+      u=ru[1];
+
+      spin1_initial[0] = atoms::x_spin_array[atom_number1];
+      spin1_initial[1] = atoms::y_spin_array[atom_number1];
+      spin1_initial[2] = atoms::z_spin_array[atom_number1];
+      double spin1_final[3];
+      internal::mc_move_counter(spin1_initial, spin1_final, ru[0], g, mp::material_hot_params[imat1].mc_sigma);
+
+      for(int i=0;i<2;i++){
+         delta[i] = pm[i][0]*(spin1_initial[0]-spin1_final[0])+pm[i][1]*(spin1_initial[1]-spin1_final[1])+pm[i][2]*(spin1_initial[2]-spin1_final[2]);
+      }
+      for(int i=0;i<3;i++) dm1[i] = spin1_final[i]-spin1_initial[i];
+
+      beta_dE1 = spin_move_energy(atom_number1, spin1_final, AtomExchangeType);
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to sort atoms of each colour into constraint groups. Constrained
+   // Monte Carlo uses a single group, and the hybrid method uses one group per
+   // material so that pairs are always formed from atoms of the same material.
+   //-----------------------------------------------------------------------------
+   void initialise_parallel_constrained_monte_carlo(){
+
+      // check calling of routine if error checking is activated
+      if(err::check==true) std::cout << "sim::initialise_parallel_constrained_monte_carlo has been called" << std::endl;
+
+      // Check for initialisation of colouring
+      if(internal::mc_colours_set==false) sim::initialise_parallel_monte_carlo();
+
+      #ifdef MPICF
+         const int num_core_atoms = vmpi::num_core_atoms;
+      #else
+         const int num_core_atoms = atoms::num_atoms;
+      #endif
+
+      const bool hybrid = (sim::integrator==sim::hybrid_constrained_monte_carlo);
+      const int num_groups = hybrid ? mp::num_materials : 1;
+      const int num_colours = internal::mc_num_colours;
+
+      internal::cmc_num_groups=num_groups;
+      internal::cmc_group_start.assign(num_colours*num_groups+1,0);
+      internal::cmc_group_atoms.resize(internal::mc_colour_atoms.size());
+      internal::cmc_mix_start.assign(num_groups+1,0);
+
+      // count atoms in each colour and group
+      for(int c=0;c<num_colours;c++){
+         for(int i=internal::mc_colour_start[c];i<internal::mc_colour_start[c+1];i++){
+            const int group = hybrid ? atoms::type_array[internal::mc_colour_atoms[i]] : 0;
+            internal::cmc_group_start[c*num_groups+group+1]++;
+         }
+      }
+      for(int i=0;i<num_colours*num_groups;i++) internal::cmc_group_start[i+1]+=internal::cmc_group_start[i];
+
+      for(int atom=0;atom<num_core_atoms;atom++){
+         const int group = hybrid ? atoms::type_array[atom] : 0;
+         internal::cmc_mix_start[group+1]++;
+      }
+      for(int g=0;g<num_groups;g++) internal::cmc_mix_start[g+1]+=internal::cmc_mix_start[g];
+      internal::cmc_mix_atoms.resize(internal::cmc_mix_start[num_groups]);
+
+      // fill lists, keeping core atoms first within each colour and group
+      std::vector<int> fill(internal::cmc_group_start.begin(),internal::cmc_group_start.end()-1);
+      for(int c=0;c<num_colours;c++){
+         for(int i=internal::mc_colour_start[c];i<internal::mc_colour_start[c+1];i++){
+            const int atom = internal::mc_colour_atoms[i];
+            const int group = hybrid ? atoms::type_array[atom] : 0;
+            internal::cmc_group_atoms[fill[c*num_groups+group]]=atom;
+            fill[c*num_groups+group]++;
+         }
+      }
+      std::vector<int> mix_fill(internal::cmc_mix_start.begin(),internal::cmc_mix_start.end()-1);
+      for(int atom=0;atom<num_core_atoms;atom++){
+         const int group = hybrid ? atoms::type_array[atom] : 0;
+         internal::cmc_mix_atoms[mix_fill[group]]=atom;
+         mix_fill[group]++;
+      }
+
+      internal::cmc_groups_set=true;
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to perform unconstrained Metropolis moves for atoms in the list
+   //-----------------------------------------------------------------------------
+   void parallel_cmc_single_moves(const int start, const int end){
+
+      const int AtomExchangeType=atoms::exchange_type;
+
+      double success=0.0;
+      double reject=0.0;
+
+      #pragma omp parallel for schedule(static) reduction(+:success,reject) if(end-start > vomp::min_atoms_per_team)
+      for(int i=start;i<end;i++){
+
+         const int atom = internal::cmc_group_atoms[i];
+         const int imat = atoms::type_array[atom];
+
+         // generate random numbers for move
+         double g[3];
+         double u[2];
+         internal::mc_counter_randoms(atoms::global_id_array[atom], internal::cmc_stream, g, u);
+
+         // Save old spin position and make Monte Carlo move
+         const double Sold[3] = {atoms::x_spin_array[atom], atoms::y_spin_array[atom], atoms::z_spin_array[atom]};
+         double Snew[3];
+         internal::mc_move_counter(Sold, Snew, u[0], g, mp::material_hot_params[imat].mc_sigma);
+
+         // Accept lower energy or with Boltzmann probability, otherwise reset spin
+         const double beta_dE = spin_move_energy(atom, Snew, AtomExchangeType);
+         if(beta_dE<0 || exp(-beta_dE) >= u[1]) success+=1.0;
+         else{
+            set_spin(atom, Sold);
+            reject+=1.0;
+         }
+
+      }
+
+      cmc::mc_success += success;
+      cmc::energy_reject += reject;
+      cmc::mc_total += double(end-start);
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to perform constrained pair moves for atoms in one colour and
+   // group. The magnetisation M is taken from the start of the colour, and the
+   // change in M from accepted pairs is added to dM.
+   //-----------------------------------------------------------------------------
+   void parallel_cmc_pair_moves(const int start, const int end, const int colour, const int group,
+                                const double pm[3][3], const double pmt[3][3], const double pv[3],
+                                const double M[3], double dM[3]){
+
+      const int n = end-start;
+      if(n<2) return;
+
+      const int AtomExchangeType=atoms::exchange_type;
+
+      uint64_t offset;
+      int stride;
+      random_pairing(n, colour, group, offset, stride);
+
+      const int num_pairs = n/2;
+
+      double success=0.0;
+      double energy_reject=0.0;
+      double sphere_reject=0.0;
+      double dMx=0.0;
+      double dMy=0.0;
+      double dMz=0.0;
+
+      #pragma omp parallel for schedule(static) reduction(+:success,energy_reject,sphere_reject,dMx,dMy,dMz) if(num_pairs > vomp::min_atoms_per_team)
+      for(int k=0;k<num_pairs;k++){
+
+         const int atom_number1 = internal::cmc_group_atoms[start+int((offset+uint64_t(2*k)*uint64_t(stride))%uint64_t(n))];
+         const int atom_number2 = internal::cmc_group_atoms[start+int((offset+uint64_t(2*k+1)*uint64_t(stride))%uint64_t(n))];
+
+         double spin1_initial[3];
+         double delta[2];
+         double beta_dE1;
+         double dm1[3];
+         double u;
+         propose_pair_move(atom_number1, internal::cmc_stream, pm, spin1_initial, delta, beta_dE1, dm1, u, AtomExchangeType);
+
+         double dm[3]={0.0,0.0,0.0};
+         const int result = complete_pair_move(atom_number2, delta, beta_dE1, dm1, u, pm, pmt, pv, M, dm, AtomExchangeType);
+         if(result==0){
+            dMx+=dm[0];
+            dMy+=dm[1];
+            dMz+=dm[2];
+            success+=1.0;
+         }
+         else{
+            set_spin(atom_number1, spin1_initial);
+            if(result==1) energy_reject+=1.0;
+            else sphere_reject+=1.0;
+         }
+
+      }
+
+      dM[0]+=dMx;
+      dM[1]+=dMy;
+      dM[2]+=dMz;
+
+      cmc::mc_success += success;
+      cmc::energy_reject += energy_reject;
+      cmc::sphere_reject += sphere_reject;
+      cmc::mc_total += double(num_pairs);
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to perform mixing pair moves between any core atoms of a group on
+   // this processor. The moves are made in sequence, so that the pairs may
+   // include interacting atoms of different colours.
+   //-----------------------------------------------------------------------------
+   void parallel_cmc_mixing_moves(const int group, const double pm[3][3], const double pmt[3][3], const double pv[3],
+                                  const double M[3], double dM[3]){
+
+      const int start = internal::cmc_mix_start[group];
+      const int n = internal::cmc_mix_start[group+1]-start;
+      if(n<2) return;
+
+      const int AtomExchangeType=atoms::exchange_type;
+
+      uint64_t offset;
+      int stride;
+      random_pairing(n, internal::cmc_mix_label, group, offset, stride);
+
+      const int num_pairs = n/internal::cmc_mix_ratio > 0 ? n/internal::cmc_mix_ratio : 1;
+
+      for(int k=0;k<num_pairs;k++){
+
+         const int atom_number1 = internal::cmc_mix_atoms[start+int((offset+uint64_t(2*k)*uint64_t(stride))%uint64_t(n))];
+         const int atom_number2 = internal::cmc_mix_atoms[start+int((offset+uint64_t(2*k+1)*uint64_t(stride))%uint64_t(n))];
+
+         double spin1_initial[3];
+         double delta[2];
+         double beta_dE1;
+         double dm1[3];
+         double u;
+         propose_pair_move(atom_number1, internal::cmc_mix_stream, pm, spin1_initial, delta, beta_dE1, dm1, u, AtomExchangeType);
+
+         // include changes from previous pairs in magnetisation
+         const double Mk[3] = {M[0]+dM[0], M[1]+dM[1], M[2]+dM[2]};
+         const int result = complete_pair_move(atom_number2, delta, beta_dE1, dm1, u, pm, pmt, pv, Mk, dM, AtomExchangeType);
+         if(result==0) cmc::mc_success += 1.0;
+         else{
+            set_spin(atom_number1, spin1_initial);
+            if(result==1) cmc::energy_reject += 1.0;
+            else cmc::sphere_reject += 1.0;
+         }
+         cmc::mc_total += 1.0;
+
+      }
+
+      return;
+
+   }
+
+   #ifdef MPICF
+   //-----------------------------------------------------------------------------
+   // Function to perform mixing pair moves between processors. Processors are
+   // matched at random, and core atoms of one colour on the first processor of
+   // a match are paired with core atoms of the same colour on the second. The
+   // first processor sends the moves of spin 1 and the second processor
+   // completes the pair moves and returns the accepted moves. Core atoms of
+   // one colour do not interact, so all pairs are moved concurrently.
+   //-----------------------------------------------------------------------------
+   void parallel_cmc_processor_mixing_moves(const int group, const double pm[3][3], const double pmt[3][3], const double pv[3],
+                                            const double M[3], double dM[3]){
+
+      const int num_groups = internal::cmc_num_groups;
+      const int AtomExchangeType=atoms::exchange_type;
+
+      // random matching of processors, identical on all processors
+      std::vector<int> order(vmpi::num_processors);
+      for(int p=0;p<vmpi::num_processors;p++) order[p]=p;
+      for(int p=vmpi::num_processors-1;p>0;p--){
+         const uint32_t key[2] = {uint32_t(mtrandom::integration_seed), internal::cmc_pair_stream};
+         const uint32_t ctr[4] = {internal::cmc_match_label, uint32_t(group*vmpi::num_processors+p), uint32_t(mtrandom::thermal_step), uint32_t(mtrandom::thermal_step >> 32)};
+         uint32_t r[4];
+         mtrandom::philox4x32(ctr, key, r);
+         const int q = r[0]%uint32_t(p+1);
+         const int t = order[p];
+         order[p] = order[q];
+         order[q] = t;
+      }
+      int position=0;
+      while(order[position]!=vmpi::my_rank) position++;
+      const int partner_position = position^1;
+      if(partner_position >= vmpi::num_processors) return;
+      const int partner = order[partner_position];
+      const bool first = (position%2==0);
+
+      // select colour at random and find core atoms of colour in group
+      const uint32_t key[2] = {uint32_t(mtrandom::integration_seed), internal::cmc_pair_stream};
+      const uint32_t ctr[4] = {internal::cmc_match_label, uint32_t(group), uint32_t(~mtrandom::thermal_step), uint32_t(mtrandom::thermal_step >> 32)};
+      uint32_t r[4];
+      mtrandom::philox4x32(ctr, key, r);
+      const int colour = r[0]%uint32_t(internal::mc_num_colours);
+      const int start = internal::cmc_group_start[colour*num_groups+group];
+      int end = start;
+      while(end < internal::cmc_group_start[colour*num_groups+group+1] && internal::cmc_group_atoms[end] < vmpi::num_core_atoms) end++;
+      const int n = end-start;
+
+      // agree number of pairs with partner
+      int num_pairs = n;
+      int partner_num_pairs=0;
+      MPI_Sendrecv(&num_pairs, 1, MPI_INT, partner, 70, &partner_num_pairs, 1, MPI_INT, partner, 70, vmpi::comm, MPI_STATUS_IGNORE);
+      if(partner_num_pairs < num_pairs) num_pairs = partner_num_pairs;
+      if(num_pairs==0) return;
+
+      uint64_t offset;
+      int stride;
+      random_pairing(n, internal::cmc_rank_label, uint32_t(group*vmpi::num_processors+vmpi::my_rank), offset, stride);
+
+      std::vector<double> moves(6*num_pairs);
+      std::vector<int> accepted(num_pairs);
+
+      if(first){
+
+         // propose moves of spin 1 and send to partner
+         std::vector<double> spin1_initial(3*num_pairs);
+         #pragma omp parallel for schedule(static) if(num_pairs > vomp::min_atoms_per_team)
+         for(int k=0;k<num_pairs;k++){
+            const int atom_number1 = internal::cmc_group_atoms[start+int((offset+uint64_t(k)*uint64_t(stride))%uint64_t(n))];
+            double u;
+            propose_pair_move(atom_number1, internal::cmc_rank_stream, pm, &spin1_initial[3*k], &moves[6*k], moves[6*k+2], &moves[6*k+3], u, AtomExchangeType);
+         }
+         MPI_Send(&moves[0], 6*num_pairs, MPI_DOUBLE, partner, 71, vmpi::comm);
+         MPI_Recv(&accepted[0], num_pairs, MPI_INT, partner, 72, vmpi::comm, MPI_STATUS_IGNORE);
+
+         // reset rejected moves
+         for(int k=0;k<num_pairs;k++){
+            const int atom_number1 = internal::cmc_group_atoms[start+int((offset+uint64_t(k)*uint64_t(stride))%uint64_t(n))];
+            if(accepted[k]==0) set_spin(atom_number1, &spin1_initial[3*k]);
+         }
+
+      }
+      else{
+
+         // complete moves with spin 2 and return accepted moves
+         MPI_Recv(&moves[0], 6*num_pairs, MPI_DOUBLE, partner, 71, vmpi::comm, MPI_STATUS_IGNORE);
+
+         double success=0.0;
+         double energy_reject=0.0;
+         double sphere_reject=0.0;
+         double dMx=0.0;
+         double dMy=0.0;
+         double dMz=0.0;
+
+         #pragma omp parallel for schedule(static) reduction(+:success,energy_reject,sphere_reject,dMx,dMy,dMz) if(num_pairs > vomp::min_atoms_per_team)
+         for(int k=0;k<num_pairs;k++){
+            const int atom_number2 = internal::cmc_group_atoms[start+int((offset+uint64_t(k)*uint64_t(stride))%uint64_t(n))];
+
+            // acceptance random number from spin 2
+            double g[3];
+            double u[2];
+            internal::mc_counter_randoms(atoms::global_id_array[atom_number2], internal::cmc_rank_stream, g, u);
+
+            double dm[3]={0.0,0.0,0.0};
+            const int result = complete_pair_move(atom_number2, &moves[6*k], moves[6*k+2], &moves[6*k+3], u[1], pm, pmt, pv, M, dm, AtomExchangeType);
+            accepted[k] = (result==0);
+            if(result==0){
+               dMx+=dm[0];
+               dMy+=dm[1];
+               dMz+=dm[2];
+               success+=1.0;
+            }
+            else if(result==1) energy_reject+=1.0;
+            else sphere_reject+=1.0;
+         }
+
+         dM[0]+=dMx;
+         dM[1]+=dMy;
+         dM[2]+=dMz;
+
+         cmc::mc_success += success;
+         cmc::energy_reject += energy_reject;
+         cmc::sphere_reject += sphere_reject;
+         cmc::mc_total += double(num_pairs);
+
+         MPI_Send(&accepted[0], num_pairs, MPI_INT, partner, 72, vmpi::comm);
+
+      }
+
+      return;
+
+   }
+   #endif
+
+   //-----------------------------------------------------------------------------
+   // Parallel constrained and hybrid constrained Monte Carlo integrator. Each
+   // step is a sweep over all colours, with a set of non-overlapping pair moves
+   // in each constraint group of a colour, followed by the mixing pairs.
+   //-----------------------------------------------------------------------------
+   int ParallelConstrainedMonteCarlo(){
+
+      // Check for calling of function
+      if(err::check==true) std::cout << "sim::ParallelConstrainedMonteCarlo has been called" << std::endl;
+
+      const bool hybrid = (sim::integrator==sim::hybrid_constrained_monte_carlo);
+
+      // check for cmc initialisation
+      if(cmc::is_initialised==false){
+         if(hybrid) CMCMCinit();
+         else CMCinit();
+      }
+      if(internal::cmc_groups_set==false) sim::initialise_parallel_constrained_monte_carlo();
+
+      // Update material dependent temperature rescaling in compact material table
+      mp::update_material_hot_params_temperature();
+
+      const int num_groups = internal::cmc_num_groups;
+      #ifdef MPICF
+         const int num_local_atoms = vmpi::num_core_atoms+vmpi::num_bdry_atoms;
+      #else
+         const int num_local_atoms = atoms::num_atoms;
+      #endif
+
+      // copy constraint matrices for each group
+      std::vector<bool> constrained(num_groups,true);
+      std::vector<double> pm(9*num_groups);
+      std::vector<double> pmt(9*num_groups);
+      std::vector<double> pv(3*num_groups);
+      for(int g=0;g<num_groups;g++){
+         if(hybrid) constrained[g]=mp::material[g].constrained;
+         for(int i=0;i<3;i++){
+            pv[3*g+i] = hybrid ? cmc::cmc_mat[g].ppolar_vector[i] : cmc::polar_vector[0][i];
+            for(int j=0;j<3;j++){
+               pm[9*g+3*i+j]  = hybrid ? cmc::cmc_mat[g].ppolar_matrix[i][j] : cmc::polar_matrix[i][j];
+               pmt[9*g+3*i+j] = hybrid ? cmc::cmc_mat[g].ppolar_matrix_tp[i][j] : cmc::polar_matrix_tp[i][j];
+            }
+         }
+      }
+
+      // calculate total magnetisation of each group
+      std::vector<double> M(3*num_groups,0.0);
+      for(int atom=0;atom<num_local_atoms;atom++){
+         const int g = hybrid ? atoms::type_array[atom] : 0;
+         M[3*g+0] += atoms::x_spin_array[atom];
+         M[3*g+1] += atoms::y_spin_array[atom];
+         M[3*g+2] += atoms::z_spin_array[atom];
+      }
+      #ifdef MPICF
+         MPI_Allreduce(MPI_IN_PLACE, &M[0], 3*num_groups, MPI_DOUBLE, MPI_SUM, vmpi::comm);
+      #endif
+
+      std::vector<double> dM(3*num_groups);
+
+      for(int c=0;c<internal::mc_num_colours;c++){
+
+         for(int i=0;i<3*num_groups;i++) dM[i]=0.0;
+
+         for(int g=0;g<num_groups;g++){
+            const int start = internal::cmc_group_start[c*num_groups+g];
+            const int end = internal::cmc_group_start[c*num_groups+g+1];
+            if(constrained[g]){
+               const double (*pmg)[3] = reinterpret_cast<const double (*)[3]>(&pm[9*g]);
+               const double (*pmtg)[3] = reinterpret_cast<const double (*)[3]>(&pmt[9*g]);
+               parallel_cmc_pair_moves(start, end, c, g, pmg, pmtg, &pv[3*g], &M[3*g], &dM[3*g]);
+            }
+            else parallel_cmc_single_moves(start, end);
+         }
+
+         // reconcile change in magnetisation and update halo spins
+         #ifdef MPICF
+            MPI_Allreduce(MPI_IN_PLACE, &dM[0], 3*num_groups, MPI_DOUBLE, MPI_SUM, vmpi::comm);
+            mpi_init_halo_swap();
+            mpi_complete_halo_swap();
+         #endif
+         for(int i=0;i<3*num_groups;i++) M[i]+=dM[i];
+
+      }
+
+      // mixing pairs between colours and processors, which only move core atoms
+      for(int g=0;g<num_groups;g++){
+         if(!constrained[g]) continue;
+         const double (*pmg)[3] = reinterpret_cast<const double (*)[3]>(&pm[9*g]);
+         const double (*pmtg)[3] = reinterpret_cast<const double (*)[3]>(&pmt[9*g]);
+         double dMg[3]={0.0,0.0,0.0};
+         parallel_cmc_mixing_moves(g, pmg, pmtg, &pv[3*g], &M[3*g], dMg);
+         #ifdef MPICF
+            MPI_Allreduce(MPI_IN_PLACE, &dMg[0], 3, MPI_DOUBLE, MPI_SUM, vmpi::comm);
+            for(int i=0;i<3;i++){
+               M[3*g+i]+=dMg[i];
+               dMg[i]=0.0;
+            }
+            if(vmpi::num_processors>1) parallel_cmc_processor_mixing_moves(g, pmg, pmtg, &pv[3*g], &M[3*g], dMg);
+            MPI_Allreduce(MPI_IN_PLACE, &dMg[0], 3, MPI_DOUBLE, MPI_SUM, vmpi::comm);
+         #endif
+         for(int i=0;i<3;i++) M[3*g+i]+=dMg[i];
+      }
+
+      // save magnetisation of each material for hybrid method
+      if(hybrid){
+         for(int g=0;g<num_groups;g++){
+            cmc::cmc_mat[g].M_other[0]=M[3*g+0];
+            cmc::cmc_mat[g].M_other[1]=M[3*g+1];
+            cmc::cmc_mat[g].M_other[2]=M[3*g+2];
+         }
+      }
+
+      return EXIT_SUCCESS;
+
+   }
+
+} // end of namespace sim
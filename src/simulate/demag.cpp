@@ -52,6 +52,34 @@
 ///       rij_matrix[4] = yz = zy
 ///       rij_matrix[5] = zz
 ///
+///	With demag::compressed=true the matrix is instead stored once for each
+///	integer displacement between cells on the regular macrocell grid,
+///	requiring O(N) rather than O(N^2) memory. Partially filled cells at the
+///	edges of the system have a magnetic centre of mass which differs from the
+///	regular position on the grid, and for pairs including these cells the
+///	difference from the exact matrix is added as a correction.
+///
+///	For large regular macrocell grids the sum can instead be evaluated as a
+///	convolution using zero-padded 3D FFTs (demag::fft=true). The dipole tensor
+///	is then a function only of the separation of cells on the regular grid,
+///	is precomputed once in Fourier space, and the field costs O(N log N) time
+///	and O(N) memory. Cell separations are taken from the grid spacing rather
+///	than the magnetic centre of mass of each cell.
+///
+///	For sparse or irregular sets of occupied macrocells the sum can instead be
+///	evaluated with a Barnes-Hut tree code (demag::tree=true), in which distant
+///	groups of cells are replaced by a multipole expansion. The accuracy is set
+///	by demag::tree_opening_angle, see demag_tree.cpp.
+///
+///	With demag::hybrid=true the field on each atom from atoms in the same and
+///	near cells is calculated atomistically, and only the field from far cells
+///	is taken from the macrocell calculation, see demag_hybrid.cpp.
+///
+///	With demag::adaptive=true the fields are updated only from cells whose
+///	moment has changed by more than demag::update_tolerance since it was last
+///	used, and the interval between updates is adapted to the change in the
+///	fields, see demag_adaptive.cpp.
+///
 /// @section License
 /// Use of this code, either in source or compiled form, is subject to license from the authors.
 /// Copyright \htmlonly &copy \endhtmlonly Richard Evans, 2009-2010. All Rights Reserved.
@@ -72,11 +100,15 @@
 #include "demag.hpp"
 #include "sim.hpp"
 #include "vio.hpp"
+#include "vmath.hpp"
 #include "vmpi.hpp"
 
 
+#include <algorithm>
 #include <cmath>
+#include <complex>
 #include <iostream>
+#include <map>
 #include <time.h>
 
 namespace demag{
@@ -95,6 +127,317 @@ namespace demag{
 	std::vector <std::vector < double > > rij_yy;
 	std::vector <std::vector < double > > rij_yz;
 	std::vector <std::vector < double > > rij_zz;
+
+	// Compressed fast demag variables
+	bool compressed=false;
+
+	std::vector <double> compressed_rij_xx; /// dipole tensor for each cell displacement on grid
+	std::vector <double> compressed_rij_xy;
+	std::vector <double> compressed_rij_xz;
+	std::vector <double> compressed_rij_yy;
+	std::vector <double> compressed_rij_yz;
+	std::vector <double> compressed_rij_zz;
+
+	std::vector <double> compressed_mx; /// cell moments padded along z to match tensor
+	std::vector <double> compressed_my;
+	std::vector <double> compressed_mz;
+
+	std::vector <int> regular_cell_array;   /// 1 if occupied cell is at regular position on grid
+	std::vector <int> irregular_cell_array; /// occupied cells away from regular position
+
+	// FFT demag variables
+	bool fft=false;
+
+	int fft_nx=0; /// zero-padded grid dimensions
+	int fft_ny=0;
+	int fft_nz=0;
+
+	std::vector <std::complex<double> > fft_rij_xx; /// dipole tensor in Fourier space
+	std::vector <std::complex<double> > fft_rij_xy;
+	std::vector <std::complex<double> > fft_rij_xz;
+	std::vector <std::complex<double> > fft_rij_yy;
+	std::vector <std::complex<double> > fft_rij_yz;
+	std::vector <std::complex<double> > fft_rij_zz;
+
+	std::vector <std::complex<double> > fft_mx; /// work arrays for cell moments and fields
+	std::vector <std::complex<double> > fft_my;
+	std::vector <std::complex<double> > fft_mz;
+
+/// @brief Function to calculate dipole tensor for separation r
+///
+/// @details Shared by all demag methods so that their tensors are identical
+///
+/// @internal
+///=====================================================================================
+///
+void dipole_tensor(const double rx, const double ry, const double rz, double rij_matrix[6]){
+
+	const double rij = 1.0/sqrt(rx*rx+ry*ry+rz*rz);
+
+	const double ex = rx*rij;
+	const double ey = ry*rij;
+	const double ez = rz*rij;
+
+	const double rij3 = rij*rij*rij; // Angstroms
+
+	rij_matrix[0] = demag::prefactor*((3.0*ex*ex - 1.0)*rij3);
+	rij_matrix[1] = demag::prefactor*(3.0*ex*ey)*rij3;
+	rij_matrix[2] = demag::prefactor*(3.0*ex*ez)*rij3;
+
+	rij_matrix[3] = demag::prefactor*((3.0*ey*ey - 1.0)*rij3);
+	rij_matrix[4] = demag::prefactor*(3.0*ey*ez)*rij3;
+	rij_matrix[5] = demag::prefactor*((3.0*ez*ez - 1.0)*rij3);
+
+}
+
+/// @brief Function to return index of displacement between cells in compressed tensor
+///
+/// @internal
+///=====================================================================================
+///
+inline int displacement_index(const int i, const int j){
+
+	const int nx = cells::num_cells_x;
+	const int ny = cells::num_cells_y;
+	const int nz = cells::num_cells_z;
+
+	const int dx = j/(ny*nz) - i/(ny*nz);
+	const int dy = (j/nz)%ny - (i/nz)%ny;
+	const int dz = j%nz - i%nz;
+
+	return ((dx+nx-1)*(2*ny-1) + (dy+ny-1))*(2*nz-1) + (dz+nz-1);
+
+}
+
+/// @brief Function to return fast dipole tensor between local cell lc and cell j
+///
+/// @details For the compressed tensor, pairs of regular cells are taken from
+///          the tensor for their displacement, otherwise the tensor is
+///          calculated from the cell coordinates.
+///
+/// @internal
+///=====================================================================================
+///
+void fast_tensor(const int lc, const int j, double rij_matrix[6]){
+
+	const int i = cells::local_cell_array[lc];
+
+	if(demag::compressed==false){
+		rij_matrix[0] = demag::rij_xx[lc][j];
+		rij_matrix[1] = demag::rij_xy[lc][j];
+		rij_matrix[2] = demag::rij_xz[lc][j];
+		rij_matrix[3] = demag::rij_yy[lc][j];
+		rij_matrix[4] = demag::rij_yz[lc][j];
+		rij_matrix[5] = demag::rij_zz[lc][j];
+	}
+	else if(demag::regular_cell_array[i]==1 && demag::regular_cell_array[j]==1){
+		const int index = displacement_index(i,j);
+		rij_matrix[0] = demag::compressed_rij_xx[index];
+		rij_matrix[1] = demag::compressed_rij_xy[index];
+		rij_matrix[2] = demag::compressed_rij_xz[index];
+		rij_matrix[3] = demag::compressed_rij_yy[index];
+		rij_matrix[4] = demag::compressed_rij_yz[index];
+		rij_matrix[5] = demag::compressed_rij_zz[index];
+	}
+	else{
+		dipole_tensor(cells::x_coord_array[j]-cells::x_coord_array[i],
+						  cells::y_coord_array[j]-cells::y_coord_array[i],
+						  cells::z_coord_array[j]-cells::z_coord_array[i], rij_matrix);
+	}
+
+}
+
+/// @brief Function to precompute compressed dipole tensor for fast update
+///
+/// @details Cells are regular if the offset of their magnetic centre of mass
+///          from the cell origin is the same as that of the most common
+///          offset of occupied cells. The tensor is then calculated for all
+///          displacements -(n-1)..(n-1) between cells on the grid.
+///
+/// @internal
+///=====================================================================================
+///
+void compressed_init(){
+
+	const int nx = cells::num_cells_x;
+	const int ny = cells::num_cells_y;
+	const int nz = cells::num_cells_z;
+	const int num_displacements = (2*nx-1)*(2*ny-1)*(2*nz-1);
+
+	// Check memory requirements and print to screen
+	const double memory = (double(num_displacements+nz)*6.0 + double(nx*ny*(2*nz-1))*3.0)*8.0/1.0e6;
+	zlog << zTs() << "Compressed fast demagnetisation field calculation has been enabled and requires " << memory << " MB of RAM" << std::endl;
+	std::cout << "Compressed fast demagnetisation field calculation has been enabled and requires " << memory << " MB of RAM" << std::endl;
+
+	// determine offset of centre of mass from cell origin for occupied cells
+	const double tolerance = 1.0e-6*cells::size;
+	std::map<std::vector<long long>, int> offset_count;
+	std::vector<std::vector<long long> > cell_offset(cells::num_cells);
+	for(int cell=0;cell<cells::num_cells;cell++){
+		if(cells::volume_array[cell]>0.0){
+			const double offset[3]={cells::x_coord_array[cell]-double(cell/(ny*nz))*cells::size,
+											cells::y_coord_array[cell]-double((cell/nz)%ny)*cells::size,
+											cells::z_coord_array[cell]-double(cell%nz)*cells::size};
+			cell_offset[cell].resize(3);
+			for(int c=0;c<3;c++) cell_offset[cell][c]=(long long)(floor(offset[c]/tolerance+0.5));
+			offset_count[cell_offset[cell]]++;
+		}
+	}
+
+	// find most common offset
+	std::vector<long long> regular_offset;
+	int max_count=0;
+	for(std::map<std::vector<long long>, int>::iterator it=offset_count.begin(); it!=offset_count.end(); ++it){
+		if(it->second>max_count){
+			max_count=it->second;
+			regular_offset=it->first;
+		}
+	}
+
+	demag::regular_cell_array.assign(cells::num_cells,0);
+	demag::irregular_cell_array.resize(0);
+	for(int cell=0;cell<cells::num_cells;cell++){
+		if(cells::volume_array[cell]>0.0){
+			bool regular=true;
+			for(int c=0;c<3;c++) if(std::abs(cell_offset[cell][c]-regular_offset[c])>1) regular=false;
+			if(regular) demag::regular_cell_array[cell]=1;
+			else demag::irregular_cell_array.push_back(cell);
+		}
+	}
+
+	zlog << zTs() << "Compressed dipole tensor for fast demag calculation has " << num_displacements << " displacements, with "
+		  << demag::irregular_cell_array.size() << " of " << demag::irregular_cell_array.size()+max_count << " occupied cells away from regular positions" << std::endl;
+	if(int(demag::irregular_cell_array.size())>max_count){
+		zlog << zTs() << "Warning: most cells are away from regular positions, and so the compressed tensor has little benefit. The macrocell size should be a multiple of the unit cell size." << std::endl;
+	}
+
+	// discard any dense tensor loaded from system image
+	demag::rij_xx.resize(0); demag::rij_xy.resize(0); demag::rij_xz.resize(0);
+	demag::rij_yy.resize(0); demag::rij_yz.resize(0); demag::rij_zz.resize(0);
+
+	// tensor is padded to allow reading of padded moments beyond last displacement
+	demag::compressed_rij_xx.assign(num_displacements+nz,0.0);
+	demag::compressed_rij_xy.assign(num_displacements+nz,0.0);
+	demag::compressed_rij_xz.assign(num_displacements+nz,0.0);
+	demag::compressed_rij_yy.assign(num_displacements+nz,0.0);
+	demag::compressed_rij_yz.assign(num_displacements+nz,0.0);
+	demag::compressed_rij_zz.assign(num_displacements+nz,0.0);
+
+	demag::compressed_mx.assign(nx*ny*(2*nz-1),0.0);
+	demag::compressed_my.assign(nx*ny*(2*nz-1),0.0);
+	demag::compressed_mz.assign(nx*ny*(2*nz-1),0.0);
+
+	for(int dx=-(nx-1);dx<nx;dx++){
+		for(int dy=-(ny-1);dy<ny;dy++){
+			for(int dz=-(nz-1);dz<nz;dz++){
+
+				// self interaction is included separately
+				if(dx==0 && dy==0 && dz==0) continue;
+
+				const int index = ((dx+nx-1)*(2*ny-1) + (dy+ny-1))*(2*nz-1) + (dz+nz-1);
+
+				double rij_matrix[6];
+				dipole_tensor(double(dx)*cells::size, double(dy)*cells::size, double(dz)*cells::size, rij_matrix);
+
+				demag::compressed_rij_xx[index] = rij_matrix[0];
+				demag::compressed_rij_xy[index] = rij_matrix[1];
+				demag::compressed_rij_xz[index] = rij_matrix[2];
+				demag::compressed_rij_yy[index] = rij_matrix[3];
+				demag::compressed_rij_yz[index] = rij_matrix[4];
+				demag::compressed_rij_zz[index] = rij_matrix[5];
+
+			}
+		}
+	}
+
+	return;
+
+}
+
+/// @brief Function to precompute dipole tensor in Fourier space
+///
+/// @details The tensor is set on a grid zero-padded to twice the size of
+///          the macrocell grid so that the cyclic convolution is equal to
+///          the open boundary sum over all cell pairs.
+///
+/// @section License
+/// Use of this code, either in source or compiled form, is subject to license from the authors.
+/// Copyright \htmlonly &copy \endhtmlonly Richard Evans, 2009-2011. All Rights Reserved.
+///
+/// @internal
+///=====================================================================================
+///
+void fft_init(){
+
+	const int nx = cells::num_cells_x;
+	const int ny = cells::num_cells_y;
+	const int nz = cells::num_cells_z;
+
+	// padded dimensions must hold all separations -(n-1)..(n-1)
+	demag::fft_nx = vmath::next_power_of_two(2*nx-1);
+	demag::fft_ny = vmath::next_power_of_two(2*ny-1);
+	demag::fft_nz = vmath::next_power_of_two(2*nz-1);
+	const int num_padded_cells = demag::fft_nx*demag::fft_ny*demag::fft_nz;
+
+	// Check memory requirements and print to screen
+	zlog << zTs() << "FFT demagnetisation field calculation has been enabled and requires " << double(num_padded_cells)*9.0*16.0/1.0e6 << " MB of RAM" << std::endl;
+	std::cout << "FFT demagnetisation field calculation has been enabled and requires " << double(num_padded_cells)*9.0*16.0/1.0e6 << " MB of RAM" << std::endl;
+	zlog << zTs() << "Zero-padded FFT grid for demag calculation: " << demag::fft_nx << "\t" << demag::fft_ny << "\t" << demag::fft_nz << std::endl;
+
+	const std::complex<double> zero(0.0,0.0);
+	demag::fft_rij_xx.assign(num_padded_cells,zero);
+	demag::fft_rij_xy.assign(num_padded_cells,zero);
+	demag::fft_rij_xz.assign(num_padded_cells,zero);
+	demag::fft_rij_yy.assign(num_padded_cells,zero);
+	demag::fft_rij_yz.assign(num_padded_cells,zero);
+	demag::fft_rij_zz.assign(num_padded_cells,zero);
+
+	demag::fft_mx.assign(num_padded_cells,zero);
+	demag::fft_my.assign(num_padded_cells,zero);
+	demag::fft_mz.assign(num_padded_cells,zero);
+
+	// set real space tensor for all separations, wrapping negative separations
+	for(int i=0;i<demag::fft_nx;i++){
+		const int di = i<nx ? i : i-demag::fft_nx;
+		if(di <= -nx) continue;
+		for(int j=0;j<demag::fft_ny;j++){
+			const int dj = j<ny ? j : j-demag::fft_ny;
+			if(dj <= -ny) continue;
+			for(int k=0;k<demag::fft_nz;k++){
+				const int dk = k<nz ? k : k-demag::fft_nz;
+				if(dk <= -nz) continue;
+
+				// self interaction is included separately
+				if(di==0 && dj==0 && dk==0) continue;
+
+				double rij_matrix[6];
+				dipole_tensor(double(di)*cells::size, double(dj)*cells::size, double(dk)*cells::size, rij_matrix); // Angstroms
+
+				const int index = (i*demag::fft_ny+j)*demag::fft_nz+k;
+
+				demag::fft_rij_xx[index] = rij_matrix[0];
+				demag::fft_rij_xy[index] = rij_matrix[1];
+				demag::fft_rij_xz[index] = rij_matrix[2];
+
+				demag::fft_rij_yy[index] = rij_matrix[3];
+				demag::fft_rij_yz[index] = rij_matrix[4];
+				demag::fft_rij_zz[index] = rij_matrix[5];
+
+			}
+		}
+	}
+
+	// transform tensor to Fourier space
+	vmath::fft3d(demag::fft_rij_xx, demag::fft_nx, demag::fft_ny, demag::fft_nz, false);
+	vmath::fft3d(demag::fft_rij_xy, demag::fft_nx, demag::fft_ny, demag::fft_nz, false);
+	vmath::fft3d(demag::fft_rij_xz, demag::fft_nx, demag::fft_ny, demag::fft_nz, false);
+	vmath::fft3d(demag::fft_rij_yy, demag::fft_nx, demag::fft_ny, demag::fft_nz, false);
+	vmath::fft3d(demag::fft_rij_yz, demag::fft_nx, demag::fft_ny, demag::fft_nz, false);
+	vmath::fft3d(demag::fft_rij_zz, demag::fft_nx, demag::fft_ny, demag::fft_nz, false);
+
+	return;
+
+}
 	
 /// @brief Function to set r_ij matrix values
 ///
@@ -123,7 +466,60 @@ void init(){
 		std::cerr << "demag::set_rij_matrix has been called " << vmpi::my_rank << std::endl;
 		terminaltextcolor(WHITE);
 	}
-	if(demag::fast==true) {
+	if(demag::fft==true){
+
+      // timing function
+      #ifdef MPICF
+         double t1 = MPI_Wtime();
+      #else
+         time_t t1;
+         t1 = time (NULL);
+      #endif
+
+		zlog << zTs() << "Precalculating Fourier space dipole tensor for demag calculation... " << std::endl;
+
+		demag::fft_init();
+
+      #ifdef MPICF
+         double t2 = MPI_Wtime();
+      #else
+         time_t t2;
+         t2 = time (NULL);
+      #endif
+		zlog << zTs() << "Precalculation of Fourier space dipole tensor complete. Time taken: " << t2-t1 << "s."<< std::endl;
+
+	}
+	else if(demag::tree==true){
+		demag::tree_init();
+	}
+	else if(demag::compressed==true){
+
+      // timing function
+      #ifdef MPICF
+         double t1 = MPI_Wtime();
+      #else
+         time_t t1;
+         t1 = time (NULL);
+      #endif
+
+		zlog << zTs() << "Precalculating compressed rij matrix for demag calculation... " << std::endl;
+
+		demag::compressed_init();
+
+      #ifdef MPICF
+         double t2 = MPI_Wtime();
+      #else
+         time_t t2;
+         t2 = time (NULL);
+      #endif
+		zlog << zTs() << "Precalculation of compressed rij matrix for demag calculation complete. Time taken: " << t2-t1 << "s."<< std::endl;
+
+	}
+	else if(demag::fast==true && int(demag::rij_xx.size())==cells::num_local_cells){
+		// dipole tensor loaded from system image
+		zlog << zTs() << "Using precalculated rij matrix for demag calculation from system image." << std::endl;
+	}
+	else if(demag::fast==true) {
 		
       // timing function
       #ifdef MPICF
@@ -136,6 +532,10 @@ void init(){
 		zlog << zTs() << "Fast demagnetisation field calculation has been enabled and requires " << double(cells::num_cells)*double(cells::num_local_cells*6)*8.0/1.0e6 << " MB of RAM" << std::endl;
 		std::cout << "Fast demagnetisation field calculation has been enabled and requires " << double(cells::num_cells)*double(cells::num_local_cells*6)*8.0/1.0e6 << " MB of RAM" << std::endl;
 		
+		// discard any mismatched data from system image
+		demag::rij_xx.resize(0); demag::rij_xy.resize(0); demag::rij_xz.resize(0);
+		demag::rij_yy.resize(0); demag::rij_yz.resize(0); demag::rij_zz.resize(0);
+
 		// allocate arrays to store data [nloccell x ncells]
 		for(int lc=0;lc<cells::num_local_cells; lc++){
 			
@@ -172,25 +572,18 @@ void init(){
 			for(int j=0;j<cells::num_cells;j++){
 				if(i!=j){
 				
-					const double rx = cells::x_coord_array[j]-cells::x_coord_array[i]; // Angstroms
-					const double ry = cells::y_coord_array[j]-cells::y_coord_array[i];
-					const double rz = cells::z_coord_array[j]-cells::z_coord_array[i];
-
-					const double rij = 1.0/sqrt(rx*rx+ry*ry+rz*rz);
-					
-					const double ex = rx*rij;
-					const double ey = ry*rij;
-					const double ez = rz*rij;
+					double rij_matrix[6];
+					dipole_tensor(cells::x_coord_array[j]-cells::x_coord_array[i], // Angstroms
+									  cells::y_coord_array[j]-cells::y_coord_array[i],
+									  cells::z_coord_array[j]-cells::z_coord_array[i], rij_matrix);
 
-					const double rij3 = rij*rij*rij; // Angstroms
+					rij_xx[lc][j] = rij_matrix[0];
+					rij_xy[lc][j] = rij_matrix[1];
+					rij_xz[lc][j] = rij_matrix[2];
 
-					rij_xx[lc][j] = demag::prefactor*((3.0*ex*ex - 1.0)*rij3);
-					rij_xy[lc][j] = demag::prefactor*(3.0*ex*ey)*rij3;
-					rij_xz[lc][j] = demag::prefactor*(3.0*ex*ez)*rij3;
-
-					rij_yy[lc][j] = demag::prefactor*((3.0*ey*ey - 1.0)*rij3);
-					rij_yz[lc][j] = demag::prefactor*(3.0*ey*ez)*rij3;
-					rij_zz[lc][j] = demag::prefactor*((3.0*ez*ez - 1.0)*rij3);
+					rij_yy[lc][j] = rij_matrix[3];
+					rij_yz[lc][j] = rij_matrix[4];
+					rij_zz[lc][j] = rij_matrix[5];
 
 				}
 			}
@@ -206,6 +599,12 @@ void init(){
 		
 	}
 	
+	// initialise hybrid near field calculation
+	if(demag::hybrid==true) demag::hybrid_init();
+
+	// initialise adaptive update
+	if(demag::adaptive==true) demag::adaptive_init();
+
 	// timing function
    #ifdef MPICF
       double t1 = MPI_Wtime();
@@ -292,6 +691,231 @@ inline void fast_update(){
 	//err::vexit();
 }
 
+/// @brief Function to recalculate demag fields using compressed fast update method
+///
+/// @section License
+/// Use of this code, either in source or compiled form, is subject to license from the authors.
+/// Copyright \htmlonly &copy \endhtmlonly Richard Evans, 2009-2011. All Rights Reserved.
+///
+/// @internal
+///=====================================================================================
+///
+inline void compressed_update(){
+	
+	// check for callin of routine
+	if(err::check==true) {
+		terminaltextcolor(RED);
+		std::cerr << "demag::compressed_update has been called " << vmpi::my_rank << std::endl;
+		terminaltextcolor(WHITE);
+	}
+	const int nx = cells::num_cells_x;
+	const int ny = cells::num_cells_y;
+	const int nz = cells::num_cells_z;
+	const int num_irregular_cells = demag::irregular_cell_array.size();
+
+	// copy cell moments into arrays padded along z
+	for(int cell=0;cell<cells::num_cells;cell++){
+		const int index = (cell/nz)*(2*nz-1) + cell%nz;
+		demag::compressed_mx[index] = cells::x_mag_array[cell];
+		demag::compressed_my[index] = cells::y_mag_array[cell];
+		demag::compressed_mz[index] = cells::z_mag_array[cell];
+	}
+
+	// loop over local cells
+	for(int lc=0;lc<cells::num_local_cells;lc++){
+		
+		int i = cells::local_cell_array[lc];
+		
+      // Calculate inverse volume from number of atoms in macrocell
+      // V in A^3 == 1e-30 m3, mu_0 = 4pie-7 -> prefactor = pi*4e23/3V
+      const double mu0_three_cell_volume = -4.0e23*M_PI/(3.0*cells::volume_array[i]);
+
+      // Add self-demagnetisation
+		double hx=mu0_three_cell_volume*cells::x_mag_array[i];
+		double hy=mu0_three_cell_volume*cells::y_mag_array[i];
+		double hz=mu0_three_cell_volume*cells::z_mag_array[i];
+
+		if(demag::regular_cell_array[i]==1){
+
+			// grid coordinates of local cell
+			const int ci = i/(ny*nz);
+			const int cj = (i/nz)%ny;
+			const int ck = i%nz;
+
+			// Loop over all other cells to calculate contribution to local cell.
+			// For each plane of cells the tensor for all displacements is read
+			// contiguously, matching the moments padded along z.
+			const int plane_size = ny*(2*nz-1);
+			for(int gi=0;gi<nx;gi++){
+
+				const double* const rxx = &demag::compressed_rij_xx[((gi-ci+nx-1)*(2*ny-1) + (ny-1-cj))*(2*nz-1) + (nz-1-ck)];
+				const double* const rxy = &demag::compressed_rij_xy[((gi-ci+nx-1)*(2*ny-1) + (ny-1-cj))*(2*nz-1) + (nz-1-ck)];
+				const double* const rxz = &demag::compressed_rij_xz[((gi-ci+nx-1)*(2*ny-1) + (ny-1-cj))*(2*nz-1) + (nz-1-ck)];
+				const double* const ryy = &demag::compressed_rij_yy[((gi-ci+nx-1)*(2*ny-1) + (ny-1-cj))*(2*nz-1) + (nz-1-ck)];
+				const double* const ryz = &demag::compressed_rij_yz[((gi-ci+nx-1)*(2*ny-1) + (ny-1-cj))*(2*nz-1) + (nz-1-ck)];
+				const double* const rzz = &demag::compressed_rij_zz[((gi-ci+nx-1)*(2*ny-1) + (ny-1-cj))*(2*nz-1) + (nz-1-ck)];
+
+				const double* const pmx = &demag::compressed_mx[gi*plane_size];
+				const double* const pmy = &demag::compressed_my[gi*plane_size];
+				const double* const pmz = &demag::compressed_mz[gi*plane_size];
+
+				for(int t=0;t<plane_size;t++){
+
+					const double mx = pmx[t];
+					const double my = pmy[t];
+					const double mz = pmz[t];
+
+					hx+=(mx*rxx[t] + my*rxy[t] + mz*rxz[t]);
+					hy+=(mx*rxy[t] + my*ryy[t] + mz*ryz[t]);
+					hz+=(mx*rxz[t] + my*ryz[t] + mz*rzz[t]);
+
+				}
+			}
+
+			// Correct contributions of cells away from regular position
+			for(int c=0;c<num_irregular_cells;c++){
+
+				const int j = demag::irregular_cell_array[c];
+				const int index = displacement_index(i,j);
+
+				double rij_matrix[6];
+				fast_tensor(lc,j,rij_matrix);
+
+				rij_matrix[0]-=demag::compressed_rij_xx[index];
+				rij_matrix[1]-=demag::compressed_rij_xy[index];
+				rij_matrix[2]-=demag::compressed_rij_xz[index];
+				rij_matrix[3]-=demag::compressed_rij_yy[index];
+				rij_matrix[4]-=demag::compressed_rij_yz[index];
+				rij_matrix[5]-=demag::compressed_rij_zz[index];
+
+				const double mx = cells::x_mag_array[j];
+				const double my = cells::y_mag_array[j];
+				const double mz = cells::z_mag_array[j];
+
+				hx+=(mx*rij_matrix[0] + my*rij_matrix[1] + mz*rij_matrix[2]);
+				hy+=(mx*rij_matrix[1] + my*rij_matrix[3] + mz*rij_matrix[4]);
+				hz+=(mx*rij_matrix[2] + my*rij_matrix[4] + mz*rij_matrix[5]);
+
+			}
+		}
+		else{
+
+			// Local cell away from regular position, so calculate tensor for all other cells
+			for(int j=0;j<cells::num_cells;j++){
+
+				if(j==i || cells::volume_array[j]==0.0) continue;
+
+				double rij_matrix[6];
+				fast_tensor(lc,j,rij_matrix);
+
+				const double mx = cells::x_mag_array[j];
+				const double my = cells::y_mag_array[j];
+				const double mz = cells::z_mag_array[j];
+
+				hx+=(mx*rij_matrix[0] + my*rij_matrix[1] + mz*rij_matrix[2]);
+				hy+=(mx*rij_matrix[1] + my*rij_matrix[3] + mz*rij_matrix[4]);
+				hz+=(mx*rij_matrix[2] + my*rij_matrix[4] + mz*rij_matrix[5]);
+
+			}
+		}
+
+		cells::x_field_array[i]=hx;
+		cells::y_field_array[i]=hy;
+		cells::z_field_array[i]=hz;
+
+	}
+	//err::vexit();
+}
+
+/// @brief Function to recalculate demag fields using FFT convolution
+///
+/// @details All ranks hold the full set of cell moments after cells::mag(),
+///          so the convolution is evaluated on each rank and only the fields
+///          of local cells are stored.
+///
+/// @section License
+/// Use of this code, either in source or compiled form, is subject to license from the authors.
+/// Copyright \htmlonly &copy \endhtmlonly Richard Evans, 2009-2011. All Rights Reserved.
+///
+/// @internal
+///=====================================================================================
+///
+inline void fft_update(){
+
+	// check for calling of routine
+	if(err::check==true){
+		terminaltextcolor(RED);
+		std::cerr << "demag::fft_update has been called " << vmpi::my_rank << std::endl;
+		terminaltextcolor(WHITE);
+	}
+
+	const int nx = cells::num_cells_x;
+	const int ny = cells::num_cells_y;
+	const int nz = cells::num_cells_z;
+	const int num_padded_cells = demag::fft_nx*demag::fft_ny*demag::fft_nz;
+
+	// copy cell moments into zero-padded arrays
+	const std::complex<double> zero(0.0,0.0);
+	std::fill(demag::fft_mx.begin(),demag::fft_mx.end(),zero);
+	std::fill(demag::fft_my.begin(),demag::fft_my.end(),zero);
+	std::fill(demag::fft_mz.begin(),demag::fft_mz.end(),zero);
+
+	for(int i=0;i<nx;i++){
+		for(int j=0;j<ny;j++){
+			for(int k=0;k<nz;k++){
+				const int cell = (i*ny+j)*nz+k;
+				const int index = (i*demag::fft_ny+j)*demag::fft_nz+k;
+				demag::fft_mx[index] = cells::x_mag_array[cell];
+				demag::fft_my[index] = cells::y_mag_array[cell];
+				demag::fft_mz[index] = cells::z_mag_array[cell];
+			}
+		}
+	}
+
+	vmath::fft3d(demag::fft_mx, demag::fft_nx, demag::fft_ny, demag::fft_nz, false);
+	vmath::fft3d(demag::fft_my, demag::fft_nx, demag::fft_ny, demag::fft_nz, false);
+	vmath::fft3d(demag::fft_mz, demag::fft_nx, demag::fft_ny, demag::fft_nz, false);
+
+	// multiply by tensor in Fourier space, overwriting moments with fields
+	for(int index=0;index<num_padded_cells;index++){
+		const std::complex<double> mx = demag::fft_mx[index];
+		const std::complex<double> my = demag::fft_my[index];
+		const std::complex<double> mz = demag::fft_mz[index];
+
+		demag::fft_mx[index] = demag::fft_rij_xx[index]*mx + demag::fft_rij_xy[index]*my + demag::fft_rij_xz[index]*mz;
+		demag::fft_my[index] = demag::fft_rij_xy[index]*mx + demag::fft_rij_yy[index]*my + demag::fft_rij_yz[index]*mz;
+		demag::fft_mz[index] = demag::fft_rij_xz[index]*mx + demag::fft_rij_yz[index]*my + demag::fft_rij_zz[index]*mz;
+	}
+
+	vmath::fft3d(demag::fft_mx, demag::fft_nx, demag::fft_ny, demag::fft_nz, true);
+	vmath::fft3d(demag::fft_my, demag::fft_nx, demag::fft_ny, demag::fft_nz, true);
+	vmath::fft3d(demag::fft_mz, demag::fft_nx, demag::fft_ny, demag::fft_nz, true);
+
+	const double inv_num_padded_cells = 1.0/double(num_padded_cells);
+
+	// loop over local cells
+	for(int lc=0;lc<cells::num_local_cells;lc++){
+
+		int i = cells::local_cell_array[lc];
+
+		// unpack grid coordinates of cell
+		const int ci = i/(ny*nz);
+		const int cj = (i/nz)%ny;
+		const int ck = i%nz;
+		const int index = (ci*demag::fft_ny+cj)*demag::fft_nz+ck;
+
+      // V in A^3 == 1e-30 m3, mu_0 = 4pie-7 -> prefactor = pi*4e23/3V
+      const double mu0_three_cell_volume = -4.0e23*M_PI/(3.0*cells::volume_array[i]);
+
+      // Add self-demagnetisation and field from all other cells
+		cells::x_field_array[i]=mu0_three_cell_volume*cells::x_mag_array[i] + demag::fft_mx[index].real()*inv_num_padded_cells;
+		cells::y_field_array[i]=mu0_three_cell_volume*cells::y_mag_array[i] + demag::fft_my[index].real()*inv_num_padded_cells;
+		cells::z_field_array[i]=mu0_three_cell_volume*cells::z_mag_array[i] + demag::fft_mz[index].real()*inv_num_padded_cells;
+
+	}
+
+}
+
 /// @brief Function to recalculate demag fields using standard update method
 ///
 /// @section License
@@ -428,7 +1052,10 @@ void update(){
 	if(demag::update_time!=sim::time){
 
 		// Check if update required
-	  if(sim::time%demag::update_rate==0){
+		bool update_required = (sim::time%demag::update_rate==0);
+		if(demag::adaptive==true) update_required = demag::adaptive_update_required(demag::update_time);
+
+	  if(update_required){
 
 		//if updated record last time at update
 		demag::update_time=sim::time;
@@ -436,9 +1063,20 @@ void update(){
 		// update cell magnetisations
 		cells::mag();
 		
-		// recalculate demag fields
-		if(demag::fast==true) fast_update();
-		else std_update();
+		// recalculate demag fields, in adaptive mode only from changed cells where possible
+		bool updated = false;
+		if(demag::adaptive==true) updated = demag::adaptive_update();
+
+		if(updated==false){
+			if(demag::fft==true) fft_update();
+			else if(demag::tree==true) tree_update();
+			else if(demag::compressed==true) compressed_update();
+			else if(demag::fast==true) fast_update();
+			else std_update();
+		}
+
+		// adapt interval to next update
+		if(demag::adaptive==true) demag::adaptive_schedule();
 		
 		// For MPI version, only add local atoms
 		#ifdef MPICF
@@ -447,14 +1085,17 @@ void update(){
 			const int num_local_atoms = atoms::num_atoms;
 		#endif
 			
-		// Update Atomistic Dipolar Field Array
-		for(int atom=0;atom<num_local_atoms;atom++){
-			const int cell = atoms::cell_array[atom];
-
-			// Copy field from macrocell to atomistic spin
-			atoms::x_dipolar_field_array[atom]=cells::x_field_array[cell];
-			atoms::y_dipolar_field_array[atom]=cells::y_field_array[cell];
-			atoms::z_dipolar_field_array[atom]=cells::z_field_array[cell];
+		// Update Atomistic Dipolar Field Array, replacing near cells with atomistic field for hybrid calculation
+		if(demag::hybrid==true) demag::hybrid_update();
+		else{
+			for(int atom=0;atom<num_local_atoms;atom++){
+				const int cell = atoms::cell_array[atom];
+
+				// Copy field from macrocell to atomistic spin
+				atoms::x_dipolar_field_array[atom]=cells::x_field_array[cell];
+				atoms::y_dipolar_field_array[atom]=cells::y_field_array[cell];
+				atoms::z_dipolar_field_array[atom]=cells::z_field_array[cell];
+			}
 		}
 
 		} // End of check for update rate
@@ -0,0 +1,326 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+//
+//    Adaptive, change-driven demagnetisation field update. With
+//    sim:enable-adaptive-dipole-fields, the moment of each cell last used to
+//    calculate the fields is stored, and at each update only the
+//    contributions of cells whose moment has changed by more than
+//    sim:dipole-field-update-tolerance (relative to the saturation moment of
+//    the cell) are refreshed. For the fast and standard methods this is done
+//    with rank-1 updates using the stored (or directly calculated) dipole
+//    tensor, at a cost of O(N_local N_changed). Unrefreshed changes are kept
+//    and applied once they exceed the tolerance. The FFT and tree methods
+//    are recalculated in full only if any cell has changed.
+//
+//    The interval between updates is also adapted from the largest relative
+//    change in the field of any cell at each update. The interval is doubled
+//    (up to max_interval_factor times the dipole field update rate) while
+//    the change is less than half of the tolerance, and reset to the update
+//    rate if the change exceeds the tolerance.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Vampire headers
+#include "atoms.hpp"
+#include "cells.hpp"
+#include "demag.hpp"
+#include "errors.hpp"
+#include "material.hpp"
+#include "sim.hpp"
+#include "vio.hpp"
+#include "vmpi.hpp"
+
+namespace demag{
+
+	bool adaptive=false;          /// flag to enable adaptive demag field update
+	double update_tolerance=1.0e-3; /// relative change in cell moment or field for update
+
+	namespace internal{
+
+		const int max_interval_factor=16; /// maximum interval between updates as multiple of update rate
+
+		int update_interval=1; /// current interval between adaptive updates
+
+		std::vector<double> saturation_moment_array; /// saturation moment of each cell
+
+		std::vector<double> x_ref_mag_array; /// cell moments last used to calculate fields
+		std::vector<double> y_ref_mag_array;
+		std::vector<double> z_ref_mag_array;
+
+		std::vector<double> x_cell_field_array; /// field of local cells from other cells [local cell]
+		std::vector<double> y_cell_field_array;
+		std::vector<double> z_cell_field_array;
+
+		std::vector<double> x_old_field_array; /// field of local cells before update [local cell]
+		std::vector<double> y_old_field_array;
+		std::vector<double> z_old_field_array;
+
+		std::vector<int> changed_cell_array; /// cells with changed moments
+		std::vector<double> changed_mag_array; /// change in moment of changed cells [3*changed cell]
+
+	} // end of namespace internal
+
+	//-----------------------------------------------------------------------------
+	// Function to initialise adaptive demag field update
+	//-----------------------------------------------------------------------------
+	void adaptive_init(){
+
+		using namespace internal;
+
+		// calculate saturation moment of each cell
+		saturation_moment_array.assign(cells::num_cells,0.0);
+
+		#ifdef MPICF
+			const int num_local_atoms = vmpi::num_core_atoms+vmpi::num_bdry_atoms;
+		#else
+			const int num_local_atoms = atoms::num_atoms;
+		#endif
+
+		for(int atom=0;atom<num_local_atoms;atom++){
+			saturation_moment_array[atoms::cell_array[atom]]+=mp::material[atoms::type_array[atom]].mu_s_SI;
+		}
+
+		#ifdef MPICF
+			if(cells::num_cells>0) MPI_Allreduce(MPI_IN_PLACE, &saturation_moment_array[0], cells::num_cells, MPI_DOUBLE, MPI_SUM, vmpi::comm);
+		#endif
+
+		// fields are calculated in full from zero reference moments at first update
+		x_ref_mag_array.assign(cells::num_cells,0.0);
+		y_ref_mag_array.assign(cells::num_cells,0.0);
+		z_ref_mag_array.assign(cells::num_cells,0.0);
+
+		x_cell_field_array.assign(cells::num_local_cells,0.0);
+		y_cell_field_array.assign(cells::num_local_cells,0.0);
+		z_cell_field_array.assign(cells::num_local_cells,0.0);
+
+		x_old_field_array.assign(cells::num_local_cells,0.0);
+		y_old_field_array.assign(cells::num_local_cells,0.0);
+		z_old_field_array.assign(cells::num_local_cells,0.0);
+
+		update_interval=demag::update_rate;
+
+		zlog << zTs() << "Adaptive demagnetisation field update has been enabled with tolerance " << demag::update_tolerance
+			  << " and maximum update interval " << max_interval_factor*demag::update_rate << std::endl;
+
+		return;
+
+	}
+
+	//-----------------------------------------------------------------------------
+	// Function to determine if adaptive update is required
+	//-----------------------------------------------------------------------------
+	bool adaptive_update_required(const int last_update_time){
+
+		// always update on first call or if time has been reset by program
+		// negative time means never updated, so casts below are safe
+		if(last_update_time<0 || sim::time<uint64_t(last_update_time)) return true;
+
+		return sim::time-uint64_t(last_update_time)>=uint64_t(internal::update_interval);
+
+	}
+
+	//-----------------------------------------------------------------------------
+	// Function to update demag fields from cells with changed moments. Returns
+	// false if the fields must instead be recalculated in full.
+	//-----------------------------------------------------------------------------
+	bool adaptive_update(){
+
+		// check for calling of routine
+		if(err::check==true){
+			terminaltextcolor(RED);
+			std::cerr << "demag::adaptive_update has been called " << vmpi::my_rank << std::endl;
+			terminaltextcolor(WHITE);
+		}
+
+		using namespace internal;
+
+		// save fields of local cells to determine change in field
+		for(int lc=0;lc<cells::num_local_cells;lc++){
+			const int i = cells::local_cell_array[lc];
+			x_old_field_array[lc]=cells::x_field_array[i];
+			y_old_field_array[lc]=cells::y_field_array[i];
+			z_old_field_array[lc]=cells::z_field_array[i];
+		}
+
+		// determine cells with moments changed by more than tolerance. All
+		// processors hold all cell moments and so find the same cells.
+		changed_cell_array.resize(0);
+		changed_mag_array.resize(0);
+
+		const double tolerance_sq = demag::update_tolerance*demag::update_tolerance;
+
+		for(int j=0;j<cells::num_cells;j++){
+
+			const double dmx = cells::x_mag_array[j]-x_ref_mag_array[j];
+			const double dmy = cells::y_mag_array[j]-y_ref_mag_array[j];
+			const double dmz = cells::z_mag_array[j]-z_ref_mag_array[j];
+
+			const double ms = saturation_moment_array[j];
+
+			if(dmx*dmx+dmy*dmy+dmz*dmz > tolerance_sq*ms*ms){
+				changed_cell_array.push_back(j);
+				changed_mag_array.push_back(dmx);
+				changed_mag_array.push_back(dmy);
+				changed_mag_array.push_back(dmz);
+			}
+
+		}
+
+		const int num_changed = changed_cell_array.size();
+
+		//--------------------------------------------------------------------------
+		// FFT and tree methods cannot be updated from single cells, and so are
+		// recalculated in full if any cell has changed
+		//--------------------------------------------------------------------------
+		if(demag::fft==true || demag::tree==true){
+
+			if(num_changed==0) return true;
+
+			x_ref_mag_array=cells::x_mag_array;
+			y_ref_mag_array=cells::y_mag_array;
+			z_ref_mag_array=cells::z_mag_array;
+
+			return false;
+
+		}
+
+		//--------------------------------------------------------------------------
+		// Add change in field from changed cells (rank-1 update of each tensor)
+		//--------------------------------------------------------------------------
+		for(int c=0;c<num_changed;c++){
+			const int j = changed_cell_array[c];
+			x_ref_mag_array[j]=cells::x_mag_array[j];
+			y_ref_mag_array[j]=cells::y_mag_array[j];
+			z_ref_mag_array[j]=cells::z_mag_array[j];
+		}
+
+		#pragma omp parallel for schedule(dynamic,16)
+		for(int lc=0;lc<cells::num_local_cells;lc++){
+
+			const int i = cells::local_cell_array[lc];
+
+			double hx=0.0;
+			double hy=0.0;
+			double hz=0.0;
+
+			if(demag::fast==true){
+				for(int c=0;c<num_changed;c++){
+
+					const int j = changed_cell_array[c];
+					if(j==i) continue;
+
+					const double dmx = changed_mag_array[3*c+0];
+					const double dmy = changed_mag_array[3*c+1];
+					const double dmz = changed_mag_array[3*c+2];
+
+					double rij_matrix[6];
+					demag::fast_tensor(lc,j,rij_matrix);
+
+					hx+=(dmx*rij_matrix[0] + dmy*rij_matrix[1] + dmz*rij_matrix[2]);
+					hy+=(dmx*rij_matrix[1] + dmy*rij_matrix[3] + dmz*rij_matrix[4]);
+					hz+=(dmx*rij_matrix[2] + dmy*rij_matrix[4] + dmz*rij_matrix[5]);
+
+				}
+			}
+			else{
+				for(int c=0;c<num_changed;c++){
+
+					const int j = changed_cell_array[c];
+					if(j==i) continue;
+
+					const double dmx = changed_mag_array[3*c+0];
+					const double dmy = changed_mag_array[3*c+1];
+					const double dmz = changed_mag_array[3*c+2];
+
+					const double dx = cells::x_coord_array[j]-cells::x_coord_array[i];
+					const double dy = cells::y_coord_array[j]-cells::y_coord_array[i];
+					const double dz = cells::z_coord_array[j]-cells::z_coord_array[i];
+
+					const double drij = 1.0/sqrt(dx*dx+dy*dy+dz*dz);
+					const double drij3 = drij*drij*drij;
+
+					const double ex = dx*drij;
+					const double ey = dy*drij;
+					const double ez = dz*drij;
+
+					const double s_dot_e = (dmx * ex + dmy * ey + dmz * ez);
+
+					hx+=(3.0 * s_dot_e * ex - dmx)*drij3*demag::prefactor;
+					hy+=(3.0 * s_dot_e * ey - dmy)*drij3*demag::prefactor;
+					hz+=(3.0 * s_dot_e * ez - dmz)*drij3*demag::prefactor;
+
+				}
+			}
+
+			x_cell_field_array[lc]+=hx;
+			y_cell_field_array[lc]+=hy;
+			z_cell_field_array[lc]+=hz;
+
+			// V in A^3 == 1e-30 m3, mu_0 = 4pie-7 -> prefactor = pi*4e23/3V
+			const double mu0_three_cell_volume = -4.0e23*M_PI/(3.0*cells::volume_array[i]);
+
+			// Add self-demagnetisation for current moment
+			cells::x_field_array[i]=mu0_three_cell_volume*cells::x_mag_array[i] + x_cell_field_array[lc];
+			cells::y_field_array[i]=mu0_three_cell_volume*cells::y_mag_array[i] + y_cell_field_array[lc];
+			cells::z_field_array[i]=mu0_three_cell_volume*cells::z_mag_array[i] + z_cell_field_array[lc];
+
+		}
+
+		return true;
+
+	}
+
+	//-----------------------------------------------------------------------------
+	// Function to adapt interval between updates from change in fields
+	//-----------------------------------------------------------------------------
+	void adaptive_schedule(){
+
+		using namespace internal;
+
+		// determine largest change in field and largest field of local cells
+		double max_change[2]={0.0,0.0};
+
+		for(int lc=0;lc<cells::num_local_cells;lc++){
+
+			const int i = cells::local_cell_array[lc];
+
+			const double hx = cells::x_field_array[i];
+			const double hy = cells::y_field_array[i];
+			const double hz = cells::z_field_array[i];
+
+			const double dhx = hx-x_old_field_array[lc];
+			const double dhy = hy-y_old_field_array[lc];
+			const double dhz = hz-z_old_field_array[lc];
+
+			max_change[0]=std::max(max_change[0],dhx*dhx+dhy*dhy+dhz*dhz);
+			max_change[1]=std::max(max_change[1],hx*hx+hy*hy+hz*hz);
+
+		}
+
+		#ifdef MPICF
+			MPI_Allreduce(MPI_IN_PLACE, max_change, 2, MPI_DOUBLE, MPI_MAX, vmpi::comm);
+		#endif
+
+		// relative change in field, which is the largest error in the field before update
+		const double field_error = max_change[1]>0.0 ? sqrt(max_change[0]/max_change[1]) : 0.0;
+
+		if(field_error>demag::update_tolerance) update_interval=demag::update_rate;
+		else if(2.0*field_error<demag::update_tolerance) update_interval=std::min(2*update_interval,max_interval_factor*demag::update_rate);
+
+		return;
+
+	}
+
+} // end of namespace demag
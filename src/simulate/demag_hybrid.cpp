@@ -0,0 +1,415 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+//
+//    Hybrid near-field atomistic and far-field macrocell demagnetisation
+//    field calculation. With sim:enable-hybrid-dipole-fields, the cells
+//    within sim:dipole-near-field-range cells of each cell along each axis
+//    are near cells. The field on each atom from atoms in the same and near
+//    cells is calculated exactly from the atomic dipoles, and the field from
+//    all other cells is taken from the macrocell calculation, with the self
+//    and near cell terms removed. This resolves dipolar structure within
+//    and between neighbouring cells at the surfaces and edges of small
+//    systems, while keeping large macrocells for the far field.
+//
+//    Atoms in each cell are stored in a cell list, and near cells of each
+//    local cell in a second list, which together act as a neighbour list
+//    for the atomistic calculation. In parallel, the positions and moments
+//    of atoms on other processors in near cells of local cells are received
+//    once during initialisation, and only spin directions are sent at each
+//    update.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Vampire headers
+#include "atoms.hpp"
+#include "cells.hpp"
+#include "demag.hpp"
+#include "errors.hpp"
+#include "material.hpp"
+#include "vio.hpp"
+#include "vmpi.hpp"
+
+namespace demag{
+
+	bool hybrid=false;       /// flag to enable hybrid near field atomistic demag calculation
+	int near_field_range=1;  /// range of near cells along each axis
+
+	namespace internal{
+
+		int num_local_atoms=0; /// number of local atoms, stored first in near field atom arrays
+
+		std::vector<int> near_cell_start; /// start of near cells of each local cell [local cell+1]
+		std::vector<int> near_cell_array; /// near cells of local cells
+
+		std::vector<int> cell_atom_start; /// start of near field atoms in each cell [cell+1]
+		std::vector<int> cell_atom_array; /// near field atoms in each cell
+
+		std::vector<double> nf_x_coord_array; /// coordinates of near field atoms (Angstroms)
+		std::vector<double> nf_y_coord_array;
+		std::vector<double> nf_z_coord_array;
+		std::vector<double> nf_moment_array;  /// moment of near field atoms (J/T)
+
+		std::vector<double> nf_x_spin_array;  /// spin directions of near field atoms
+		std::vector<double> nf_y_spin_array;
+		std::vector<double> nf_z_spin_array;
+
+		#ifdef MPICF
+			std::vector<int> nf_send_atom_array;  /// local atoms sent to other processors
+			std::vector<int> nf_send_counts;      /// number of atoms sent to each processor
+			std::vector<int> nf_send_displacements;
+			std::vector<int> nf_recv_counts;      /// number of atoms received from each processor
+			std::vector<int> nf_recv_displacements;
+			std::vector<double> nf_send_buffer;
+			std::vector<double> nf_recv_buffer;
+		#endif
+
+		//-----------------------------------------------------------------------
+		// Function to return dipole tensor between cells consistent with
+		// macrocell calculation
+		//-----------------------------------------------------------------------
+		void cell_tensor(const int i, const int j, double rij_matrix[6]){
+
+			double rx, ry, rz;
+
+			// FFT calculation uses separation of cells on regular grid
+			if(demag::fft==true){
+				const int ny = cells::num_cells_y;
+				const int nz = cells::num_cells_z;
+				rx = double(j/(ny*nz) - i/(ny*nz))*cells::size;
+				ry = double((j/nz)%ny - (i/nz)%ny)*cells::size;
+				rz = double(j%nz - i%nz)*cells::size;
+			}
+			else{
+				rx = cells::x_coord_array[j]-cells::x_coord_array[i];
+				ry = cells::y_coord_array[j]-cells::y_coord_array[i];
+				rz = cells::z_coord_array[j]-cells::z_coord_array[i];
+			}
+
+			demag::dipole_tensor(rx, ry, rz, rij_matrix);
+
+		}
+
+	} // end of namespace internal
+
+	//-----------------------------------------------------------------------------
+	// Function to set up cell lists for hybrid demag calculation
+	//-----------------------------------------------------------------------------
+	void hybrid_init(){
+
+		using namespace internal;
+
+		const int nx = cells::num_cells_x;
+		const int ny = cells::num_cells_y;
+		const int nz = cells::num_cells_z;
+		const int range = demag::near_field_range;
+
+		#ifdef MPICF
+			num_local_atoms = vmpi::num_core_atoms+vmpi::num_bdry_atoms;
+		#else
+			num_local_atoms = atoms::num_atoms;
+		#endif
+
+		//--------------------------------------------------------------------------
+		// Determine near cells of local cells
+		//--------------------------------------------------------------------------
+		std::vector<int> needed_cell(cells::num_cells,0);
+		near_cell_start.assign(cells::num_local_cells+1,0);
+		near_cell_array.resize(0);
+
+		for(int lc=0;lc<cells::num_local_cells;lc++){
+
+			const int i = cells::local_cell_array[lc];
+			const int ci = i/(ny*nz);
+			const int cj = (i/nz)%ny;
+			const int ck = i%nz;
+
+			for(int gi=std::max(ci-range,0);gi<=std::min(ci+range,nx-1);gi++){
+				for(int gj=std::max(cj-range,0);gj<=std::min(cj+range,ny-1);gj++){
+					for(int gk=std::max(ck-range,0);gk<=std::min(ck+range,nz-1);gk++){
+						const int j = (gi*ny+gj)*nz+gk;
+						if(cells::volume_array[j]>0.0){
+							near_cell_array.push_back(j);
+							needed_cell[j]=1;
+						}
+					}
+				}
+			}
+
+			near_cell_start[lc+1]=near_cell_array.size();
+
+		}
+
+		//--------------------------------------------------------------------------
+		// Store positions and moments of local atoms
+		//--------------------------------------------------------------------------
+		std::vector<int> nf_cell_array(num_local_atoms);
+		nf_x_coord_array.resize(num_local_atoms);
+		nf_y_coord_array.resize(num_local_atoms);
+		nf_z_coord_array.resize(num_local_atoms);
+		nf_moment_array.resize(num_local_atoms);
+
+		for(int atom=0;atom<num_local_atoms;atom++){
+			nf_x_coord_array[atom]=atoms::x_coord_array[atom];
+			nf_y_coord_array[atom]=atoms::y_coord_array[atom];
+			nf_z_coord_array[atom]=atoms::z_coord_array[atom];
+			nf_moment_array[atom]=mp::material[atoms::type_array[atom]].mu_s_SI;
+			nf_cell_array[atom]=atoms::cell_array[atom];
+		}
+
+		//--------------------------------------------------------------------------
+		// Receive positions and moments of atoms on other processors in near cells
+		//--------------------------------------------------------------------------
+		#ifdef MPICF
+
+			const int P=vmpi::num_processors;
+
+			// gather lists of needed cells from all processors
+			std::vector<int> needed_cell_list;
+			for(int cell=0;cell<cells::num_cells;cell++) if(needed_cell[cell]==1) needed_cell_list.push_back(cell);
+
+			std::vector<int> needed_counts(P,0);
+			std::vector<int> needed_displacements(P,0);
+			int num_needed=needed_cell_list.size();
+			MPI_Allgather(&num_needed, 1, MPI_INT, &needed_counts[0], 1, MPI_INT, vmpi::comm);
+			for(int p=1;p<P;p++) needed_displacements[p]=needed_displacements[p-1]+needed_counts[p-1];
+			std::vector<int> all_needed_cells(needed_displacements[P-1]+needed_counts[P-1]);
+			MPI_Allgatherv(needed_cell_list.empty() ? NULL : &needed_cell_list[0], num_needed, MPI_INT,
+								all_needed_cells.empty() ? NULL : &all_needed_cells[0], &needed_counts[0], &needed_displacements[0], MPI_INT, vmpi::comm);
+
+			// determine local atoms in cells needed by each other processor
+			nf_send_atom_array.resize(0);
+			nf_send_counts.assign(P,0);
+			nf_send_displacements.assign(P,0);
+			std::vector<int> needed_by_processor(cells::num_cells,0);
+			for(int p=0;p<P;p++){
+				nf_send_displacements[p]=nf_send_atom_array.size();
+				if(p==vmpi::my_rank) continue;
+				for(int c=0;c<needed_counts[p];c++) needed_by_processor[all_needed_cells[needed_displacements[p]+c]]=1;
+				for(int atom=0;atom<num_local_atoms;atom++){
+					if(needed_by_processor[atoms::cell_array[atom]]==1) nf_send_atom_array.push_back(atom);
+				}
+				for(int c=0;c<needed_counts[p];c++) needed_by_processor[all_needed_cells[needed_displacements[p]+c]]=0;
+				nf_send_counts[p]=nf_send_atom_array.size()-nf_send_displacements[p];
+			}
+
+			nf_recv_counts.assign(P,0);
+			nf_recv_displacements.assign(P,0);
+			MPI_Alltoall(&nf_send_counts[0], 1, MPI_INT, &nf_recv_counts[0], 1, MPI_INT, vmpi::comm);
+			for(int p=1;p<P;p++) nf_recv_displacements[p]=nf_recv_displacements[p-1]+nf_recv_counts[p-1];
+			const int num_send_atoms=nf_send_atom_array.size();
+			const int num_recv_atoms=nf_recv_displacements[P-1]+nf_recv_counts[P-1];
+
+			// send positions, moments and cells of atoms
+			std::vector<int> counts(P,0);
+			std::vector<int> displacements(P,0);
+			std::vector<int> recv_counts(P,0);
+			std::vector<int> recv_displacements(P,0);
+			for(int p=0;p<P;p++){
+				counts[p]=5*nf_send_counts[p];
+				displacements[p]=5*nf_send_displacements[p];
+				recv_counts[p]=5*nf_recv_counts[p];
+				recv_displacements[p]=5*nf_recv_displacements[p];
+			}
+			nf_send_buffer.resize(5*num_send_atoms);
+			nf_recv_buffer.resize(5*num_recv_atoms);
+			for(int s=0;s<num_send_atoms;s++){
+				const int atom=nf_send_atom_array[s];
+				nf_send_buffer[5*s+0]=atoms::x_coord_array[atom];
+				nf_send_buffer[5*s+1]=atoms::y_coord_array[atom];
+				nf_send_buffer[5*s+2]=atoms::z_coord_array[atom];
+				nf_send_buffer[5*s+3]=mp::material[atoms::type_array[atom]].mu_s_SI;
+				nf_send_buffer[5*s+4]=double(atoms::cell_array[atom]);
+			}
+			MPI_Alltoallv(nf_send_buffer.empty() ? NULL : &nf_send_buffer[0], &counts[0], &displacements[0], MPI_DOUBLE,
+							  nf_recv_buffer.empty() ? NULL : &nf_recv_buffer[0], &recv_counts[0], &recv_displacements[0], MPI_DOUBLE, vmpi::comm);
+
+			for(int r=0;r<num_recv_atoms;r++){
+				nf_x_coord_array.push_back(nf_recv_buffer[5*r+0]);
+				nf_y_coord_array.push_back(nf_recv_buffer[5*r+1]);
+				nf_z_coord_array.push_back(nf_recv_buffer[5*r+2]);
+				nf_moment_array.push_back(nf_recv_buffer[5*r+3]);
+				nf_cell_array.push_back(int(nf_recv_buffer[5*r+4]+0.5));
+			}
+
+			// spin directions are sent at each update
+			nf_send_buffer.resize(3*num_send_atoms);
+			nf_recv_buffer.resize(3*num_recv_atoms);
+			for(int p=0;p<P;p++){
+				nf_send_counts[p]*=3;
+				nf_send_displacements[p]*=3;
+				nf_recv_counts[p]*=3;
+				nf_recv_displacements[p]*=3;
+			}
+
+		#endif
+
+		//--------------------------------------------------------------------------
+		// Sort near field atoms into cell list
+		//--------------------------------------------------------------------------
+		const int num_nf_atoms=nf_cell_array.size();
+
+		cell_atom_start.assign(cells::num_cells+1,0);
+		for(int atom=0;atom<num_nf_atoms;atom++) cell_atom_start[nf_cell_array[atom]+1]++;
+		for(int cell=0;cell<cells::num_cells;cell++) cell_atom_start[cell+1]+=cell_atom_start[cell];
+
+		cell_atom_array.resize(num_nf_atoms);
+		std::vector<int> cell_count(cell_atom_start.begin(),cell_atom_start.end()-1);
+		for(int atom=0;atom<num_nf_atoms;atom++) cell_atom_array[cell_count[nf_cell_array[atom]]++]=atom;
+
+		nf_x_spin_array.assign(num_nf_atoms,0.0);
+		nf_y_spin_array.assign(num_nf_atoms,0.0);
+		nf_z_spin_array.assign(num_nf_atoms,0.0);
+
+		zlog << zTs() << "Hybrid demagnetisation field calculation has been enabled with near field range " << demag::near_field_range << " cells, "
+			  << near_cell_array.size() << " near cells of local cells and " << num_nf_atoms-num_local_atoms << " atoms from other processors" << std::endl;
+
+		return;
+
+	}
+
+	//-----------------------------------------------------------------------------
+	// Function to calculate atomic dipolar fields from near field atoms and
+	// far field cells. Requires macrocell fields to be calculated first.
+	//-----------------------------------------------------------------------------
+	void hybrid_update(){
+
+		// check for calling of routine
+		if(err::check==true){
+			terminaltextcolor(RED);
+			std::cerr << "demag::hybrid_update has been called " << vmpi::my_rank << std::endl;
+			terminaltextcolor(WHITE);
+		}
+
+		using namespace internal;
+
+		// copy spin directions of local atoms
+		for(int atom=0;atom<num_local_atoms;atom++){
+			nf_x_spin_array[atom]=atoms::x_spin_array[atom];
+			nf_y_spin_array[atom]=atoms::y_spin_array[atom];
+			nf_z_spin_array[atom]=atoms::z_spin_array[atom];
+		}
+
+		// exchange spin directions of atoms in near cells on other processors
+		#ifdef MPICF
+			for(unsigned int s=0;s<nf_send_atom_array.size();s++){
+				const int atom=nf_send_atom_array[s];
+				nf_send_buffer[3*s+0]=atoms::x_spin_array[atom];
+				nf_send_buffer[3*s+1]=atoms::y_spin_array[atom];
+				nf_send_buffer[3*s+2]=atoms::z_spin_array[atom];
+			}
+			MPI_Alltoallv(nf_send_buffer.empty() ? NULL : &nf_send_buffer[0], &nf_send_counts[0], &nf_send_displacements[0], MPI_DOUBLE,
+							  nf_recv_buffer.empty() ? NULL : &nf_recv_buffer[0], &nf_recv_counts[0], &nf_recv_displacements[0], MPI_DOUBLE, vmpi::comm);
+			for(unsigned int r=0;r<nf_recv_buffer.size()/3;r++){
+				nf_x_spin_array[num_local_atoms+r]=nf_recv_buffer[3*r+0];
+				nf_y_spin_array[num_local_atoms+r]=nf_recv_buffer[3*r+1];
+				nf_z_spin_array[num_local_atoms+r]=nf_recv_buffer[3*r+2];
+			}
+		#endif
+
+		#pragma omp parallel for schedule(dynamic,16)
+		for(int lc=0;lc<cells::num_local_cells;lc++){
+
+			const int i = cells::local_cell_array[lc];
+
+			//-----------------------------------------------------------------------
+			// Remove self and near cell terms from macrocell field
+			//-----------------------------------------------------------------------
+			// V in A^3 == 1e-30 m3, mu_0 = 4pie-7 -> prefactor = pi*4e23/3V
+			const double mu0_three_cell_volume = -4.0e23*M_PI/(3.0*cells::volume_array[i]);
+
+			double hx = cells::x_field_array[i] - mu0_three_cell_volume*cells::x_mag_array[i];
+			double hy = cells::y_field_array[i] - mu0_three_cell_volume*cells::y_mag_array[i];
+			double hz = cells::z_field_array[i] - mu0_three_cell_volume*cells::z_mag_array[i];
+
+			for(int n=near_cell_start[lc];n<near_cell_start[lc+1];n++){
+
+				const int j = near_cell_array[n];
+				if(j==i) continue;
+
+				double rij_matrix[6];
+				cell_tensor(i,j,rij_matrix);
+
+				const double mx = cells::x_mag_array[j];
+				const double my = cells::y_mag_array[j];
+				const double mz = cells::z_mag_array[j];
+
+				hx-=(mx*rij_matrix[0] + my*rij_matrix[1] + mz*rij_matrix[2]);
+				hy-=(mx*rij_matrix[1] + my*rij_matrix[3] + mz*rij_matrix[4]);
+				hz-=(mx*rij_matrix[2] + my*rij_matrix[4] + mz*rij_matrix[5]);
+
+			}
+
+			//-----------------------------------------------------------------------
+			// Add field from atoms in same and near cells to local atoms in cell
+			//-----------------------------------------------------------------------
+			for(int a=cell_atom_start[i];a<cell_atom_start[i+1];a++){
+
+				const int atom = cell_atom_array[a];
+				if(atom>=num_local_atoms) continue;
+
+				const double x = nf_x_coord_array[atom];
+				const double y = nf_y_coord_array[atom];
+				const double z = nf_z_coord_array[atom];
+
+				double bx=0.0;
+				double by=0.0;
+				double bz=0.0;
+
+				for(int n=near_cell_start[lc];n<near_cell_start[lc+1];n++){
+
+					const int j = near_cell_array[n];
+
+					for(int b=cell_atom_start[j];b<cell_atom_start[j+1];b++){
+
+						const int natom = cell_atom_array[b];
+						if(natom==atom) continue;
+
+						const double mu = nf_moment_array[natom];
+						const double mx = nf_x_spin_array[natom]*mu;
+						const double my = nf_y_spin_array[natom]*mu;
+						const double mz = nf_z_spin_array[natom]*mu;
+
+						const double dx = nf_x_coord_array[natom]-x;
+						const double dy = nf_y_coord_array[natom]-y;
+						const double dz = nf_z_coord_array[natom]-z;
+
+						const double drij = 1.0/sqrt(dx*dx+dy*dy+dz*dz);
+						const double drij3 = drij*drij*drij;
+
+						const double ex = dx*drij;
+						const double ey = dy*drij;
+						const double ez = dz*drij;
+
+						const double s_dot_e = (mx * ex + my * ey + mz * ez);
+
+						bx+=(3.0 * s_dot_e * ex - mx)*drij3;
+						by+=(3.0 * s_dot_e * ey - my)*drij3;
+						bz+=(3.0 * s_dot_e * ez - mz)*drij3;
+
+					}
+				}
+
+				atoms::x_dipolar_field_array[atom]=hx+bx*demag::prefactor;
+				atoms::y_dipolar_field_array[atom]=hy+by*demag::prefactor;
+				atoms::z_dipolar_field_array[atom]=hz+bz*demag::prefactor;
+
+			}
+		}
+
+		return;
+
+	}
+
+} // end of namespace demag
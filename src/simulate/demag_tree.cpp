@@ -0,0 +1,387 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+//
+//    Tree code demagnetisation field calculation. With
+//    sim:enable-tree-dipole-fields, occupied macrocells are sorted into an
+//    octree once during initialisation. At each update the total moment of
+//    each tree node and its first and second moments about the node centre
+//    are summed up the tree, and the field at each local cell is calculated
+//    by walking the tree from the root. Nodes which appear smaller than the
+//    opening angle (sim:dipole-tree-opening-angle) are replaced by a dipole
+//    expansion including first and second order corrections for the
+//    distribution of moments in the node, otherwise the node is opened, and
+//    leaf cells are summed directly. The cost is O(N log N) time and O(N)
+//    memory, and an opening angle of zero reproduces the direct sum.
+//
+//    All processors hold the moments of all cells after cells::mag(), and so
+//    each processor builds the same tree and calculates the fields of its
+//    local cells only, without further communication.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Vampire headers
+#include "cells.hpp"
+#include "demag.hpp"
+#include "errors.hpp"
+#include "vio.hpp"
+#include "vmpi.hpp"
+
+namespace demag{
+
+	bool tree=false;              /// flag to enable tree code demag calculation
+	double tree_opening_angle=0.3; /// ratio of node radius to distance below which nodes are expanded
+
+	namespace internal{
+
+		const int max_cells_per_leaf=32; /// maximum number of cells in a leaf node
+		const int max_tree_depth=32;    /// maximum depth of tree to stop subdivision of coincident cells
+
+		// Define data type for tree node
+		struct node_t{
+			int start;          /// range of cells in node in tree order [start,end)
+			int end;
+			int first_child;    /// children are stored contiguously (-1 for leaf)
+			int num_children;
+			double c[3];        /// geometric centre of cells in node (Angstroms)
+			double radius;      /// largest distance of cell in node from centre (Angstroms)
+			double m[3];        /// total moment of node
+			double q[3][3];     /// first moment of node q[a][b] = sum m_a (r-c)_b
+			double o[3][3][3];  /// second moment of node o[a][b][c] = sum m_a (r-c)_b (r-c)_c
+		};
+
+		std::vector<node_t> tree_nodes;    /// octree of occupied cells, children stored after parents
+		std::vector<int> tree_cell_array;  /// cell ids in tree order
+
+		//-----------------------------------------------------------------------
+		// Function to subdivide node into octants of its bounding box
+		//-----------------------------------------------------------------------
+		void subdivide(const int node, const int depth){
+
+			const int start=tree_nodes[node].start;
+			const int end=tree_nodes[node].end;
+
+			// determine centre and radius of node
+			double c[3]={0.0,0.0,0.0};
+			double min[3]={ 1.0e300, 1.0e300, 1.0e300};
+			double max[3]={-1.0e300,-1.0e300,-1.0e300};
+			for(int idx=start;idx<end;idx++){
+				const int cell=tree_cell_array[idx];
+				const double r[3]={cells::x_coord_array[cell],cells::y_coord_array[cell],cells::z_coord_array[cell]};
+				for(int i=0;i<3;i++){
+					c[i]+=r[i];
+					min[i]=std::min(min[i],r[i]);
+					max[i]=std::max(max[i],r[i]);
+				}
+			}
+			for(int i=0;i<3;i++) c[i]/=double(end-start);
+
+			double radius=0.0;
+			for(int idx=start;idx<end;idx++){
+				const int cell=tree_cell_array[idx];
+				const double dx=cells::x_coord_array[cell]-c[0];
+				const double dy=cells::y_coord_array[cell]-c[1];
+				const double dz=cells::z_coord_array[cell]-c[2];
+				radius=std::max(radius,sqrt(dx*dx+dy*dy+dz*dz));
+			}
+
+			for(int i=0;i<3;i++) tree_nodes[node].c[i]=c[i];
+			tree_nodes[node].radius=radius;
+
+			if(end-start<=max_cells_per_leaf || depth>=max_tree_depth || radius==0.0) return;
+
+			// sort cells into octants about centre of bounding box
+			const double split[3]={0.5*(min[0]+max[0]),0.5*(min[1]+max[1]),0.5*(min[2]+max[2])};
+			std::vector<int> octant(end-start);
+			int count[8]={0,0,0,0,0,0,0,0};
+			for(int idx=start;idx<end;idx++){
+				const int cell=tree_cell_array[idx];
+				const int o=(cells::x_coord_array[cell]>split[0] ? 4 : 0) +
+								(cells::y_coord_array[cell]>split[1] ? 2 : 0) +
+								(cells::z_coord_array[cell]>split[2] ? 1 : 0);
+				octant[idx-start]=o;
+				count[o]++;
+			}
+
+			int offset[8];
+			offset[0]=start;
+			for(int o=1;o<8;o++) offset[o]=offset[o-1]+count[o-1];
+
+			std::vector<int> sorted(end-start);
+			int next[8];
+			std::copy(offset,offset+8,next);
+			for(int idx=start;idx<end;idx++) sorted[next[octant[idx-start]]++ - start]=tree_cell_array[idx];
+			std::copy(sorted.begin(),sorted.end(),tree_cell_array.begin()+start);
+
+			// add non-empty octants as children
+			const int first_child=tree_nodes.size();
+			int num_children=0;
+			for(int o=0;o<8;o++){
+				if(count[o]==0) continue;
+				node_t child;
+				child.start=offset[o];
+				child.end=offset[o]+count[o];
+				child.first_child=-1;
+				child.num_children=0;
+				tree_nodes.push_back(child);
+				num_children++;
+			}
+			tree_nodes[node].first_child=first_child;
+			tree_nodes[node].num_children=num_children;
+
+			for(int child=first_child;child<first_child+num_children;child++) subdivide(child,depth+1);
+
+			return;
+
+		}
+
+	} // end of namespace internal
+
+	//-----------------------------------------------------------------------------
+	// Function to build octree of occupied macrocells
+	//-----------------------------------------------------------------------------
+	void tree_init(){
+
+		using internal::tree_nodes;
+		using internal::tree_cell_array;
+
+		tree_nodes.resize(0);
+		tree_cell_array.resize(0);
+
+		// only cells containing atoms on any processor have a volume
+		for(int cell=0;cell<cells::num_cells;cell++){
+			if(cells::volume_array[cell]>0.0) tree_cell_array.push_back(cell);
+		}
+
+		if(tree_cell_array.size()>0){
+			internal::node_t root;
+			root.start=0;
+			root.end=tree_cell_array.size();
+			root.first_child=-1;
+			root.num_children=0;
+			tree_nodes.push_back(root);
+			internal::subdivide(0,0);
+		}
+
+		zlog << zTs() << "Tree demagnetisation field calculation has been enabled with " << tree_cell_array.size() << " occupied cells in "
+			  << tree_nodes.size() << " nodes and opening angle " << demag::tree_opening_angle << std::endl;
+		zlog << zTs() << "Tree demagnetisation field calculation requires "
+			  << (double(tree_nodes.size())*sizeof(internal::node_t)+double(tree_cell_array.size())*sizeof(int))/1.0e6 << " MB of RAM" << std::endl;
+
+		return;
+
+	}
+
+	//-----------------------------------------------------------------------------
+	// Function to recalculate demag fields using tree code
+	//-----------------------------------------------------------------------------
+	void tree_update(){
+
+		// check for calling of routine
+		if(err::check==true){
+			terminaltextcolor(RED);
+			std::cerr << "demag::tree_update has been called " << vmpi::my_rank << std::endl;
+			terminaltextcolor(WHITE);
+		}
+
+		using internal::node_t;
+		using internal::tree_nodes;
+		using internal::tree_cell_array;
+
+		const int num_nodes=tree_nodes.size();
+
+		// sum moments up tree, children are always stored after their parents
+		for(int n=num_nodes-1;n>=0;n--){
+			node_t& node=tree_nodes[n];
+			for(int a=0;a<3;a++){
+				node.m[a]=0.0;
+				for(int b=0;b<3;b++){
+					node.q[a][b]=0.0;
+					for(int c=0;c<3;c++) node.o[a][b][c]=0.0;
+				}
+			}
+			if(node.num_children==0){
+				for(int idx=node.start;idx<node.end;idx++){
+					const int cell=tree_cell_array[idx];
+					const double m[3]={cells::x_mag_array[cell],cells::y_mag_array[cell],cells::z_mag_array[cell]};
+					const double d[3]={cells::x_coord_array[cell]-node.c[0],cells::y_coord_array[cell]-node.c[1],cells::z_coord_array[cell]-node.c[2]};
+					for(int a=0;a<3;a++){
+						node.m[a]+=m[a];
+						for(int b=0;b<3;b++){
+							node.q[a][b]+=m[a]*d[b];
+							for(int c=0;c<3;c++) node.o[a][b][c]+=m[a]*d[b]*d[c];
+						}
+					}
+				}
+			}
+			else{
+				// shift moments of children to centre of node
+				for(int n=node.first_child;n<node.first_child+node.num_children;n++){
+					const node_t& child=tree_nodes[n];
+					const double d[3]={child.c[0]-node.c[0],child.c[1]-node.c[1],child.c[2]-node.c[2]};
+					for(int a=0;a<3;a++){
+						node.m[a]+=child.m[a];
+						for(int b=0;b<3;b++){
+							node.q[a][b]+=child.q[a][b]+child.m[a]*d[b];
+							for(int c=0;c<3;c++) node.o[a][b][c]+=child.o[a][b][c]+child.q[a][b]*d[c]+child.q[a][c]*d[b]+child.m[a]*d[b]*d[c];
+						}
+					}
+				}
+			}
+		}
+
+		const double theta_sq=demag::tree_opening_angle*demag::tree_opening_angle;
+
+		#pragma omp parallel
+		{
+
+		// stack of nodes to visit
+		std::vector<int> stack;
+		stack.reserve(8*internal::max_tree_depth);
+
+		// loop over local cells
+		#pragma omp for schedule(dynamic,16)
+		for(int lc=0;lc<cells::num_local_cells;lc++){
+
+			const int i = cells::local_cell_array[lc];
+
+			// V in A^3 == 1e-30 m3, mu_0 = 4pie-7 -> prefactor = pi*4/3V
+			const double mu0_three_cell_volume = -4.0*M_PI/(3.0*cells::volume_array[i]);
+
+			double h[3]={mu0_three_cell_volume*cells::x_mag_array[i],
+							 mu0_three_cell_volume*cells::y_mag_array[i],
+							 mu0_three_cell_volume*cells::z_mag_array[i]};
+
+			const double r[3]={cells::x_coord_array[i],cells::y_coord_array[i],cells::z_coord_array[i]};
+
+			// walk tree from root
+			if(num_nodes>0) stack.push_back(0);
+
+			while(!stack.empty()){
+
+				const node_t& node=tree_nodes[stack.back()];
+				stack.pop_back();
+
+				const double R[3]={r[0]-node.c[0],r[1]-node.c[1],r[2]-node.c[2]};
+				const double R_sq=R[0]*R[0]+R[1]*R[1]+R[2]*R[2];
+
+				// node is far enough away to be expanded, which excludes nodes containing cell i
+				if(node.radius*node.radius < theta_sq*R_sq){
+
+					const double inv_R=1.0/sqrt(R_sq);
+					const double inv_R2=inv_R*inv_R;
+					const double inv_R3=inv_R*inv_R2;
+					const double inv_R5=inv_R3*inv_R2;
+					const double inv_R7=inv_R5*inv_R2;
+					const double inv_R9=inv_R7*inv_R2;
+
+					// The field of moment m at separation R is T(R).m, where
+					// T_ab = d_a d_b (1/R). Expanding about the node centre gives
+					// h_a = T_ab m_b - D_abc q_bc + 1/2 D_abcd o_bcd, where D are
+					// higher derivatives of 1/R.
+
+					// contractions of first and second moments with R
+					double qR[3]={0.0,0.0,0.0};  // q_ab R_b
+					double Rq[3]={0.0,0.0,0.0};  // R_b q_ba
+					double oRR[3]={0.0,0.0,0.0}; // o_abc R_b R_c
+					double RoR[3]={0.0,0.0,0.0}; // R_b o_bac R_c
+					double tr_o[3]={0.0,0.0,0.0}; // o_abb
+					double otr[3]={0.0,0.0,0.0};  // o_bba
+					double trace_q=0.0;
+					double RoR_tr=0.0; // R_a o_abb
+					double otr_R=0.0;  // o_bba R_a
+					for(int a=0;a<3;a++){
+						trace_q+=node.q[a][a];
+						for(int b=0;b<3;b++){
+							qR[a]+=node.q[a][b]*R[b];
+							Rq[a]+=R[b]*node.q[b][a];
+							tr_o[a]+=node.o[a][b][b];
+							otr[a]+=node.o[b][b][a];
+							for(int c=0;c<3;c++){
+								oRR[a]+=node.o[a][b][c]*R[b]*R[c];
+								RoR[a]+=R[b]*node.o[b][a][c]*R[c];
+							}
+						}
+					}
+					double R_dot_m=0.0;
+					double RqR=0.0;
+					double RoRR=0.0;
+					for(int a=0;a<3;a++){
+						R_dot_m+=R[a]*node.m[a];
+						RqR+=R[a]*qR[a];
+						RoRR+=R[a]*oRR[a];
+						RoR_tr+=R[a]*tr_o[a];
+						otr_R+=otr[a]*R[a];
+					}
+
+					for(int a=0;a<3;a++){
+						// dipole term
+						h[a]+=3.0*R_dot_m*R[a]*inv_R5 - node.m[a]*inv_R3;
+						// first order term
+						h[a]+=15.0*R[a]*RqR*inv_R7 - 3.0*(Rq[a] + R[a]*trace_q + qR[a])*inv_R5;
+						// second order term
+						h[a]+=0.5*(105.0*R[a]*RoRR*inv_R9
+									- 15.0*(oRR[a] + 2.0*RoR[a] + 2.0*R[a]*otr_R + R[a]*RoR_tr)*inv_R7
+									+ 3.0*(tr_o[a] + 2.0*otr[a])*inv_R5);
+					}
+
+				}
+				else if(node.num_children>0){
+					for(int c=node.first_child;c<node.first_child+node.num_children;c++) stack.push_back(c);
+				}
+				else{
+					// direct sum over cells in leaf
+					for(int idx=node.start;idx<node.end;idx++){
+
+						const int j=tree_cell_array[idx];
+						if(j==i) continue;
+
+						const double mx = cells::x_mag_array[j];
+						const double my = cells::y_mag_array[j];
+						const double mz = cells::z_mag_array[j];
+
+						const double dx = cells::x_coord_array[j]-r[0];
+						const double dy = cells::y_coord_array[j]-r[1];
+						const double dz = cells::z_coord_array[j]-r[2];
+
+						const double drij = 1.0/sqrt(dx*dx+dy*dy+dz*dz);
+						const double drij3 = drij*drij*drij;
+
+						const double ex = dx*drij;
+						const double ey = dy*drij;
+						const double ez = dz*drij;
+
+						const double s_dot_e = (mx * ex + my * ey + mz * ez);
+
+						h[0]+=(3.0 * s_dot_e * ex - mx)*drij3;
+						h[1]+=(3.0 * s_dot_e * ey - my)*drij3;
+						h[2]+=(3.0 * s_dot_e * ez - mz)*drij3;
+
+					}
+				}
+			}
+
+			cells::x_field_array[i]=h[0]*demag::prefactor;
+			cells::y_field_array[i]=h[1]*demag::prefactor;
+			cells::z_field_array[i]=h[2]*demag::prefactor;
+
+		}
+
+		} // end of omp parallel region
+
+		return;
+
+	}
+
+} // end of namespace demag
@@ -88,6 +88,9 @@ namespace sim{
 ///
 double spin_exchange_energy_isotropic(const int atom, const double Sx, const double Sy, const double Sz){
 	
+	// Use stencil grid if explicit neighbour list is not available
+	if(atoms::stencil_exchange) return sim::stencil_exchange_energy(atom, Sx, Sy, Sz);
+
 	// energy
 	double energy=0.0;
 	
@@ -457,9 +460,6 @@ double calculate_spin_energy(const int atom, const int AtomExchangeType){
 	const double Sy=atoms::y_spin_array[atom];
 	const double Sz=atoms::z_spin_array[atom];
 	
-	// Determine neighbour material
-	const int imaterial=atoms::type_array[atom];
-	
 	// Initialise energy to zero
 	double energy=0.0;
 	
@@ -470,6 +470,30 @@ double calculate_spin_energy(const int atom, const int AtomExchangeType){
 		case 2: energy+=spin_exchange_energy_tensor(atom, Sx, Sy, Sz); break;
 		default: zlog << zTs() << "Error. atoms::exchange_type has value " << AtomExchangeType << " which is outside of valid range 0-2. Exiting." << std::endl; err::vexit();
 	}
+	energy+=calculate_spin_onsite_energy(atom, Sx, Sy, Sz);
+	
+	return energy; // Tesla
+}
+
+/// @brief Calculates the energy for a single spin excluding exchange.
+///
+/// @details Sums the anisotropy, applied field and magnetostatic energies,
+///          which depend only on the spin itself for fixed fields.
+///
+/// @param[in] atom atom number 
+/// @param[in] Sx x-spin of local atom  
+/// @param[in] Sy y-spin of local atom 
+/// @param[in] Sz z-spin of local atom 
+/// @return on-site spin energy
+///
+double calculate_spin_onsite_energy(const int atom, const double Sx, const double Sy, const double Sz){
+
+	// Determine neighbour material
+	const int imaterial=atoms::type_array[atom];
+
+	// Initialise energy to zero
+	double energy=0.0;
+
 	switch(sim::AnisotropyType){
 		case 0: energy+=spin_scalar_anisotropy_energy(imaterial, Sz); break;
 		case 1: energy+=spin_tensor_anisotropy_energy(imaterial, Sx, Sy, Sz); break;
@@ -483,7 +507,7 @@ double calculate_spin_energy(const int atom, const int AtomExchangeType){
 	if(sim::surface_anisotropy==true) energy+=spin_surface_anisotropy_energy(atom, imaterial, Sx, Sy, Sz);
 	energy+=spin_applied_field_energy(Sx, Sy, Sz);
 	energy+=spin_magnetostatic_energy(atom, Sx, Sy, Sz);
-	
+
 	return energy; // Tesla
 }
 
@@ -0,0 +1,352 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Vampire headers
+#include "atoms.hpp"
+#include "errors.hpp"
+#include "sim.hpp"
+#include "vio.hpp"
+#include "vmpi.hpp"
+#include "vomp.hpp"
+
+namespace sim{
+
+   // Number of atoms per vector block (covers 512-bit vectors in single precision)
+   const int ell_block_size = 16;
+
+   //-----------------------------------------------------------------------------
+   // Function to build padded neighbour list and packed spin array for the
+   // isotropic exchange interaction. The second indirection through the
+   // interaction type is removed by storing Jij directly for each slot.
+   //-----------------------------------------------------------------------------
+   void initialise_packed_exchange(){
+
+      // check calling of routine if error checking is activated
+      if(err::check==true) std::cout << "sim::initialise_packed_exchange has been called" << std::endl;
+
+      // Packed exchange is only implemented for isotropic exchange
+      if(atoms::exchange_type!=0){
+         zlog << zTs() << "Warning: Packed exchange layout is only available for isotropic exchange and has been disabled." << std::endl;
+         atoms::packed_exchange=false;
+         return;
+      }
+
+      const int num_atoms = atoms::num_atoms;
+
+      // determine maximum number of neighbours
+      int width=0;
+      for(int atom=0;atom<num_atoms;atom++){
+         const int nn = atoms::neighbour_list_end_index[atom]-atoms::neighbour_list_start_index[atom]+1;
+         if(nn > width) width = nn;
+      }
+
+      const int stride = ((num_atoms+ell_block_size-1)/ell_block_size)*ell_block_size;
+
+      atoms::ell_width = width;
+      atoms::ell_stride = stride;
+
+      zlog << zTs() << "Packed exchange layout on rank " << vmpi::my_rank << " with " << width << " neighbour slots requires "
+           << (double(width)*double(stride)*double(sizeof(int)+sizeof(atoms::packed_real_t)) + 4.0*double(stride)*double(sizeof(atoms::packed_real_t)))/1.0e6
+           << " MB RAM" << std::endl;
+
+      // padded slots point to the atom itself with zero exchange
+      atoms::ell_neighbour_array.resize(size_t(width)*size_t(stride));
+      atoms::ell_exchange_array.resize(size_t(width)*size_t(stride));
+
+      for(int atom=0;atom<stride;atom++){
+         const int self = atom < num_atoms ? atom : 0;
+         int slot=0;
+         if(atom < num_atoms){
+            for(int nn=atoms::neighbour_list_start_index[atom];nn<=atoms::neighbour_list_end_index[atom];nn++){
+               const int index = slot*stride+atom;
+               atoms::ell_neighbour_array[index] = atoms::neighbour_list_array[nn];
+               atoms::ell_exchange_array[index] = atoms::packed_real_t(atoms::i_exchange_list[atoms::neighbour_interaction_type_array[nn]].Jij);
+               slot++;
+            }
+         }
+         for(;slot<width;slot++){
+            const int index = slot*stride+atom;
+            atoms::ell_neighbour_array[index] = self;
+            atoms::ell_exchange_array[index] = 0.0;
+         }
+      }
+
+      // allocate aligned spin array
+      if(atoms::packed_spin_array!=NULL) free(atoms::packed_spin_array);
+      void* ptr=NULL;
+      if(posix_memalign(&ptr, 64, 4*size_t(stride)*sizeof(atoms::packed_real_t))!=0){
+         terminaltextcolor(RED);
+         std::cerr << "Error allocating packed spin array for exchange calculation" << std::endl;
+         terminaltextcolor(WHITE);
+         zlog << zTs() << "Error allocating packed spin array for exchange calculation" << std::endl;
+         err::vexit();
+      }
+      atoms::packed_spin_array = static_cast<atoms::packed_real_t*>(ptr);
+      for(int i=0;i<4*stride;i++) atoms::packed_spin_array[i]=0.0;
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to release packed exchange arrays
+   //-----------------------------------------------------------------------------
+   void finalise_packed_exchange(){
+
+      if(atoms::packed_spin_array!=NULL) free(atoms::packed_spin_array);
+      atoms::packed_spin_array=NULL;
+      atoms::packed_spins_current=false;
+
+      std::vector<int>().swap(atoms::ell_neighbour_array);
+      std::vector<atoms::packed_real_t>().swap(atoms::ell_exchange_array);
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to copy spins of a range of atoms into packed array
+   //-----------------------------------------------------------------------------
+   void pack_spins(const int start_index, const int end_index){
+
+      atoms::packed_real_t* const s = atoms::packed_spin_array;
+
+      #pragma omp parallel for schedule(static) if(end_index-start_index > vomp::min_atoms_per_team)
+      for(int atom=start_index;atom<end_index;atom++){
+         s[4*atom+0] = atoms::packed_real_t(atoms::x_spin_array[atom]);
+         s[4*atom+1] = atoms::packed_real_t(atoms::y_spin_array[atom]);
+         s[4*atom+2] = atoms::packed_real_t(atoms::z_spin_array[atom]);
+      }
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to update packed spins needed to calculate exchange fields of a
+   // range of atoms. Local atoms are packed once for each field evaluation,
+   // from the call starting at the first atom, unless the integrator has
+   // already written the packed spins. In parallel, halo atoms are only
+   // needed (and received) for boundary atoms, and so are packed by calls
+   // which include boundary atoms.
+   //-----------------------------------------------------------------------------
+   void update_packed_spins(const int start_index, const int end_index){
+
+      #ifdef MPICF
+         const int num_core_atoms = vmpi::num_core_atoms;
+         const int num_local_atoms = vmpi::num_core_atoms+vmpi::num_bdry_atoms;
+      #else
+         const int num_core_atoms = atoms::num_atoms;
+         const int num_local_atoms = atoms::num_atoms;
+      #endif
+
+      if(start_index==0){
+         if(atoms::packed_spins_current==false) pack_spins(0,num_local_atoms);
+         atoms::packed_spins_current=false;
+      }
+
+      if(end_index>num_core_atoms) pack_spins(num_local_atoms,atoms::num_atoms);
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to calculate isotropic exchange fields from packed layout. The
+   // loop over atoms is vectorised, with each lane gathering its neighbours.
+   //-----------------------------------------------------------------------------
+   void calculate_packed_exchange_fields(const int start_index, const int end_index){
+
+      const int width = atoms::ell_width;
+      const int stride = atoms::ell_stride;
+
+      const int* const nlist = &atoms::ell_neighbour_array[0];
+      const atoms::packed_real_t* const jlist = &atoms::ell_exchange_array[0];
+      const atoms::packed_real_t* const s = atoms::packed_spin_array;
+
+      double* const hx = &atoms::x_total_spin_field_array[0];
+      double* const hy = &atoms::y_total_spin_field_array[0];
+      double* const hz = &atoms::z_total_spin_field_array[0];
+
+      #pragma omp simd
+      for(int atom=start_index;atom<end_index;atom++){
+         double Hx=0.0;
+         double Hy=0.0;
+         double Hz=0.0;
+         for(int slot=0;slot<width;slot++){
+            const int index = slot*stride+atom;
+            const int natom = 4*nlist[index];
+            const double Jij = jlist[index];
+            Hx -= Jij*s[natom+0];
+            Hy -= Jij*s[natom+1];
+            Hz -= Jij*s[natom+2];
+         }
+         hx[atom] += Hx;
+         hy[atom] += Hy;
+         hz[atom] += Hz;
+      }
+
+      return;
+
+   }
+
+   namespace internal{
+
+      // Work arrays for stencil exchange, in site order
+      std::vector<double> stencil_spin_array; /// spins of all sites [x, y, z blocks]
+      std::vector<double> stencil_field_array; /// exchange fields of all sites [x, y, z blocks]
+
+   } // end of namespace internal
+
+   //-----------------------------------------------------------------------------
+   // Function to allocate work arrays for stencil exchange
+   //-----------------------------------------------------------------------------
+   void initialise_stencil_exchange(){
+
+      // check calling of routine if error checking is activated
+      if(err::check==true) std::cout << "sim::initialise_stencil_exchange has been called" << std::endl;
+
+      const size_t num_sites = size_t(atoms::stencil_num_sublattices)*size_t(atoms::stencil_grid_size);
+
+      internal::stencil_spin_array.assign(3*num_sites,0.0);
+      internal::stencil_field_array.assign(3*num_sites,0.0);
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to calculate isotropic exchange fields on all sites of stencil
+   // grid. Spins are first copied onto the grid, with vacancies having zero
+   // spin, and then each interaction of the unit cell template is applied to
+   // whole rows of the grid along x.
+   //-----------------------------------------------------------------------------
+   void update_stencil_exchange_fields(){
+
+      const int num_sublattices = atoms::stencil_num_sublattices;
+      const int grid_size = atoms::stencil_grid_size;
+      const int num_sites = num_sublattices*grid_size;
+      const int pad = atoms::stencil_padding;
+      const int gx = atoms::stencil_dimensions[0];
+      const int gy = atoms::stencil_dimensions[1];
+      const int gz = atoms::stencil_dimensions[2];
+
+      // number of atoms in each row and number of rows of grid excluding padding
+      const int nx = gx-2*pad;
+      const int num_rows = (gy-2*pad)*(gz-2*pad);
+
+      const int* const site_atom = &atoms::stencil_atom_array[0];
+      double* const sx = &internal::stencil_spin_array[0];
+      double* const sy = sx + num_sites;
+      double* const sz = sy + num_sites;
+
+      // copy spins onto grid
+      #pragma omp parallel for schedule(static) if(num_sites > vomp::min_atoms_per_team)
+      for(int site=0;site<num_sites;site++){
+         const int atom = site_atom[site];
+         if(atom>=0){
+            sx[site] = atoms::x_spin_array[atom];
+            sy[site] = atoms::y_spin_array[atom];
+            sz[site] = atoms::z_spin_array[atom];
+         }
+         else{
+            sx[site] = 0.0;
+            sy[site] = 0.0;
+            sz[site] = 0.0;
+         }
+      }
+
+      double* const hx = &internal::stencil_field_array[0];
+      double* const hy = hx + num_sites;
+      double* const hz = hy + num_sites;
+
+      // apply interaction template to each row of each sublattice
+      #pragma omp parallel for schedule(static) if(num_sublattices*num_rows*nx > vomp::min_atoms_per_team)
+      for(int index=0;index<num_sublattices*num_rows;index++){
+
+         const int sublattice = index/num_rows;
+         const int row = index%num_rows;
+         const int y = row%(gy-2*pad)+pad;
+         const int z = row/(gy-2*pad)+pad;
+         const int start = sublattice*grid_size + (z*gy+y)*gx + pad;
+
+         for(int x=0;x<nx;x++){
+            hx[start+x]=0.0;
+            hy[start+x]=0.0;
+            hz[start+x]=0.0;
+         }
+
+         for(int i=atoms::stencil_interaction_start_index[sublattice];i<atoms::stencil_interaction_start_index[sublattice+1];i++){
+            const double Jij = atoms::stencil_interaction_Jij_array[i];
+            const int nstart = atoms::stencil_interaction_sublattice_array[i]*grid_size + (z*gy+y)*gx + pad + atoms::stencil_interaction_offset_array[i];
+            #pragma omp simd
+            for(int x=0;x<nx;x++){
+               hx[start+x] -= Jij*sx[nstart+x];
+               hy[start+x] -= Jij*sy[nstart+x];
+               hz[start+x] -= Jij*sz[nstart+x];
+            }
+         }
+
+      }
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to add stencil exchange fields to atoms
+   //-----------------------------------------------------------------------------
+   void calculate_stencil_exchange_fields(const int start_index, const int end_index){
+
+      const int num_sites = atoms::stencil_num_sublattices*atoms::stencil_grid_size;
+      const int* const site = &atoms::stencil_site_array[0];
+      const double* const hx = &internal::stencil_field_array[0];
+      const double* const hy = hx + num_sites;
+      const double* const hz = hy + num_sites;
+
+      for(int atom=start_index;atom<end_index;atom++){
+         atoms::x_total_spin_field_array[atom] += hx[site[atom]];
+         atoms::y_total_spin_field_array[atom] += hy[site[atom]];
+         atoms::z_total_spin_field_array[atom] += hz[site[atom]];
+      }
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to calculate isotropic exchange energy of a single spin using
+   // current spins of neighbouring atoms found from stencil grid
+   //-----------------------------------------------------------------------------
+   double stencil_exchange_energy(const int atom, const double Sx, const double Sy, const double Sz){
+
+      const int grid_size = atoms::stencil_grid_size;
+      const int site = atoms::stencil_site_array[atom];
+      const int sublattice = site/grid_size;
+      const int cell = site%grid_size;
+
+      double energy=0.0;
+
+      for(int i=atoms::stencil_interaction_start_index[sublattice];i<atoms::stencil_interaction_start_index[sublattice+1];i++){
+         const int natom = atoms::stencil_atom_array[atoms::stencil_interaction_sublattice_array[i]*grid_size + cell + atoms::stencil_interaction_offset_array[i]];
+         if(natom<0) continue;
+         const double Jij = atoms::stencil_interaction_Jij_array[i];
+         energy+=Jij*(atoms::x_spin_array[natom]*Sx + atoms::y_spin_array[natom]*Sy + atoms::z_spin_array[natom]*Sz);
+      }
+
+      return energy;
+
+   }
+
+} // end of namespace sim
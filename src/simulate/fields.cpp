@@ -40,6 +40,7 @@
 #include "sim.hpp"
 #include "stats.hpp"
 #include "vmpi.hpp"
+#include "vomp.hpp"
 
 #include <algorithm>
 #include <cmath>
@@ -74,26 +75,40 @@ int calculate_spin_fields(const int start_index,const int end_index){
 	// check calling of routine if error checking is activated
 	if(err::check==true){std::cout << "calculate_spin_fields has been called" << std::endl;}
 	
-	// Initialise Total Spin Fields to zero
-	fill (atoms::x_total_spin_field_array.begin()+start_index,atoms::x_total_spin_field_array.begin()+end_index,0.0);
-	fill (atoms::y_total_spin_field_array.begin()+start_index,atoms::y_total_spin_field_array.begin()+end_index,0.0);
-	fill (atoms::z_total_spin_field_array.begin()+start_index,atoms::z_total_spin_field_array.begin()+end_index,0.0);
-
-	// Exchange Fields
-	if(sim::hamiltonian_simulation_flags[0]==1) calculate_exchange_fields(start_index,end_index);
+	// Update packed spin layout for exchange calculation
+	if(atoms::packed_exchange && sim::hamiltonian_simulation_flags[0]==1) sim::update_packed_spins(start_index,end_index);
+
+	// Update exchange fields on stencil grid
+	if(atoms::stencil_exchange && sim::hamiltonian_simulation_flags[0]==1) sim::update_stencil_exchange_fields();
+
+	// Spin fields are purely local to each atom, and so the range is split
+	// into contiguous blocks, one per thread, for large enough systems
+	#pragma omp parallel if(end_index-start_index > vomp::min_atoms_per_team)
+	{
+		int tstart, tend;
+		vomp::thread_range(start_index, end_index, tstart, tend);
+
+		// Initialise Total Spin Fields to zero
+		fill (atoms::x_total_spin_field_array.begin()+tstart,atoms::x_total_spin_field_array.begin()+tend,0.0);
+		fill (atoms::y_total_spin_field_array.begin()+tstart,atoms::y_total_spin_field_array.begin()+tend,0.0);
+		fill (atoms::z_total_spin_field_array.begin()+tstart,atoms::z_total_spin_field_array.begin()+tend,0.0);
+
+		// Exchange Fields
+		if(sim::hamiltonian_simulation_flags[0]==1) calculate_exchange_fields(tstart,tend);
 	
-	// Anisotropy Fields
-	if(sim::UniaxialScalarAnisotropy || sim::TensorAnisotropy) calculate_anisotropy_fields(start_index,end_index);
-   if(sim::second_order_uniaxial_anisotropy) calculate_second_order_uniaxial_anisotropy_fields(start_index,end_index);
-   if(sim::sixth_order_uniaxial_anisotropy) calculate_sixth_order_uniaxial_anisotropy_fields(start_index,end_index);
-   if(sim::spherical_harmonics) calculate_spherical_harmonic_fields(start_index,end_index);
-   if(sim::lattice_anisotropy_flag) calculate_lattice_anisotropy_fields(start_index,end_index);
-   if(sim::CubicScalarAnisotropy) calculate_cubic_anisotropy_fields(start_index,end_index);
-	//if(sim::hamiltonian_simulation_flags[1]==3) calculate_local_anis_fields();
-	if(sim::surface_anisotropy==true) calculate_surface_anisotropy_fields(start_index,end_index);
-	// Spin Dependent Extra Fields
-	//if(sim::hamiltonian_simulation_flags[4]==1) calculate_??_fields();
-	if(sim::lagrange_multiplier==true) calculate_lagrange_fields(start_index,end_index);
+		// Anisotropy Fields
+		if(sim::UniaxialScalarAnisotropy || sim::TensorAnisotropy) calculate_anisotropy_fields(tstart,tend);
+	   if(sim::second_order_uniaxial_anisotropy) calculate_second_order_uniaxial_anisotropy_fields(tstart,tend);
+	   if(sim::sixth_order_uniaxial_anisotropy) calculate_sixth_order_uniaxial_anisotropy_fields(tstart,tend);
+	   if(sim::spherical_harmonics) calculate_spherical_harmonic_fields(tstart,tend);
+	   if(sim::lattice_anisotropy_flag) calculate_lattice_anisotropy_fields(tstart,tend);
+	   if(sim::CubicScalarAnisotropy) calculate_cubic_anisotropy_fields(tstart,tend);
+		//if(sim::hamiltonian_simulation_flags[1]==3) calculate_local_anis_fields();
+		if(sim::surface_anisotropy==true) calculate_surface_anisotropy_fields(tstart,tend);
+		// Spin Dependent Extra Fields
+		//if(sim::hamiltonian_simulation_flags[4]==1) calculate_??_fields();
+		if(sim::lagrange_multiplier==true) calculate_lagrange_fields(tstart,tend);
+	}
 
 	return 0;
 }
@@ -159,6 +174,14 @@ int calculate_exchange_fields(const int start_index,const int end_index){
 	// Use appropriate function for exchange calculation
 	switch(atoms::exchange_type){
 		case 0: // isotropic
+			if(atoms::stencil_exchange){
+				sim::calculate_stencil_exchange_fields(start_index,end_index);
+				break;
+			}
+			if(atoms::packed_exchange){
+				sim::calculate_packed_exchange_fields(start_index,end_index);
+				break;
+			}
 			for(int atom=start_index;atom<end_index;atom++){
 				register double Hx=0.0;
 				register double Hy=0.0;
@@ -595,38 +618,29 @@ int calculate_thermal_fields(const int start_index,const int end_index){
 	///======================================================
 	/// 		Subroutine to calculate thermal fields
 	///
-   ///      Version 1.2 R Evans 12/08/2014
+   ///      Version 1.3 R Evans 12/08/2014
+	///
+	///      Gaussian noise is generated from a counter-based
+	///      generator keyed by global atom id and thermal step
 	///======================================================
 
 	// check calling of routine if error checking is activated
 	if(err::check==true){std::cout << "calculate_thermal_fields has been called" << std::endl;}
 
-   // unroll sigma for speed
-   std::vector<double> sigma_prefactor(0);
-   sigma_prefactor.reserve(mp::material.size());
-
-   // Calculate material temperature (with optional rescaling)
-   for(int mat=0;mat<mp::material.size();mat++){
-      double temperature = sim::temperature;
-      // Check for localised temperature
-      if(sim::local_temperature) temperature = mp::material[mat].temperature;
-      // Calculate temperature rescaling
-      double alpha = mp::material[mat].temperature_rescaling_alpha;
-      double Tc = mp::material[mat].temperature_rescaling_Tc;
-      // if T<Tc T/Tc = (T/Tc)^alpha else T = T
-      double rescaled_temperature = temperature < Tc ? Tc*pow(temperature/Tc,alpha) : temperature;
-      double sqrt_T=sqrt(rescaled_temperature);
-      sigma_prefactor.push_back(sqrt_T*mp::material[mat].H_th_sigma);
-   }
+   // update temperature dependent entries of compact material table
+   mp::update_material_hot_params_temperature();
 
- 	generate (atoms::x_total_external_field_array.begin()+start_index,atoms::x_total_external_field_array.begin()+end_index, mtrandom::gaussian);
-	generate (atoms::y_total_external_field_array.begin()+start_index,atoms::y_total_external_field_array.begin()+end_index, mtrandom::gaussian);
-	generate (atoms::z_total_external_field_array.begin()+start_index,atoms::z_total_external_field_array.begin()+end_index, mtrandom::gaussian);
+	mtrandom::counter_gaussian_batch(atoms::global_id_array, start_index, end_index,
+	                                 uint32_t(mtrandom::integration_seed), mtrandom::thermal_step,
+	                                 atoms::x_total_external_field_array,
+	                                 atoms::y_total_external_field_array,
+	                                 atoms::z_total_external_field_array);
 
+	#pragma omp parallel for schedule(static) if(end_index-start_index > vomp::min_atoms_per_team)
 	for(int atom=start_index;atom<end_index;atom++){
 
 		const int imaterial=atoms::type_array[atom];
-      const double H_th_sigma = sigma_prefactor[imaterial];
+      const double H_th_sigma = mp::material_hot_params[imaterial].thermal_sigma;
 
 		atoms::x_total_external_field_array[atom] *= H_th_sigma;
 		atoms::y_total_external_field_array[atom] *= H_th_sigma;
@@ -694,7 +708,7 @@ void calculate_hamr_fields(const int start_index,const int end_index){
 			const double cy = atoms::y_coord_array[atom];		
 			const double r2 = (cx-px)*(cx-px)+(cy-py)*(cy-py);
 			const double sqrt_T = sqrt(sim::Tmin+DeltaT*exp(-r2/fwhm2));
-			const double H_th_sigma = sqrt_T*mp::material[imaterial].H_th_sigma;
+			const double H_th_sigma = sqrt_T*mp::material_hot_params[imaterial].H_th_sigma;
 			atoms::x_total_external_field_array[atom] *= H_th_sigma; //*mtrandom::gaussian();
 			atoms::y_total_external_field_array[atom] *= H_th_sigma; //*mtrandom::gaussian();
 			atoms::z_total_external_field_array[atom] *= H_th_sigma; //*mtrandom::gaussian();
@@ -722,7 +736,7 @@ void calculate_hamr_fields(const int start_index,const int end_index){
 		double sqrt_T=sqrt(sim::temperature);
 		for(int atom=start_index;atom<end_index;atom++){
 			const int imaterial=atoms::type_array[atom];
-			const double H_th_sigma = sqrt_T*material_parameters::material[imaterial].H_th_sigma;
+			const double H_th_sigma = sqrt_T*mp::material_hot_params[imaterial].H_th_sigma;
 			atoms::x_total_external_field_array[atom] *= H_th_sigma; //*mtrandom::gaussian();
 			atoms::y_total_external_field_array[atom] *= H_th_sigma; //*mtrandom::gaussian();
 			atoms::z_total_external_field_array[atom] *= H_th_sigma; //*mtrandom::gaussian();
@@ -735,7 +749,7 @@ void calculate_fmr_fields(const int start_index,const int end_index){
 	if(err::check==true){std::cout << "calculate_fmr_fields has been called" << std::endl;}
 
 	// Declare fmr variables
-	const double real_time=sim::time*mp::dt_SI;
+	const double real_time=sim::physical_time;
 	const double osc_freq=20.0e9; // Hz
 	const double osc_period=1.0/osc_freq;
 	const double Hfmrx=1.0;
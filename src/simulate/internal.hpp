@@ -0,0 +1,46 @@
+#ifndef SIM_INTERNAL_H_
+#define SIM_INTERNAL_H_
+//-----------------------------------------------------------------------------
+//
+// This header file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <stdint.h>
+#include <vector>
+
+//---------------------------------------------------------------------
+// Defines shared internal data structures and functions for the
+// parallel Monte Carlo integrators. These functions should not be
+// accessed outside of the simulate module.
+//---------------------------------------------------------------------
+namespace sim{
+   namespace internal{
+
+      //-----------------------------------------------------------------------------
+      // Shared variables for graph coloured Monte Carlo sweeps
+      //-----------------------------------------------------------------------------
+      extern bool mc_colours_set;                   /// flag to indicate initialised colouring
+      extern int mc_num_colours;                    /// number of independent sets
+      extern std::vector<int> mc_colour_start;      /// start index of each colour in mc_colour_atoms
+      extern std::vector<int> mc_colour_bdry_start; /// start index of boundary atoms of each colour
+      extern std::vector<int> mc_colour_atoms;      /// list of local atoms sorted by colour
+
+      // Key words separating counter based random streams of the integrators
+      const uint32_t mc_stream = 0x5851F42D;
+      const uint32_t cmc_stream = 0x2545F491;
+
+      //-----------------------------------------------------------------------------
+      // Shared functions for graph coloured Monte Carlo sweeps
+      //-----------------------------------------------------------------------------
+      extern void mc_counter_randoms(const uint64_t id, const uint32_t stream, double g[3], double u[2]);
+      extern void mc_move_counter(const double old_spin[3], double new_spin[3], const double u, const double g[3], const double delta_angle);
+
+   } // end of internal namespace
+} // end of sim namespace
+
+#endif //SIM_INTERNAL_H_
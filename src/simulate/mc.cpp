@@ -103,16 +103,8 @@ int MonteCarlo(){
 	double DE=0.0;
 	const int AtomExchangeType=atoms::exchange_type;
 	
-   // Material dependent temperature rescaling
-   std::vector<double> rescaled_material_kBTBohr(mp::num_materials);
-   std::vector<double> sigma_array(mp::num_materials); // range for tuned gaussian random move
-   for(int m=0; m<mp::num_materials; ++m){
-      double alpha = mp::material[m].temperature_rescaling_alpha;
-      double Tc = mp::material[m].temperature_rescaling_Tc;
-      double rescaled_temperature = sim::temperature < Tc ? Tc*pow(sim::temperature/Tc,alpha) : sim::temperature;
-      rescaled_material_kBTBohr[m] = 9.27400915e-24/(rescaled_temperature*1.3806503e-23);
-      sigma_array[m] = rescaled_temperature < 1.0 ? 0.02 : pow(1.0/rescaled_material_kBTBohr[m],0.2)*0.08;
-   }
+   // Update material dependent temperature rescaling in compact material table
+   mp::update_material_hot_params_temperature();
 
    double statistics_moves = 0.0;
    double statistics_reject = 0.0;
@@ -130,7 +122,7 @@ int MonteCarlo(){
 		const int imaterial=atoms::type_array[atom];
 
       // Calculate range for move
-      sim::mc_delta_angle=sigma_array[imaterial];
+      sim::mc_delta_angle=mp::material_hot_params[imaterial].mc_sigma;
 
 		// Save old spin position
 		Sold[0] = atoms::x_spin_array[atom];
@@ -152,13 +144,13 @@ int MonteCarlo(){
 		Enew = sim::calculate_spin_energy(atom, AtomExchangeType);
 		
 		// Calculate difference in Joules/mu_B
-		DE = (Enew-Eold)*mp::material[imaterial].mu_s_SI*1.07828231e23; //1/9.27400915e-24
+		DE = (Enew-Eold)*mp::material_hot_params[imaterial].mu_s_SI*1.07828231e23; //1/9.27400915e-24
 		
 		// Check for lower energy state and accept unconditionally
 		if(DE<0) continue;
 		// Otherwise evaluate probability for move
 		else{
-			if(exp(-DE*rescaled_material_kBTBohr[imaterial]) >= mtrandom::grnd()) continue;
+			if(exp(-DE*mp::material_hot_params[imaterial].mc_kBTBohr) >= mtrandom::grnd()) continue;
 			// If rejected reset spin coordinates and continue
 			else{
 				atoms::x_spin_array[atom] = Sold[0];
@@ -0,0 +1,301 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+//
+//    Monte Carlo integrator with cached local exchange fields. The exchange
+//    field of each atom from its neighbours is stored, so that the change in
+//    exchange energy of a trial move is found without a loop over the
+//    neighbour list. On acceptance the change in spin is scattered to the
+//    fields of all neighbours.
+//
+//    The random number sequence is identical to sim::MonteCarlo().
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// Vampire headers
+#include "atoms.hpp"
+#include "errors.hpp"
+#include "material.hpp"
+#include "random.hpp"
+#include "sim.hpp"
+#include "vio.hpp"
+
+namespace sim{
+
+   namespace internal{
+
+      bool mc_local_field_set=false;            /// flag to indicate initialised local field cache
+      int mc_local_field_age=0;                 /// number of steps since local fields were recalculated
+      std::vector<double> mc_local_field;       /// cached exchange field of each atom (3N)
+      std::vector<double> mc_cached_spin;       /// spins from which local fields were calculated (3N)
+      std::vector<int> mc_reverse_neighbour;    /// index of reverse interaction for each neighbour list entry
+
+      // Number of steps between recalculation of local fields to remove rounding errors
+      const int mc_local_field_rebuild_rate = 1000;
+
+   } // end of namespace internal
+
+   //-----------------------------------------------------------------------------
+   // Function to add the exchange field from a spin to the cached field of an
+   // atom, with interaction given by neighbour list entry nn of the atom
+   //-----------------------------------------------------------------------------
+   inline void add_exchange_field(const int atom, const int nn, const double S[3], const int AtomExchangeType){
+
+      double* h = &internal::mc_local_field[3*atom];
+      const int itype = atoms::neighbour_interaction_type_array[nn];
+
+      switch(AtomExchangeType){
+         case 0:{
+            const double Jij=atoms::i_exchange_list[itype].Jij;
+            h[0]+=Jij*S[0];
+            h[1]+=Jij*S[1];
+            h[2]+=Jij*S[2];
+            break;
+         }
+         case 1:{
+            const double* Jij=atoms::v_exchange_list[itype].Jij;
+            h[0]+=Jij[0]*S[0];
+            h[1]+=Jij[1]*S[1];
+            h[2]+=Jij[2]*S[2];
+            break;
+         }
+         case 2:{
+            const double (*Jij)[3]=atoms::t_exchange_list[itype].Jij;
+            h[0]+=Jij[0][0]*S[0]+Jij[0][1]*S[1]+Jij[0][2]*S[2];
+            h[1]+=Jij[1][0]*S[0]+Jij[1][1]*S[1]+Jij[1][2]*S[2];
+            h[2]+=Jij[2][0]*S[0]+Jij[2][1]*S[1]+Jij[2][2]*S[2];
+            break;
+         }
+      }
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to calculate cached exchange fields of all atoms from scratch
+   //-----------------------------------------------------------------------------
+   void calculate_local_exchange_fields(){
+
+      const int num_atoms = atoms::num_atoms;
+      const int AtomExchangeType = atoms::exchange_type;
+
+      for(int atom=0;atom<num_atoms;atom++){
+         internal::mc_cached_spin[3*atom+0] = atoms::x_spin_array[atom];
+         internal::mc_cached_spin[3*atom+1] = atoms::y_spin_array[atom];
+         internal::mc_cached_spin[3*atom+2] = atoms::z_spin_array[atom];
+      }
+
+      for(int atom=0;atom<num_atoms;atom++){
+         internal::mc_local_field[3*atom+0]=0.0;
+         internal::mc_local_field[3*atom+1]=0.0;
+         internal::mc_local_field[3*atom+2]=0.0;
+         for(int nn=atoms::neighbour_list_start_index[atom];nn<=atoms::neighbour_list_end_index[atom];nn++){
+            const int natom = atoms::neighbour_list_array[nn];
+            add_exchange_field(atom, nn, &internal::mc_cached_spin[3*natom], AtomExchangeType);
+         }
+      }
+
+      internal::mc_local_field_age=0;
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to scatter a change in spin of an atom to the cached exchange
+   // fields of its neighbours
+   //-----------------------------------------------------------------------------
+   inline void scatter_spin_change(const int atom, const double dS[3], const int AtomExchangeType){
+
+      for(int nn=atoms::neighbour_list_start_index[atom];nn<=atoms::neighbour_list_end_index[atom];nn++){
+         add_exchange_field(atoms::neighbour_list_array[nn], internal::mc_reverse_neighbour[nn], dS, AtomExchangeType);
+      }
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to initialise cached exchange fields. For every neighbour list
+   // entry (i,j) the reverse entry (j,i) is found, which contains the
+   // interaction used for the field at j from the spin at i.
+   //-----------------------------------------------------------------------------
+   void initialise_incremental_monte_carlo(){
+
+      // check calling of routine if error checking is activated
+      if(err::check==true) std::cout << "sim::initialise_incremental_monte_carlo has been called" << std::endl;
+
+      const int num_atoms = atoms::num_atoms;
+      const int num_entries = atoms::neighbour_list_array.size();
+
+      internal::mc_reverse_neighbour.assign(num_entries,-1);
+
+      // sort neighbours of each atom for search of reverse entries
+      std::vector<std::pair<int,int> > sorted_list(num_entries);
+      for(int atom=0;atom<num_atoms;atom++){
+         const int start = atoms::neighbour_list_start_index[atom];
+         const int end = atoms::neighbour_list_end_index[atom]+1;
+         for(int nn=start;nn<end;nn++) sorted_list[nn]=std::make_pair(atoms::neighbour_list_array[nn],nn);
+         std::sort(sorted_list.begin()+start,sorted_list.begin()+end);
+      }
+
+      typedef std::vector<std::pair<int,int> >::iterator list_iterator;
+
+      for(int atom=0;atom<num_atoms;atom++){
+         const list_iterator own_start = sorted_list.begin()+atoms::neighbour_list_start_index[atom];
+         const list_iterator own_end = sorted_list.begin()+atoms::neighbour_list_end_index[atom]+1;
+         for(int nn=atoms::neighbour_list_start_index[atom];nn<=atoms::neighbour_list_end_index[atom];nn++){
+            const int natom = atoms::neighbour_list_array[nn];
+            // count previous entries of the same neighbour to match repeated interactions in small periodic systems
+            const int repeat = std::lower_bound(own_start, own_end, std::make_pair(natom,nn)) - std::lower_bound(own_start, own_end, std::make_pair(natom,-1));
+            const list_iterator start = sorted_list.begin()+atoms::neighbour_list_start_index[natom];
+            const list_iterator end = sorted_list.begin()+atoms::neighbour_list_end_index[natom]+1;
+            const list_iterator it = std::lower_bound(start, end, std::make_pair(atom,-1));
+            if(it+repeat < end && (it+repeat)->first==atom) internal::mc_reverse_neighbour[nn]=(it+repeat)->second;
+            else{
+               terminaltextcolor(RED);
+               std::cerr << "Error: Incremental Monte Carlo requires a symmetric neighbour list but atom " << natom << " has no interaction with atom " << atom << ". Exiting." << std::endl;
+               terminaltextcolor(WHITE);
+               zlog << zTs() << "Error: Incremental Monte Carlo requires a symmetric neighbour list but atom " << natom << " has no interaction with atom " << atom << ". Exiting." << std::endl;
+               err::vexit();
+            }
+         }
+      }
+
+      internal::mc_local_field.resize(3*num_atoms);
+      internal::mc_cached_spin.resize(3*num_atoms);
+      calculate_local_exchange_fields();
+
+      zlog << zTs() << "Incremental Monte Carlo local field cache initialised for " << num_atoms << " atoms" << std::endl;
+
+      internal::mc_local_field_set=true;
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to update cached exchange fields for spins changed outside of
+   // the integrator, for example by a program setting a new initial state
+   //-----------------------------------------------------------------------------
+   void synchronise_local_exchange_fields(){
+
+      const int num_atoms = atoms::num_atoms;
+      const int AtomExchangeType = atoms::exchange_type;
+
+      for(int atom=0;atom<num_atoms;atom++){
+         double* Sc = &internal::mc_cached_spin[3*atom];
+         const double S[3] = {atoms::x_spin_array[atom], atoms::y_spin_array[atom], atoms::z_spin_array[atom]};
+         if(S[0]!=Sc[0] || S[1]!=Sc[1] || S[2]!=Sc[2]){
+            const double dS[3] = {S[0]-Sc[0], S[1]-Sc[1], S[2]-Sc[2]};
+            scatter_spin_change(atom, dS, AtomExchangeType);
+            Sc[0]=S[0];
+            Sc[1]=S[1];
+            Sc[2]=S[2];
+         }
+      }
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Monte Carlo integrator using cached local exchange fields
+   //-----------------------------------------------------------------------------
+   int IncrementalMonteCarlo(){
+
+      // Check for calling of function
+      if(err::check==true) std::cout << "sim::IncrementalMonteCarlo has been called" << std::endl;
+
+      // check for initialisation of local fields
+      if(internal::mc_local_field_set==false) sim::initialise_incremental_monte_carlo();
+      else if(internal::mc_local_field_age >= internal::mc_local_field_rebuild_rate) calculate_local_exchange_fields();
+      else synchronise_local_exchange_fields();
+      internal::mc_local_field_age++;
+
+      // calculate number of steps to calculate
+      const int nmoves = atoms::num_atoms;
+      const int AtomExchangeType=atoms::exchange_type;
+
+      // Declare arrays for spin states
+      std::valarray<double> Sold(3);
+      std::valarray<double> Snew(3);
+
+      // Update material dependent temperature rescaling in compact material table
+      mp::update_material_hot_params_temperature();
+
+      double statistics_moves = 0.0;
+      double statistics_reject = 0.0;
+
+      // loop over natoms to form a single Monte Carlo step
+      for(int i=0;i<nmoves; i++){
+
+         // add one to number of moves counter
+         statistics_moves+=1.0;
+
+         // pick atom
+         const int atom = int(nmoves*mtrandom::grnd());
+
+         // get material id
+         const int imaterial=atoms::type_array[atom];
+
+         // Calculate range for move
+         sim::mc_delta_angle=mp::material_hot_params[imaterial].mc_sigma;
+
+         // Save old spin position
+         double* Sc = &internal::mc_cached_spin[3*atom];
+         Sold[0] = Sc[0];
+         Sold[1] = Sc[1];
+         Sold[2] = Sc[2];
+
+         // Make Monte Carlo move
+         sim::mc_move(Sold, Snew);
+
+         // Calculate change in energy from cached exchange field and on-site terms
+         const double dS[3] = {Snew[0]-Sold[0], Snew[1]-Sold[1], Snew[2]-Sold[2]};
+         const double* h = &internal::mc_local_field[3*atom];
+         const double Eex = h[0]*dS[0] + h[1]*dS[1] + h[2]*dS[2];
+         const double Eold = sim::calculate_spin_onsite_energy(atom, Sold[0], Sold[1], Sold[2]);
+         const double Enew = sim::calculate_spin_onsite_energy(atom, Snew[0], Snew[1], Snew[2]);
+
+         // Calculate difference in Joules/mu_B
+         const double DE = (Eex+Enew-Eold)*mp::material_hot_params[imaterial].mu_s_SI*1.07828231e23; //1/9.27400915e-24
+
+         // Check for lower energy state and accept unconditionally, otherwise evaluate probability for move
+         if(DE<0 || exp(-DE*mp::material_hot_params[imaterial].mc_kBTBohr) >= mtrandom::grnd()){
+            atoms::x_spin_array[atom] = Snew[0];
+            atoms::y_spin_array[atom] = Snew[1];
+            atoms::z_spin_array[atom] = Snew[2];
+            Sc[0] = Snew[0];
+            Sc[1] = Snew[1];
+            Sc[2] = Snew[2];
+            scatter_spin_change(atom, dS, AtomExchangeType);
+         }
+         // If rejected add one to rejection counter
+         else statistics_reject += 1.0;
+
+      }
+
+      // Save statistics to sim namespace variable
+      sim::mc_statistics_moves += statistics_moves;
+      sim::mc_statistics_reject += statistics_reject;
+
+      return EXIT_SUCCESS;
+
+   }
+
+} // end of namespace sim
@@ -0,0 +1,401 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+//
+//    Parallel Monte Carlo integrator using graph colouring of the
+//    neighbour list. Atoms of the same colour do not interact and so
+//    can be updated concurrently by threads and MPI processes.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Vampire headers
+#include "atoms.hpp"
+#include "cells.hpp"
+#include "create.hpp"
+#include "errors.hpp"
+#include "material.hpp"
+#include "random.hpp"
+#include "sim.hpp"
+#include "vio.hpp"
+#include "vmpi.hpp"
+#include "vomp.hpp"
+
+// Internal sim header
+#include "internal.hpp"
+
+#ifdef MPICF
+int mpi_init_halo_swap();
+int mpi_complete_halo_swap();
+#endif
+
+namespace sim{
+
+   namespace internal{
+
+      bool mc_colours_set=false;
+      int mc_num_colours=0;
+      std::vector<int> mc_colour_start;
+      std::vector<int> mc_colour_bdry_start;
+      std::vector<int> mc_colour_atoms;
+
+      // Maximum number of atom classes for which the class graph is coloured
+      const int max_colour_classes = 2048;
+
+   } // end of namespace internal
+
+   //-----------------------------------------------------------------------------
+   // Function to return the class of an atom along one dimension. Unit cells
+   // separated by a multiple of m share a class, with the remainder cells at
+   // the end of the system given unique classes so that periodic images of
+   // the same class are always at least m cells apart.
+   //-----------------------------------------------------------------------------
+   inline int cell_class(const int x, const int n, const int m){
+      const int b=(n/m)*m;
+      return x < b ? x%m : m+(x-b);
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to colour the local atoms into independent sets. Atoms are first
+   // grouped into classes by unit cell atom and unit cell position, with the
+   // period chosen from the range of the neighbour list. Classes connected by
+   // an interaction are then coloured greedily. The class graph is reduced over
+   // all processors, so that the colouring is consistent across halo atoms.
+   //-----------------------------------------------------------------------------
+   void initialise_parallel_monte_carlo(){
+
+      // check calling of routine if error checking is activated
+      if(err::check==true) std::cout << "sim::initialise_parallel_monte_carlo has been called" << std::endl;
+
+      #ifdef MPICF
+         const int num_local_atoms = vmpi::num_core_atoms+vmpi::num_bdry_atoms;
+         const int num_core_atoms = vmpi::num_core_atoms;
+      #else
+         const int num_local_atoms = atoms::num_atoms;
+         const int num_core_atoms = atoms::num_atoms;
+      #endif
+
+      const int nuc = cells::num_atoms_in_unit_cell;
+      const int n[3] = { int(cs::total_num_unit_cells[0]), int(cs::total_num_unit_cells[1]), int(cs::total_num_unit_cells[2]) };
+
+      // decode unit cell coordinates for local and halo atoms from global id
+      std::vector<int> cell(3*atoms::num_atoms);
+      std::vector<int> uc_id(atoms::num_atoms);
+      for(int atom=0;atom<atoms::num_atoms;atom++){
+         const uint64_t id = atoms::global_id_array[atom];
+         const uint64_t sc = id/uint64_t(nuc);
+         uc_id[atom] = int(id%uint64_t(nuc));
+         cell[3*atom+0] = int(sc%uint64_t(n[0]));
+         cell[3*atom+1] = int((sc/uint64_t(n[0]))%uint64_t(n[1]));
+         cell[3*atom+2] = int(sc/(uint64_t(n[0])*uint64_t(n[1])));
+      }
+
+      // determine range of interactions in unit cells
+      int range[3]={0,0,0};
+      for(int atom=0;atom<num_local_atoms;atom++){
+         for(int nn=atoms::neighbour_list_start_index[atom];nn<=atoms::neighbour_list_end_index[atom];nn++){
+            const int natom = atoms::neighbour_list_array[nn];
+            for(int d=0;d<3;d++){
+               int dx = abs(cell[3*atom+d]-cell[3*natom+d]);
+               if(cs::pbc[d] && n[d]-dx < dx) dx = n[d]-dx;
+               if(dx > range[d]) range[d] = dx;
+            }
+         }
+      }
+      #ifdef MPICF
+         MPI_Allreduce(MPI_IN_PLACE, &range[0], 3, MPI_INT, MPI_MAX, vmpi::comm);
+      #endif
+
+      // with stencil exchange the colouring must still see the explicit neighbour list,
+      // otherwise all atoms fall into a single colour and updates race silently
+      if(atoms::stencil_exchange){
+         int num_neighbours = int(atoms::neighbour_list_array.size());
+         #ifdef MPICF
+            MPI_Allreduce(MPI_IN_PLACE, &num_neighbours, 1, MPI_INT, MPI_SUM, vmpi::comm);
+         #endif
+         if(num_neighbours==0){
+            terminaltextcolor(RED);
+            std::cerr << "Error - explicit neighbour list released before parallel Monte Carlo colouring" << std::endl;
+            terminaltextcolor(WHITE);
+            zlog << zTs() << "Error - explicit neighbour list released before parallel Monte Carlo colouring" << std::endl;
+            err::vexit();
+         }
+      }
+
+      // number of classes along each dimension
+      int m[3];
+      int nc[3];
+      for(int d=0;d<3;d++){
+         m[d] = range[d]+1;
+         nc[d] = n[d] < m[d] ? n[d] : m[d]+(n[d]-(n[d]/m[d])*m[d]);
+      }
+      const int num_classes = nuc*nc[0]*nc[1]*nc[2];
+
+      // calculate class of each atom
+      std::vector<int> atom_class(atoms::num_atoms);
+      for(int atom=0;atom<atoms::num_atoms;atom++){
+         const int cx = cell_class(cell[3*atom+0],n[0],m[0]);
+         const int cy = cell_class(cell[3*atom+1],n[1],m[1]);
+         const int cz = cell_class(cell[3*atom+2],n[2],m[2]);
+         atom_class[atom] = ((cz*nc[1]+cy)*nc[0]+cx)*nuc+uc_id[atom];
+      }
+
+      // colour the class graph, or use classes directly if the graph is too large
+      std::vector<int> class_colour(num_classes);
+      int num_colours=0;
+      if(num_classes <= internal::max_colour_classes){
+         std::vector<int> class_graph(num_classes*num_classes,0);
+         for(int atom=0;atom<num_local_atoms;atom++){
+            const int ic = atom_class[atom];
+            for(int nn=atoms::neighbour_list_start_index[atom];nn<=atoms::neighbour_list_end_index[atom];nn++){
+               const int jc = atom_class[atoms::neighbour_list_array[nn]];
+               class_graph[ic*num_classes+jc]=1;
+               class_graph[jc*num_classes+ic]=1;
+            }
+         }
+         #ifdef MPICF
+            MPI_Allreduce(MPI_IN_PLACE, &class_graph[0], num_classes*num_classes, MPI_INT, MPI_MAX, vmpi::comm);
+         #endif
+         // greedy colouring in class order
+         std::vector<bool> used(num_classes);
+         for(int ic=0;ic<num_classes;ic++){
+            for(int c=0;c<num_colours;c++) used[c]=false;
+            for(int jc=0;jc<ic;jc++) if(class_graph[ic*num_classes+jc]==1) used[class_colour[jc]]=true;
+            int c=0;
+            while(c<num_colours && used[c]) c++;
+            class_colour[ic]=c;
+            if(c==num_colours) num_colours++;
+         }
+      }
+      else{
+         for(int ic=0;ic<num_classes;ic++) class_colour[ic]=ic;
+         num_colours=num_classes;
+      }
+
+      // sort local atoms by colour, with core atoms before boundary atoms
+      internal::mc_num_colours=num_colours;
+      internal::mc_colour_start.assign(num_colours+1,0);
+      internal::mc_colour_bdry_start.assign(num_colours,0);
+      internal::mc_colour_atoms.resize(num_local_atoms);
+      for(int atom=0;atom<num_local_atoms;atom++) internal::mc_colour_start[class_colour[atom_class[atom]]+1]++;
+      for(int c=0;c<num_colours;c++) internal::mc_colour_start[c+1]+=internal::mc_colour_start[c];
+      std::vector<int> fill(internal::mc_colour_start.begin(),internal::mc_colour_start.end()-1);
+      for(int atom=0;atom<num_local_atoms;atom++){
+         const int c = class_colour[atom_class[atom]];
+         internal::mc_colour_atoms[fill[c]]=atom;
+         fill[c]++;
+      }
+      for(int c=0;c<num_colours;c++){
+         int i=internal::mc_colour_start[c];
+         while(i<internal::mc_colour_start[c+1] && internal::mc_colour_atoms[i]<num_core_atoms) i++;
+         internal::mc_colour_bdry_start[c]=i;
+      }
+
+      // check that no neighbouring atoms share a colour
+      for(int atom=0;atom<num_local_atoms;atom++){
+         const int c = class_colour[atom_class[atom]];
+         for(int nn=atoms::neighbour_list_start_index[atom];nn<=atoms::neighbour_list_end_index[atom];nn++){
+            const int natom = atoms::neighbour_list_array[nn];
+            if(natom!=atom && class_colour[atom_class[natom]]==c){
+               terminaltextcolor(RED);
+               std::cerr << "Error - unable to colour neighbour list for parallel Monte Carlo integration" << std::endl;
+               terminaltextcolor(WHITE);
+               zlog << zTs() << "Error - unable to colour neighbour list for parallel Monte Carlo integration: atoms " << atom << " and " << natom << " share colour " << c << std::endl;
+               err::vexit();
+            }
+         }
+      }
+
+      zlog << zTs() << "Parallel Monte Carlo neighbour list coloured into " << num_colours << " independent sets from " << num_classes << " atom classes" << std::endl;
+
+      internal::mc_colours_set=true;
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to generate random numbers for a single Monte Carlo move of the
+   // atom with global id, as two Philox blocks keyed by the integration seed
+   // and the stream of the calling integrator. Returns three gaussian numbers
+   // and two uniform numbers in (0,1).
+   //-----------------------------------------------------------------------------
+   void internal::mc_counter_randoms(const uint64_t id, const uint32_t stream, double g[3], double u[2]){
+
+      const double two_pi = 2.0*M_PI;
+      const double scale = 2.3283064365386963e-10; // 2^-32
+
+      const uint32_t key_a[2] = {uint32_t(mtrandom::integration_seed), stream};
+      const uint32_t key_b[2] = {uint32_t(mtrandom::integration_seed), ~stream};
+      const uint32_t ctr[4] = {uint32_t(id), uint32_t(id >> 32), uint32_t(mtrandom::thermal_step), uint32_t(mtrandom::thermal_step >> 32)};
+      uint32_t ra[4];
+      uint32_t rb[4];
+      mtrandom::philox4x32(ctr, key_a, ra);
+      mtrandom::philox4x32(ctr, key_b, rb);
+
+      const double r0 = sqrt(-2.0*log((double(ra[0])+0.5)*scale));
+      const double r1 = sqrt(-2.0*log((double(ra[2])+0.5)*scale));
+      const double t0 = two_pi*(double(ra[1])+0.5)*scale;
+      const double t1 = two_pi*(double(ra[3])+0.5)*scale;
+      g[0] = r0*cos(t0);
+      g[1] = r0*sin(t0);
+      g[2] = r1*cos(t1);
+      u[0] = (double(rb[0])+0.5)*scale;
+      u[1] = (double(rb[1])+0.5)*scale;
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to generate a trial spin from the selected move type. Random
+   // numbers are supplied by the caller: u is a uniform number used to select
+   // the move for the Hinzke-Nowak algorithm and g are three gaussians.
+   //-----------------------------------------------------------------------------
+   void internal::mc_move_counter(const double old_spin[3], double new_spin[3], const double u, const double g[3], const double delta_angle){
+
+      int move=sim::mc_algorithm;
+      if(move==sim::hinzke_nowak){
+         const int pick_move=int(3.0*u);
+         move = pick_move==0 ? sim::spin_flip : (pick_move==1 ? sim::uniform : sim::angle);
+      }
+
+      switch(move){
+         case sim::spin_flip:
+            new_spin[0]=-old_spin[0];
+            new_spin[1]=-old_spin[1];
+            new_spin[2]=-old_spin[2];
+            return;
+         case sim::uniform:
+            new_spin[0]=g[0];
+            new_spin[1]=g[1];
+            new_spin[2]=g[2];
+            break;
+         default:
+            new_spin[0]=old_spin[0]+g[0]*delta_angle;
+            new_spin[1]=old_spin[1]+g[1]*delta_angle;
+            new_spin[2]=old_spin[2]+g[2]*delta_angle;
+            break;
+      }
+
+      // Apply normalisation
+      const double r = 1.0/sqrt(new_spin[0]*new_spin[0]+new_spin[1]*new_spin[1]+new_spin[2]*new_spin[2]);
+      new_spin[0]*=r;
+      new_spin[1]*=r;
+      new_spin[2]*=r;
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to perform Metropolis moves for a list of atoms of the same colour.
+   // Random numbers are counter based on (seed, global atom id, step), so that
+   // the result is independent of the number of threads and processors.
+   //-----------------------------------------------------------------------------
+   void parallel_monte_carlo_sweep(const int start, const int end, double& moves, double& reject){
+
+      const int AtomExchangeType=atoms::exchange_type;
+
+      double local_reject=0.0;
+
+      #pragma omp parallel for schedule(static) reduction(+:local_reject) if(end-start > vomp::min_atoms_per_team)
+      for(int i=start;i<end;i++){
+
+         const int atom = internal::mc_colour_atoms[i];
+         const int imaterial = atoms::type_array[atom];
+
+         // generate random numbers for move
+         double g[3];
+         double u[2];
+         internal::mc_counter_randoms(atoms::global_id_array[atom], internal::mc_stream, g, u);
+
+         // Save old spin position
+         const double Sold[3] = {atoms::x_spin_array[atom], atoms::y_spin_array[atom], atoms::z_spin_array[atom]};
+         double Snew[3];
+
+         // Make Monte Carlo move
+         internal::mc_move_counter(Sold, Snew, u[0], g, mp::material_hot_params[imaterial].mc_sigma);
+
+         // Calculate current energy
+         const double Eold = sim::calculate_spin_energy(atom, AtomExchangeType);
+
+         // Copy new spin position
+         atoms::x_spin_array[atom] = Snew[0];
+         atoms::y_spin_array[atom] = Snew[1];
+         atoms::z_spin_array[atom] = Snew[2];
+
+         // Calculate new energy
+         const double Enew = sim::calculate_spin_energy(atom, AtomExchangeType);
+
+         // Calculate difference in Joules/mu_B
+         const double DE = (Enew-Eold)*mp::material_hot_params[imaterial].mu_s_SI*1.07828231e23; //1/9.27400915e-24
+
+         // Check for lower energy state and accept unconditionally, otherwise evaluate probability for move
+         if(DE<0) continue;
+         if(exp(-DE*mp::material_hot_params[imaterial].mc_kBTBohr) >= u[1]) continue;
+
+         // If rejected reset spin coordinates
+         atoms::x_spin_array[atom] = Sold[0];
+         atoms::y_spin_array[atom] = Sold[1];
+         atoms::z_spin_array[atom] = Sold[2];
+         local_reject += 1.0;
+
+      }
+
+      moves += double(end-start);
+      reject += local_reject;
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Parallel Monte Carlo integrator. Each step is a sweep over all atoms, one
+   // colour at a time. With MPI the boundary atoms of each colour are updated
+   // first so that the halo swap overlaps with the update of the core atoms.
+   //-----------------------------------------------------------------------------
+   int ParallelMonteCarlo(){
+
+      // Check for calling of function
+      if(err::check==true) std::cout << "sim::ParallelMonteCarlo has been called" << std::endl;
+
+      // Check for initialisation of colouring
+      if(internal::mc_colours_set==false) sim::initialise_parallel_monte_carlo();
+
+      // Update material dependent temperature rescaling in compact material table
+      mp::update_material_hot_params_temperature();
+
+      double statistics_moves = 0.0;
+      double statistics_reject = 0.0;
+
+      for(int c=0;c<internal::mc_num_colours;c++){
+         #ifdef MPICF
+            parallel_monte_carlo_sweep(internal::mc_colour_bdry_start[c], internal::mc_colour_start[c+1], statistics_moves, statistics_reject);
+            mpi_init_halo_swap();
+            parallel_monte_carlo_sweep(internal::mc_colour_start[c], internal::mc_colour_bdry_start[c], statistics_moves, statistics_reject);
+            mpi_complete_halo_swap();
+         #else
+            parallel_monte_carlo_sweep(internal::mc_colour_start[c], internal::mc_colour_start[c+1], statistics_moves, statistics_reject);
+         #endif
+      }
+
+      // Save statistics to sim namespace variable
+      sim::mc_statistics_moves += statistics_moves;
+      sim::mc_statistics_reject += statistics_reject;
+
+      return EXIT_SUCCESS;
+
+   }
+
+} // end of namespace sim
@@ -0,0 +1,436 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+//
+//    Energy minimisation of the spin system using the limited memory BFGS
+//    method on the product of unit spheres. The energy gradient of each
+//    spin is -mu_s (H - (H.S) S), taken from the effective field, and spins
+//    are moved along great circles by the exponential map. Curvature pairs
+//    from previous iterations are transported to the current tangent space
+//    by projection, and the initial inverse Hessian is preconditioned by
+//    the local field of each spin. Steps which increase the total energy
+//    are halved. Each call makes a single iteration with one evaluation of
+//    the fields, so that the number of steps needed for convergence is
+//    directly comparable with the damped LLG integrators.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Vampire headers
+#include "atoms.hpp"
+#include "errors.hpp"
+#include "material.hpp"
+#include "sim.hpp"
+#include "vio.hpp"
+#include "vmpi.hpp"
+#include "vomp.hpp"
+
+// Function prototypes
+int calculate_spin_fields(const int,const int);
+int calculate_external_fields(const int,const int);
+#ifdef MPICF
+int mpi_init_halo_swap();
+int mpi_complete_halo_swap();
+#endif
+
+namespace sim{
+
+   namespace internal{
+
+      bool minimiser_set=false;                        /// flag to indicate initialised minimiser arrays
+      int minimiser_num_pairs=-1;                      /// number of stored curvature pairs, -1 if no previous step
+      int minimiser_newest=0;                          /// index of newest curvature pair
+      double minimiser_energy=0.0;                     /// total energy at start of previous step [mu_B T]
+      double minimiser_H_applied=0.0;                  /// applied field of last iteration
+      std::vector<double> minimiser_gradient;          /// gradient of current iteration (3N)
+      std::vector<double> minimiser_last_gradient;     /// gradient at start of previous step (3N)
+      std::vector<double> minimiser_preconditioner;    /// inverse local curvature 1/(mu_s |H|) (N)
+      std::vector<double> minimiser_direction;         /// step of previous iteration (3N)
+      std::vector<double> minimiser_start_spin;        /// spins at start of previous step (3N)
+      std::vector<double> minimiser_last_spin;         /// spins at end of previous step (3N)
+      std::vector<std::vector<double> > minimiser_s;   /// stored changes in spin
+      std::vector<std::vector<double> > minimiser_y;   /// stored changes in gradient
+      std::vector<double> minimiser_rho;               /// 1/(s.y) for stored pairs
+      std::vector<double> minimiser_alpha;             /// coefficients of two loop recursion
+
+      // Number of stored curvature pairs
+      const int minimiser_memory = 5;
+
+      // Maximum rotation of any spin in a single iteration (radians)
+      const double minimiser_max_angle = 0.5;
+
+      // Relative increase in energy accepted from rounding error
+      const double minimiser_energy_tolerance = 1.0e-10;
+
+   } // end of namespace internal
+
+   //-----------------------------------------------------------------------------
+   // Function to calculate dot product of two vectors over local atoms
+   //-----------------------------------------------------------------------------
+   double minimiser_dot(const std::vector<double>& a, const std::vector<double>& b, const int num_local_atoms){
+
+      double sum=0.0;
+      #pragma omp parallel for schedule(static) reduction(+:sum) if(num_local_atoms > vomp::min_atoms_per_team)
+      for(int i=0;i<3*num_local_atoms;i++) sum+=a[i]*b[i];
+
+      #ifdef MPICF
+         MPI_Allreduce(MPI_IN_PLACE, &sum, 1, MPI_DOUBLE, MPI_SUM, vmpi::comm);
+      #endif
+
+      return sum;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to project a vector onto the tangent space of the current spins
+   //-----------------------------------------------------------------------------
+   void minimiser_project(std::vector<double>& v, const int num_local_atoms){
+
+      #pragma omp parallel for schedule(static) if(num_local_atoms > vomp::min_atoms_per_team)
+      for(int atom=0;atom<num_local_atoms;atom++){
+         const double S[3] = {atoms::x_spin_array[atom],atoms::y_spin_array[atom],atoms::z_spin_array[atom]};
+         double* vi = &v[3*atom];
+         const double vdotS = vi[0]*S[0] + vi[1]*S[1] + vi[2]*S[2];
+         vi[0]-=vdotS*S[0];
+         vi[1]-=vdotS*S[1];
+         vi[2]-=vdotS*S[2];
+      }
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to calculate energy gradient on the tangent space of the spins
+   // and the local field preconditioner, returning the maximum torque |S x H|
+   // on any local spin
+   //-----------------------------------------------------------------------------
+   double calculate_minimiser_gradient(const int num_local_atoms){
+
+      // update halo spins and calculate fields
+      #ifdef MPICF
+         mpi_init_halo_swap();
+         mpi_complete_halo_swap();
+      #endif
+      calculate_spin_fields(0,num_local_atoms);
+      calculate_external_fields(0,num_local_atoms);
+
+      std::vector<double>& g = internal::minimiser_gradient;
+
+      double max_torque=0.0;
+      #pragma omp parallel for schedule(static) reduction(max:max_torque) if(num_local_atoms > vomp::min_atoms_per_team)
+      for(int atom=0;atom<num_local_atoms;atom++){
+
+         const int imaterial=atoms::type_array[atom];
+         const double mu_s = mp::material_hot_params[imaterial].mu_s_SI*1.07828231e23; //1/9.27400915e-24
+
+         const double S[3] = {atoms::x_spin_array[atom],atoms::y_spin_array[atom],atoms::z_spin_array[atom]};
+         const double H[3] = {atoms::x_total_spin_field_array[atom]+atoms::x_total_external_field_array[atom],
+                              atoms::y_total_spin_field_array[atom]+atoms::y_total_external_field_array[atom],
+                              atoms::z_total_spin_field_array[atom]+atoms::z_total_external_field_array[atom]};
+
+         // Component of field perpendicular to spin, with magnitude |S x H|
+         const double HdotS = H[0]*S[0] + H[1]*S[1] + H[2]*S[2];
+         const double Hp[3] = {H[0]-HdotS*S[0], H[1]-HdotS*S[1], H[2]-HdotS*S[2]};
+
+         g[3*atom+0] = -mu_s*Hp[0];
+         g[3*atom+1] = -mu_s*Hp[1];
+         g[3*atom+2] = -mu_s*Hp[2];
+
+         // Preconditioned steepest descent rotates each spin towards its local field
+         const double mod_H = sqrt(H[0]*H[0] + H[1]*H[1] + H[2]*H[2]);
+         internal::minimiser_preconditioner[atom] = mod_H > 0.0 ? 1.0/(mu_s*mod_H) : 0.0;
+
+         const double torque = sqrt(Hp[0]*Hp[0] + Hp[1]*Hp[1] + Hp[2]*Hp[2]);
+         if(torque>max_torque) max_torque=torque;
+
+      }
+
+      #ifdef MPICF
+         MPI_Allreduce(MPI_IN_PLACE, &max_torque, 1, MPI_DOUBLE, MPI_MAX, vmpi::comm);
+      #endif
+
+      return max_torque;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to calculate total energy of local spins in mu_B T, counting
+   // each exchange and magnetostatic interaction once, so that the energy is
+   // consistent with the gradient calculated from the fields
+   //-----------------------------------------------------------------------------
+   double calculate_minimiser_energy(const int num_local_atoms){
+
+      const int AtomExchangeType = atoms::exchange_type;
+
+      double energy=0.0;
+      #pragma omp parallel for schedule(static) reduction(+:energy) if(num_local_atoms > vomp::min_atoms_per_team)
+      for(int atom=0;atom<num_local_atoms;atom++){
+         const int imaterial=atoms::type_array[atom];
+         const double mu_s = mp::material_hot_params[imaterial].mu_s_SI*1.07828231e23; //1/9.27400915e-24
+         const double Sx = atoms::x_spin_array[atom];
+         const double Sy = atoms::y_spin_array[atom];
+         const double Sz = atoms::z_spin_array[atom];
+         // spin energy includes on-site terms, which are counted in full except for the magnetostatic pair interaction
+         const double onsite = sim::calculate_spin_onsite_energy(atom, Sx, Sy, Sz) - sim::spin_magnetostatic_energy(atom, Sx, Sy, Sz);
+         energy += 0.5*mu_s*(sim::calculate_spin_energy(atom, AtomExchangeType) + onsite);
+      }
+
+      #ifdef MPICF
+         MPI_Allreduce(MPI_IN_PLACE, &energy, 1, MPI_DOUBLE, MPI_SUM, vmpi::comm);
+      #endif
+
+      return energy;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to determine if spins or applied field have been changed outside
+   // of the minimiser since the last iteration, invalidating the previous step
+   //-----------------------------------------------------------------------------
+   bool minimiser_state_changed(const int num_local_atoms){
+
+      int changed = (sim::H_applied!=internal::minimiser_H_applied);
+
+      const std::vector<double>& S = internal::minimiser_last_spin;
+      for(int atom=0;atom<num_local_atoms && changed==0;atom++){
+         if(atoms::x_spin_array[atom]!=S[3*atom+0] ||
+            atoms::y_spin_array[atom]!=S[3*atom+1] ||
+            atoms::z_spin_array[atom]!=S[3*atom+2]) changed=1;
+      }
+
+      #ifdef MPICF
+         MPI_Allreduce(MPI_IN_PLACE, &changed, 1, MPI_INT, MPI_MAX, vmpi::comm);
+      #endif
+
+      return changed==1;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // Function to move spins along great circles S' = S cos|d| + d/|d| sin|d|
+   // from their positions at the start of the step
+   //-----------------------------------------------------------------------------
+   void minimiser_step(const int num_local_atoms){
+
+      const std::vector<double>& d = internal::minimiser_direction;
+      const std::vector<double>& S0 = internal::minimiser_start_spin;
+
+      #pragma omp parallel for schedule(static) if(num_local_atoms > vomp::min_atoms_per_team)
+      for(int atom=0;atom<num_local_atoms;atom++){
+         const double* di = &d[3*atom];
+         const double* S = &S0[3*atom];
+         const double theta = sqrt(di[0]*di[0] + di[1]*di[1] + di[2]*di[2]);
+         double Sn[3] = {S[0], S[1], S[2]};
+         if(theta>0.0){
+            const double cos_theta = cos(theta);
+            const double sin_theta = sin(theta)/theta;
+            Sn[0] = S[0]*cos_theta + di[0]*sin_theta;
+            Sn[1] = S[1]*cos_theta + di[1]*sin_theta;
+            Sn[2] = S[2]*cos_theta + di[2]*sin_theta;
+            // renormalise to remove accumulated rounding error
+            const double mod_S = 1.0/sqrt(Sn[0]*Sn[0] + Sn[1]*Sn[1] + Sn[2]*Sn[2]);
+            Sn[0]*=mod_S;
+            Sn[1]*=mod_S;
+            Sn[2]*=mod_S;
+         }
+         atoms::x_spin_array[atom] = Sn[0];
+         atoms::y_spin_array[atom] = Sn[1];
+         atoms::z_spin_array[atom] = Sn[2];
+         internal::minimiser_last_spin[3*atom+0] = Sn[0];
+         internal::minimiser_last_spin[3*atom+1] = Sn[1];
+         internal::minimiser_last_spin[3*atom+2] = Sn[2];
+      }
+
+      internal::minimiser_H_applied = sim::H_applied;
+
+      return;
+
+   }
+
+   //-----------------------------------------------------------------------------
+   // L-BFGS energy minimiser. Each call makes a single iteration.
+   //-----------------------------------------------------------------------------
+   int Minimise(){
+
+      // check calling of routine if error checking is activated
+      if(err::check==true) std::cout << "sim::Minimise has been called" << std::endl;
+
+      using namespace internal;
+
+      #ifdef MPICF
+         const int num_local_atoms = vmpi::num_core_atoms+vmpi::num_bdry_atoms;
+      #else
+         const int num_local_atoms = atoms::num_atoms;
+      #endif
+
+      // Check for initialisation of minimiser arrays
+      if(minimiser_set==false){
+         minimiser_gradient.resize(3*num_local_atoms);
+         minimiser_last_gradient.resize(3*num_local_atoms);
+         minimiser_preconditioner.resize(num_local_atoms);
+         minimiser_direction.resize(3*num_local_atoms);
+         minimiser_start_spin.resize(3*num_local_atoms);
+         minimiser_last_spin.resize(3*num_local_atoms);
+         minimiser_s.resize(minimiser_memory, std::vector<double>(3*num_local_atoms));
+         minimiser_y.resize(minimiser_memory, std::vector<double>(3*num_local_atoms));
+         minimiser_rho.resize(minimiser_memory);
+         minimiser_alpha.resize(minimiser_memory);
+         if(sim::hamiltonian_simulation_flags[3]==1 && sim::temperature>0.0){
+            zlog << zTs() << "Warning: Energy minimisation finds the ground state at zero temperature, thermal fields will be ignored." << std::endl;
+         }
+         minimiser_num_pairs=-1;
+         minimiser_set=true;
+      }
+      // Discard previous step and curvature information if the energy surface has changed
+      else if(minimiser_num_pairs>=0 && minimiser_state_changed(num_local_atoms)){
+         minimiser_num_pairs=-1;
+      }
+
+      // Disable thermal fields during minimisation
+      const int thermal_flag = sim::hamiltonian_simulation_flags[3];
+      sim::hamiltonian_simulation_flags[3] = 0;
+
+      const double max_torque = calculate_minimiser_gradient(num_local_atoms);
+      const double energy = calculate_minimiser_energy(num_local_atoms);
+
+      sim::hamiltonian_simulation_flags[3] = thermal_flag;
+
+      // No further minimisation is needed once converged
+      if(max_torque < sim::minimiser_tolerance){
+         minimiser_num_pairs=-1;
+         return EXIT_SUCCESS;
+      }
+
+      std::vector<double>& g = minimiser_gradient;
+      std::vector<double>& d = minimiser_direction;
+      const std::vector<double>& D = minimiser_preconditioner;
+
+      //----------------------------------------------------------------
+      // Halve previous step if energy has increased
+      //----------------------------------------------------------------
+      if(minimiser_num_pairs>=0 && energy > minimiser_energy + minimiser_energy_tolerance*std::fabs(minimiser_energy)){
+         for(int i=0;i<3*num_local_atoms;i++) d[i]*=0.5;
+         minimiser_step(num_local_atoms);
+         return EXIT_SUCCESS;
+      }
+
+      //----------------------------------------------------------------
+      // Transport stored pairs to tangent space of current spins and add
+      // the pair from the previous step if the curvature is positive
+      //----------------------------------------------------------------
+      if(minimiser_num_pairs<0) minimiser_num_pairs=0;
+      else{
+         for(int k=0;k<minimiser_num_pairs;k++){
+            const int p = (minimiser_newest-k+minimiser_memory)%minimiser_memory;
+            minimiser_project(minimiser_s[p], num_local_atoms);
+            minimiser_project(minimiser_y[p], num_local_atoms);
+            const double sy = minimiser_dot(minimiser_s[p], minimiser_y[p], num_local_atoms);
+            minimiser_rho[p] = sy > 0.0 ? 1.0/sy : 0.0;
+         }
+
+         const int p = (minimiser_newest+1)%minimiser_memory;
+         std::vector<double>& s = minimiser_s[p];
+         std::vector<double>& y = minimiser_y[p];
+         for(int i=0;i<3*num_local_atoms;i++){
+            s[i] = d[i];
+            y[i] = minimiser_last_gradient[i];
+         }
+         minimiser_project(s, num_local_atoms);
+         minimiser_project(y, num_local_atoms);
+         for(int i=0;i<3*num_local_atoms;i++) y[i] = g[i]-y[i];
+
+         const double sy = minimiser_dot(s, y, num_local_atoms);
+         if(sy > 0.0){
+            minimiser_rho[p] = 1.0/sy;
+            minimiser_newest = p;
+            if(minimiser_num_pairs<minimiser_memory) minimiser_num_pairs++;
+         }
+      }
+
+      //----------------------------------------------------------------
+      // Calculate search direction from two loop recursion
+      //----------------------------------------------------------------
+      for(int i=0;i<3*num_local_atoms;i++) d[i] = g[i];
+
+      for(int k=0;k<minimiser_num_pairs;k++){
+         const int p = (minimiser_newest-k+minimiser_memory)%minimiser_memory;
+         minimiser_alpha[p] = minimiser_rho[p]*minimiser_dot(minimiser_s[p], d, num_local_atoms);
+         for(int i=0;i<3*num_local_atoms;i++) d[i] -= minimiser_alpha[p]*minimiser_y[p][i];
+      }
+
+      // initial inverse Hessian from local fields, scaled by newest pair
+      double gamma=1.0;
+      if(minimiser_num_pairs>0){
+         const int p = minimiser_newest;
+         double yDy=0.0;
+         for(int i=0;i<3*num_local_atoms;i++) yDy += minimiser_y[p][i]*minimiser_y[p][i]*D[i/3];
+         #ifdef MPICF
+            MPI_Allreduce(MPI_IN_PLACE, &yDy, 1, MPI_DOUBLE, MPI_SUM, vmpi::comm);
+         #endif
+         if(yDy > 0.0) gamma = 1.0/(minimiser_rho[p]*yDy);
+      }
+      for(int i=0;i<3*num_local_atoms;i++) d[i] *= gamma*D[i/3];
+
+      for(int k=minimiser_num_pairs-1;k>=0;k--){
+         const int p = (minimiser_newest-k+minimiser_memory)%minimiser_memory;
+         const double beta = minimiser_rho[p]*minimiser_dot(minimiser_y[p], d, num_local_atoms);
+         for(int i=0;i<3*num_local_atoms;i++) d[i] += (minimiser_alpha[p]-beta)*minimiser_s[p][i];
+      }
+
+      for(int i=0;i<3*num_local_atoms;i++) d[i] = -d[i];
+      minimiser_project(d, num_local_atoms);
+
+      // Revert to preconditioned steepest descent if direction is not downhill
+      if(minimiser_num_pairs>0 && !(minimiser_dot(d, g, num_local_atoms) < 0.0)){
+         for(int i=0;i<3*num_local_atoms;i++) d[i] = -D[i/3]*g[i];
+         minimiser_num_pairs=0;
+      }
+
+      //----------------------------------------------------------------
+      // Limit maximum rotation of any spin
+      //----------------------------------------------------------------
+      double max_angle=0.0;
+      #pragma omp parallel for schedule(static) reduction(max:max_angle) if(num_local_atoms > vomp::min_atoms_per_team)
+      for(int atom=0;atom<num_local_atoms;atom++){
+         const double angle = sqrt(d[3*atom+0]*d[3*atom+0] + d[3*atom+1]*d[3*atom+1] + d[3*atom+2]*d[3*atom+2]);
+         if(angle>max_angle) max_angle=angle;
+      }
+      #ifdef MPICF
+         MPI_Allreduce(MPI_IN_PLACE, &max_angle, 1, MPI_DOUBLE, MPI_MAX, vmpi::comm);
+      #endif
+
+      if(max_angle>minimiser_max_angle){
+         const double scale = minimiser_max_angle/max_angle;
+         for(int i=0;i<3*num_local_atoms;i++) d[i] *= scale;
+      }
+
+      //----------------------------------------------------------------
+      // Store state at start of step and move spins
+      //----------------------------------------------------------------
+      for(int atom=0;atom<num_local_atoms;atom++){
+         minimiser_start_spin[3*atom+0] = atoms::x_spin_array[atom];
+         minimiser_start_spin[3*atom+1] = atoms::y_spin_array[atom];
+         minimiser_start_spin[3*atom+2] = atoms::z_spin_array[atom];
+      }
+      minimiser_last_gradient.swap(minimiser_gradient);
+      minimiser_energy = energy;
+
+      minimiser_step(num_local_atoms);
+
+      return EXIT_SUCCESS;
+
+   }
+
+} // end of namespace sim
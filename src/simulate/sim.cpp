@@ -59,6 +59,7 @@
 namespace sim{
 	std::ofstream mag_file;
 	uint64_t time=0;
+	double physical_time=0.0; /// Simulated physical time [s]
 	uint64_t total_time=10000;
 	uint64_t loop_time=10000;
 	int partial_time=1000;
@@ -131,10 +132,16 @@ namespace sim{
   
    double mc_delta_angle=0.1; /// Tuned angle for Monte Carlo trial move
    mc_algorithms mc_algorithm=hinzke_nowak;
+   bool parallel_cmc=false; /// Use graph coloured pair moves for constrained Monte Carlo
+   bool incremental_mc=false; /// Use cached local exchange fields for Monte Carlo
+
+   double adaptive_tolerance=1.0e-5; /// Maximum error in spin direction per adaptive step
+   double adaptive_dt_SI=0.0; /// Physical time of last adaptive step [s]
+   double minimiser_tolerance=1.0e-6; /// Maximum torque on any spin at convergence [T]
   
 	int system_simulation_flags;
 	int hamiltonian_simulation_flags[10];
-	int integrator=0; /// 0 = LLG Heun; 1= MC; 2 = LLG Midpoint; 3 = CMC 
+	int integrator=llg_heun; /// 0 = LLG Heun; 1= MC; 2 = LLG Midpoint; 3 = CMC; 4 = Hybrid CMC; 5 = Parallel MC; 6 = LLG RK23; 7 = LLG Rotation; 8 = Energy minimisation
 	int program=0; 
 	int AnisotropyType=2; /// Controls scalar (0) or tensor(1) anisotropy (off(2))
 	
@@ -192,8 +199,32 @@ namespace sim{
 ///
 	void increment_time(){
 		
+		// Physical time of step, which varies for the adaptive integrator and
+		// is zero for energy minimisation. Every integrator is listed so that
+		// -Wswitch flags any new integrator without a time step.
+		double dt_SI = mp::dt_SI;
+		switch(integrators_t(sim::integrator)){
+			case llg_heun:
+			case monte_carlo:
+			case llg_midpoint:
+			case constrained_monte_carlo:
+			case hybrid_constrained_monte_carlo:
+			case parallel_monte_carlo:
+			case llg_rotation:
+				dt_SI = mp::dt_SI;
+				break;
+			case llg_rk23:
+				dt_SI = sim::adaptive_dt_SI;
+				break;
+			case energy_minimisation:
+				dt_SI = 0.0;
+				break;
+		}
+
 		sim::time++;
-		sim::head_position[0]+=sim::head_speed*mp::dt_SI*1.0e10;
+		sim::physical_time+=dt_SI;
+		mtrandom::thermal_step++;
+		sim::head_position[0]+=sim::head_speed*dt_SI*1.0e10;
 		if(sim::hamiltonian_simulation_flags[4]==1) demag::update();
 		if(sim::lagrange_multiplier) update_lagrange_lambda();
 	}
@@ -244,6 +275,7 @@ int run(){
 
 	// Initialise random number generator
 	mtrandom::grnd.seed(mtrandom::integration_seed+vmpi::my_rank);
+	mtrandom::thermal_step=0;
 
    // Seeds with single bit differences are not ideal and may be correlated for first few values - warming up integrator
    for(int i=0; i<1000; ++i) mtrandom::grnd();
@@ -385,6 +417,14 @@ int run(){
             zlog << "effective-damping..." << std::endl;
          }
          program::effective_damping();
+         break;
+
+      case 15:
+         if(vmpi::my_rank==0){
+            std::cout << "Replica-Exchange..." << std::endl;
+            zlog << "Replica-Exchange..." << std::endl;
+         }
+         program::replica_exchange();
          break;
 
 		case 50:
@@ -402,10 +442,13 @@ int run(){
 			}
 	}
 
+   // Write ordered output of all replicas for statistical parallelism
+   vout::write_replica_data();
+
    //------------------------------------------------
    // Output Monte Carlo statistics if applicable
    //------------------------------------------------
-   if(sim::integrator==1){
+   if(sim::integrator==monte_carlo || sim::integrator==parallel_monte_carlo){
       std::cout << "Monte Carlo statistics:" << std::endl;
       std::cout << "\tTotal moves: " << long(sim::mc_statistics_moves) << std::endl;
       std::cout << "\t" << ((sim::mc_statistics_moves - sim::mc_statistics_reject)/sim::mc_statistics_moves)*100.0 << "% Accepted" << std::endl;
@@ -415,7 +458,7 @@ int run(){
       zlog << zTs() << "\t" << ((sim::mc_statistics_moves - sim::mc_statistics_reject)/sim::mc_statistics_moves)*100.0 << "% Accepted" << std::endl;
       zlog << zTs() << "\t" << (sim::mc_statistics_reject/sim::mc_statistics_moves)*100.0                              << "% Rejected" << std::endl;
    }
-   if(sim::integrator==3 || sim::integrator==4){
+   if(sim::integrator==constrained_monte_carlo || sim::integrator==hybrid_constrained_monte_carlo){
       std::cout << "Constrained Monte Carlo statistics:" << std::endl;
       std::cout << "\tTotal moves: " << cmc::mc_total << std::endl;
       std::cout << "\t" << (cmc::mc_success/cmc::mc_total)*100.0    << "% Accepted" << std::endl;
@@ -436,6 +479,9 @@ int run(){
    // optionally save checkpoint file
    if(sim::save_checkpoint_flag && !sim::save_checkpoint_continuous_flag) save_checkpoint();
 
+   // release packed exchange arrays
+   if(atoms::packed_exchange) sim::finalise_packed_exchange();
+
 	return EXIT_SUCCESS;
 }
 
@@ -507,7 +553,7 @@ void integrate_serial(int n_steps){
    // Case statement to call integrator
    switch(sim::integrator){
 
-      case 0: // LLG Heun
+      case llg_heun: // LLG Heun
          for(int ti=0;ti<n_steps;ti++){
             // Optionally select GPU accelerated version
             if(gpu::acceleration) gpu::llg_heun();
@@ -518,15 +564,16 @@ void integrate_serial(int n_steps){
          }
          break;
 		
-		case 1: // Montecarlo
+		case monte_carlo: // Montecarlo
 			for(int ti=0;ti<n_steps;ti++){
-				sim::MonteCarlo();
+				if(sim::incremental_mc) sim::IncrementalMonteCarlo();
+				else sim::MonteCarlo();
 				// increment time
 				increment_time();
 			}
 			break;
 
-      case 2: // LLG Midpoint
+      case llg_midpoint: // LLG Midpoint
          for(int ti=0;ti<n_steps;ti++){
             sim::LLG_Midpoint();
             // increment time
@@ -534,17 +581,51 @@ void integrate_serial(int n_steps){
          }
          break;
 
-		case 3: // Constrained Monte Carlo
+		case constrained_monte_carlo: // Constrained Monte Carlo
+			for(int ti=0;ti<n_steps;ti++){
+				if(sim::parallel_cmc) sim::ParallelConstrainedMonteCarlo();
+				else sim::ConstrainedMonteCarlo();
+				// increment time
+				increment_time();
+			}
+			break;
+
+		case hybrid_constrained_monte_carlo: // Hybrid Constrained Monte Carlo
 			for(int ti=0;ti<n_steps;ti++){
-				sim::ConstrainedMonteCarlo();
+				if(sim::parallel_cmc) sim::ParallelConstrainedMonteCarlo();
+				else sim::ConstrainedMonteCarloMonteCarlo();
 				// increment time
 				increment_time();
 			}
 			break;
 
-		case 4: // Hybrid Constrained Monte Carlo
+		case parallel_monte_carlo: // Parallel Monte Carlo
 			for(int ti=0;ti<n_steps;ti++){
-				sim::ConstrainedMonteCarloMonteCarlo();
+				sim::ParallelMonteCarlo();
+				// increment time
+				increment_time();
+			}
+			break;
+
+		case llg_rk23: // Adaptive LLG Runge-Kutta
+			for(int ti=0;ti<n_steps;ti++){
+				sim::LLG_RK23();
+				// increment time
+				increment_time();
+			}
+			break;
+
+		case llg_rotation: // Geometric LLG rotation
+			for(int ti=0;ti<n_steps;ti++){
+				sim::LLG_Rotation();
+				// increment time
+				increment_time();
+			}
+			break;
+
+		case energy_minimisation: // L-BFGS energy minimisation
+			for(int ti=0;ti<n_steps;ti++){
+				sim::Minimise();
 				// increment time
 				increment_time();
 			}
@@ -589,7 +670,7 @@ int integrate_mpi(int n_steps){
 	
 	// Case statement to call integrator
 	switch(sim::integrator){
-		case 0: // LLG Heun
+		case llg_heun: // LLG Heun
 			for(int ti=0;ti<n_steps;ti++){
 			#ifdef MPICF
 				// Select CUDA version if supported
@@ -604,18 +685,40 @@ int integrate_mpi(int n_steps){
 			}
 			break;
 		
-		case 1: // Montecarlo
+		case monte_carlo: // Montecarlo (random site updates are serial, so use coloured sweeps)
+		case parallel_monte_carlo: // Parallel Monte Carlo
+			for(int ti=0;ti<n_steps;ti++){
+				sim::ParallelMonteCarlo();
+				// increment time
+				increment_time();
+			}
+			break;
+
+		case llg_rk23: // Adaptive LLG Runge-Kutta
+			for(int ti=0;ti<n_steps;ti++){
+				sim::LLG_RK23();
+				// increment time
+				increment_time();
+			}
+			break;
+
+		case llg_rotation: // Geometric LLG rotation
+			for(int ti=0;ti<n_steps;ti++){
+				sim::LLG_Rotation();
+				// increment time
+				increment_time();
+			}
+			break;
+
+		case energy_minimisation: // L-BFGS energy minimisation
 			for(int ti=0;ti<n_steps;ti++){
-				terminaltextcolor(RED);
-				std::cerr << "Error - Monte Carlo Integrator unavailable for parallel execution" << std::endl;
-				terminaltextcolor(WHITE);
-				err::vexit();
+				sim::Minimise();
 				// increment time
 				increment_time();
 			}
 			break;
 		
-		case 2: // LLG Midpoint
+		case llg_midpoint: // LLG Midpoint
 			for(int ti=0;ti<n_steps;ti++){
 			#ifdef MPICF
 			// Select CUDA version if supported
@@ -630,12 +733,10 @@ int integrate_mpi(int n_steps){
 			}
 			break;
 			
-		case 3: // Constrained Monte Carlo
+		case constrained_monte_carlo: // Constrained Monte Carlo (pair moves are always graph coloured in parallel)
+		case hybrid_constrained_monte_carlo: // Hybrid Constrained Monte Carlo
 			for(int ti=0;ti<n_steps;ti++){
-				terminaltextcolor(RED);
-				std::cerr << "Error - Constrained Monte Carlo Integrator unavailable for parallel execution" << std::endl;
-				terminaltextcolor(WHITE);
-				err::vexit();
+				sim::ParallelConstrainedMonteCarlo();
 				// increment time
 				increment_time();
 			}
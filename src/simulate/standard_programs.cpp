@@ -135,7 +135,7 @@ int hamr_run(){
 	//sim::LLG(sim::equilibration_time);
 
 	// Simulate system with single timestep resolution
-	for(sim::time=0;sim::time<sim::loop_time;sim::time++){
+	for(sim::time=0,sim::physical_time=0.0;sim::time<sim::loop_time;sim::time++,sim::physical_time+=mp::dt_SI){
 		
 		// calculate real time and temperature using gaussian cooling
 		double actual_time = (double(run)*double(sim::loop_time)+double(sim::time))*mp::dt_SI;
@@ -240,7 +240,7 @@ int two_temperature_pulse(){
 	sim::temperature=77.0;
 	
 	// Equilibrate system
-	for(sim::time=0;sim::time<sim::equilibration_time;sim::time++){
+	for(sim::time=0,sim::physical_time=0.0;sim::time<sim::equilibration_time;sim::time++,sim::physical_time+=mp::dt_SI){
 		double actual_time = double(sim::time-sim::equilibration_time)*mp::dt_SI;
 		//sim::LLG(1);
 		
@@ -278,7 +278,7 @@ int two_temperature_pulse(){
 	pp.open("pp.dat");
 	
 	// Simulate system with single timestep resolution
-	for(sim::time=0;sim::time<sim::loop_time;sim::time++){
+	for(sim::time=0,sim::physical_time=0.0;sim::time<sim::loop_time;sim::time++,sim::physical_time+=mp::dt_SI){
 		
 		// calculate real time and temperature using gaussian cooling
 		double actual_time = double(sim::time)*mp::dt_SI;
@@ -49,7 +49,7 @@ namespace stats{
          }
          // Reduce maximum height on all CPUS
          #ifdef MPICF
-            MPI_Allreduce(MPI_IN_PLACE, &max_height, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+            MPI_Allreduce(MPI_IN_PLACE, &max_height, 1, MPI_INT, MPI_MAX, vmpi::comm);
          #endif
          stats::height_magnetization.set_mask(max_height+1,mask,magnetic_moment_array);
       }
@@ -67,7 +67,7 @@ namespace stats{
          }
          // Reduce maximum height on all CPUS
          #ifdef MPICF
-            MPI_Allreduce(MPI_IN_PLACE, &max_height, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+            MPI_Allreduce(MPI_IN_PLACE, &max_height, 1, MPI_INT, MPI_MAX, vmpi::comm);
          #endif
          stats::material_height_magnetization.set_mask(num_materials*(max_height+1),mask,magnetic_moment_array);
       }
@@ -65,7 +65,7 @@ void magnetization_statistic_t::set_mask(const int in_mask_size, std::vector<int
 
    // Add saturation for all CPUs
    #ifdef MPICF
-      MPI_Allreduce(MPI_IN_PLACE, &saturation[0], mask_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+      MPI_Allreduce(MPI_IN_PLACE, &saturation[0], mask_size, MPI_DOUBLE, MPI_SUM, vmpi::comm);
    #endif
 
    // determine mask id's with no atoms
@@ -78,7 +78,7 @@ void magnetization_statistic_t::set_mask(const int in_mask_size, std::vector<int
 
    // Reduce on all CPUs
    #ifdef MPICF
-      MPI_Allreduce(MPI_IN_PLACE, &num_atoms_in_mask[0], mask_size, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+      MPI_Allreduce(MPI_IN_PLACE, &num_atoms_in_mask[0], mask_size, MPI_INT, MPI_SUM, vmpi::comm);
    #endif
 
    // Check for no atoms in mask on any CPU
@@ -121,7 +121,7 @@ void magnetization_statistic_t::calculate_magnetization(const std::vector<double
 
    // Reduce on all CPUS
    #ifdef MPICF
-      MPI_Allreduce(MPI_IN_PLACE, &magnetization[0], 4*mask_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+      MPI_Allreduce(MPI_IN_PLACE, &magnetization[0], 4*mask_size, MPI_DOUBLE, MPI_SUM, vmpi::comm);
    #endif
 
    // Calculate magnetisation length and normalize
@@ -0,0 +1,232 @@
+//-----------------------------------------------------------------------------
+//
+// This source file is part of the VAMPIRE open source package under the
+// GNU GPL (version 2) licence (see licence file for details).
+//
+// (c) R F L Evans 2015. All rights reserved.
+//
+//-----------------------------------------------------------------------------
+//
+//    Asynchronous output. Output functions copy data from the simulation
+//    into a buffer taken from a pool and submit a job, which is formatted
+//    and written to disk by a background writer thread while the
+//    simulation continues. The number of jobs in flight is bounded by
+//    output:asynchronous-queue-depth, after which submission waits for
+//    the writer. Without output:asynchronous, jobs are written immediately.
+//    Files are opened before submission so that errors are reported by the
+//    main thread, and completion messages of written jobs are logged by the
+//    main thread at the next submission or on finalisation.
+//
+//-----------------------------------------------------------------------------
+
+// C++ standard library headers
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef WIN_COMPILE
+   #include <pthread.h>
+#endif
+
+// Vampire headers
+#include "errors.hpp"
+#include "vio.hpp"
+
+namespace vout{
+
+   bool asynchronous_output=false;     /// flag to enable background writer thread
+   int asynchronous_queue_depth=2;     /// maximum number of output jobs in flight
+
+   namespace async{
+
+      #ifndef WIN_COMPILE
+
+      namespace internal{
+
+         bool initialised=false;                   /// flag to indicate running writer thread
+         bool shutdown=false;                      /// flag to stop writer thread when queue is empty
+         int jobs_in_flight=0;                     /// number of submitted jobs not yet written
+         std::deque<job_t*> queue;                 /// jobs waiting for writer thread
+         std::vector<std::vector<char> > pool;     /// buffers of completed jobs for reuse
+         std::vector<std::string> messages;        /// completion messages of written jobs
+
+         pthread_t writer_thread;
+         pthread_mutex_t mutex;
+         pthread_cond_t job_submitted;
+         pthread_cond_t job_completed;
+
+      } // end of namespace internal
+
+      //-----------------------------------------------------------------------------
+      // Writer thread, which writes queued jobs in order of submission and
+      // returns their buffers to the pool
+      //-----------------------------------------------------------------------------
+      void* writer(void*){
+
+         using namespace internal;
+
+         pthread_mutex_lock(&mutex);
+
+         while(true){
+
+            while(queue.empty() && !shutdown) pthread_cond_wait(&job_submitted, &mutex);
+            if(queue.empty()) break;
+
+            job_t* job = queue.front();
+            queue.pop_front();
+
+            // format and write without holding lock
+            pthread_mutex_unlock(&mutex);
+            job->write();
+            pthread_mutex_lock(&mutex);
+
+            pool.push_back(std::vector<char>());
+            pool.back().swap(job->buffer);
+            if(!job->message.empty()) messages.push_back(job->message);
+            delete job;
+
+            jobs_in_flight--;
+            pthread_cond_broadcast(&job_completed);
+
+         }
+
+         pthread_mutex_unlock(&mutex);
+
+         return NULL;
+
+      }
+
+      //-----------------------------------------------------------------------------
+      // Function to start writer thread, falling back to synchronous output
+      //-----------------------------------------------------------------------------
+      void initialise(){
+
+         using namespace internal;
+
+         pthread_mutex_init(&mutex, NULL);
+         pthread_cond_init(&job_submitted, NULL);
+         pthread_cond_init(&job_completed, NULL);
+
+         shutdown=false;
+         jobs_in_flight=0;
+
+         if(pthread_create(&writer_thread, NULL, writer, NULL)!=0){
+            zlog << zTs() << "Warning: Unable to start asynchronous output thread, output will be written synchronously." << std::endl;
+            vout::asynchronous_output=false;
+            return;
+         }
+
+         zlog << zTs() << "Asynchronous output thread started with queue depth " << vout::asynchronous_queue_depth << std::endl;
+
+         initialised=true;
+
+         return;
+
+      }
+
+      //-----------------------------------------------------------------------------
+      // Function to log completion messages of written jobs on main thread
+      //-----------------------------------------------------------------------------
+      void log_messages(){
+
+         using namespace internal;
+
+         std::vector<std::string> completed;
+         pthread_mutex_lock(&mutex);
+         completed.swap(messages);
+         pthread_mutex_unlock(&mutex);
+
+         for(unsigned int i=0;i<completed.size();i++) zlog << zTs() << completed[i] << std::endl;
+
+         return;
+
+      }
+
+      #endif
+
+      //-----------------------------------------------------------------------------
+      // Function to resize buffer for a new job, reusing a pooled buffer
+      //-----------------------------------------------------------------------------
+      void acquire_buffer(std::vector<char>& buffer, const size_t size){
+
+         #ifndef WIN_COMPILE
+            if(internal::initialised){
+               pthread_mutex_lock(&internal::mutex);
+               if(!internal::pool.empty()){
+                  buffer.swap(internal::pool.back());
+                  internal::pool.pop_back();
+               }
+               pthread_mutex_unlock(&internal::mutex);
+            }
+         #endif
+
+         buffer.resize(size);
+
+         return;
+
+      }
+
+      //-----------------------------------------------------------------------------
+      // Function to submit job for writing, taking ownership of the job
+      //-----------------------------------------------------------------------------
+      void submit(job_t* job){
+
+         #ifndef WIN_COMPILE
+            if(vout::asynchronous_output && !internal::initialised) initialise();
+            if(internal::initialised){
+               pthread_mutex_lock(&internal::mutex);
+               while(internal::jobs_in_flight>=vout::asynchronous_queue_depth) pthread_cond_wait(&internal::job_completed, &internal::mutex);
+               internal::queue.push_back(job);
+               internal::jobs_in_flight++;
+               pthread_cond_signal(&internal::job_submitted);
+               pthread_mutex_unlock(&internal::mutex);
+               log_messages();
+               return;
+            }
+         #endif
+
+         // otherwise write synchronously
+         job->write();
+         if(!job->message.empty()) zlog << zTs() << job->message << std::endl;
+         delete job;
+
+         return;
+
+      }
+
+      //-----------------------------------------------------------------------------
+      // Function to complete all outstanding output and stop writer thread. This
+      // is also called by err::vexit so that queued output is not lost.
+      //-----------------------------------------------------------------------------
+      void finalise(){
+
+         #ifndef WIN_COMPILE
+            if(!internal::initialised) return;
+
+            pthread_mutex_lock(&internal::mutex);
+            internal::shutdown=true;
+            pthread_cond_signal(&internal::job_submitted);
+            pthread_mutex_unlock(&internal::mutex);
+
+            pthread_join(internal::writer_thread, NULL);
+
+            log_messages();
+
+            pthread_cond_destroy(&internal::job_submitted);
+            pthread_cond_destroy(&internal::job_completed);
+            pthread_mutex_destroy(&internal::mutex);
+
+            internal::pool.clear();
+            internal::initialised=false;
+
+            zlog << zTs() << "Asynchronous output completed." << std::endl;
+         #endif
+
+         return;
+
+      }
+
+   } // end of namespace async
+
+} // end of namespace vout
@@ -6,86 +6,277 @@
 // (c) R F L Evans 2014. All rights reserved.
 //
 //-----------------------------------------------------------------------------
+//
+//    Checkpoint files. All processors write a single shared file vampire.chk
+//    containing the simulation state, the random number generator state of
+//    each processor and a record (global atom id, sx, sy, sz) for every
+//    atom, written with collective parallel I/O. On loading, records are
+//    read in equal contiguous chunks and redistributed to the processors
+//    owning each atom, so that a simulation can be restarted on any number
+//    of processors. Global atom ids are lattice site ids, which are
+//    identical for any decomposition of the system.
+//
+//    File layout (native byte order):
+//
+//       header                     checkpoint::header_size bytes
+//       generator state            checkpoint::mt_record_size bytes per processor
+//       atom records               checkpoint::atom_record_size bytes per atom
+//
+//    Per-processor files vampireN.chk written by older versions can still be
+//    loaded on the same number of processors.
+//
+//-----------------------------------------------------------------------------
 
 // System headers
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <stdint.h>
+#include <vector>
 
 // Program headers
 #include "atoms.hpp"
+#include "create.hpp"
 #include "errors.hpp"
+#include "material.hpp"
 #include "random.hpp"
 #include "sim.hpp"
 #include "vio.hpp"
+#include "vmpi.hpp"
 #include "program.hpp"
 
-//-----------------------------------------------------------------------------
-// Function to save checkpoint file
-//-----------------------------------------------------------------------------
-void save_checkpoint(){
+namespace checkpoint{
 
-   // convert number of atoms, rank and time to standard long int
-   uint64_t natoms64 = uint64_t(atoms::num_atoms-vmpi::num_halo_atoms);
-   int64_t time64 = int64_t(sim::time);
-   int64_t eqtime64 = int64_t(sim::equilibration_time);
-   int64_t parity64 = int64_t(sim::parity);
-   int64_t iH64 = int64_t(sim::iH);
-   int64_t output_atoms_file_counter64 = int64_t(sim::output_atoms_file_counter);
+   const uint32_t version = 2;
+   const int header_size = 4096;
+   const int mt_state_size = 624; // 624 is hard coded in mt implementation
+   const int mt_record_size = sizeof(int32_t)+mt_state_size*sizeof(uint32_t);
+   const int atom_record_size = sizeof(uint64_t)+3*sizeof(double);
 
-   // determine checkpoint file name
-   std::stringstream chkfilenamess;
-   chkfilenamess << "vampire" << vmpi::my_rank << ".chk";
-   std::string chkfilename = chkfilenamess.str();
+   // location of header variables in file
+   namespace offset{
+      const int magic = 0;
+      const int version = 8;
+      const int header_size = 12;
+      const int num_atoms = 16;
+      const int num_processors = 24;
+      const int time = 32;
+      const int equilibration_time = 40;
+      const int parity = 48;
+      const int iH = 56;
+      const int output_atoms_file_counter = 64;
+      const int thermal_seed = 72;
+      const int thermal_step = 80;
+      const int checksum = 88;
+      const int physical_time = 96;
+   }
 
-   // open checkpoint file
-   std::ofstream chkfile;
-   chkfile.open(chkfilename.c_str(),std::ios::binary);
+   template <typename T> void pack(std::vector<char>& buffer, const size_t index, const T value){
+      memcpy(&buffer[index], &value, sizeof(T));
+   }
 
-   // check for open file
-   if(!chkfile.is_open()){
+   template <typename T> T unpack(const std::vector<char>& buffer, const size_t index){
+      T value;
+      memcpy(&value, &buffer[index], sizeof(T));
+      return value;
+   }
+
+   //--------------------------------------------------------------------------
+   // Function to calculate checksum of atom records, independent of the order
+   // of records so that it is identical for any decomposition
+   //--------------------------------------------------------------------------
+   uint64_t checksum(const std::vector<char>& records){
+
+      uint64_t sum=0;
+      for(size_t r=0; r<records.size(); r+=atom_record_size){
+         // 64-bit FNV-1a hash of record
+         uint64_t hash=14695981039346656037ULL;
+         for(int b=0; b<atom_record_size; b++){
+            hash ^= uint64_t(static_cast<unsigned char>(records[r+b]));
+            hash *= 1099511628211ULL;
+         }
+         sum+=hash;
+      }
+
+      return sum;
+
+   }
+
+   //--------------------------------------------------------------------------
+   // Function to determine checkpoint file name, separate for each replica
+   //--------------------------------------------------------------------------
+   std::string filename(){
+      std::stringstream chkfilenamess;
+      chkfilenamess << "vampire";
+      if(vmpi::num_replicas>1) chkfilenamess << "-replica-" << vmpi::replica_id;
+      chkfilenamess << ".chk";
+      return chkfilenamess.str();
+   }
+
+   //--------------------------------------------------------------------------
+   // Function to sort atom records by global atom id
+   //--------------------------------------------------------------------------
+   struct record_index_t{
+      uint64_t id;
+      size_t index;
+      bool operator<(const record_index_t& other) const { return id<other.id; }
+   };
+
+   //--------------------------------------------------------------------------
+   // Function to look up spins of requested atoms in a list of atom records,
+   // returning false if an atom is not found
+   //--------------------------------------------------------------------------
+   bool find_spins(const std::vector<char>& records, const std::vector<uint64_t>& ids, std::vector<double>& spins){
+
+      const size_t num_records = records.size()/atom_record_size;
+      std::vector<record_index_t> sorted(num_records);
+      for(size_t r=0; r<num_records; r++){
+         sorted[r].id = unpack<uint64_t>(records, r*atom_record_size);
+         sorted[r].index = r;
+      }
+      std::sort(sorted.begin(), sorted.end());
+
+      spins.resize(3*ids.size());
+      for(size_t i=0; i<ids.size(); i++){
+         record_index_t key;
+         key.id = ids[i];
+         std::vector<record_index_t>::const_iterator it = std::lower_bound(sorted.begin(), sorted.end(), key);
+         if(it==sorted.end() || it->id!=ids[i]) return false;
+         const size_t start = it->index*atom_record_size+sizeof(uint64_t);
+         for(int c=0; c<3; c++) spins[3*i+c] = unpack<double>(records, start+c*sizeof(double));
+      }
+
+      return true;
+
+   }
+
+   //--------------------------------------------------------------------------
+   // Function to report fatal checkpoint error
+   //--------------------------------------------------------------------------
+   void error(const std::string& message){
       terminaltextcolor(RED);
-      std::cerr << "Error: Unable to open checkpoint file " << chkfilename << " for writing. Exiting." << std::endl;
+      std::cerr << "Error: " << message << " Exiting." << std::endl;
       terminaltextcolor(WHITE);
-      zlog << zTs() << "Error: Unable to open checkpoint file " << chkfilename << " for writing. Exiting." << std::endl;
+      zlog << zTs() << "Error: " << message << " Exiting." << std::endl;
       err::vexit();
    }
 
+} // end of namespace checkpoint
+
+//-----------------------------------------------------------------------------
+// Function to save checkpoint file
+//-----------------------------------------------------------------------------
+void save_checkpoint(){
+
+   using namespace checkpoint;
+
+   // number of atoms on local processor
+   const uint64_t natoms64 = uint64_t(atoms::num_atoms-vmpi::num_halo_atoms);
+
+   // determine total number of atoms and offset of local atom records
+   uint64_t total_atoms = natoms64;
+   #ifdef MPICF
+      uint64_t atom_offset = 0;
+      MPI_Allreduce(MPI_IN_PLACE, &total_atoms, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, vmpi::comm);
+      MPI_Exscan(&natoms64, &atom_offset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, vmpi::comm);
+      if(vmpi::my_rank==0) atom_offset=0;
+   #endif
+
    // get state of random number generator
-   std::vector<uint32_t> mt_state(624); // 624 is hard coded in mt implementation. uint64 assumes same size as unsigned long
-   int32_t mt_p=0; // position in rng state
-   mt_p=mtrandom::grnd.get_state(mt_state);
-
-   // write checkpoint variables to file
-   chkfile.write(reinterpret_cast<const char*>(&natoms64),sizeof(uint64_t));
-   chkfile.write(reinterpret_cast<const char*>(&time64),sizeof(int64_t));
-   chkfile.write(reinterpret_cast<const char*>(&eqtime64),sizeof(int64_t));
-   chkfile.write(reinterpret_cast<const char*>(&parity64),sizeof(int64_t));
-   chkfile.write(reinterpret_cast<const char*>(&iH64),sizeof(int64_t));
-   chkfile.write(reinterpret_cast<const char*>(&output_atoms_file_counter64),sizeof(int64_t));
-   chkfile.write(reinterpret_cast<const char*>(&mt_p),sizeof(int32_t));
-   chkfile.write(reinterpret_cast<const char*>(&mt_state[0]),sizeof(uint32_t)*mt_state.size());
-
-   // write spin array to file
-   chkfile.write(reinterpret_cast<const char*>(&atoms::x_spin_array[0]),sizeof(double)*natoms64);
-   chkfile.write(reinterpret_cast<const char*>(&atoms::y_spin_array[0]),sizeof(double)*natoms64);
-   chkfile.write(reinterpret_cast<const char*>(&atoms::z_spin_array[0]),sizeof(double)*natoms64);
+   std::vector<uint32_t> mt_state(mt_state_size);
+   int32_t mt_p=mtrandom::grnd.get_state(mt_state);
 
-   // close checkpoint file
-   chkfile.close();
+   std::vector<char> mt_record(mt_record_size);
+   pack<int32_t>(mt_record, 0, mt_p);
+   memcpy(&mt_record[sizeof(int32_t)], &mt_state[0], mt_state_size*sizeof(uint32_t));
+
+   // pack local atom records in generation order
+   std::vector<char> records(natoms64*atom_record_size);
+   for(uint64_t i=0; i<natoms64; i++){
+      const int atom = cs::sfc::output_order.empty() ? i : cs::sfc::output_order[i];
+      const size_t start = i*atom_record_size;
+      pack<uint64_t>(records, start, atoms::global_id_array[atom]);
+      pack<double>(records, start+8, atoms::x_spin_array[atom]);
+      pack<double>(records, start+16, atoms::y_spin_array[atom]);
+      pack<double>(records, start+24, atoms::z_spin_array[atom]);
+   }
+
+   uint64_t sum = checksum(records);
+   #ifdef MPICF
+      MPI_Allreduce(MPI_IN_PLACE, &sum, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, vmpi::comm);
+   #endif
+
+   // set header
+   std::vector<char> header(header_size,0);
+   memcpy(&header[offset::magic], "VAMPCHK2", 8);
+   pack<uint32_t>(header, offset::version, version);
+   pack<uint32_t>(header, offset::header_size, header_size);
+   pack<uint64_t>(header, offset::num_atoms, total_atoms);
+   pack<uint64_t>(header, offset::num_processors, vmpi::num_processors);
+   pack<int64_t>(header, offset::time, sim::time);
+   pack<int64_t>(header, offset::equilibration_time, sim::equilibration_time);
+   pack<int64_t>(header, offset::parity, sim::parity);
+   pack<int64_t>(header, offset::iH, sim::iH);
+   pack<int64_t>(header, offset::output_atoms_file_counter, sim::output_atoms_file_counter);
+   // counter-based thermal noise only needs seed and counter to be restored
+   pack<int64_t>(header, offset::thermal_seed, mtrandom::integration_seed);
+   pack<uint64_t>(header, offset::thermal_step, mtrandom::thermal_step);
+   pack<uint64_t>(header, offset::checksum, sum);
+   // physical time is stored as it differs from time*dt for adaptive integrators
+   pack<double>(header, offset::physical_time, sim::physical_time);
+
+   const std::string chkfilename = checkpoint::filename();
+   const uint64_t records_start = uint64_t(header_size) + uint64_t(vmpi::num_processors)*mt_record_size;
+
+   #ifdef MPICF
+
+      // write shared checkpoint file with collective I/O
+      MPI_File fh;
+      if(MPI_File_open(vmpi::comm, const_cast<char*>(chkfilename.c_str()), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh)!=MPI_SUCCESS){
+         checkpoint::error("Unable to open checkpoint file "+chkfilename+" for writing.");
+      }
+      MPI_File_set_size(fh, 0);
+
+      if(vmpi::my_rank==0) MPI_File_write_at(fh, 0, &header[0], header_size, MPI_BYTE, MPI_STATUS_IGNORE);
+      MPI_File_write_at_all(fh, MPI_Offset(header_size)+MPI_Offset(vmpi::my_rank)*mt_record_size, &mt_record[0], mt_record_size, MPI_BYTE, MPI_STATUS_IGNORE);
+      char* data = records.size()>0 ? &records[0] : NULL;
+      MPI_File_write_at_all(fh, MPI_Offset(records_start)+MPI_Offset(atom_offset)*atom_record_size, data, records.size(), MPI_BYTE, MPI_STATUS_IGNORE);
+
+      MPI_File_close(&fh);
+
+   #else
+
+      // open checkpoint file, which is written by the output thread
+      vout::async::binary_job_t* job = new vout::async::binary_job_t();
+      job->ofile.open(chkfilename.c_str(), std::ios::binary);
+      if(!job->ofile.is_open()) checkpoint::error("Unable to open checkpoint file "+chkfilename+" for writing.");
+      job->message = "Checkpoint file written to disk.";
+
+      vout::async::acquire_buffer(job->buffer, records_start+records.size());
+      std::copy(header.begin(), header.end(), job->buffer.begin());
+      std::copy(mt_record.begin(), mt_record.end(), job->buffer.begin()+header_size);
+      std::copy(records.begin(), records.end(), job->buffer.begin()+records_start);
+      vout::async::submit(job);
 
-   // log writing checkpoint file 
-   zlog << zTs() << "Checkpoint file written to disk." << std::endl;
+   #endif
+
+   // log writing checkpoint file, which is logged on completion by the output thread in serial
+   #ifdef MPICF
+      zlog << zTs() << "Checkpoint file written to disk." << std::endl;
+   #endif
 
    return;
 
 }
 
 //-----------------------------------------------------------------------------
-// Function to save checkpoint file
+// Function to load per-processor checkpoint files vampireN.chk written by
+// older versions, requiring an identical decomposition
 //-----------------------------------------------------------------------------
-void load_checkpoint(){
+void load_per_processor_checkpoint(){
 
    // convert number of atoms, rank and time to standard long int
    uint64_t natoms64;
@@ -99,6 +290,10 @@ void load_checkpoint(){
    std::vector<uint32_t> mt_state(624); // 624 is hard coded in mt implementation. uint64 assumes same size as unsigned long
    int32_t mt_p=0; // position in rng state
 
+   // variables for loading state of counter-based thermal noise
+   int64_t thermal_seed64;
+   uint64_t thermal_step64;
+
    // determine checkpoint file name
    std::stringstream chkfilenamess;
    chkfilenamess << "vampire" << vmpi::my_rank << ".chk";
@@ -128,9 +323,15 @@ void load_checkpoint(){
    chkfile.read((char*)&output_atoms_file_counter64,sizeof(int64_t));
    chkfile.read((char*)&mt_p,sizeof(int32_t));
    chkfile.read((char*)&mt_state[0],sizeof(uint32_t)*mt_state.size());
+   chkfile.read((char*)&thermal_seed64,sizeof(int64_t));
+   chkfile.read((char*)&thermal_step64,sizeof(uint64_t));
 
    // if continuing set state of rng
-   if(sim::load_checkpoint_continue_flag) mtrandom::grnd.set_state(mt_state, mt_p);
+   if(sim::load_checkpoint_continue_flag){
+      mtrandom::grnd.set_state(mt_state, mt_p);
+      mtrandom::integration_seed = int(thermal_seed64);
+      mtrandom::thermal_step = thermal_step64;
+   }
 
    // check for rational number of atoms
    if((atoms::num_atoms-vmpi::num_halo_atoms)!=natoms64){
@@ -148,6 +349,7 @@ void load_checkpoint(){
       sim::iH = iH64;
 //      sim::iH = int(iH64);
       sim::time = time64;
+      sim::physical_time = double(time64)*mp::dt_SI;
       sim::equilibration_time = eqtime64;
 //      sim::H = (double) sim::iH;
       sim::output_atoms_file_counter = output_atoms_file_counter64;
@@ -161,10 +363,243 @@ void load_checkpoint(){
    // close checkpoint file
    chkfile.close();
 
-   // log reading checkpoint file 
+   // spins are stored in generation order, so move to reordered atoms
+   if(!cs::sfc::output_order.empty()){
+      const std::vector<double> sx(atoms::x_spin_array.begin(), atoms::x_spin_array.begin()+natoms64);
+      const std::vector<double> sy(atoms::y_spin_array.begin(), atoms::y_spin_array.begin()+natoms64);
+      const std::vector<double> sz(atoms::z_spin_array.begin(), atoms::z_spin_array.begin()+natoms64);
+      for(uint64_t i=0; i<natoms64; i++){
+         const int atom = cs::sfc::output_order[i];
+         atoms::x_spin_array[atom] = sx[i];
+         atoms::y_spin_array[atom] = sy[i];
+         atoms::z_spin_array[atom] = sz[i];
+      }
+   }
+
+   // log reading checkpoint file
    zlog << zTs() << "Checkpoint file loaded at sim::time " << sim::time << "." << std::endl;
 
    return;
 
 }
 
+//-----------------------------------------------------------------------------
+// Function to load checkpoint file
+//-----------------------------------------------------------------------------
+void load_checkpoint(){
+
+   using namespace checkpoint;
+
+   const std::string chkfilename = checkpoint::filename();
+
+   // number of atoms on local processor
+   const uint64_t natoms64 = uint64_t(atoms::num_atoms-vmpi::num_halo_atoms);
+   uint64_t total_atoms = natoms64;
+   #ifdef MPICF
+      MPI_Allreduce(MPI_IN_PLACE, &total_atoms, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, vmpi::comm);
+   #endif
+
+   std::vector<char> header(header_size,0);
+   std::vector<char> mt_record(mt_record_size);
+   std::vector<char> records;
+
+   //--------------------------------------------------------------------------
+   // Read header, generator state and an equal chunk of atom records
+   //--------------------------------------------------------------------------
+   #ifdef MPICF
+
+      MPI_File fh;
+      if(MPI_File_open(vmpi::comm, const_cast<char*>(chkfilename.c_str()), MPI_MODE_RDONLY, MPI_INFO_NULL, &fh)!=MPI_SUCCESS){
+         load_per_processor_checkpoint();
+         return;
+      }
+      MPI_File_read_at_all(fh, 0, &header[0], header_size, MPI_BYTE, MPI_STATUS_IGNORE);
+
+   #else
+
+      std::ifstream chkfile(chkfilename.c_str(), std::ios::binary);
+      if(!chkfile.is_open()){
+         load_per_processor_checkpoint();
+         return;
+      }
+      chkfile.read(&header[0], header_size);
+
+   #endif
+
+   if(std::string(&header[offset::magic],8)!="VAMPCHK2" || unpack<uint32_t>(header, offset::version)!=version){
+      checkpoint::error("File "+chkfilename+" is not a valid vampire checkpoint file.");
+   }
+
+   const uint64_t file_atoms = unpack<uint64_t>(header, offset::num_atoms);
+   const uint64_t file_processors = unpack<uint64_t>(header, offset::num_processors);
+   const uint64_t records_start = uint64_t(unpack<uint32_t>(header, offset::header_size)) + file_processors*mt_record_size;
+
+   if(file_atoms!=total_atoms){
+      std::stringstream message;
+      message << "Mismatch between number of atoms in checkpoint file (" << file_atoms << ") and number of generated atoms (" << total_atoms << ").";
+      checkpoint::error(message.str());
+   }
+
+   // generator state is only restored for an identical number of processors
+   const bool restore_mt_state = (file_processors==uint64_t(vmpi::num_processors));
+
+   // first and last record read by local processor
+   const uint64_t first = (file_atoms*uint64_t(vmpi::my_rank))/uint64_t(vmpi::num_processors);
+   const uint64_t last = (file_atoms*uint64_t(vmpi::my_rank+1))/uint64_t(vmpi::num_processors);
+   records.resize((last-first)*atom_record_size);
+
+   #ifdef MPICF
+
+      if(restore_mt_state){
+         MPI_File_read_at_all(fh, MPI_Offset(unpack<uint32_t>(header, offset::header_size))+MPI_Offset(vmpi::my_rank)*mt_record_size, &mt_record[0], mt_record_size, MPI_BYTE, MPI_STATUS_IGNORE);
+      }
+      char* data = records.size()>0 ? &records[0] : NULL;
+      MPI_File_read_at_all(fh, MPI_Offset(records_start)+MPI_Offset(first)*atom_record_size, data, records.size(), MPI_BYTE, MPI_STATUS_IGNORE);
+      MPI_File_close(&fh);
+
+   #else
+
+      if(restore_mt_state){
+         chkfile.seekg(unpack<uint32_t>(header, offset::header_size));
+         chkfile.read(&mt_record[0], mt_record_size);
+      }
+      chkfile.seekg(records_start);
+      if(records.size()>0) chkfile.read(&records[0], records.size());
+      if(!chkfile.good()) checkpoint::error("Checkpoint file "+chkfilename+" is truncated.");
+      chkfile.close();
+
+   #endif
+
+   // check data integrity
+   uint64_t sum = checksum(records);
+   #ifdef MPICF
+      MPI_Allreduce(MPI_IN_PLACE, &sum, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, vmpi::comm);
+   #endif
+   if(sum!=unpack<uint64_t>(header, offset::checksum)) checkpoint::error("Checksum of checkpoint file "+chkfilename+" is incorrect, file is corrupted.");
+
+   //--------------------------------------------------------------------------
+   // Find spins of local atoms from atom records
+   //--------------------------------------------------------------------------
+   std::vector<uint64_t> local_ids(atoms::global_id_array.begin(), atoms::global_id_array.begin()+natoms64);
+   std::vector<double> spins;
+   bool found=true;
+
+   #ifdef MPICF
+
+      // Records and requests for each atom are sent to a directory
+      // processor determined by its global id, which returns the spins
+      const int num_processors = vmpi::num_processors;
+
+      // send records to directory processors
+      std::vector<int> send_counts(num_processors,0);
+      std::vector<int> recv_counts(num_processors,0);
+      const size_t num_records = records.size()/atom_record_size;
+      for(size_t r=0; r<num_records; r++) send_counts[unpack<uint64_t>(records, r*atom_record_size)%num_processors]+=atom_record_size;
+
+      std::vector<int> send_displ(num_processors,0);
+      std::vector<int> recv_displ(num_processors,0);
+      for(int p=1; p<num_processors; p++) send_displ[p]=send_displ[p-1]+send_counts[p-1];
+
+      std::vector<char> send_records(records.size());
+      std::vector<int> position(send_displ);
+      for(size_t r=0; r<num_records; r++){
+         const int p = unpack<uint64_t>(records, r*atom_record_size)%num_processors;
+         std::copy(records.begin()+r*atom_record_size, records.begin()+(r+1)*atom_record_size, send_records.begin()+position[p]);
+         position[p]+=atom_record_size;
+      }
+
+      MPI_Alltoall(&send_counts[0], 1, MPI_INT, &recv_counts[0], 1, MPI_INT, vmpi::comm);
+      for(int p=1; p<num_processors; p++) recv_displ[p]=recv_displ[p-1]+recv_counts[p-1];
+      std::vector<char> directory(recv_displ[num_processors-1]+recv_counts[num_processors-1]);
+      MPI_Alltoallv(send_records.size()>0 ? &send_records[0] : NULL, &send_counts[0], &send_displ[0], MPI_BYTE,
+                    directory.size()>0 ? &directory[0] : NULL, &recv_counts[0], &recv_displ[0], MPI_BYTE, vmpi::comm);
+      std::vector<char>().swap(records);
+      std::vector<char>().swap(send_records);
+
+      // send ids of local atoms to directory processors, remembering order
+      std::fill(send_counts.begin(), send_counts.end(), 0);
+      for(uint64_t atom=0; atom<natoms64; atom++) send_counts[local_ids[atom]%num_processors]++;
+      send_displ[0]=0;
+      for(int p=1; p<num_processors; p++) send_displ[p]=send_displ[p-1]+send_counts[p-1];
+
+      std::vector<uint64_t> send_ids(natoms64);
+      std::vector<uint64_t> request_order(natoms64);
+      position=send_displ;
+      for(uint64_t atom=0; atom<natoms64; atom++){
+         const int p = local_ids[atom]%num_processors;
+         send_ids[position[p]]=local_ids[atom];
+         request_order[position[p]]=atom;
+         position[p]++;
+      }
+
+      MPI_Alltoall(&send_counts[0], 1, MPI_INT, &recv_counts[0], 1, MPI_INT, vmpi::comm);
+      recv_displ[0]=0;
+      for(int p=1; p<num_processors; p++) recv_displ[p]=recv_displ[p-1]+recv_counts[p-1];
+      std::vector<uint64_t> requested_ids(recv_displ[num_processors-1]+recv_counts[num_processors-1]);
+      MPI_Alltoallv(send_ids.size()>0 ? &send_ids[0] : NULL, &send_counts[0], &send_displ[0], MPI_UNSIGNED_LONG_LONG,
+                    requested_ids.size()>0 ? &requested_ids[0] : NULL, &recv_counts[0], &recv_displ[0], MPI_UNSIGNED_LONG_LONG, vmpi::comm);
+
+      // look up requested spins and return them
+      std::vector<double> requested_spins;
+      found = find_spins(directory, requested_ids, requested_spins);
+
+      for(int p=0; p<num_processors; p++){
+         send_counts[p]*=3; send_displ[p]*=3;
+         recv_counts[p]*=3; recv_displ[p]*=3;
+      }
+      std::vector<double> received_spins(3*natoms64);
+      MPI_Alltoallv(requested_spins.size()>0 ? &requested_spins[0] : NULL, &recv_counts[0], &recv_displ[0], MPI_DOUBLE,
+                    received_spins.size()>0 ? &received_spins[0] : NULL, &send_counts[0], &send_displ[0], MPI_DOUBLE, vmpi::comm);
+
+      spins.resize(3*natoms64);
+      for(uint64_t i=0; i<natoms64; i++){
+         for(int c=0; c<3; c++) spins[3*request_order[i]+c] = received_spins[3*i+c];
+      }
+
+      int all_found = found;
+      MPI_Allreduce(MPI_IN_PLACE, &all_found, 1, MPI_INT, MPI_MIN, vmpi::comm);
+      found = all_found;
+
+   #else
+
+      found = find_spins(records, local_ids, spins);
+
+   #endif
+
+   if(!found) checkpoint::error("Atoms in checkpoint file "+chkfilename+" do not match generated system.");
+
+   for(uint64_t atom=0; atom<natoms64; atom++){
+      atoms::x_spin_array[atom] = spins[3*atom+0];
+      atoms::y_spin_array[atom] = spins[3*atom+1];
+      atoms::z_spin_array[atom] = spins[3*atom+2];
+   }
+
+   // Load saved time and generator state if simulation continuing
+   if(sim::load_checkpoint_continue_flag){
+      sim::parity = unpack<int64_t>(header, offset::parity);
+      sim::iH = unpack<int64_t>(header, offset::iH);
+      sim::time = unpack<int64_t>(header, offset::time);
+      sim::physical_time = unpack<double>(header, offset::physical_time);
+      // files written before physical time was stored have zero in its place
+      if(sim::physical_time==0.0) sim::physical_time = double(sim::time)*mp::dt_SI;
+      sim::equilibration_time = unpack<int64_t>(header, offset::equilibration_time);
+      sim::output_atoms_file_counter = unpack<int64_t>(header, offset::output_atoms_file_counter);
+      mtrandom::integration_seed = int(unpack<int64_t>(header, offset::thermal_seed));
+      mtrandom::thermal_step = unpack<uint64_t>(header, offset::thermal_step);
+      if(restore_mt_state){
+         std::vector<uint32_t> mt_state(mt_state_size);
+         memcpy(&mt_state[0], &mt_record[sizeof(int32_t)], mt_state_size*sizeof(uint32_t));
+         int32_t mt_p = unpack<int32_t>(mt_record, 0);
+         mtrandom::grnd.set_state(mt_state, mt_p);
+      }
+      else{
+         zlog << zTs() << "Checkpoint file written by " << file_processors << " processors, random number generator state not restored." << std::endl;
+      }
+   }
+
+   // log reading checkpoint file
+   zlog << zTs() << "Checkpoint file " << chkfilename << " loaded at sim::time " << sim::time << "." << std::endl;
+
+   return;
+
+}
@@ -63,6 +63,9 @@ namespace err
         terminaltextcolor(WHITE);
       }
 
+      // Complete any queued asynchronous output
+      vout::async::finalise();
+
       // Abort MPI processes for parallel execution
       #ifdef MPICF
       terminaltextcolor(RED);
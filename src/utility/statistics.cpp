@@ -166,7 +166,7 @@ int mag_m(){
 
       // Calculate global moment for all CPUs
       #ifdef MPICF
-         MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&stats::max_moment,1,MPI_DOUBLE,MPI_SUM);
+         vmpi::comm.Allreduce(MPI_IN_PLACE,&stats::max_moment,1,MPI_DOUBLE,MPI_SUM);
       #endif
 
       // Resize arrays
@@ -295,7 +295,7 @@ double max_torque(){
 
    // find max torque on all nodes
    #ifdef MPICF
-      MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&max_torque,1,MPI_DOUBLE,MPI_MAX);
+      vmpi::comm.Allreduce(MPI_IN_PLACE,&max_torque,1,MPI_DOUBLE,MPI_MAX);
    #endif
 
   return max_torque;
@@ -323,7 +323,7 @@ void system_torque(){
 
 		// get atomic moment
 		const int imat=atoms::type_array[atom];
-		const double mu = mp::material[imat].mu_s_SI;
+		const double mu = mp::material_hot_params[imat].mu_s_SI;
 		
 		// Store local spin in Sand local field in H
 		const double S[3] = {atoms::x_spin_array[atom]*mu,atoms::y_spin_array[atom]*mu,atoms::z_spin_array[atom]*mu};
@@ -342,10 +342,10 @@ void system_torque(){
 
 	// reduce torque on all nodes
 	#ifdef MPICF
-		MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&torque[0],3,MPI_DOUBLE,MPI_SUM);
-		MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&stats::sublattice_mean_torque_x_array[0],mp::num_materials,MPI_DOUBLE,MPI_SUM);
-		MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&stats::sublattice_mean_torque_y_array[0],mp::num_materials,MPI_DOUBLE,MPI_SUM);
-		MPI::COMM_WORLD.Allreduce(MPI_IN_PLACE,&stats::sublattice_mean_torque_z_array[0],mp::num_materials,MPI_DOUBLE,MPI_SUM);
+		vmpi::comm.Allreduce(MPI_IN_PLACE,&torque[0],3,MPI_DOUBLE,MPI_SUM);
+		vmpi::comm.Allreduce(MPI_IN_PLACE,&stats::sublattice_mean_torque_x_array[0],mp::num_materials,MPI_DOUBLE,MPI_SUM);
+		vmpi::comm.Allreduce(MPI_IN_PLACE,&stats::sublattice_mean_torque_y_array[0],mp::num_materials,MPI_DOUBLE,MPI_SUM);
+		vmpi::comm.Allreduce(MPI_IN_PLACE,&stats::sublattice_mean_torque_z_array[0],mp::num_materials,MPI_DOUBLE,MPI_SUM);
 	#endif
 
 	// Set stats values
@@ -392,7 +392,7 @@ void system_energy(){
          double Sy=atoms::y_spin_array[atom];
          double Sz=atoms::z_spin_array[atom];
          const int imaterial=atoms::type_array[atom];
-         energy+=sim::spin_exchange_energy_isotropic(atom, Sx, Sy, Sz)*mp::material[imaterial].mu_s_SI;
+         energy+=sim::spin_exchange_energy_isotropic(atom, Sx, Sy, Sz)*mp::material_hot_params[imaterial].mu_s_SI;
       }
       stats::total_exchange_energy=energy;
    }
@@ -403,7 +403,7 @@ void system_energy(){
          double Sy=atoms::y_spin_array[atom];
          double Sz=atoms::z_spin_array[atom];
          const int imaterial=atoms::type_array[atom];
-         energy+=sim::spin_exchange_energy_vector(atom, Sx, Sy, Sz)*mp::material[imaterial].mu_s_SI;
+         energy+=sim::spin_exchange_energy_vector(atom, Sx, Sy, Sz)*mp::material_hot_params[imaterial].mu_s_SI;
       }
       stats::total_exchange_energy=energy;
    }
@@ -414,7 +414,7 @@ void system_energy(){
          double Sy=atoms::y_spin_array[atom];
          double Sz=atoms::z_spin_array[atom];
          const int imaterial=atoms::type_array[atom];
-         energy+=sim::spin_exchange_energy_tensor(atom, Sx, Sy, Sz)*mp::material[imaterial].mu_s_SI;
+         energy+=sim::spin_exchange_energy_tensor(atom, Sx, Sy, Sz)*mp::material_hot_params[imaterial].mu_s_SI;
       }
       stats::total_exchange_energy=energy;
    }
@@ -426,7 +426,7 @@ void system_energy(){
       for(int atom=0; atom<stats::num_atoms; atom++){
          const double Sz=atoms::z_spin_array[atom];
          const int imaterial=atoms::type_array[atom];
-         energy+=sim::spin_scalar_anisotropy_energy(imaterial, Sz)*mp::material[imaterial].mu_s_SI;
+         energy+=sim::spin_scalar_anisotropy_energy(imaterial, Sz)*mp::material_hot_params[imaterial].mu_s_SI;
       }
       stats::total_anisotropy_energy=energy;
    }
@@ -437,7 +437,7 @@ void system_energy(){
          const double Sy=atoms::y_spin_array[atom];
          const double Sz=atoms::z_spin_array[atom];
          const int imaterial=atoms::type_array[atom];
-         energy+=sim::spin_tensor_anisotropy_energy(imaterial, Sx, Sy, Sz)*mp::material[imaterial].mu_s_SI;
+         energy+=sim::spin_tensor_anisotropy_energy(imaterial, Sx, Sy, Sz)*mp::material_hot_params[imaterial].mu_s_SI;
       }
       stats::total_anisotropy_energy=energy;
    }
@@ -451,7 +451,7 @@ void system_energy(){
          const double Sy=atoms::y_spin_array[atom];
          const double Sz=atoms::z_spin_array[atom];
          const int imaterial=atoms::type_array[atom];
-         energy+=sim::spin_cubic_anisotropy_energy(imaterial, Sx, Sy, Sz)*mp::material[imaterial].mu_s_SI;
+         energy+=sim::spin_cubic_anisotropy_energy(imaterial, Sx, Sy, Sz)*mp::material_hot_params[imaterial].mu_s_SI;
       }
       stats::total_cubic_anisotropy_energy=energy;
    }
@@ -462,7 +462,7 @@ void system_energy(){
          const double Sy=atoms::y_spin_array[atom];
          const double Sz=atoms::z_spin_array[atom];
          const int imaterial=atoms::type_array[atom];
-         energy+=sim::spin_second_order_uniaxial_anisotropy_energy(imaterial, Sx, Sy, Sz)*mp::material[imaterial].mu_s_SI;
+         energy+=sim::spin_second_order_uniaxial_anisotropy_energy(imaterial, Sx, Sy, Sz)*mp::material_hot_params[imaterial].mu_s_SI;
       }
       stats::total_so_anisotropy_energy=energy;
    }
@@ -473,7 +473,7 @@ void system_energy(){
          const double Sy=atoms::y_spin_array[atom];
          const double Sz=atoms::z_spin_array[atom];
          const int imaterial=atoms::type_array[atom];
-         energy+=sim::spin_lattice_anisotropy_energy(imaterial, Sx, Sy, Sz)*mp::material[imaterial].mu_s_SI;
+         energy+=sim::spin_lattice_anisotropy_energy(imaterial, Sx, Sy, Sz)*mp::material_hot_params[imaterial].mu_s_SI;
       }
       stats::total_lattice_anisotropy_energy=energy;
    }
@@ -484,7 +484,7 @@ void system_energy(){
          const double Sy=atoms::y_spin_array[atom];
          const double Sz=atoms::z_spin_array[atom];
          const int imaterial=atoms::type_array[atom];
-         energy+=sim::spin_surface_anisotropy_energy(atom, imaterial, Sx, Sy, Sz)*mp::material[imaterial].mu_s_SI;
+         energy+=sim::spin_surface_anisotropy_energy(atom, imaterial, Sx, Sy, Sz)*mp::material_hot_params[imaterial].mu_s_SI;
       }
       stats::total_surface_anisotropy_energy=energy;
    }
@@ -495,7 +495,7 @@ void system_energy(){
          const double Sy=atoms::y_spin_array[atom];
          const double Sz=atoms::z_spin_array[atom];
          const int imaterial=atoms::type_array[atom];
-         energy+=sim::spin_applied_field_energy(Sx, Sy, Sz)*mp::material[imaterial].mu_s_SI;
+         energy+=sim::spin_applied_field_energy(Sx, Sy, Sz)*mp::material_hot_params[imaterial].mu_s_SI;
       }
       stats::total_applied_field_energy=energy;
    }
@@ -506,7 +506,7 @@ void system_energy(){
          const double Sy=atoms::y_spin_array[atom];
          const double Sz=atoms::z_spin_array[atom];
          const int imaterial=atoms::type_array[atom];
-         energy+=sim::spin_magnetostatic_energy(atom, Sx, Sy, Sz)*mp::material[imaterial].mu_s_SI;
+         energy+=sim::spin_magnetostatic_energy(atom, Sx, Sy, Sz)*mp::material_hot_params[imaterial].mu_s_SI;
       }
       stats::total_magnetostatic_energy=energy;
    }
@@ -526,26 +526,26 @@ void system_energy(){
       // MPI_IN_PLACE is only valid on root process for MPI_Reduce()
       // MPI_Reduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm)
       if(vmpi::my_rank==0){
-         MPI_Reduce(MPI_IN_PLACE, &stats::total_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(MPI_IN_PLACE, &stats::total_exchange_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(MPI_IN_PLACE, &stats::total_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(MPI_IN_PLACE, &stats::total_so_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(MPI_IN_PLACE, &stats::total_lattice_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(MPI_IN_PLACE, &stats::total_cubic_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(MPI_IN_PLACE, &stats::total_surface_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(MPI_IN_PLACE, &stats::total_applied_field_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(MPI_IN_PLACE, &stats::total_magnetostatic_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+         MPI_Reduce(MPI_IN_PLACE, &stats::total_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(MPI_IN_PLACE, &stats::total_exchange_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(MPI_IN_PLACE, &stats::total_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(MPI_IN_PLACE, &stats::total_so_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(MPI_IN_PLACE, &stats::total_lattice_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(MPI_IN_PLACE, &stats::total_cubic_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(MPI_IN_PLACE, &stats::total_surface_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(MPI_IN_PLACE, &stats::total_applied_field_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(MPI_IN_PLACE, &stats::total_magnetostatic_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
       }
       else{
-         MPI_Reduce(&stats::total_energy, &stats::total_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(&stats::total_exchange_energy, &stats::total_exchange_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(&stats::total_anisotropy_energy, &stats::total_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(&stats::total_so_anisotropy_energy, &stats::total_so_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(&stats::total_lattice_anisotropy_energy, &stats::total_lattice_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(&stats::total_cubic_anisotropy_energy, &stats::total_cubic_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(&stats::total_surface_anisotropy_energy, &stats::total_surface_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(&stats::total_applied_field_energy, &stats::total_applied_field_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
-         MPI_Reduce(&stats::total_magnetostatic_energy, &stats::total_magnetostatic_energy, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);         
+         MPI_Reduce(&stats::total_energy, &stats::total_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(&stats::total_exchange_energy, &stats::total_exchange_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(&stats::total_anisotropy_energy, &stats::total_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(&stats::total_so_anisotropy_energy, &stats::total_so_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(&stats::total_lattice_anisotropy_energy, &stats::total_lattice_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(&stats::total_cubic_anisotropy_energy, &stats::total_cubic_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(&stats::total_surface_anisotropy_energy, &stats::total_surface_anisotropy_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(&stats::total_applied_field_energy, &stats::total_applied_field_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);
+         MPI_Reduce(&stats::total_magnetostatic_energy, &stats::total_magnetostatic_energy, 1, MPI_DOUBLE, MPI_SUM, 0, vmpi::comm);         
       }
    #endif
 
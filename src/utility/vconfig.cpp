@@ -41,19 +41,24 @@
 ///
 
 // Standard Libraries
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <stdint.h>
 #include <string>
+#include <vector>
 
 
 // Vampire Header files
 #include "atoms.hpp"
 #include "cells.hpp"
+#include "create.hpp"
 #include "errors.hpp"
 #include "LLG.hpp"
 #include "material.hpp"
@@ -79,6 +84,9 @@ namespace vout{
    int total_output_atoms=0;
    std::vector<int> local_output_atom_list(0);
 
+   int atoms_output_format=0; // 0 = text, 1 = binary double, 2 = binary float, 3 = binary 16-bit
+   uint64_t local_output_atom_offset=0; // index of first local atom in binary snapshot files
+
    bool output_cells_config=false;
    int output_cells_config_rate=1000;
    int output_cells_file_counter=0;
@@ -90,9 +98,48 @@ namespace vout{
    // function headers
    void atoms();
    void atoms_coords();
+   void atoms_binary();
+   void atoms_coords_binary();
    void cells();
    void cells_coords();
 
+   //-----------------------------------------------------------------------------
+   // Output job to write a header and values formatted as tab separated lines
+   // of a fixed number of columns to a text configuration file. The file is
+   // opened on construction, before submission.
+   //-----------------------------------------------------------------------------
+   class text_output_job_t : public async::job_t{
+   public:
+      std::ofstream ofile;
+      std::string header;
+      int columns;
+
+      text_output_job_t(const std::string& filename, const std::string& in_header, const int in_columns):
+         ofile(filename.c_str()), header(in_header), columns(in_columns){
+
+         if(!ofile.is_open()){
+            terminaltextcolor(RED);
+            std::cerr << "Error: Unable to open configuration file " << filename << " for writing. Exiting." << std::endl;
+            terminaltextcolor(WHITE);
+            zlog << zTs() << "Error: Unable to open configuration file " << filename << " for writing. Exiting." << std::endl;
+            err::vexit();
+         }
+
+      }
+
+      void write(){
+         ofile << header;
+         const int num_values = buffer.size()/sizeof(double);
+         const double* values = reinterpret_cast<const double*>(num_values>0 ? &buffer[0] : NULL);
+         for(int i=0; i<num_values; i+=columns){
+            ofile << values[i];
+            for(int j=1; j<columns; j++) ofile << "\t" << values[i+j];
+            ofile << "\n";
+         }
+         ofile.close();
+      }
+   };
+
 /// @brief Config master output function
 ///
 /// @section License
@@ -208,11 +255,11 @@ void config(){
       // check calling of routine if error checking is activated
       if(err::check==true){std::cout << "vout::atoms has been called" << std::endl;}
 
-      #ifdef MPICF
-         const int num_atoms = vmpi::num_core_atoms+vmpi::num_bdry_atoms;
-      #else
-         const int num_atoms = atoms::num_atoms;
-      #endif
+      // optionally output binary snapshot
+      if(vout::atoms_output_format!=0){
+         vout::atoms_binary();
+         return;
+      }
 
       // Set local output filename
       std::stringstream file_sstr;
@@ -224,55 +271,58 @@ void config(){
       file_sstr << std::setfill('0') << std::setw(8) << sim::output_atoms_file_counter;
       file_sstr << ".cfg";
       std::string cfg_file = file_sstr.str();
-      const char* cfg_filec = cfg_file.c_str();
 
       // Output informative message to log file
       zlog << zTs() << "Outputting configuration file " << cfg_file << " to disk" << std::endl;
 
-      // Declare and open output file
-      std::ofstream cfg_file_ofstr;
-      cfg_file_ofstr.open (cfg_filec);
-
-      // Output masterfile header on root process
+      // Format masterfile header on root process, which is written with the spins by the output thread
+      std::stringstream header;
       if(vmpi::my_rank==0){
          // Get system date
       time_t rawtime = time(NULL);
       struct tm * timeinfo = localtime(&rawtime);
 
-         cfg_file_ofstr << "#------------------------------------------------------"<< std::endl;
-         cfg_file_ofstr << "# Atomistic spin configuration file for vampire"<< std::endl;
-         cfg_file_ofstr << "#------------------------------------------------------"<< std::endl;
-         cfg_file_ofstr << "# Date: "<< asctime(timeinfo);
-         cfg_file_ofstr << "#------------------------------------------------------"<< std::endl;
-         cfg_file_ofstr << "Number of spins: "<< vout::total_output_atoms << std::endl;
-         cfg_file_ofstr << "System dimensions:" << cs::system_dimensions[0] << "\t" << cs::system_dimensions[1] << "\t" << cs::system_dimensions[2] << std::endl;
-         cfg_file_ofstr << "Coordinates-file: atoms-coord.cfg"<< std::endl;
-         cfg_file_ofstr << "Time: " << double(sim::time)*mp::dt_SI << std::endl;
-         cfg_file_ofstr << "Field: " << sim::H_applied << std::endl;
-         cfg_file_ofstr << "Temperature: "<< sim::temperature << std::endl;
-         cfg_file_ofstr << "Magnetisation: " << stats::system_magnetization.output_normalized_magnetization() << std::endl;
-         cfg_file_ofstr << "Number of Materials: " << mp::num_materials << std::endl;
+         header << "#------------------------------------------------------"<< std::endl;
+         header << "# Atomistic spin configuration file for vampire"<< std::endl;
+         header << "#------------------------------------------------------"<< std::endl;
+         header << "# Date: "<< asctime(timeinfo);
+         header << "#------------------------------------------------------"<< std::endl;
+         header << "Number of spins: "<< vout::total_output_atoms << std::endl;
+         header << "System dimensions:" << cs::system_dimensions[0] << "\t" << cs::system_dimensions[1] << "\t" << cs::system_dimensions[2] << std::endl;
+         header << "Coordinates-file: atoms-coord.cfg"<< std::endl;
+         header << "Time: " << sim::physical_time << std::endl;
+         header << "Field: " << sim::H_applied << std::endl;
+         header << "Temperature: "<< sim::temperature << std::endl;
+         header << "Magnetisation: " << stats::system_magnetization.output_normalized_magnetization() << std::endl;
+         header << "Number of Materials: " << mp::num_materials << std::endl;
          for(int mat=0;mat<mp::num_materials;mat++){
-            cfg_file_ofstr << mp::material[mat].mu_s_SI << std::endl;
+            header << mp::material[mat].mu_s_SI << std::endl;
          }
-         cfg_file_ofstr << "#------------------------------------------------------" << std::endl;
-         cfg_file_ofstr << "Number of spin files: " << vmpi::num_processors-1 << std::endl;
+         header << "#------------------------------------------------------" << std::endl;
+         header << "Number of spin files: " << vmpi::num_processors-1 << std::endl;
          for(int p=1;p<vmpi::num_processors;p++){
             std::stringstream cfg_sstr;
             cfg_sstr << "atoms-" << std::setfill('0') << std::setw(5) << p << "-" << std::setfill('0') << std::setw(8) << sim::output_atoms_file_counter << ".cfg";
-            cfg_file_ofstr << cfg_sstr.str() << std::endl;
+            header << cfg_sstr.str() << std::endl;
          }
-         cfg_file_ofstr << "#------------------------------------------------------"<< std::endl;
+         header << "#------------------------------------------------------"<< std::endl;
       }
 
       // Everyone now outputs their atom list
-      cfg_file_ofstr << vout::local_output_atom_list.size() << std::endl;
-      for(int i=0; i<vout::local_output_atom_list.size(); i++){
+      header << vout::local_output_atom_list.size() << std::endl;
+
+      // Copy spins of output atoms for formatting by output thread
+      const int num_output_atoms = vout::local_output_atom_list.size();
+      text_output_job_t* job = new text_output_job_t(cfg_file, header.str(), 3);
+      async::acquire_buffer(job->buffer, 3*num_output_atoms*sizeof(double));
+      double* spins = reinterpret_cast<double*>(num_output_atoms>0 ? &job->buffer[0] : NULL);
+      for(int i=0; i<num_output_atoms; i++){
          const int atom = vout::local_output_atom_list[i];
-         cfg_file_ofstr << atoms::x_spin_array[atom] << "\t" << atoms::y_spin_array[atom] << "\t" << atoms::z_spin_array[atom] << std::endl;
+         spins[3*i+0] = atoms::x_spin_array[atom];
+         spins[3*i+1] = atoms::y_spin_array[atom];
+         spins[3*i+2] = atoms::z_spin_array[atom];
       }
-
-      cfg_file_ofstr.close();
+      async::submit(job);
 
       sim::output_atoms_file_counter++;
 
@@ -336,9 +386,10 @@ void config(){
                      vout::atoms_output_max[1]*cs::system_dimensions[1],
                      vout::atoms_output_max[2]*cs::system_dimensions[2]};
 
-      // loop over all local atoms and record output list
-      for(int atom=0;atom<num_atoms;atom++){
+      // loop over all local atoms in generation order and record output list
+      for(int i=0;i<num_atoms;i++){
 
+         const int atom = cs::sfc::output_order.empty() ? i : cs::sfc::output_order[i];
          const double cc[3] = {atoms::x_coord_array[atom],atoms::y_coord_array[atom],atoms::z_coord_array[atom]};
 
          // check atom within output bounds
@@ -357,7 +408,7 @@ void config(){
          int total_atoms;
          //std::cerr << vmpi::my_rank << "\t" << local_atoms << &local_atoms << "\t" << &total_atoms << std::endl;
          //MPI::COMM_WORLD.Barrier();
-         MPI::COMM_WORLD.Allreduce(&local_atoms, &total_atoms,1, MPI_INT,MPI_SUM);
+         vmpi::comm.Allreduce(&local_atoms, &total_atoms,1, MPI_INT,MPI_SUM);
          vout::total_output_atoms=total_atoms;
          //std::cerr << vmpi::my_rank << "\t" << total_atoms << "\t" << &local_atoms << "\t" << &total_atoms << std::endl;
          //MPI::COMM_WORLD.Barrier();
@@ -365,6 +416,12 @@ void config(){
          vout::total_output_atoms=local_output_atom_list.size();
       #endif
 
+      // optionally output binary coordinates
+      if(vout::atoms_output_format!=0){
+         vout::atoms_coords_binary();
+         return;
+      }
+
       // Set local output filename
       std::stringstream file_sstr;
       file_sstr << "atoms-coords";
@@ -408,14 +465,281 @@ void config(){
          const int atom = vout::local_output_atom_list[i];
          cfg_file_ofstr << atoms::type_array[atom] << "\t" << atoms::category_array[atom] << "\t" << 
          atoms::x_coord_array[atom] << "\t" << atoms::y_coord_array[atom] << "\t" << atoms::z_coord_array[atom] << "\t";
-         if(sim::identify_surface_atoms==true && atoms::surface_array[atom]==true) cfg_file_ofstr << "O " << std::endl;
-         else cfg_file_ofstr << mp::material[atoms::type_array[atom]].element << std::endl;
+         if(sim::identify_surface_atoms==true && atoms::surface_array[atom]==true) cfg_file_ofstr << "O " << "\n";
+         else cfg_file_ofstr << mp::material[atoms::type_array[atom]].element << "\n";
       }
 
       cfg_file_ofstr.close();
 
    }
 
+//-----------------------------------------------------------------------------
+// Binary snapshot files
+//
+// Binary snapshots store all atoms in a single file per snapshot, written
+// collectively by all processors with MPI-IO. Each file has a header of
+// fixed layout in native (little endian) byte order:
+//
+//    offset  type       content
+//       0    char[8]    "VAMPSPIN" (spins) or "VAMPCRDS" (coordinates)
+//       8    uint32     format version (1)
+//      12    uint32     header size in bytes, including material names
+//      16    uint32     data type (0 = float64, 1 = float32, 2 = int16 scaled by 1/32767)
+//      20    uint32     components per atom (3)
+//      24    uint64     number of atoms
+//      32    uint64     snapshot number
+//      40    float64    time (s)
+//      48    float64    applied field (T)
+//      56    float64    temperature (K)
+//      64    float64[4] normalised magnetisation mx, my, mz, |m|
+//      96    float64[3] system dimensions (A)
+//     120    uint32     number of materials
+//     124    uint32     reserved
+//
+// Spin files are followed by sx, sy, sz for each atom. Coordinate files
+// are followed by an 8 character element name and float64 moment (J/T) for
+// each material, then int32 material and int32 category arrays and x, y, z
+// for each atom in float64. Atoms appear in the same order in spin and
+// coordinate files.
+//-----------------------------------------------------------------------------
+namespace binary{
+
+   const int header_size = 128;
+   const int element_name_size = 8;
+   const int material_record_size = 16;
+
+   //--------------------------------------------------------------------------
+   // Function to copy a value into a byte buffer at a given offset
+   //--------------------------------------------------------------------------
+   template <typename T> void pack(std::vector<char>& buffer, const int offset, const T value){
+      memcpy(&buffer[offset], &value, sizeof(T));
+   }
+
+   //--------------------------------------------------------------------------
+   // Function to fill common snapshot header
+   //--------------------------------------------------------------------------
+   void set_header(std::vector<char>& header, const char* magic, const uint32_t data_type, const uint64_t snapshot){
+
+      memcpy(&header[0], magic, 8);
+      binary::pack<uint32_t>(header, 8, 1);
+      binary::pack<uint32_t>(header, 12, header.size());
+      binary::pack<uint32_t>(header, 16, data_type);
+      binary::pack<uint32_t>(header, 20, 3);
+      binary::pack<uint64_t>(header, 24, vout::total_output_atoms);
+      binary::pack<uint64_t>(header, 32, snapshot);
+      binary::pack<double>(header, 40, sim::physical_time);
+      binary::pack<double>(header, 48, sim::H_applied);
+      binary::pack<double>(header, 56, sim::temperature);
+      const std::vector<double>& m = stats::system_magnetization.get_magnetization();
+      for(int i=0;i<4;i++) binary::pack<double>(header, 64+8*i, m[i]);
+      for(int i=0;i<3;i++) binary::pack<double>(header, 96+8*i, cs::system_dimensions[i]);
+      binary::pack<uint32_t>(header, 120, mp::num_materials);
+      binary::pack<uint32_t>(header, 124, 0);
+
+   }
+
+   //--------------------------------------------------------------------------
+   // Function to write header and sections of per-atom data to a single
+   // file. In each section every processor writes its local atoms starting
+   // at the global offset of its first atom.
+   //--------------------------------------------------------------------------
+   void write(const std::string& filename, const std::vector<char>& header,
+              const std::vector<std::vector<char> >& sections, const std::vector<int>& bytes_per_atom){
+
+      #ifdef MPICF
+
+         MPI_File fh;
+         int error = MPI_File_open(vmpi::comm, const_cast<char*>(filename.c_str()), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh);
+         if(error!=MPI_SUCCESS){
+            terminaltextcolor(RED);
+            std::cerr << "Error: Unable to open binary snapshot file " << filename << " for writing. Exiting." << std::endl;
+            terminaltextcolor(WHITE);
+            zlog << zTs() << "Error: Unable to open binary snapshot file " << filename << " for writing. Exiting." << std::endl;
+            err::vexit();
+         }
+         MPI_File_set_size(fh, 0);
+
+         if(vmpi::my_rank==0) MPI_File_write_at(fh, 0, const_cast<char*>(&header[0]), header.size(), MPI_BYTE, MPI_STATUS_IGNORE);
+
+         MPI_Offset section_start = header.size();
+         for(unsigned int s=0;s<sections.size();s++){
+            const MPI_Offset offset = section_start + MPI_Offset(vout::local_output_atom_offset)*bytes_per_atom[s];
+            char* data = sections[s].size()>0 ? const_cast<char*>(&sections[s][0]) : NULL;
+            MPI_File_write_at_all(fh, offset, data, sections[s].size(), MPI_BYTE, MPI_STATUS_IGNORE);
+            section_start += MPI_Offset(vout::total_output_atoms)*bytes_per_atom[s];
+         }
+
+         MPI_File_close(&fh);
+
+      #else
+
+         // all atoms are local, and so sections are written contiguously
+         (void)bytes_per_atom;
+
+         // open file before submission so that errors are reported immediately
+         async::binary_job_t* job = new async::binary_job_t();
+         std::ofstream& ofile = job->ofile;
+         ofile.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+         if(!ofile.is_open()){
+            terminaltextcolor(RED);
+            std::cerr << "Error: Unable to open binary snapshot file " << filename << " for writing. Exiting." << std::endl;
+            terminaltextcolor(WHITE);
+            zlog << zTs() << "Error: Unable to open binary snapshot file " << filename << " for writing. Exiting." << std::endl;
+            err::vexit();
+         }
+         // concatenate header and sections for writing by output thread
+         size_t total_size = header.size();
+         for(unsigned int s=0;s<sections.size();s++) total_size += sections[s].size();
+         async::acquire_buffer(job->buffer, total_size);
+         std::copy(header.begin(), header.end(), job->buffer.begin());
+         size_t offset = header.size();
+         for(unsigned int s=0;s<sections.size();s++){
+            std::copy(sections[s].begin(), sections[s].end(), job->buffer.begin()+offset);
+            offset += sections[s].size();
+         }
+         async::submit(job);
+
+      #endif
+
+      return;
+
+   }
+
+   //--------------------------------------------------------------------------
+   // Function to pack spin components of output atoms with given precision
+   //--------------------------------------------------------------------------
+   template <typename T> void pack_spins(std::vector<char>& buffer, const double scale){
+
+      const int num_atoms = vout::local_output_atom_list.size();
+      buffer.resize(3*num_atoms*sizeof(T));
+      T* data = reinterpret_cast<T*>(num_atoms>0 ? &buffer[0] : NULL);
+
+      for(int i=0; i<num_atoms; i++){
+         const int atom = vout::local_output_atom_list[i];
+         if(scale>0.0){
+            data[3*i+0] = T(floor(atoms::x_spin_array[atom]*scale+0.5));
+            data[3*i+1] = T(floor(atoms::y_spin_array[atom]*scale+0.5));
+            data[3*i+2] = T(floor(atoms::z_spin_array[atom]*scale+0.5));
+         }
+         else{
+            data[3*i+0] = T(atoms::x_spin_array[atom]);
+            data[3*i+1] = T(atoms::y_spin_array[atom]);
+            data[3*i+2] = T(atoms::z_spin_array[atom]);
+         }
+      }
+
+   }
+
+} // end of namespace binary
+
+//-----------------------------------------------------------------------------
+// Function to output binary spin snapshot atoms-XXXXXXXX.vbin
+//-----------------------------------------------------------------------------
+void atoms_binary(){
+
+   // check calling of routine if error checking is activated
+   if(err::check==true){std::cout << "vout::atoms_binary has been called" << std::endl;}
+
+   std::stringstream file_sstr;
+   file_sstr << "atoms-" << std::setfill('0') << std::setw(8) << sim::output_atoms_file_counter << ".vbin";
+   const std::string filename = file_sstr.str();
+
+   // Output informative message to log file
+   zlog << zTs() << "Outputting binary configuration file " << filename << " to disk" << std::endl;
+
+   // Pack spins with requested precision
+   std::vector<std::vector<char> > sections(1);
+   std::vector<int> bytes_per_atom(1);
+   uint32_t data_type=0;
+   switch(vout::atoms_output_format){
+      case 1:
+         binary::pack_spins<double>(sections[0], 0.0);
+         bytes_per_atom[0] = 3*sizeof(double);
+         data_type=0;
+         break;
+      case 2:
+         binary::pack_spins<float>(sections[0], 0.0);
+         bytes_per_atom[0] = 3*sizeof(float);
+         data_type=1;
+         break;
+      case 3:
+         binary::pack_spins<int16_t>(sections[0], 32767.0);
+         bytes_per_atom[0] = 3*sizeof(int16_t);
+         data_type=2;
+         break;
+   }
+
+   std::vector<char> header(binary::header_size, 0);
+   binary::set_header(header, "VAMPSPIN", data_type, sim::output_atoms_file_counter);
+
+   binary::write(filename, header, sections, bytes_per_atom);
+
+   sim::output_atoms_file_counter++;
+
+   return;
+
+}
+
+//-----------------------------------------------------------------------------
+// Function to output binary coordinates atoms-coords.vbin, and to determine
+// the offset of local atoms in binary snapshot files
+//-----------------------------------------------------------------------------
+void atoms_coords_binary(){
+
+   // check calling of routine if error checking is activated
+   if(err::check==true){std::cout << "vout::atoms_coords_binary has been called" << std::endl;}
+
+   const int num_atoms = vout::local_output_atom_list.size();
+
+   // calculate offset of local atoms from exclusive sum of atoms on lower ranks
+   #ifdef MPICF
+      unsigned long long local_atoms = num_atoms;
+      unsigned long long offset = 0;
+      MPI_Exscan(&local_atoms, &offset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, vmpi::comm);
+      if(vmpi::my_rank==0) offset=0;
+      vout::local_output_atom_offset = offset;
+   #else
+      vout::local_output_atom_offset = 0;
+   #endif
+
+   std::vector<std::vector<char> > sections(3);
+   std::vector<int> bytes_per_atom(3);
+   bytes_per_atom[0] = sizeof(int32_t);
+   bytes_per_atom[1] = sizeof(int32_t);
+   bytes_per_atom[2] = 3*sizeof(double);
+   for(int s=0;s<3;s++) sections[s].resize(num_atoms*bytes_per_atom[s]);
+
+   for(int i=0; i<num_atoms; i++){
+      const int atom = vout::local_output_atom_list[i];
+      const int32_t material = atoms::type_array[atom];
+      const int32_t category = atoms::category_array[atom];
+      const double coords[3] = {atoms::x_coord_array[atom], atoms::y_coord_array[atom], atoms::z_coord_array[atom]};
+      memcpy(&sections[0][i*bytes_per_atom[0]], &material, sizeof(int32_t));
+      memcpy(&sections[1][i*bytes_per_atom[1]], &category, sizeof(int32_t));
+      memcpy(&sections[2][i*bytes_per_atom[2]], coords, 3*sizeof(double));
+   }
+
+   // header includes element names and moments of materials
+   std::vector<char> header(binary::header_size + binary::material_record_size*mp::num_materials, 0);
+   binary::set_header(header, "VAMPCRDS", 0, 0);
+   for(int mat=0;mat<mp::num_materials;mat++){
+      const int record = binary::header_size + binary::material_record_size*mat;
+      const std::string& element = mp::material[mat].element;
+      memcpy(&header[record], element.c_str(), std::min(int(element.size()), binary::element_name_size));
+      binary::pack<double>(header, record + binary::element_name_size, mp::material[mat].mu_s_SI);
+   }
+
+   if(vmpi::my_rank==0){
+      std::cout << "Outputting binary atomic coordinates to disk." << std::endl;
+      zlog << zTs() << "Outputting binary atomic coordinates to disk." << std::endl;
+   }
+
+   binary::write("atoms-coords.vbin", header, sections, bytes_per_atom);
+
+   return;
+
+}
+
 /// @brief Cell output function
 ///
 /// @details Outputs formatted data snapshot for visualisation
@@ -462,19 +786,18 @@ void cells(){
    file_sstr << std::setfill('0') << std::setw(8) << output_cells_file_counter;
    file_sstr << ".cfg";
    std::string cfg_file = file_sstr.str();
-   const char* cfg_filec = cfg_file.c_str();
 
    #ifdef MPICF
    // Reduce demagnetisation fields to processor 0
    if(vmpi::my_rank==0){
-      MPI_Reduce(MPI_IN_PLACE, &cells::x_field_array[0], cells::num_cells, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
-      MPI_Reduce(MPI_IN_PLACE, &cells::y_field_array[0], cells::num_cells, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
-      MPI_Reduce(MPI_IN_PLACE, &cells::z_field_array[0], cells::num_cells, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+      MPI_Reduce(MPI_IN_PLACE, &cells::x_field_array[0], cells::num_cells, MPI_DOUBLE, MPI_MIN, 0, vmpi::comm);
+      MPI_Reduce(MPI_IN_PLACE, &cells::y_field_array[0], cells::num_cells, MPI_DOUBLE, MPI_MIN, 0, vmpi::comm);
+      MPI_Reduce(MPI_IN_PLACE, &cells::z_field_array[0], cells::num_cells, MPI_DOUBLE, MPI_MIN, 0, vmpi::comm);
    }
    else{
-      MPI_Reduce(&cells::x_field_array[0], &cells::x_field_array[0], cells::num_cells, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
-      MPI_Reduce(&cells::y_field_array[0], &cells::y_field_array[0], cells::num_cells, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
-      MPI_Reduce(&cells::z_field_array[0], &cells::z_field_array[0], cells::num_cells, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+      MPI_Reduce(&cells::x_field_array[0], &cells::x_field_array[0], cells::num_cells, MPI_DOUBLE, MPI_MIN, 0, vmpi::comm);
+      MPI_Reduce(&cells::y_field_array[0], &cells::y_field_array[0], cells::num_cells, MPI_DOUBLE, MPI_MIN, 0, vmpi::comm);
+      MPI_Reduce(&cells::z_field_array[0], &cells::z_field_array[0], cells::num_cells, MPI_DOUBLE, MPI_MIN, 0, vmpi::comm);
    }
    #endif
 
@@ -483,35 +806,40 @@ void cells(){
 
       zlog << zTs() << "Outputting cell configuration " << output_cells_file_counter << " to disk." << std::endl;
 
-      // Declare and open output file
-      std::ofstream cfg_file_ofstr;
-      cfg_file_ofstr.open (cfg_filec);
+      // Format header, which is written with the cell data by the output thread
+      std::stringstream header;
 
       // Get system date
       time_t rawtime = time(NULL);
       struct tm * timeinfo = localtime(&rawtime);
 
-      cfg_file_ofstr << "#------------------------------------------------------"<< std::endl;
-      cfg_file_ofstr << "# Cell configuration file for vampire"<< std::endl;
-      cfg_file_ofstr << "#------------------------------------------------------"<< std::endl;
-      cfg_file_ofstr << "# Date: "<< asctime(timeinfo);
-      cfg_file_ofstr << "#------------------------------------------------------"<< std::endl;
-      cfg_file_ofstr << "# Number of spins: "<< cells::num_cells << std::endl;
-      cfg_file_ofstr << "# System dimensions:" << cs::system_dimensions[0] << "\t" << cs::system_dimensions[1] << "\t" << cs::system_dimensions[2] << std::endl;
-      cfg_file_ofstr << "# Coordinates-file: cells-coord.cfg"<< std::endl;
-      cfg_file_ofstr << "# Time: " << double(sim::time)*mp::dt_SI << std::endl;
-      cfg_file_ofstr << "# Field: " << sim::H_applied << std::endl;
-      cfg_file_ofstr << "# Temperature: "<< sim::temperature << std::endl;
-      cfg_file_ofstr << "# Magnetisation: " << stats::system_magnetization.output_normalized_magnetization() << std::endl;
-      cfg_file_ofstr << "#------------------------------------------------------"<< std::endl;
+      header << "#------------------------------------------------------"<< std::endl;
+      header << "# Cell configuration file for vampire"<< std::endl;
+      header << "#------------------------------------------------------"<< std::endl;
+      header << "# Date: "<< asctime(timeinfo);
+      header << "#------------------------------------------------------"<< std::endl;
+      header << "# Number of spins: "<< cells::num_cells << std::endl;
+      header << "# System dimensions:" << cs::system_dimensions[0] << "\t" << cs::system_dimensions[1] << "\t" << cs::system_dimensions[2] << std::endl;
+      header << "# Coordinates-file: cells-coord.cfg"<< std::endl;
+      header << "# Time: " << sim::physical_time << std::endl;
+      header << "# Field: " << sim::H_applied << std::endl;
+      header << "# Temperature: "<< sim::temperature << std::endl;
+      header << "# Magnetisation: " << stats::system_magnetization.output_normalized_magnetization() << std::endl;
+      header << "#------------------------------------------------------"<< std::endl;
 
       // Root process now outputs the cell magnetisations
+      text_output_job_t* job = new text_output_job_t(cfg_file, header.str(), 6);
+      async::acquire_buffer(job->buffer, 6*cells::num_cells*sizeof(double));
+      double* data = reinterpret_cast<double*>(cells::num_cells>0 ? &job->buffer[0] : NULL);
       for(int cell=0; cell < cells::num_cells; cell++){
-         cfg_file_ofstr << cells::x_mag_array[cell] << "\t" << cells::y_mag_array[cell] << "\t" << cells::z_mag_array[cell]<< "\t";
-         cfg_file_ofstr << cells::x_field_array[cell] << "\t" << cells::y_field_array[cell] << "\t" << cells::z_field_array[cell] << std::endl;
+         data[6*cell+0] = cells::x_mag_array[cell];
+         data[6*cell+1] = cells::y_mag_array[cell];
+         data[6*cell+2] = cells::z_mag_array[cell];
+         data[6*cell+3] = cells::x_field_array[cell];
+         data[6*cell+4] = cells::y_field_array[cell];
+         data[6*cell+5] = cells::z_field_array[cell];
       }
-
-      cfg_file_ofstr.close();
+      async::submit(job);
 
    }
 
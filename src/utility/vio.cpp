@@ -709,6 +709,8 @@ int read(string const filename){
 		//std::cout << "\t" << "word: " << word << std::endl;
 		//std::cout << "\t" << "value:" << value << std::endl;
 		//std::cout << "\t" << "unit: " << unit << std::endl;
+		// lines which may affect system generation identify system image
+		if(key!="sim" && key!="output" && key!="screen" && key!="config" && key!="grain") cs::image::add_to_key(line);
 		int matchcheck = match(key, word, value, unit, line_counter);
 		if(matchcheck==EXIT_FAILURE){
 			err::vexit();
@@ -1212,6 +1214,45 @@ int match_create(string const word, string const value, string const unit, int c
       }
    }
    //--------------------------------------------------------------------
+   test="system-image";
+   if(word==test){
+      cs::image::enabled=true;
+      return EXIT_SUCCESS;
+   }
+   //--------------------------------------------------------------------
+   test="atom-ordering";
+   if(word==test){
+      // Test for different options
+      test="default";
+      if(value==test){
+         cs::sfc::ordering=0;
+         return EXIT_SUCCESS;
+      }
+      test="morton";
+      if(value==test){
+         cs::sfc::ordering=1;
+         return EXIT_SUCCESS;
+      }
+      test="hilbert";
+      if(value==test){
+         cs::sfc::ordering=2;
+         return EXIT_SUCCESS;
+      }
+      else{
+         terminaltextcolor(RED);
+         std::cerr << "Error - value for \'create:" << word << "\' must be one of:" << std::endl;
+         std::cerr << "\t\"default\"" << std::endl;
+         std::cerr << "\t\"morton\"" << std::endl;
+         std::cerr << "\t\"hilbert\"" << std::endl;
+         zlog << zTs() << "Error - value for \'create:" << word << "\' must be one of:" << std::endl;
+         zlog << zTs() << "\t\"default\"" << std::endl;
+         zlog << zTs() << "\t\"morton\"" << std::endl;
+         zlog << zTs() << "\t\"hilbert\"" << std::endl;
+         terminaltextcolor(WHITE);
+         err::vexit();
+      }
+   }
+   //--------------------------------------------------------------------
    // keyword not found
    //--------------------------------------------------------------------
    else{
@@ -1398,27 +1439,47 @@ int match_sim(string const word, string const value, string const unit, int cons
    if(word==test){
       test="llg-heun";
       if(value==test){
-         sim::integrator=0;
+         sim::integrator=sim::llg_heun;
          return EXIT_SUCCESS;
       }
       test="monte-carlo";
       if(value==test){
-         sim::integrator=1;
+         sim::integrator=sim::monte_carlo;
          return EXIT_SUCCESS;
       }
       test="llg-midpoint";
       if(value==test){
-         sim::integrator=2;
+         sim::integrator=sim::llg_midpoint;
          return EXIT_SUCCESS;
       }
       test="constrained-monte-carlo";
       if(value==test){
-         sim::integrator=3;
+         sim::integrator=sim::constrained_monte_carlo;
          return EXIT_SUCCESS;
       }
       test="hybrid-constrained-monte-carlo";
       if(value==test){
-         sim::integrator=4;
+         sim::integrator=sim::hybrid_constrained_monte_carlo;
+         return EXIT_SUCCESS;
+      }
+      test="parallel-monte-carlo";
+      if(value==test){
+         sim::integrator=sim::parallel_monte_carlo;
+         return EXIT_SUCCESS;
+      }
+      test="llg-rk23";
+      if(value==test){
+         sim::integrator=sim::llg_rk23;
+         return EXIT_SUCCESS;
+      }
+      test="llg-rotation";
+      if(value==test){
+         sim::integrator=sim::llg_rotation;
+         return EXIT_SUCCESS;
+      }
+      test="energy-minimisation";
+      if(value==test){
+         sim::integrator=sim::energy_minimisation;
          return EXIT_SUCCESS;
       }
       else{
@@ -1428,6 +1489,10 @@ int match_sim(string const word, string const value, string const unit, int cons
          std::cerr << "\t\"llg-midpoint\"" << std::endl;
          std::cerr << "\t\"monte-carlo\"" << std::endl;
          std::cerr << "\t\"constrained-monte-carlo\"" << std::endl;
+         std::cerr << "\t\"parallel-monte-carlo\"" << std::endl;
+         std::cerr << "\t\"llg-rk23\"" << std::endl;
+         std::cerr << "\t\"llg-rotation\"" << std::endl;
+         std::cerr << "\t\"energy-minimisation\"" << std::endl;
 		 terminaltextcolor(WHITE);
          err::vexit();
       }
@@ -1510,6 +1575,11 @@ int match_sim(string const word, string const value, string const unit, int cons
          sim::program=14;
          return EXIT_SUCCESS;
       }
+      test="replica-exchange";
+      if(value==test){
+         sim::program=15;
+         return EXIT_SUCCESS;
+      }
       test="diagnostic-boltzmann";
       if(value==test){
          sim::program=50;
@@ -1529,6 +1599,7 @@ int match_sim(string const word, string const value, string const unit, int cons
          std::cerr << "\t\"hybrid-cmc\"" << std::endl;
          std::cerr << "\t\"reverse-hybrid-cmc\"" << std::endl;
          std::cerr << "\t\"localised-temperature-pulse\"" << std::endl;
+         std::cerr << "\t\"replica-exchange\"" << std::endl;
          terminaltextcolor(WHITE);
 		 err::vexit();
       }
@@ -1552,6 +1623,85 @@ int match_sim(string const word, string const value, string const unit, int cons
       return EXIT_SUCCESS;
    }
    //-------------------------------------------------------------------
+   test="enable-compressed-fast-dipole-fields";
+   if(word==test){
+      demag::fast=true;
+      demag::compressed=true;
+      return EXIT_SUCCESS;
+   }
+   //-------------------------------------------------------------------
+   test="enable-fft-dipole-fields";
+   if(word==test){
+      demag::fft=true;
+      return EXIT_SUCCESS;
+   }
+   //-------------------------------------------------------------------
+   test="enable-tree-dipole-fields";
+   if(word==test){
+      demag::tree=true;
+      return EXIT_SUCCESS;
+   }
+   //-------------------------------------------------------------------
+   test="dipole-tree-opening-angle";
+   if(word==test){
+      double theta=atof(value.c_str());
+      check_for_valid_value(theta, word, line, prefix, unit, "none", 0.0, 1.0,"input","0.0 - 1.0");
+      demag::tree_opening_angle=theta;
+      return EXIT_SUCCESS;
+   }
+   //-------------------------------------------------------------------
+   test="enable-packed-exchange";
+   if(word==test){
+      atoms::packed_exchange=true;
+      return EXIT_SUCCESS;
+   }
+   //-------------------------------------------------------------------
+   test="enable-stencil-exchange";
+   if(word==test){
+      atoms::stencil_exchange=true;
+      return EXIT_SUCCESS;
+   }
+   //-------------------------------------------------------------------
+   test="enable-parallel-constrained-monte-carlo";
+   if(word==test){
+      sim::parallel_cmc=true;
+      return EXIT_SUCCESS;
+   }
+   //-------------------------------------------------------------------
+   test="enable-incremental-monte-carlo";
+   if(word==test){
+      sim::incremental_mc=true;
+      return EXIT_SUCCESS;
+   }
+   //-------------------------------------------------------------------
+   test="enable-hybrid-dipole-fields";
+   if(word==test){
+      demag::hybrid=true;
+      return EXIT_SUCCESS;
+   }
+   //-------------------------------------------------------------------
+   test="dipole-near-field-range";
+   if(word==test){
+      int range=atoi(value.c_str());
+      check_for_valid_int(range, word, line, prefix, 0, 10,"input","0 - 10");
+      demag::near_field_range=range;
+      return EXIT_SUCCESS;
+   }
+   //-------------------------------------------------------------------
+   test="enable-adaptive-dipole-fields";
+   if(word==test){
+      demag::adaptive=true;
+      return EXIT_SUCCESS;
+   }
+   //-------------------------------------------------------------------
+   test="dipole-field-update-tolerance";
+   if(word==test){
+      double tol=atof(value.c_str());
+      check_for_valid_value(tol, word, line, prefix, unit, "none", 0.0, 1.0,"input","0.0 - 1.0");
+      demag::update_tolerance=tol;
+      return EXIT_SUCCESS;
+   }
+   //-------------------------------------------------------------------
    test="dipole-field-update-rate";
    if(word==test){
       int dpur=atoi(value.c_str());
@@ -1598,6 +1748,22 @@ int match_sim(string const word, string const value, string const unit, int cons
       return EXIT_SUCCESS;
    }
    //--------------------------------------------------------------------
+   test="adaptive-tolerance";
+   if(word==test){
+      double tol=atof(value.c_str());
+      check_for_valid_value(tol, word, line, prefix, unit, "none", 1.0e-12, 1.0e-1,"input","1.0e-12 - 0.1");
+      sim::adaptive_tolerance=tol;
+      return EXIT_SUCCESS;
+   }
+   //--------------------------------------------------------------------
+   test="minimisation-tolerance";
+   if(word==test){
+      double tol=atof(value.c_str());
+      check_for_valid_value(tol, word, line, prefix, unit, "field", 1.0e-12, 1.0,"input","1.0e-12 - 1.0 T");
+      sim::minimiser_tolerance=tol;
+      return EXIT_SUCCESS;
+   }
+   //--------------------------------------------------------------------
    test="total-time-steps";
    if(word==test){
       int tt=atoi(value.c_str());
@@ -1957,12 +2123,18 @@ int match_sim(string const word, string const value, string const unit, int cons
          vmpi::replicated_data_staged=true;
          return EXIT_SUCCESS;
       }
+      test="statistical-parallelism";
+      if(value==test){
+         vmpi::mpi_mode=2;
+         return EXIT_SUCCESS;
+      }
       else{
 		 terminaltextcolor(RED);
          std::cerr << "Error - value for \'sim:" << word << "\' must be one of:" << std::endl;
          std::cerr << "\t\"geometric-decomposition\"" << std::endl;
          std::cerr << "\t\"replicated-data\"" << std::endl;
          std::cerr << "\t\"replicated-data-staged\"" << std::endl;
+         std::cerr << "\t\"statistical-parallelism\"" << std::endl;
 		 terminaltextcolor(WHITE);
          err::vexit();
       }
@@ -1976,6 +2148,14 @@ int match_sim(string const word, string const value, string const unit, int cons
       return EXIT_SUCCESS;
    }
    //--------------------------------------------------------------------
+   test="mpi-replicas";
+   if(word==test){
+      int nr=atoi(value.c_str());
+      check_for_valid_int(nr, word, line, prefix, 1, 1000000,"input","1 - 1,000,000");
+      vmpi::num_replicas=nr;
+      return EXIT_SUCCESS;
+   }
+   //--------------------------------------------------------------------
    test="integrator-random-seed";
    if(word==test){
       int is=atoi(value.c_str());
@@ -2176,6 +2356,40 @@ int match_config(string const word, string const value,int const line){
       vout::output_atoms_config_rate=i;
       return EXIT_SUCCESS;
    }
+   //-----------------------------------------
+   test="atoms-output-format";
+   if(word==test){
+      test="text";
+      if(value==test){
+         vout::atoms_output_format=0;
+         return EXIT_SUCCESS;
+      }
+      test="binary-double";
+      if(value==test){
+         vout::atoms_output_format=1;
+         return EXIT_SUCCESS;
+      }
+      test="binary-single";
+      if(value==test){
+         vout::atoms_output_format=2;
+         return EXIT_SUCCESS;
+      }
+      test="binary-16bit";
+      if(value==test){
+         vout::atoms_output_format=3;
+         return EXIT_SUCCESS;
+      }
+      else{
+         terminaltextcolor(RED);
+         std::cerr << "Error - value for \'config:" << word << "\' must be one of:" << std::endl;
+         std::cerr << "\t\"text\"" << std::endl;
+         std::cerr << "\t\"binary-double\"" << std::endl;
+         std::cerr << "\t\"binary-single\"" << std::endl;
+         std::cerr << "\t\"binary-16bit\"" << std::endl;
+         terminaltextcolor(WHITE);
+         err::vexit();
+      }
+   }
    //--------------------------------------------------------------------
    test="atoms-minimum-x";
    if(word==test){
@@ -2637,6 +2851,20 @@ int match_vout_list(string const word, string const value, int const line, std::
       vout::output_rate=r;
       return EXIT_SUCCESS;
    }
+   //--------------------------------------------------------------------
+   test="asynchronous";
+   if(word==test){
+      vout::asynchronous_output=true;
+      return EXIT_SUCCESS;
+   }
+   //--------------------------------------------------------------------
+   test="asynchronous-queue-depth";
+   if(word==test){
+      int d=atoi(value.c_str());
+      check_for_valid_int(d, word, line, prefix, 1, 64,"input","1 - 64");
+      vout::asynchronous_queue_depth=d;
+      return EXIT_SUCCESS;
+   }
 
    //--------------------------------------------------------------------
    // keyword not found
@@ -2939,6 +3167,7 @@ int read_mat_file(std::string const matfile, int const LineNumber){
 			//std::cout << "\t" << "word: " << word << std::endl;
 			//std::cout << "\t" << "value:" << value << std::endl;
 			//std::cout << "\t" << "unit: " << unit << std::endl;
+			cs::image::add_to_key(line);
 			int matchcheck = vin::match_material(word, value, unit, line_counter, super_index-1, sub_index-1);
 			if(matchcheck==EXIT_FAILURE){
 				err::vexit();
@@ -3885,7 +4114,7 @@ namespace vout{
 
 	// Output Function 1
 	void real_time(std::ostream& stream){
-		stream << sim::time*mp::dt_SI << "\t";
+		stream << sim::physical_time << "\t";
 	}
 	
 	// Output Function 2
@@ -4048,7 +4277,7 @@ namespace vout{
 
 	// Output Function 25
 	void material_fmr_field_strength(std::ostream& stream){
-		const double real_time=sim::time*mp::dt_SI;
+		const double real_time=sim::physical_time;
 
 		for(int mat=0;mat<mp::material.size();mat++){
 			const double Hsinwt_local=mp::material[mat].fmr_field_strength*sin(2.0*M_PI*real_time*mp::material[mat].fmr_field_frequency);
@@ -4181,14 +4410,14 @@ namespace vout{
 		if(vmpi::DetailedMPITiming){
 
 			// Calculate Average times
-			MPI_Reduce (&vmpi::TotalComputeTime,&vmpi::AverageComputeTime,1,MPI_DOUBLE,MPI_SUM,0,MPI_COMM_WORLD); 
-			MPI_Reduce (&vmpi::TotalWaitTime,&vmpi::AverageWaitTime,1,MPI_DOUBLE,MPI_SUM,0,MPI_COMM_WORLD);
+			MPI_Reduce (&vmpi::TotalComputeTime,&vmpi::AverageComputeTime,1,MPI_DOUBLE,MPI_SUM,0,vmpi::comm); 
+			MPI_Reduce (&vmpi::TotalWaitTime,&vmpi::AverageWaitTime,1,MPI_DOUBLE,MPI_SUM,0,vmpi::comm);
 			vmpi::AverageComputeTime/=double(vmpi::num_processors);
 			vmpi::AverageWaitTime/=double(vmpi::num_processors);
 			
 			// Calculate Maximum times
-			MPI_Reduce (&vmpi::TotalComputeTime,&vmpi::MaximumComputeTime,1,MPI_DOUBLE,MPI_MAX,0,MPI_COMM_WORLD);
-			MPI_Reduce (&vmpi::TotalWaitTime,&vmpi::MaximumWaitTime,1,MPI_DOUBLE,MPI_MAX,0,MPI_COMM_WORLD);
+			MPI_Reduce (&vmpi::TotalComputeTime,&vmpi::MaximumComputeTime,1,MPI_DOUBLE,MPI_MAX,0,vmpi::comm);
+			MPI_Reduce (&vmpi::TotalWaitTime,&vmpi::MaximumWaitTime,1,MPI_DOUBLE,MPI_MAX,0,vmpi::comm);
 
 			// Save times for timing matrix
 			vmpi::ComputeTimeArray.push_back(vmpi::TotalComputeTime);
@@ -4200,8 +4429,8 @@ namespace vout{
 		}
 		#endif
 
-      // check for open ofstream
-      if(!zmag.is_open()){
+      // check for open ofstream, which is written only by the first replica for statistical parallelism
+      if(!zmag.is_open() && (vmpi::mpi_mode!=2 || vmpi::world_rank==0)){
          // check for checkpoint continue and append data
          if(sim::load_checkpoint_flag && sim::load_checkpoint_continue_flag) zmag.open("output",std::ofstream::app);
          // otherwise overwrite file
@@ -4215,149 +4444,152 @@ namespace vout{
 		// Only output 1/output_rate time steps
       if(sim::time%vout::output_rate==0){
 
-		// Output data to output
+		// Output data to output, or store line for ordered output of all replicas
       if(vmpi::my_rank==0){
+      std::ostringstream replica_line;
+      std::ostream& ofile = (vmpi::mpi_mode==2) ? static_cast<std::ostream&>(replica_line) : static_cast<std::ostream&>(zmag);
 		for(unsigned int item=0;item<file_output_list.size();item++){
 			switch(file_output_list[item]){
 				case 0:
-					vout::time(zmag);
+					vout::time(ofile);
 					break;
 				case 1:
-					vout::real_time(zmag);
+					vout::real_time(ofile);
 					break;
 				case 2:
-					vout::temperature(zmag);
+					vout::temperature(ofile);
 					break;
 				case 3:
-					vout::Happ(zmag);
+					vout::Happ(ofile);
 					break;
 				case 4:
-					vout::Hvec(zmag);
+					vout::Hvec(ofile);
 					break;
 				case 5:
-					vout::mvec(zmag);
+					vout::mvec(ofile);
 					break;
 				case 6:
-					vout::magm(zmag);
+					vout::magm(ofile);
 					break;
 				case 7:
-					vout::mean_magm(zmag);
+					vout::mean_magm(ofile);
 					break;
 				case 8:
-					vout::mat_mvec(zmag);
+					vout::mat_mvec(ofile);
 					break;
 				case 9:
-					vout::mat_mean_magm(zmag);
+					vout::mat_mean_magm(ofile);
 					break;
 				case 12:
-					vout::mdoth(zmag);
+					vout::mdoth(ofile);
 					break;
 				case 14:
-					vout::systorque(zmag);
+					vout::systorque(ofile);
 					break;
 				case 15:
-					vout::mean_systorque(zmag);
+					vout::mean_systorque(ofile);
 					break;
 				case 16:
-					vout::constraint_phi(zmag);
+					vout::constraint_phi(ofile);
 					break;
 				case 17:
-					vout::constraint_theta(zmag);
+					vout::constraint_theta(ofile);
 					break;
 				case 18:
-					vout::material_constraint_phi(zmag);
+					vout::material_constraint_phi(ofile);
 					break;
 				case 19:
-					vout::material_constraint_theta(zmag);
+					vout::material_constraint_theta(ofile);
 					break;
 				case 20:
-					vout::material_mean_systorque(zmag);
+					vout::material_mean_systorque(ofile);
 					break;
 				case 21:
-					vout::mean_system_susceptibility(zmag);
+					vout::mean_system_susceptibility(ofile);
 					break;
 				case 22:
-					vout::phonon_temperature(zmag);
+					vout::phonon_temperature(ofile);
 					break;
 				case 23:
-					vout::material_temperature(zmag);
+					vout::material_temperature(ofile);
 					break;
 				case 24:
-					vout::material_applied_field_strength(zmag);
+					vout::material_applied_field_strength(ofile);
 					break;
 				case 25:
-					vout::material_fmr_field_strength(zmag);
+					vout::material_fmr_field_strength(ofile);
 					break;
 				case 26:
-					vout::mat_mdoth(zmag);
+					vout::mat_mdoth(ofile);
 					break;
             case 27:
-               vout::total_energy(zmag);
+               vout::total_energy(ofile);
                break;
             case 28:
-               vout::mean_total_energy(zmag);
+               vout::mean_total_energy(ofile);
                break;
             case 29:
-               vout::total_anisotropy_energy(zmag);
+               vout::total_anisotropy_energy(ofile);
                break;
             case 30:
-               vout::mean_total_anisotropy_energy(zmag);
+               vout::mean_total_anisotropy_energy(ofile);
                break;
             case 31:
-               vout::total_cubic_anisotropy_energy(zmag);
+               vout::total_cubic_anisotropy_energy(ofile);
                break;
             case 32:
-               vout::mean_total_cubic_anisotropy_energy(zmag);
+               vout::mean_total_cubic_anisotropy_energy(ofile);
                break;
             case 33:
-               vout::total_surface_anisotropy_energy(zmag);
+               vout::total_surface_anisotropy_energy(ofile);
                break;
             case 34:
-               vout::mean_total_surface_anisotropy_energy(zmag);
+               vout::mean_total_surface_anisotropy_energy(ofile);
                break;
             case 35:
-               vout::total_exchange_energy(zmag);
+               vout::total_exchange_energy(ofile);
                break;
             case 36:
-               vout::mean_total_exchange_energy(zmag);
+               vout::mean_total_exchange_energy(ofile);
                break;
             case 37:
-               vout::total_applied_field_energy(zmag);
+               vout::total_applied_field_energy(ofile);
                break;
             case 38:
-               vout::mean_total_applied_field_energy(zmag);
+               vout::mean_total_applied_field_energy(ofile);
                break;
             case 39:
-               vout::total_magnetostatic_energy(zmag);
+               vout::total_magnetostatic_energy(ofile);
                break;
             case 40:
-               vout::mean_total_magnetostatic_energy(zmag);
+               vout::mean_total_magnetostatic_energy(ofile);
                break;
             case 41:
-               vout::total_so_anisotropy_energy(zmag);
+               vout::total_so_anisotropy_energy(ofile);
                break;
             case 42:
-               vout::mean_total_so_anisotropy_energy(zmag);
+               vout::mean_total_so_anisotropy_energy(ofile);
                break;
             case 43:
-               vout::height_mvec(zmag);
+               vout::height_mvec(ofile);
                break;
             case 44:
-               vout::material_height_mvec(zmag);
+               vout::material_height_mvec(ofile);
                break;
             case 45:
-               vout::height_mvec_actual(zmag);
+               vout::height_mvec_actual(ofile);
                break;
             case 46:
-               vout::material_height_mvec_actual(zmag);
+               vout::material_height_mvec_actual(ofile);
                break;
             case 60:
-					vout::MPITimings(zmag);
+					vout::MPITimings(ofile);
 					break;
 			}
 		}
 		// Carriage return
-		if(file_output_list.size()>0) zmag << std::endl;
+		if(vmpi::mpi_mode==2) vout::store_replica_line(replica_line.str());
+		else if(file_output_list.size()>0) zmag << std::endl;
 
       } // end of code for rank 0 only
    } // end of if statement for output rate
@@ -4559,6 +4791,119 @@ namespace vout{
       if(sim::save_checkpoint_flag==true && sim::save_checkpoint_continuous_flag==true && sim::time%sim::save_checkpoint_rate==0) save_checkpoint();
 
 	} // end of data
-	
+
+	//-----------------------------------------------------------------------------
+	// Output line of a replica for statistical parallelism, labelled with the
+	// sweep point and sequence number for ordering of output from all replicas
+	//-----------------------------------------------------------------------------
+	struct replica_line_t{
+		int point;
+		int replica;
+		int sequence;
+		std::string line;
+	};
+
+	bool operator<(const replica_line_t& a, const replica_line_t& b){
+		if(a.point!=b.point) return a.point<b.point;
+		if(a.replica!=b.replica) return a.replica<b.replica;
+		return a.sequence<b.sequence;
+	}
+
+	std::vector<replica_line_t> replica_lines;
+
+	//-----------------------------------------------------------------------------
+	// Function to store output line of local replica
+	//-----------------------------------------------------------------------------
+	void store_replica_line(const std::string& line){
+		replica_line_t record;
+		record.point = vmpi::replica_point;
+		record.replica = vmpi::replica_id;
+		record.sequence = replica_lines.size();
+		record.line = line;
+		replica_lines.push_back(record);
+		return;
+	}
+
+	//-----------------------------------------------------------------------------
+	// Function to separate blocks of output data for gnuplot array format
+	//-----------------------------------------------------------------------------
+	void data_block_separator(){
+		if(vmpi::mpi_mode==2){
+			if(vmpi::my_rank==0 && vmpi::is_replica_point()) store_replica_line("");
+		}
+		else zmag << std::endl;
+		return;
+	}
+
+	//-----------------------------------------------------------------------------
+	// Function to gather output lines of all replicas to the first processor and
+	// write them to the output file in order of sweep point. Points simulated
+	// by more than one replica are written as separate blocks for each replica.
+	//-----------------------------------------------------------------------------
+	void write_replica_data(){
+
+		if(vmpi::mpi_mode!=2) return;
+
+		// serialise local lines
+		std::ostringstream local_stream;
+		for(unsigned int i=0;i<replica_lines.size();i++){
+			local_stream << replica_lines[i].point << " " << replica_lines[i].replica << " " << replica_lines[i].sequence << " " << replica_lines[i].line << "\n";
+		}
+		std::string buffer = local_stream.str();
+
+		#ifdef MPICF
+			// gather serialised lines from all processors
+			int local_size = buffer.size();
+			const int num_world_processors = MPI::COMM_WORLD.Get_size();
+			std::vector<int> sizes(num_world_processors,0);
+			std::vector<int> offsets(num_world_processors,0);
+			MPI::COMM_WORLD.Gather(&local_size,1,MPI_INT,&sizes[0],1,MPI_INT,0);
+			int total_size=0;
+			for(int p=0;p<num_world_processors;p++){
+				offsets[p]=total_size;
+				total_size+=sizes[p];
+			}
+			std::vector<char> all_lines(total_size+1,'\0');
+			MPI::COMM_WORLD.Gatherv(buffer.c_str(),local_size,MPI_CHAR,&all_lines[0],&sizes[0],&offsets[0],MPI_CHAR,0);
+			if(vmpi::world_rank==0) buffer = std::string(&all_lines[0],total_size);
+		#endif
+
+		if(vmpi::world_rank==0){
+
+			// unpack and sort lines
+			std::vector<replica_line_t> lines;
+			std::istringstream all_stream(buffer);
+			std::string record_line;
+			while(std::getline(all_stream,record_line)){
+				std::istringstream record_stream(record_line);
+				replica_line_t record;
+				record_stream >> record.point >> record.replica >> record.sequence;
+				record_stream.get();
+				std::getline(record_stream,record.line);
+				lines.push_back(record);
+			}
+			std::stable_sort(lines.begin(),lines.end());
+
+			// open output file if no data has been output
+			if(!zmag.is_open()){
+				zmag.open("output",std::ofstream::trunc);
+				write_output_file_header(zmag, file_output_list);
+			}
+
+			for(unsigned int i=0;i<lines.size();i++){
+				if(i>0 && lines[i].point==lines[i-1].point && lines[i].replica!=lines[i-1].replica) zmag << std::endl;
+				zmag << lines[i].line << std::endl;
+			}
+
+			zlog << zTs() << "Output of " << lines.size() << " lines of all replicas written to output file" << std::endl;
+
+		}
+
+		replica_lines.clear();
+
+		return;
+
+	}
+
 } // end of namespace vout
 
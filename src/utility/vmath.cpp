@@ -43,6 +43,7 @@
 #include "vmath.hpp"
 #include "vio.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
@@ -501,5 +502,74 @@ double interpolate_c(double xi,double yi,double xj,double yj){
 
 }
 
+//-----------------------------------------------------
+// Function to return smallest power of two >= n
+//
+unsigned int next_power_of_two(unsigned int n){
+
+   unsigned int p=1;
+   while(p<n) p*=2;
+
+   return p;
+
+}
+
+//-----------------------------------------------------
+// In-place iterative radix-2 Cooley-Tukey FFT of n
+// complex values separated by stride. The inverse
+// transform is not normalised.
+//
+void fft(std::complex<double>* data, const int n, const int stride, const bool inverse){
+
+   // bit reversal permutation
+   for(int i=1, j=0; i<n; i++){
+      int bit = n >> 1;
+      for(; j & bit; bit >>= 1) j ^= bit;
+      j ^= bit;
+      if(i<j) std::swap(data[i*stride],data[j*stride]);
+   }
+
+   // butterflies
+   const double sign = inverse ? 1.0 : -1.0;
+   for(int len=2; len<=n; len<<=1){
+      const double theta = sign*2.0*M_PI/double(len);
+      const std::complex<double> wlen(cos(theta),sin(theta));
+      for(int i=0; i<n; i+=len){
+         std::complex<double> w(1.0,0.0);
+         for(int j=0; j<len/2; j++){
+            const std::complex<double> u = data[(i+j)*stride];
+            const std::complex<double> v = data[(i+j+len/2)*stride]*w;
+            data[(i+j)*stride] = u+v;
+            data[(i+j+len/2)*stride] = u-v;
+            w*=wlen;
+         }
+      }
+   }
+
+   return;
+
+}
+
+//-----------------------------------------------------
+// 3D FFT of data stored as [x][y][z] with z fastest,
+// performed as successive 1D transforms along each axis
+//
+void fft3d(std::vector<std::complex<double> >& data, const int nx, const int ny, const int nz, const bool inverse){
+
+   // transform along z
+   for(int i=0; i<nx*ny; i++) fft(&data[i*nz], nz, 1, inverse);
+
+   // transform along y
+   for(int i=0; i<nx; i++){
+      for(int k=0; k<nz; k++) fft(&data[i*ny*nz+k], ny, nz, inverse);
+   }
+
+   // transform along x
+   for(int jk=0; jk<ny*nz; jk++) fft(&data[jk], nx, ny*nz, inverse);
+
+   return;
+
+}
+
 } // end of namespcae vmath
 
@@ -0,0 +1,93 @@
+/// Program to convert vampire binary snapshot files to text cfg format,
+/// for use with cfg2povray and cfg2rasmol
+///
+/// ./vbin2cfg atoms-00000000.vbin atoms-00000001.vbin ...
+///
+/// The coordinate file atoms-coords.vbin is converted to atoms-coords.cfg,
+/// and each spin file atoms-XXXXXXXX.vbin to atoms-XXXXXXXX.cfg.
+
+// Standard Libraries
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "vsnapshot.hpp"
+
+int main(int argc, char* argv[]){
+
+	// Get date for file headers
+	time_t rawtime = time(NULL);
+	struct tm * timeinfo = localtime(&rawtime);
+
+	// convert coordinate file
+	vsnapshot::header_t header;
+	std::vector<int> mat, cat;
+	std::vector<double> coords, mu_s;
+	std::vector<std::string> elements;
+
+	if(!vsnapshot::read_coordinates("atoms-coords.vbin", header, mat, cat, coords, elements, mu_s)) exit(1);
+
+	std::ofstream coord_file("atoms-coords.cfg");
+	coord_file << "#------------------------------------------------------"<< "\n";
+	coord_file << "# Atomistic coordinates configuration file for vampire"<< "\n";
+	coord_file << "#------------------------------------------------------"<< "\n";
+	coord_file << "# Date: "<< asctime(timeinfo);
+	coord_file << "#------------------------------------------------------"<< "\n";
+	coord_file << "Number of atoms: "<< header.num_atoms << "\n";
+	coord_file << "#------------------------------------------------------" << "\n";
+	coord_file << "Number of spin files: 0" << "\n";
+	coord_file << "#------------------------------------------------------"<< "\n";
+	coord_file << header.num_atoms << "\n";
+	for(uint64_t i=0;i<header.num_atoms;i++){
+		coord_file << mat[i] << "\t" << cat[i] << "\t" << coords[3*i+0] << "\t" << coords[3*i+1] << "\t" << coords[3*i+2] << "\t" << elements[mat[i]] << "\n";
+	}
+	coord_file.close();
+
+	const uint32_t num_materials = header.num_materials;
+
+	// convert spin files
+	for(int file=1;file<argc;file++){
+
+		const std::string filename(argv[file]);
+		std::vector<double> spins;
+		if(!vsnapshot::read_spins(filename, header, spins)) exit(1);
+
+		std::string cfg_filename = filename;
+		const std::string::size_type dot = cfg_filename.rfind(".vbin");
+		if(dot!=std::string::npos) cfg_filename.erase(dot);
+		cfg_filename += ".cfg";
+
+		std::ofstream spin_file(cfg_filename.c_str());
+		spin_file << "#------------------------------------------------------"<< "\n";
+		spin_file << "# Atomistic spin configuration file for vampire"<< "\n";
+		spin_file << "#------------------------------------------------------"<< "\n";
+		spin_file << "# Date: "<< asctime(timeinfo);
+		spin_file << "#------------------------------------------------------"<< "\n";
+		spin_file << "Number of spins: "<< header.num_atoms << "\n";
+		spin_file << "System dimensions:" << header.system_dimensions[0] << "\t" << header.system_dimensions[1] << "\t" << header.system_dimensions[2] << "\n";
+		spin_file << "Coordinates-file: atoms-coord.cfg"<< "\n";
+		spin_file << "Time: " << header.time << "\n";
+		spin_file << "Field: " << header.field << "\n";
+		spin_file << "Temperature: "<< header.temperature << "\n";
+		spin_file << "Magnetisation: " << header.magnetisation[0] << "\t" << header.magnetisation[1] << "\t" << header.magnetisation[2] << "\t" << header.magnetisation[3] << "\t" << "\n";
+		spin_file << "Number of Materials: " << num_materials << "\n";
+		for(uint32_t m=0;m<num_materials;m++) spin_file << mu_s[m] << "\n";
+		spin_file << "#------------------------------------------------------" << "\n";
+		spin_file << "Number of spin files: 0" << "\n";
+		spin_file << "#------------------------------------------------------"<< "\n";
+		spin_file << header.num_atoms << "\n";
+		for(uint64_t i=0;i<header.num_atoms;i++){
+			spin_file << spins[3*i+0] << "\t" << spins[3*i+1] << "\t" << spins[3*i+2] << "\n";
+		}
+		spin_file.close();
+
+		std::cout << "Converted " << filename << " to " << cfg_filename << std::endl;
+
+	}
+
+	return 0;
+
+}
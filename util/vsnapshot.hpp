@@ -0,0 +1,169 @@
+/// Reader for vampire binary snapshot files (atoms-XXXXXXXX.vbin and
+/// atoms-coords.vbin), written with config:atoms-output-format=binary-*
+///
+/// Usage:
+///
+///    vsnapshot::header_t header;
+///    std::vector<double> spins;
+///    vsnapshot::read_spins("atoms-00000000.vbin", header, spins);
+///
+/// Files are in native byte order of the machine which wrote them.
+
+#ifndef VSNAPSHOT_H_
+#define VSNAPSHOT_H_
+
+// Standard Libraries
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace vsnapshot{
+
+	const int header_size = 128;
+	const int element_name_size = 8;
+	const int material_record_size = 16;
+
+	struct header_t{
+		char magic[9];
+		uint32_t version;
+		uint32_t header_size;
+		uint32_t data_type; // 0 = float64, 1 = float32, 2 = int16 scaled by 1/32767
+		uint32_t components;
+		uint64_t num_atoms;
+		uint64_t snapshot;
+		double time;
+		double field;
+		double temperature;
+		double magnetisation[4];
+		double system_dimensions[3];
+		uint32_t num_materials;
+	};
+
+	template <typename T> T unpack(const std::vector<char>& buffer, const int offset){
+		T value;
+		memcpy(&value, &buffer[offset], sizeof(T));
+		return value;
+	}
+
+	/// Function to read file header, returning false on error
+	inline bool read_header(std::ifstream& ifile, header_t& header, const char* magic){
+
+		std::vector<char> buffer(header_size);
+		ifile.read(&buffer[0], header_size);
+		if(!ifile.good()) return false;
+
+		memcpy(header.magic, &buffer[0], 8);
+		header.magic[8]='\0';
+		if(std::string(header.magic)!=std::string(magic)) return false;
+
+		header.version = unpack<uint32_t>(buffer, 8);
+		header.header_size = unpack<uint32_t>(buffer, 12);
+		header.data_type = unpack<uint32_t>(buffer, 16);
+		header.components = unpack<uint32_t>(buffer, 20);
+		header.num_atoms = unpack<uint64_t>(buffer, 24);
+		header.snapshot = unpack<uint64_t>(buffer, 32);
+		header.time = unpack<double>(buffer, 40);
+		header.field = unpack<double>(buffer, 48);
+		header.temperature = unpack<double>(buffer, 56);
+		for(int i=0;i<4;i++) header.magnetisation[i] = unpack<double>(buffer, 64+8*i);
+		for(int i=0;i<3;i++) header.system_dimensions[i] = unpack<double>(buffer, 96+8*i);
+		header.num_materials = unpack<uint32_t>(buffer, 120);
+
+		return header.version==1 && header.components==3;
+
+	}
+
+	/// Function to read spins from binary snapshot file as sx, sy, sz for each atom
+	inline bool read_spins(const std::string& filename, header_t& header, std::vector<double>& spins){
+
+		std::ifstream ifile(filename.c_str(), std::ios::in | std::ios::binary);
+		if(!ifile.is_open()){
+			std::cerr << "Error: Unable to open binary snapshot file " << filename << std::endl;
+			return false;
+		}
+
+		if(!read_header(ifile, header, "VAMPSPIN")){
+			std::cerr << "Error: File " << filename << " is not a vampire binary spin snapshot" << std::endl;
+			return false;
+		}
+		ifile.seekg(header.header_size);
+
+		const uint64_t n = 3*header.num_atoms;
+		spins.resize(n);
+
+		switch(header.data_type){
+			case 0:{
+				if(n>0) ifile.read(reinterpret_cast<char*>(&spins[0]), n*sizeof(double));
+				break;
+			}
+			case 1:{
+				std::vector<float> data(n);
+				if(n>0) ifile.read(reinterpret_cast<char*>(&data[0]), n*sizeof(float));
+				for(uint64_t i=0;i<n;i++) spins[i]=data[i];
+				break;
+			}
+			case 2:{
+				std::vector<int16_t> data(n);
+				if(n>0) ifile.read(reinterpret_cast<char*>(&data[0]), n*sizeof(int16_t));
+				for(uint64_t i=0;i<n;i++) spins[i]=double(data[i])/32767.0;
+				break;
+			}
+			default:
+				std::cerr << "Error: Unknown data type " << header.data_type << " in file " << filename << std::endl;
+				return false;
+		}
+
+		return ifile.good();
+
+	}
+
+	/// Function to read atomic coordinates, materials and categories, and element names and moments of materials
+	inline bool read_coordinates(const std::string& filename, header_t& header, std::vector<int>& material, std::vector<int>& category,
+	                             std::vector<double>& coords, std::vector<std::string>& elements, std::vector<double>& mu_s){
+
+		std::ifstream ifile(filename.c_str(), std::ios::in | std::ios::binary);
+		if(!ifile.is_open()){
+			std::cerr << "Error: Unable to open binary coordinate file " << filename << std::endl;
+			return false;
+		}
+
+		if(!read_header(ifile, header, "VAMPCRDS")){
+			std::cerr << "Error: File " << filename << " is not a vampire binary coordinate file" << std::endl;
+			return false;
+		}
+
+		elements.resize(header.num_materials);
+		mu_s.resize(header.num_materials);
+		for(uint32_t mat=0;mat<header.num_materials;mat++){
+			std::vector<char> record(material_record_size);
+			ifile.read(&record[0], material_record_size);
+			const std::string name(&record[0], element_name_size);
+			elements[mat]=name.substr(0, name.find('\0'));
+			mu_s[mat]=unpack<double>(record, element_name_size);
+		}
+		ifile.seekg(header.header_size);
+
+		const uint64_t n = header.num_atoms;
+		std::vector<int32_t> data(n);
+		material.resize(n);
+		category.resize(n);
+		coords.resize(3*n);
+
+		if(n>0){
+			ifile.read(reinterpret_cast<char*>(&data[0]), n*sizeof(int32_t));
+			for(uint64_t i=0;i<n;i++) material[i]=data[i];
+			ifile.read(reinterpret_cast<char*>(&data[0]), n*sizeof(int32_t));
+			for(uint64_t i=0;i<n;i++) category[i]=data[i];
+			ifile.read(reinterpret_cast<char*>(&coords[0]), 3*n*sizeof(double));
+		}
+
+		return ifile.good();
+
+	}
+
+}
+
+#endif /*VSNAPSHOT_H_*/